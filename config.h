@@ -4,6 +4,9 @@
 /* Debugging level to compile in. */
 #define DEBUG 4
 
+/* Define to 1 if you have the <dirent.h> header file. */
+#define HAVE_DIRENT_H 1
+
 /* Define to 1 if you have the <dlfcn.h> header file. */
 #define HAVE_DLFCN_H 1
 
@@ -13,6 +16,9 @@
 /* Define to 1 if you have the <fcntl.h> header file. */
 #define HAVE_FCNTL_H 1
 
+/* Define to 1 if you have the <glob.h> header file. */
+#define HAVE_GLOB_H 1
+
 /* Define if you have HDF5 library */
 #define HAVE_HDF5LIB 1
 
@@ -34,6 +40,9 @@
 /* Define if you have NETCDF library */
 #define HAVE_NETCDFLIB 1
 
+/* Define if you have POSIX threads library */
+#define HAVE_PTHREAD 1
+
 /* Define if you have SHAPEFILE library */
 #define HAVE_SHAPEFILE 1
 
@@ -58,12 +67,18 @@
 /* Define to 1 if you have the <sys/mman.h> header file. */
 #define HAVE_SYS_MMAN_H 1
 
+/* Define to 1 if you have the <sys/resource.h> header file. */
+#define HAVE_SYS_RESOURCE_H 1
+
 /* Define to 1 if you have the <sys/stat.h> header file. */
 #define HAVE_SYS_STAT_H 1
 
 /* Define to 1 if you have the <sys/types.h> header file. */
 #define HAVE_SYS_TYPES_H 1
 
+/* Define to 1 if you have the <sys/wait.h> header file. */
+#define HAVE_SYS_WAIT_H 1
+
 /* Define to 1 if you have the <time.h> header file. */
 #define HAVE_TIME_H 1
 
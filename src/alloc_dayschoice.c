@@ -0,0 +1,119 @@
+/* ***************************************************** */
+/* Allocate contiguous storage of analog day choices.    */
+/* alloc_dayschoice.c                                    */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file alloc_dayschoice.c
+    \brief Allocate contiguous storage of analog day choices.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <dsclim.h>
+
+/** Allocate analog day choices of an analog day structure as contiguous (ntime x ndayschoices) blocks. */
+void
+alloc_dayschoice(analog_day_struct *analog_days, int ntime, int ndayschoices) {
+  /**
+     @param[in,out]  analog_days   Analog days structure
+     @param[in]      ntime         Number of times
+     @param[in]      ndayschoices  Maximum number of days in the first selection of analog days
+  */
+
+  int nrows = (ntime > 0) ? ntime : 1; /* Number of rows allocated */
+  int t; /* Time loop counter */
+
+  analog_days->ndayschoice = (int *) malloc(nrows * sizeof(int));
+  if (analog_days->ndayschoice == NULL) alloc_error(__FILE__, __LINE__);
+  analog_days->analog_dayschoice = (tstruct **) malloc(nrows * sizeof(tstruct *));
+  if (analog_days->analog_dayschoice == NULL) alloc_error(__FILE__, __LINE__);
+  analog_days->metric_norm = (float **) malloc(nrows * sizeof(float *));
+  if (analog_days->metric_norm == NULL) alloc_error(__FILE__, __LINE__);
+  analog_days->tindex_dayschoice = (int **) malloc(nrows * sizeof(int *));
+  if (analog_days->tindex_dayschoice == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Rows point into one block each, starting at row 0. Zeroed because the number of choices can vary between seasons. */
+  analog_days->analog_dayschoice[0] = (tstruct *) calloc((size_t) nrows * (size_t) ndayschoices, sizeof(tstruct));
+  if (analog_days->analog_dayschoice[0] == NULL) alloc_error(__FILE__, __LINE__);
+  analog_days->metric_norm[0] = (float *) calloc((size_t) nrows * (size_t) ndayschoices, sizeof(float));
+  if (analog_days->metric_norm[0] == NULL) alloc_error(__FILE__, __LINE__);
+  analog_days->tindex_dayschoice[0] = (int *) calloc((size_t) nrows * (size_t) ndayschoices, sizeof(int));
+  if (analog_days->tindex_dayschoice[0] == NULL) alloc_error(__FILE__, __LINE__);
+
+  for (t=0; t<nrows; t++) {
+    analog_days->ndayschoice[t] = ndayschoices;
+    analog_days->analog_dayschoice[t] = analog_days->analog_dayschoice[0] + (size_t) t * (size_t) ndayschoices;
+    analog_days->metric_norm[t] = analog_days->metric_norm[0] + (size_t) t * (size_t) ndayschoices;
+    analog_days->tindex_dayschoice[t] = analog_days->tindex_dayschoice[0] + (size_t) t * (size_t) ndayschoices;
+  }
+}
+
+/** Free analog day choices of an analog day structure allocated with alloc_dayschoice. */
+void
+free_dayschoice(analog_day_struct *analog_days) {
+  /**
+     @param[in,out]  analog_days   Analog days structure
+  */
+
+  if (analog_days->analog_dayschoice != NULL) {
+    (void) free(analog_days->analog_dayschoice[0]);
+    (void) free(analog_days->analog_dayschoice);
+    analog_days->analog_dayschoice = NULL;
+  }
+  if (analog_days->metric_norm != NULL) {
+    (void) free(analog_days->metric_norm[0]);
+    (void) free(analog_days->metric_norm);
+    analog_days->metric_norm = NULL;
+  }
+  if (analog_days->tindex_dayschoice != NULL) {
+    (void) free(analog_days->tindex_dayschoice[0]);
+    (void) free(analog_days->tindex_dayschoice);
+    analog_days->tindex_dayschoice = NULL;
+  }
+  if (analog_days->ndayschoice != NULL) {
+    (void) free(analog_days->ndayschoice);
+    analog_days->ndayschoice = NULL;
+  }
+}
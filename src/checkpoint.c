@@ -0,0 +1,418 @@
+/* ***************************************************** */
+/* Checkpoints of long downscaling runs.                 */
+/* checkpoint.c                                          */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file checkpoint.c
+    \brief Checkpoints of long downscaling runs, to resume them where they stopped.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <dsclim.h>
+
+/** Name of the file holding the configuration hash of the checkpoints. */
+#define CHECKPOINT_HASH_FILE "configuration_hash"
+/** Name of the learning data checkpoint entry. */
+#define CHECKPOINT_LEARNING "learning"
+
+/** Build the name of a file in the checkpoint directory. */
+static char *
+checkpoint_filename(char *dir, char *name) {
+  /**
+     @param[in]  dir   Checkpoint directory.
+     @param[in]  name  File name in the checkpoint directory.
+
+     \return           Allocated filename.
+  */
+
+  char *filename = NULL; /* Filename */
+
+  filename = (char *) malloc((strlen(dir) + strlen(name) + 2) * sizeof(char));
+  if (filename == NULL) alloc_error(__FILE__, __LINE__);
+  (void) sprintf(filename, "%s/%s", dir, name);
+
+  return filename;
+}
+
+/** Build the key of the checkpoints of a downscaling output path, so that ensemble members never share checkpoints. */
+static void
+checkpoint_output_key(char *output_path, char *key) {
+  /**
+     @param[in]   output_path  Output path directory.
+     @param[out]  key          Key: 16 hexadecimal characters and a null character.
+  */
+
+  fingerprint_struct fp; /* Fingerprint of output path */
+  char hex[33]; /* Fingerprint in hexadecimal */
+
+  (void) fingerprint_init(&fp);
+  (void) fingerprint_add_str(&fp, output_path);
+  (void) fingerprint_hex(&fp, hex);
+  (void) strncpy(key, hex, 16);
+  key[16] = '\0';
+}
+
+/** Remove all checkpoints of the checkpoint directory. */
+static void
+checkpoint_clear(char *dir) {
+  /**
+     @param[in]  dir  Checkpoint directory.
+  */
+
+#ifdef HAVE_DIRENT_H
+  DIR *dirp = NULL; /* Directory stream */
+  DIR *subdirp = NULL; /* Sub-directory stream */
+  struct dirent *entry = NULL; /* Directory entry */
+  struct dirent *subentry = NULL; /* Sub-directory entry */
+  char *path = NULL; /* Full path of an entry */
+  char *subpath = NULL; /* Full path of a sub-directory entry */
+
+  dirp = opendir(dir);
+  if (dirp == NULL)
+    return;
+  while ((entry = readdir(dirp)) != NULL) {
+    if ( !strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..") )
+      continue;
+    path = checkpoint_filename(dir, entry->d_name);
+    /* Learning entries are directories of files */
+    subdirp = opendir(path);
+    if (subdirp != NULL) {
+      while ((subentry = readdir(subdirp)) != NULL) {
+        if ( !strcmp(subentry->d_name, ".") || !strcmp(subentry->d_name, "..") )
+          continue;
+        subpath = checkpoint_filename(path, subentry->d_name);
+        (void) unlink(subpath);
+        (void) free(subpath);
+      }
+      (void) closedir(subdirp);
+      (void) rmdir(path);
+    }
+    else
+      (void) unlink(path);
+    (void) free(path);
+  }
+  (void) closedir(dirp);
+#else
+  (void) fprintf(stderr, "%s: WARNING: Cannot list checkpoint directory %s: previous checkpoints are not removed.\n", __FILE__, dir);
+#endif
+}
+
+/** Prepare the checkpoint directory of a run. A fresh run removes previous checkpoints and records the configuration hash;
+    a resumed run verifies that its configuration hash matches the one of the checkpoints. */
+int
+checkpoint_init(data_struct *data) {
+  /**
+     @param[in]  data  MASTER data structure.
+
+     \return           Status.
+  */
+
+  checkpoint_struct *checkpoint = data->checkpoint; /* Checkpoints structure */
+  fingerprint_struct fp; /* Fingerprint of the configuration */
+  char *filename = NULL; /* Configuration hash filename */
+  char hash[33]; /* Configuration hash of the checkpoints */
+  FILE *hashfile = NULL; /* Configuration hash file */
+  int found = FALSE; /* If the configuration hash of the checkpoints was found */
+
+  if (mkdir(checkpoint->run_dir, 0755) != 0 && errno != EEXIST) {
+    (void) fprintf(stderr, "%s: Cannot create run directory %s: %s\n", __FILE__, checkpoint->run_dir, strerror(errno));
+    return -1;
+  }
+  if (mkdir(checkpoint->dir, 0755) != 0 && errno != EEXIST) {
+    (void) fprintf(stderr, "%s: Cannot create checkpoint directory %s: %s\n", __FILE__, checkpoint->dir, strerror(errno));
+    return -1;
+  }
+
+  /* Configuration hash */
+  (void) fingerprint_init(&fp);
+  (void) fingerprint_add_str(&fp, PACKAGE_VERSION);
+  (void) fingerprint_add_str(&fp, data->conf->config);
+  (void) fingerprint_hex(&fp, checkpoint->hash);
+
+  filename = checkpoint_filename(checkpoint->dir, CHECKPOINT_HASH_FILE);
+
+  if (checkpoint->resume == TRUE) {
+    hashfile = fopen(filename, "r");
+    if (hashfile != NULL) {
+      found = (fscanf(hashfile, "%32s", hash) == 1);
+      (void) fclose(hashfile);
+    }
+    if (found == FALSE) {
+      (void) fprintf(stderr, "%s: WARNING: No checkpoints found in %s: starting a fresh run.\n", __FILE__, checkpoint->dir);
+      checkpoint->resume = FALSE;
+    }
+    else if (strcmp(hash, checkpoint->hash)) {
+      (void) fprintf(stderr, "%s: Checkpoints in %s were made with a different configuration (hash %s, current configuration hash %s). "
+                     "Cannot resume the run.\n", __FILE__, checkpoint->dir, hash, checkpoint->hash);
+      (void) free(filename);
+      return -1;
+    }
+    else
+      (void) printf("%s: Resuming run from checkpoints in %s.\n", __FILE__, checkpoint->dir);
+  }
+
+  if (checkpoint->resume == FALSE) {
+    /* Fresh run: previous checkpoints are obsolete */
+    (void) checkpoint_clear(checkpoint->dir);
+    hashfile = fopen(filename, "w");
+    if (hashfile == NULL) {
+      (void) fprintf(stderr, "%s: Cannot write configuration hash file %s: %s\n", __FILE__, filename, strerror(errno));
+      (void) free(filename);
+      return -1;
+    }
+    (void) fprintf(hashfile, "%s\n", checkpoint->hash);
+    (void) fclose(hashfile);
+    (void) printf("%s: Checkpoints of this run are written in %s.\n", __FILE__, checkpoint->dir);
+  }
+
+  (void) free(filename);
+
+  return 0;
+}
+
+/** Build the name of the analog data checkpoint of a large-scale field category. */
+char *
+checkpoint_analog_filename(data_struct *data, int cat) {
+  /**
+     @param[in]  data  MASTER data structure.
+     @param[in]  cat   Large-scale field category (FIELD_LS or CTRL_FIELD_LS).
+
+     \return           Allocated filename, or NULL when checkpoints are disabled.
+  */
+
+  char key[17]; /* Output path key */
+  char name[64]; /* Checkpoint name */
+
+  if (data->checkpoint->dir == NULL)
+    return NULL;
+
+  (void) checkpoint_output_key(data->conf->output_path, key);
+  (void) sprintf(name, "analog_%s_%s.nc", key, (cat == CTRL_FIELD_LS) ? "ctrl" : "other");
+
+  return checkpoint_filename(data->checkpoint->dir, name);
+}
+
+/** Check if analog data of all downscaled periods can be read from checkpoints when resuming a run. */
+int
+checkpoint_analog_resume(data_struct *data) {
+  /**
+     @param[in]  data  MASTER data structure.
+
+     \return           TRUE if analog data checkpoints are complete, FALSE otherwise.
+  */
+
+  char *filename = NULL; /* Analog data checkpoint filename */
+  struct stat st; /* File status */
+  int found; /* If the analog data checkpoint exists */
+
+  if (data->checkpoint->dir == NULL || data->checkpoint->resume == FALSE)
+    return FALSE;
+
+  filename = checkpoint_analog_filename(data, FIELD_LS);
+  found = (stat(filename, &st) == 0);
+  (void) free(filename);
+  if (found == TRUE && data->conf->period_ctrl->downscale == TRUE) {
+    filename = checkpoint_analog_filename(data, CTRL_FIELD_LS);
+    found = (stat(filename, &st) == 0);
+    (void) free(filename);
+  }
+
+  return found;
+}
+
+/** Save analog data of a large-scale field category as a checkpoint. The checkpoint is written in a temporary file
+    which is then renamed, so that an interrupted run never leaves a partial checkpoint. */
+int
+checkpoint_analog_save(data_struct *data, int cat, analog_day_struct analog_days, double *delta, double **delta_dayschoice,
+                       double *dist, int *cluster, double *time_ls) {
+  /**
+     @param[in]  data              MASTER data structure.
+     @param[in]  cat               Large-scale field category (FIELD_LS or CTRL_FIELD_LS).
+     @param[in]  analog_days       Analog days time indexes and dates with corresponding dates being downscaled.
+     @param[in]  delta             Temperature difference to apply to analog day data.
+     @param[in]  delta_dayschoice  Temperature difference to apply to analog day data, for all ndayschoices analogs.
+     @param[in]  dist              Distance to cluster associated with each downscaled/analog day.
+     @param[in]  cluster           Cluster number associated with each downscaled/analog day.
+     @param[in]  time_ls           Time values in udunit.
+
+     \return                       Status.
+  */
+
+  char *filename = NULL; /* Analog data checkpoint filename */
+  char *tmpfile = NULL; /* Temporary analog data checkpoint filename */
+  int istat = 0; /* Diagnostic status */
+
+  /* In ensemble batch mode, analog data is not resumed */
+  if (data->checkpoint->dir == NULL || data->conf->nmembers > 0)
+    return 0;
+
+  filename = checkpoint_analog_filename(data, cat);
+  tmpfile = (char *) malloc((strlen(filename) + 32) * sizeof(char));
+  if (tmpfile == NULL) alloc_error(__FILE__, __LINE__);
+  (void) sprintf(tmpfile, "%s.tmp.%ld", filename, (long) getpid());
+
+  (void) save_analog_data(analog_days, delta, delta_dayschoice, dist, cluster, time_ls, tmpfile, data);
+  if (rename(tmpfile, filename) != 0) {
+    (void) fprintf(stderr, "%s: WARNING: Cannot write analog data checkpoint %s: %s\n", __FILE__, filename, strerror(errno));
+    (void) unlink(tmpfile);
+    istat = -1;
+  }
+  else
+    (void) printf("%s: Checkpoint of analog data written in %s.\n", __FILE__, filename);
+
+  (void) free(tmpfile);
+  (void) free(filename);
+
+  return istat;
+}
+
+/** Use learning data checkpoint, if any, when resuming a run. */
+int
+checkpoint_learning_lookup(data_struct *data) {
+  /**
+     @param[in]  data  MASTER data structure.
+
+     \return           1 if learning data checkpoint will be used, 0 otherwise.
+  */
+
+  if (data->checkpoint->dir == NULL || data->checkpoint->resume == FALSE)
+    return 0;
+
+  if (learning_cache_use_entry(data, data->checkpoint->dir, CHECKPOINT_LEARNING) == 0)
+    return 0;
+
+  (void) printf("%s: Using learning data checkpoint in %s/%s.\n", __FILE__, data->checkpoint->dir, CHECKPOINT_LEARNING);
+  return 1;
+}
+
+/** Save computed learning data as a checkpoint. */
+int
+checkpoint_learning_save(data_struct *data) {
+  /**
+     @param[in]  data  MASTER data structure.
+
+     \return           Status.
+  */
+
+  if (data->checkpoint->dir == NULL)
+    return 0;
+
+  return learning_cache_save_entry(data, data->checkpoint->dir, CHECKPOINT_LEARNING);
+}
+
+/** Build the prefix of the completed output year checkpoints of a large-scale field category. */
+char *
+checkpoint_output_prefix(data_struct *data, int cat) {
+  /**
+     @param[in]  data  MASTER data structure.
+     @param[in]  cat   Large-scale field category (FIELD_LS or CTRL_FIELD_LS).
+
+     \return           Allocated prefix, or NULL when checkpoints are disabled.
+  */
+
+  char key[17]; /* Output path key */
+  char name[64]; /* Checkpoint name */
+
+  if (data->checkpoint->dir == NULL)
+    return NULL;
+
+  (void) checkpoint_output_key(data->conf->output_path, key);
+  (void) sprintf(name, "output_%s_%s", key, (cat == CTRL_FIELD_LS) ? "ctrl" : "other");
+
+  return checkpoint_filename(data->checkpoint->dir, name);
+}
+
+/** Check if an output year was completed. */
+int
+checkpoint_output_done(char *prefix, int year) {
+  /**
+     @param[in]  prefix  Prefix of the completed output year checkpoints.
+     @param[in]  year    Output year.
+
+     \return             TRUE if the output year was completed, FALSE otherwise.
+  */
+
+  char *filename = NULL; /* Output year checkpoint filename */
+  struct stat st; /* File status */
+  int done; /* If the output year was completed */
+
+  filename = (char *) malloc((strlen(prefix) + 16) * sizeof(char));
+  if (filename == NULL) alloc_error(__FILE__, __LINE__);
+  (void) sprintf(filename, "%s_%04d", prefix, year);
+  done = (stat(filename, &st) == 0);
+  (void) free(filename);
+
+  return done;
+}
+
+/** Record that an output year was completed. */
+int
+checkpoint_output_year(char *prefix, int year) {
+  /**
+     @param[in]  prefix  Prefix of the completed output year checkpoints.
+     @param[in]  year    Output year.
+
+     \return             Status.
+  */
+
+  char *filename = NULL; /* Output year checkpoint filename */
+  FILE *outfile = NULL; /* Output year checkpoint file */
+
+  filename = (char *) malloc((strlen(prefix) + 16) * sizeof(char));
+  if (filename == NULL) alloc_error(__FILE__, __LINE__);
+  (void) sprintf(filename, "%s_%04d", prefix, year);
+  outfile = fopen(filename, "w");
+  if (outfile == NULL) {
+    (void) fprintf(stderr, "%s: WARNING: Cannot write output year checkpoint %s: %s\n", __FILE__, filename, strerror(errno));
+    (void) free(filename);
+    return -1;
+  }
+  (void) fprintf(outfile, "%04d\n", year);
+  (void) fclose(outfile);
+  (void) free(filename);
+
+  return 0;
+}
@@ -83,6 +83,9 @@ int main(int argc, char **argv)
   
   /* Command-line arguments variables */
   char fileconf[500]; /* Configuration filename */
+  char *fileprofile = NULL; /* Optional JSON performance summary filename */
+  char *filetrace = NULL; /* Optional Chrome trace-event filename */
+  instrument_timer_struct timer; /* Phase timer */
 
   /* Show license so user can accept or deny it. */
   license_accept = show_license();
@@ -101,6 +104,22 @@ int main(int argc, char **argv)
   data = (data_struct *) malloc(sizeof(data_struct));
   if (data == NULL) alloc_error(__FILE__, __LINE__);
 
+  /* Create one memory arena for each phase of the run */
+  data->arena = (arena_struct **) malloc(NPHASES * sizeof(arena_struct *));
+  if (data->arena == NULL) alloc_error(__FILE__, __LINE__);
+  data->arena[PHASE_CONF] = arena_create("configuration", 0);
+  data->arena[PHASE_LEARNING] = arena_create("learning", 0);
+  data->arena[PHASE_DOWNSCALING] = arena_create("downscaling", 0);
+  data->arena[PHASE_OUTPUT] = arena_create("output", 0);
+
+  /* Checkpoints are enabled by the configuration */
+  data->checkpoint = (checkpoint_struct *) malloc(sizeof(checkpoint_struct));
+  if (data->checkpoint == NULL) alloc_error(__FILE__, __LINE__);
+  data->checkpoint->run_dir = NULL;
+  data->checkpoint->dir = NULL;
+  data->checkpoint->resume = FALSE;
+  data->checkpoint->hash[0] = '\0';
+
   /* Get command-line arguments and set appropriate variables */
   (void) printf("\n**** PROCESS COMMAND-LINE ARGUMENTS ****\n\n");
   if (argc <= 1) {
@@ -113,6 +132,12 @@ int main(int argc, char **argv)
     for (i=1; i<argc; i++) {
       if ( !strcmp(argv[i], "-conf") )
         (void) strcpy(fileconf, argv[++i]);
+      else if ( !strcmp(argv[i], "-profile") && i+1 < argc )
+        fileprofile = argv[++i];
+      else if ( !strcmp(argv[i], "-trace") && i+1 < argc )
+        filetrace = argv[++i];
+      else if ( !strcmp(argv[i], "-resume") )
+        data->checkpoint->resume = TRUE;
       else if ( !strcmp(argv[i], "--version") ) {
         (void) printf("%s version %s\n\n", PACKAGE_NAME, PACKAGE_VERSION);
         (void) banner(PACKAGE_NAME, "OK", "END");
@@ -126,15 +151,25 @@ int main(int argc, char **argv)
       }
     }
 
+  /* Start instrumentation timers and counters */
+  istat = instrument_init(fileprofile, filetrace);
+  if (istat != 0) {
+    (void) banner(PACKAGE_NAME, "ABORT", "END");
+    (void) exit(1);
+  }
+
   /* Read and store configuration file in memory */
   /* Allocate memory for main data structures */
   (void) printf("\n**** LOADING CONFIGURATION ****\n\n");
+  (void) instrument_begin(&timer, "configuration");
   istat = load_conf(data, fileconf);
+  (void) instrument_end(&timer);
   if (istat != 0) {
     (void) fprintf(stderr, "%s: Error in loading configuration file. Aborting.\n", __FILE__);
     (void) banner(PACKAGE_NAME, "ABORT", "END");
     (void) abort();
   }
+  (void) arena_phase_end(data->arena[PHASE_CONF]);
 
 
   /* Generate analog data only if we are not reading it off disk */
@@ -175,12 +210,17 @@ int main(int argc, char **argv)
 
     /* If wanted, generate learning data */
     (void) printf("\n**** LEARNING ****\n\n");
+    (void) instrument_begin(&timer, "learning");
     istat = wt_learning(data);
+    (void) instrument_end(&timer);
     if (istat != 0) {
       (void) fprintf(stderr, "%s: Error in computing or reading learning data needed for downscaling. Aborting.\n", __FILE__);
       (void) banner(PACKAGE_NAME, "ABORT", "END");
       (void) abort();
     }
+    /* Release learning scratch memory */
+    (void) arena_phase_end(data->arena[PHASE_LEARNING]);
+    (void) arena_reset(data->arena[PHASE_LEARNING]);
   }
   
   /* Perform downscaling */
@@ -192,18 +232,45 @@ int main(int argc, char **argv)
     (void) printf("\n**** DOWNSCALING ****\n\n");
     if (data->conf->output_only == TRUE)
       (void) printf("****WARNING: Configuration for reading analog dates and writing data ONLY!\n\n");
-    istat = wt_downscaling(data);
+    (void) instrument_begin(&timer, "downscaling");
+    if (data->conf->nmembers > 0)
+      /* Ensemble batch mode: downscale every member with the same learning */
+      istat = ensemble_downscaling(data);
+    else
+      istat = wt_downscaling(data);
+    (void) instrument_end(&timer);
     if (istat != 0) {
       (void) fprintf(stderr, "%s: Error in performing downscaling. Aborting.\n", __FILE__);
       (void) banner(PACKAGE_NAME, "ABORT", "END");
       (void) abort();
     }
+    /* Release downscaling and output scratch memory */
+    (void) arena_phase_end(data->arena[PHASE_OUTPUT]);
+    (void) arena_reset(data->arena[PHASE_DOWNSCALING]);
+    (void) arena_reset(data->arena[PHASE_OUTPUT]);
   }
   
   /* Free main data structure */
   (void) printf("\n**** FREE MEMORY ****\n\n");
   (void) free_main_data(data);
+
+  /* Report memory usage of each phase and free arenas */
+  (void) printf("\n**** MEMORY USAGE ****\n\n");
+  for (i=0; i<NPHASES; i++) {
+    (void) arena_report(data->arena[i]);
+    (void) instrument_arena(data->arena[i]);
+    (void) arena_free(data->arena[i]);
+  }
+  (void) free(data->arena);
+  (void) free(data->checkpoint);
   (void) free(data);
+  (void) alloc_large_cleanup();
+  /* Stop decompression threads */
+  (void) read_netcdf_chunks_set_nthreads(0);
+
+  /* Report timers and counters, write optional JSON summary and trace files */
+  (void) printf("\n**** PERFORMANCE ****\n\n");
+  (void) instrument_finalize();
 
   /* Print END banner */
   (void) banner(PACKAGE_NAME, "OK", "END");
@@ -223,6 +290,9 @@ show_usage(char *pgm) {
 
   (void) fprintf(stderr, "%s:: usage:\n", pgm);
   (void) fprintf(stderr, "-conf: configuration file\n");
+  (void) fprintf(stderr, "-profile: optional JSON file receiving timers, counters and memory usage at exit\n");
+  (void) fprintf(stderr, "-trace: optional Chrome trace-event file of all timed intervals\n");
+  (void) fprintf(stderr, "-resume: resume the run from the checkpoints of its run directory, skipping completed work\n");
 
 }
 
@@ -73,6 +73,12 @@ LICENSE END */
 #ifdef HAVE_LIBGEN_H
 #include <libgen.h>
 #endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+#ifdef HAVE_GLOB_H
+#include <glob.h>
+#endif
 
 /* NetCDF-related includes */
 #include <zlib.h>
@@ -100,12 +106,29 @@ LICENSE END */
 /** Large-scale secondary fields category for control-run. */
 #define CTRL_SEC_FIELD_LS 3
 
+/** Number of run phases, each one with its memory arena. */
+#define NPHASES 4
+/** Configuration phase: memory lives until the end of the run. */
+#define PHASE_CONF 0
+/** Learning phase. */
+#define PHASE_LEARNING 1
+/** Downscaling phase. */
+#define PHASE_DOWNSCALING 2
+/** Output phase. */
+#define PHASE_OUTPUT 3
+
 /** Maximum length of paths/filenames strings. */
 #define MAXPATH 5000
 
 /** Compression level **/
 #define DEFLATE_LEVEL 6
 
+/** Number of analog day slices queued between output pipeline stages. */
+#define OUTPUT_QUEUE_SIZE 4
+
+/** Token replaced by the member name in filenames and paths in ensemble batch mode. */
+#define ENSEMBLE_MEMBER_TOKEN "@member@"
+
 /* Local C includes. */
 #include <utils.h>
 #include <clim.h>
@@ -141,6 +164,7 @@ typedef struct {
   char **height; /**< Height attribute for post-processing variables. */
   double *delta; /**< Value to add to get SI units. */
   double *factor; /**< Value to multiply to get SI units. */
+  nc_encoding_struct *encoding; /**< Output encoding: full precision floats, packed shorts or bit-groomed floats. */
 } var_struct;
 
 /** Analog day structure analog_day_struct, season-dependent. */
@@ -152,9 +176,9 @@ typedef struct {
   int *month; /**< Month of analog day. */
   int *day; /**< Day of analog day. */
   int *ndayschoice; /**< Number of days in the first selection of analog days. */
-  tstruct **analog_dayschoice; /**< All analog days in the first selection. */
-  int **tindex_dayschoice; /**< Time index of all analog days. */
-  float **metric_norm; /**< Metric normalized for all analog days in the selection. */
+  tstruct **analog_dayschoice; /**< All analog days in the first selection. Rows point into one (ntime x ndayschoices) block starting at row 0. */
+  int **tindex_dayschoice; /**< Time index of all analog days. Rows point into one block starting at row 0. */
+  float **metric_norm; /**< Metric normalized for all analog days in the selection. Rows point into one block starting at row 0. */
   int ntime; /**< Number of analog times. */
   int *tindex_s_all; /**< Time index of day being downscaled in the season-merged index. */
   int *year_s; /**< Years of dates being downscaled. */
@@ -225,6 +249,7 @@ typedef struct {
 /* The dimension should be for each independent field, for all categories. */
   char *nomvar_ls; /**< Name of large scale field. */
   double *field_ls; /**< Large scale fields. */
+  float *field_ls_f; /**< Large scale fields in single precision, used instead of field_ls when single_precision is set for the category. */
   char *filename_ls; /**< Large scale field filename. */
   double *field_eof_ls; /**< Large scale fields projected on EOF. */
   char *dimxname; /**< X Dimension name for large-scale fields. */
@@ -251,6 +276,7 @@ typedef struct {
  * These variables are thus different for each of these categories
  */
   int n_ls; /**< Number of large scale fields. */
+  int single_precision; /**< Keep large scale fields in single precision (field_ls_f) for this category. */
   int ntime_ls; /**< Time dimension of large scale fields. */
   double *time_ls; /**< Time vector of large scale fields. */
   time_vect_struct *time_s; /**< Time structure of large scale fields. */  
@@ -313,6 +339,8 @@ typedef struct {
   char *filename_save_learn; /**< Filename for writing learning data in NetCDF format. */
   char *filename_save_clust_learn; /**< Filename for writing clusters learning data in NetCDF format. */
   char *filename_rea_sup; /**< Filename for secondary large-scale field of reanalysis data. */
+  char *cache_dir; /**< Learning cache directory. NULL to disable the learning cache. */
+  char *cache_key; /**< Fingerprint of the learning inputs, naming the entry of the learning cache. */
   char *nomvar_weight; /**< NetCDF variable name for weights. */
   char *nomvar_class_clusters; /**< NetCDF variable name clusters classification. */
   char *nomvar_precip_reg; /**< NetCDF variable name for precipitation regression coefficients. */
@@ -437,6 +465,12 @@ typedef struct {
   int format; /**< Format for NetCDF output files. */
   int compression; /**< Compression for NetCDF-4 output files. */
   int compression_level; /**< Compression Level for NetCDF-4 output files. */
+  int nthreads; /**< Number of threads used for parallel processing. */
+  int output_pipeline; /**< Overlap reading, corrections and writing of successive days when writing downscaled output. */
+  int prefetch_memory; /**< Memory budget in MB for large-scale fields and EOFs read in the background while earlier ones are processed. 0 to read synchronously. */
+  int decompression_threads; /**< Number of threads inflating compressed NetCDF-4 chunks of input variables. Less than 2 to read through the NetCDF library only. */
+  char *scratch_dir; /**< Scratch directory for memory-mapped large arrays. NULL to keep them on the heap. */
+  int scratch_min_size; /**< Minimum size in MB of an array to be memory-mapped in the scratch directory. */
   int fixtime; /**< Fix incorrect time in input climate model file, and use 01/01/year_begin_ctrl as first day for control period, and year_begin_other for other period, and assume daily data since it is required. */
   int year_begin_ctrl; /**< Use year_begin_ctrl as first day for control period in model file when fixing time units. */
   int year_begin_other; /**< Use year_begin_other as first day for other period in model file when fixing time units. */
@@ -485,8 +519,20 @@ typedef struct {
   int use_downscaled_year; /**< If we want to also search the analog day in the year of the current downscaled year. */
   int only_wt; /**< If we want to restrict search to only the same weather type. */
   double deltat; /**< Absolute difference of temperature to use to correct temperature when downscaling and comparing large-scale temperature index. */
+  int nmembers; /**< Number of ensemble members downscaled with the same learning. 0 when not in ensemble batch mode. */
+  char **members; /**< Ensemble member names, replacing ENSEMBLE_MEMBER_TOKEN in large-scale, climatology, EOF, analog, regression and output filenames. */
+  int concurrent_members; /**< Maximum number of ensemble members downscaled concurrently. */
+  int members_memory; /**< Memory budget in MB for ensemble members downscaled concurrently. 0 for no limit other than concurrent_members. */
 } conf_struct;
 
+/** Checkpoints of a run checkpoint_struct. */
+typedef struct {
+  char *run_dir; /**< Run directory, NULL when checkpoints are disabled. */
+  char *dir; /**< Checkpoint directory in the run directory, NULL when checkpoints are disabled. */
+  int resume; /**< Resume the run from its checkpoints, skipping completed work. */
+  char hash[33]; /**< Configuration hash of the checkpoints. */
+} checkpoint_struct;
+
 /** MASTER data structure data_struct. */
 typedef struct {
   info_struct *info; /**< Information structure. */
@@ -495,6 +541,8 @@ typedef struct {
   learning_struct *learning; /**< Learning data structure. */
   reg_struct *reg; /**< Regression structure. */
   mask_struct *secondary_mask; /**< Secondary large-scale mask. */
+  arena_struct **arena; /**< Memory arenas, one for each run phase. */
+  checkpoint_struct *checkpoint; /**< Checkpoints of the run. */
 } data_struct;
 
 /* Prototypes */
@@ -506,6 +554,21 @@ int read_large_scale_eof(data_struct *data);
 int read_learning_obs_eof(data_struct *data);
 int read_learning_rea_eof(data_struct *data);
 int read_learning_fields(data_struct *data);
+int learning_cache_lookup(data_struct *data);
+int learning_cache_store(data_struct *data);
+int learning_cache_use_entry(data_struct *data, char *dir, char *entry);
+int learning_cache_save_entry(data_struct *data, char *dir, char *entry);
+int checkpoint_init(data_struct *data);
+char *checkpoint_analog_filename(data_struct *data, int cat);
+int checkpoint_analog_resume(data_struct *data);
+int checkpoint_analog_save(data_struct *data, int cat, analog_day_struct analog_days, double *delta, double **delta_dayschoice,
+                           double *dist, int *cluster, double *time_ls);
+int checkpoint_learning_lookup(data_struct *data);
+int checkpoint_learning_save(data_struct *data);
+char *checkpoint_output_prefix(data_struct *data, int cat);
+int checkpoint_output_done(char *prefix, int year);
+int checkpoint_output_year(char *prefix, int year);
+int ensemble_downscaling(data_struct *data);
 int read_obs_period(double **buffer, double **lon, double **lat, double *missing_value, data_struct *data, char *varname,
                     int *year, int *month, int *day, int *nlon, int *nlat, int ntime);
 int read_field_subdomain_period(double **buffer, double **lon, double **lat, double *missing_value, char *varname,
@@ -523,6 +586,8 @@ int find_the_days(analog_day_struct analog_days, double *precip_index, double *p
                   int sup_choice, int sup_cov, int use_downscaled_year, int only_wt, int nlon, int nlat, int sup_nlon, int sup_nlat);
 void compute_secondary_large_scale_diff(double *delta, double **delta_dayschoice, analog_day_struct analog_days, double *sup_field_index,
                                         double *sup_field_index_learn, double sup_field_var, double sup_field_var_learn, int ntimes);
+void alloc_dayschoice(analog_day_struct *analog_days, int ntime, int ndayschoices);
+void free_dayschoice(analog_day_struct *analog_days);
 int merge_seasons(analog_day_struct analog_days_merged, analog_day_struct analog_days, int *merged_itimes, int ntimes_merged, int ntimes);
 int merge_seasonal_data(double *buf_merged, double *buf, analog_day_struct analog_days, int *merged_itimes, int dimx, int dimy,
                         int ntimes_merged, int ntimes);
@@ -533,7 +598,7 @@ int merge_seasonal_data_2d(double **buf_merged, double **buf, analog_day_struct
 int output_downscaled_analog(analog_day_struct analog_days, double *delta, int output_month_begin, char *output_path,
                              char *config, char *time_units, char *cal_type, double deltat,
                              int file_format, int file_compression, int file_compression_level,
-                             int debug,
+                             int debug, int nthreads, int pipeline, char *checkpoint_prefix, int resume,
                              info_struct *info, var_struct *obs_var, period_struct *period,
                              double *time_ls, int ntime);
 int write_learning_fields(data_struct *data);
@@ -0,0 +1,302 @@
+/* ***************************************************** */
+/* Downscale ensemble members with the same              */
+/* learning.                                             */
+/* ensemble_downscaling.c                                */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file ensemble_downscaling.c
+    \brief Downscale ensemble members with the same learning.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <dsclim.h>
+
+/** Replace every occurrence of the member token in a string by the member name. */
+static char *
+ensemble_substitute(arena_struct *arena, char *str, char *member) {
+  /**
+     @param[in]  arena   Arena in which the new string is allocated.
+     @param[in]  str     String, possibly NULL.
+     @param[in]  member  Member name.
+
+     \return             New string, or str itself when it does not contain the member token.
+  */
+
+  char *newstr = NULL; /* New string */
+  char *pos = NULL; /* Position of the token in str */
+  char *from = NULL; /* Current position in str */
+  size_t ntokens = 0; /* Number of tokens in str */
+  size_t toklen = strlen(ENSEMBLE_MEMBER_TOKEN); /* Token length */
+
+  if (str == NULL)
+    return NULL;
+  for (pos=strstr(str, ENSEMBLE_MEMBER_TOKEN); pos != NULL; pos=strstr(pos+toklen, ENSEMBLE_MEMBER_TOKEN))
+    ntokens++;
+  if (ntokens == 0)
+    return str;
+
+  newstr = (char *) arena_alloc(arena, (strlen(str) + ntokens * strlen(member) + 1) * sizeof(char));
+  if (newstr == NULL) alloc_error(__FILE__, __LINE__);
+  newstr[0] = '\0';
+  from = str;
+  for (pos=strstr(from, ENSEMBLE_MEMBER_TOKEN); pos != NULL; pos=strstr(from, ENSEMBLE_MEMBER_TOKEN)) {
+    (void) strncat(newstr, from, (size_t) (pos - from));
+    (void) strcat(newstr, member);
+    from = pos + toklen;
+  }
+  (void) strcat(newstr, from);
+
+  return newstr;
+}
+
+/** Set the input and output filenames of an ensemble member from the configured filenames. */
+static void
+ensemble_member_setup(data_struct *data, char *member) {
+  /**
+     @param[in]  data    MASTER data structure.
+     @param[in]  member  Member name.
+  */
+
+  arena_struct *arena = data->arena[PHASE_CONF]; /* Configuration arena */
+  int cat; /* Loop counter for field categories */
+  int i; /* Loop counter for large-scale fields */
+
+  for (cat=0; cat<NCAT; cat++)
+    for (i=0; i<data->field[cat].n_ls; i++) {
+      data->field[cat].data[i].filename_ls = ensemble_substitute(arena, data->field[cat].data[i].filename_ls, member);
+      if (data->field[cat].data[i].clim_info->clim_provided == TRUE)
+        data->field[cat].data[i].clim_info->clim_filein_ls =
+          ensemble_substitute(arena, data->field[cat].data[i].clim_info->clim_filein_ls, member);
+      if (data->field[cat].data[i].clim_info->clim_save == TRUE)
+        data->field[cat].data[i].clim_info->clim_fileout_ls =
+          ensemble_substitute(arena, data->field[cat].data[i].clim_info->clim_fileout_ls, member);
+      if (data->field[cat].data[i].eof_info->eof_project == TRUE)
+        data->field[cat].data[i].eof_info->eof_filein_ls =
+          ensemble_substitute(arena, data->field[cat].data[i].eof_info->eof_filein_ls, member);
+    }
+
+  data->conf->output_path = ensemble_substitute(arena, data->conf->output_path, member);
+  if (data->conf->analog_save == TRUE || data->conf->output_only == TRUE) {
+    if (data->conf->period_ctrl->downscale == TRUE)
+      data->conf->analog_file_ctrl = ensemble_substitute(arena, data->conf->analog_file_ctrl, member);
+    data->conf->analog_file_other = ensemble_substitute(arena, data->conf->analog_file_other, member);
+  }
+  if (data->reg->reg_save == TRUE) {
+    data->reg->filename_save_ctrl_reg = ensemble_substitute(arena, data->reg->filename_save_ctrl_reg, member);
+    data->reg->filename_save_other_reg = ensemble_substitute(arena, data->reg->filename_save_other_reg, member);
+  }
+
+  (void) printf("\n**** ENSEMBLE MEMBER %s ****\n\n", member);
+}
+
+#ifdef HAVE_SYS_WAIT_H
+/** Number of ensemble members which can be downscaled at the same time. */
+static int
+ensemble_slots(data_struct *data, size_t peak_rss) {
+  /**
+     @param[in]  data      MASTER data structure.
+     @param[in]  peak_rss  Largest peak resident memory of the members already downscaled, 0 if none yet.
+
+     \return               Number of members.
+  */
+
+  int nslots = data->conf->concurrent_members; /* Number of members */
+  size_t budget; /* Memory budget in bytes */
+
+  if (data->conf->members_memory > 0 && nslots > 1) {
+    /* Downscale a first member alone to measure its memory */
+    if (peak_rss == 0)
+      return 1;
+    budget = (size_t) data->conf->members_memory * 1024 * 1024;
+    if (budget / peak_rss < (size_t) nslots)
+      nslots = (int) (budget / peak_rss);
+    if (nslots < 1)
+      nslots = 1;
+  }
+
+  return nslots;
+}
+
+/** Wait for one ensemble member downscaled in a child process. */
+static int
+ensemble_wait(data_struct *data, pid_t *pids, size_t *peak_rss) {
+  /**
+     @param[in]      data      MASTER data structure.
+     @param[in,out]  pids      Process ID of each member downscaled in a child process, 0 when not running.
+     @param[in,out]  peak_rss  Largest peak resident memory of the members already downscaled.
+
+     \return                   0 if the member was downscaled, -1 on error.
+  */
+
+  struct rusage usage; /* Resources used by the child process */
+  size_t rss; /* Peak resident memory of the child process */
+  pid_t pid; /* Child process ID */
+  int status; /* Child process status */
+  int m; /* Loop counter for members */
+
+  /* Other child processes may exist: keep waiting until one of the members is reaped */
+  m = data->conf->nmembers;
+  while (m == data->conf->nmembers) {
+    do
+      pid = wait4((pid_t) -1, &status, 0, &usage);
+    while (pid == (pid_t) -1 && errno == EINTR);
+    if (pid == (pid_t) -1) {
+      (void) fprintf(stderr, "%s: Error waiting for ensemble members: %s\n", __FILE__, strerror(errno));
+      return -1;
+    }
+    for (m=0; m<data->conf->nmembers; m++)
+      if (pids[m] != 0 && pids[m] == pid)
+        break;
+  }
+  pids[m] = 0;
+
+  /* ru_maxrss is in kilobytes */
+  rss = (size_t) usage.ru_maxrss * 1024;
+  if (rss > *peak_rss)
+    *peak_rss = rss;
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    (void) fprintf(stderr, "%s: Error in downscaling ensemble member %s.\n", __FILE__, data->conf->members[m]);
+    return -1;
+  }
+  (void) printf("%s: Ensemble member %s downscaled, peak memory %.1f MiB.\n", __FILE__, data->conf->members[m],
+                (double) rss / 1048576.0);
+
+  return 0;
+}
+#endif
+
+/** Downscale all ensemble members with the learning data already computed or read.
+    Each member but the last is downscaled in a child process sharing the learning data and observation metadata of this process,
+    at most concurrent_members at the same time and within the members memory budget. The last member is downscaled in this process. */
+int
+ensemble_downscaling(data_struct *data) {
+  /**
+     @param[in]  data  MASTER data structure.
+
+     \return           Status.
+  */
+
+  int nmembers = data->conf->nmembers; /* Number of members */
+  int istat = 0; /* Diagnostic status */
+  int nfailed = 0; /* Number of members which failed */
+
+#ifdef HAVE_SYS_WAIT_H
+  pid_t *pids = NULL; /* Process ID of each member downscaled in a child process */
+  pid_t pid; /* Child process ID */
+  size_t peak_rss = 0; /* Largest peak resident memory of the members already downscaled */
+  int nrunning = 0; /* Number of child processes running */
+  int m; /* Loop counter for members */
+
+  pids = (pid_t *) calloc((size_t) nmembers, sizeof(pid_t));
+  if (pids == NULL) alloc_error(__FILE__, __LINE__);
+
+  for (m=0; m<nmembers-1; m++) {
+    /* Wait for a free slot */
+    while (nrunning > 0 && nrunning >= ensemble_slots(data, peak_rss)) {
+      if (ensemble_wait(data, pids, &peak_rss) != 0)
+        nfailed++;
+      nrunning--;
+    }
+
+    /* Buffered output would otherwise be written by both processes */
+    (void) fflush(NULL);
+    pid = fork();
+    if (pid == 0) {
+      /* Child process: downscale this member and exit without running the exit handlers of the parent */
+      (void) instrument_detach();
+      (void) ensemble_member_setup(data, data->conf->members[m]);
+      istat = wt_downscaling(data);
+      (void) fflush(NULL);
+      (void) _exit((istat == 0) ? 0 : 1);
+    }
+    else if (pid == (pid_t) -1) {
+      (void) fprintf(stderr, "%s: Cannot start downscaling of ensemble member %s: %s\n", __FILE__, data->conf->members[m], strerror(errno));
+      nfailed++;
+    }
+    else {
+      pids[m] = pid;
+      nrunning++;
+    }
+  }
+
+  /* This process counts as one slot for the last member */
+  while (nrunning > 0 && nrunning >= ensemble_slots(data, peak_rss)) {
+    if (ensemble_wait(data, pids, &peak_rss) != 0)
+      nfailed++;
+    nrunning--;
+  }
+#else
+  if (nmembers > 1) {
+    (void) fprintf(stderr, "%s: Ensemble batch mode with more than one member is not supported on this system.\n", __FILE__);
+    return -1;
+  }
+#endif
+
+  (void) ensemble_member_setup(data, data->conf->members[nmembers-1]);
+  istat = wt_downscaling(data);
+  if (istat != 0) {
+    (void) fprintf(stderr, "%s: Error in downscaling ensemble member %s.\n", __FILE__, data->conf->members[nmembers-1]);
+    nfailed++;
+  }
+
+#ifdef HAVE_SYS_WAIT_H
+  /* Wait for the remaining members */
+  while (nrunning > 0) {
+    if (ensemble_wait(data, pids, &peak_rss) != 0)
+      nfailed++;
+    nrunning--;
+  }
+  (void) free(pids);
+#endif
+
+  if (nfailed > 0) {
+    (void) fprintf(stderr, "%s: %d of %d ensemble members failed.\n", __FILE__, nfailed, nmembers);
+    return -1;
+  }
+
+  return 0;
+}
@@ -136,13 +136,15 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
   int min_metric_index; /* Index of minimum metric */
   int max_metric_index; /* Index of maximum metric */
   int *clust_diff = NULL; /* Cluster number differences between cluster of learning day and cluster of day being downscaled */
+  double *sup_anom = NULL; /* Masked spatial anomalies of secondary large-scale field of days to downscale */
+  double *sup_anom_learn = NULL; /* Masked spatial anomalies of secondary large-scale field of learning period */
+  int sup_npts = 0; /* Number of valid points of secondary large-scale field anomalies */
 
   int ntime_days; /* Number of days in learning period within the +-ndays of downscaled day of year */
   int *ntime_days_learn = NULL; /* Time index of the learning subperiod corresponding to all valid days within the +-ndays of downscaled day of year */
 
   int ii; /* Loop counter */
   int t; /* Time loop counter */
-  int tt; /* Time loop counter */
   int tl; /* Time loop counter */
   int pts; /* Regression points loop counter */
 
@@ -151,11 +153,18 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
   int istat; /* Return status of functions */
   double timei; /* udunits Time value */
 
+  if ((sup_choice == TRUE || sup == TRUE) && sup_cov == TRUE && (nlon != sup_nlon || nlat != sup_nlat)) {
+    (void) fprintf(stderr, "%s: Dimensions of downscaled large-scale secondary field (nlat=%d nlon=%d) are not the same as the learning field (nlat=%d nlon=%d. Cannot proceed...\n", __FILE__, nlat, nlon, sup_nlat, sup_nlon);
+    return -1;
+  }
+
   /* Initialize udunits */
+  (void) udunits_lock();
   ut_set_error_message_handler(ut_ignore);
   unitSystem = ut_read_xml(NULL);
   ut_set_error_message_handler(ut_write_to_stderr);
   dataunits = ut_parse(unitSystem, time_units, UT_ASCII);
+  (void) udunits_unlock();
 
   /* Initialize random number generator if needed */
   if (shuffle == TRUE) {
@@ -174,23 +183,45 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
   if (metric_index == NULL) alloc_error(__FILE__, __LINE__);
 
   /* Select correct months for the current season in the time vectors of the downscaled and learning period */
-  ntime_sub = 0;
-  for (t=0; t<ntime; t++)
-    for (tt=0; tt<nmonths; tt++)
-      if (month[t] == months[tt]) {
-        buf_sub_i = (int *) realloc(buf_sub_i, (ntime_sub+1) * sizeof(int));
-        if (buf_sub_i == NULL) alloc_error(__FILE__, __LINE__);
-        buf_sub_i[ntime_sub++] = t;
-      }
-
-  ntime_learn_sub = 0;
-  for (t=0; t<ntime_learn; t++)
-    for (tt=0; tt<nmonths; tt++)
-      if (month_learn[t] == months[tt]) {
-        buf_learn_sub_i = (int *) realloc(buf_learn_sub_i, (ntime_learn_sub+1) * sizeof(int));
-        if (buf_learn_sub_i == NULL) alloc_error(__FILE__, __LINE__);
-        buf_learn_sub_i[ntime_learn_sub++] = t;
-      }
+  buf_sub_i = (int *) malloc((ntime > 0 ? ntime : 1) * sizeof(int));
+  if (buf_sub_i == NULL) alloc_error(__FILE__, __LINE__);
+  ntime_sub = select_months_index(buf_sub_i, month, months, (double *) NULL, 0.0, 0.0, ntime, nmonths);
+
+  buf_learn_sub_i = (int *) malloc((ntime_learn > 0 ? ntime_learn : 1) * sizeof(int));
+  if (buf_learn_sub_i == NULL) alloc_error(__FILE__, __LINE__);
+  ntime_learn_sub = select_months_index(buf_learn_sub_i, month_learn, months, (double *) NULL, 0.0, 0.0, ntime_learn, nmonths);
+
+  /* Allocate memory for metrics of days within the day of year range: at most all the learning subperiod */
+  metric = (double *) malloc((ntime_learn_sub > 0 ? ntime_learn_sub : 1) * sizeof(double));
+  if (metric == NULL) alloc_error(__FILE__, __LINE__);
+  metric_norm = (double *) malloc((ntime_learn_sub > 0 ? ntime_learn_sub : 1) * sizeof(double));
+  if (metric_norm == NULL) alloc_error(__FILE__, __LINE__);
+  if (sup_choice == TRUE || sup == TRUE) {
+    metric_sup = (double *) malloc((ntime_learn_sub > 0 ? ntime_learn_sub : 1) * sizeof(double));
+    if (metric_sup == NULL) alloc_error(__FILE__, __LINE__);
+    metric_sup_norm = (double *) malloc((ntime_learn_sub > 0 ? ntime_learn_sub : 1) * sizeof(double));
+    if (metric_sup_norm == NULL) alloc_error(__FILE__, __LINE__);
+  }
+  if ((sup_choice == TRUE || sup == TRUE) && sup_cov == TRUE) {
+    /* Compute once the masked spatial anomalies of each day of the secondary large-scale fields, */
+    /* so that the covariance of each pair of days is a single dot product */
+    if (mask == NULL)
+      sup_npts = sup_nlon * sup_nlat;
+    else
+      for (pts=0; pts<sup_nlon*sup_nlat; pts++)
+        if (mask[pts] == 1)
+          sup_npts++;
+    sup_anom = (double *) malloc((size_t) sup_npts * (size_t) (ntime_sub > 0 ? ntime_sub : 1) * sizeof(double));
+    if (sup_anom == NULL) alloc_error(__FILE__, __LINE__);
+    sup_anom_learn = (double *) malloc((size_t) sup_npts * (size_t) (ntime_learn_sub > 0 ? ntime_learn_sub : 1) * sizeof(double));
+    if (sup_anom_learn == NULL) alloc_error(__FILE__, __LINE__);
+    (void) anomaly_fields_spatial(sup_anom, sup_field, mask, sup_nlon, sup_nlat, ntime_sub);
+    (void) anomaly_fields_spatial(sup_anom_learn, sup_field_learn, mask, sup_nlon, sup_nlat, ntime_learn_sub);
+  }
+  clust_diff = (int *) malloc((ntime_learn_sub > 0 ? ntime_learn_sub : 1) * sizeof(int));
+  if (clust_diff == NULL) alloc_error(__FILE__, __LINE__);
+  ntime_days_learn = (int *) malloc((ntime_learn_sub > 0 ? ntime_learn_sub : 1) * sizeof(int));
+  if (ntime_days_learn == NULL) alloc_error(__FILE__, __LINE__);
 
   /* Process each downscaled day */
   for (t=0; t<ntime_sub; t++) {
@@ -220,12 +251,6 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
         /* We are within the day of year range */
         if (diff_day_learn <= ndays) {
         
-          /* Allocate memory */
-          metric = (double *) realloc(metric, (ntime_days+1) * sizeof(double));
-          if (metric == NULL) alloc_error(__FILE__, __LINE__);
-          metric_norm = (double *) realloc(metric_norm, (ntime_days+1) * sizeof(double));
-          if (metric_norm == NULL) alloc_error(__FILE__, __LINE__);
-
           /* Compute precipitation index difference and precipitation index metric */
           precip_diff = 0.0;
           for (pts=0; pts<npts; pts++) {
@@ -254,24 +279,14 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
 
           /* If we want to also use the secondary large-scale fields in the first selection of days */
           if (sup_choice == TRUE || sup == TRUE) {
-            /* Allocate memory */
-            metric_sup = (double *) realloc(metric_sup, (ntime_days+1) * sizeof(double));
-            if (metric_sup == NULL) alloc_error(__FILE__, __LINE__);
-            metric_sup_norm = (double *) realloc(metric_sup_norm, (ntime_days+1) * sizeof(double));
-            if (metric_sup_norm == NULL) alloc_error(__FILE__, __LINE__);
-
             if (sup_cov != TRUE) {
               /* Compute supplemental field index difference */
               sup_diff = sup_field_index[t] - sup_field_index_learn[buf_learn_sub_i[tl]];
               metric_sup[ntime_days] = sqrt(sup_diff * sup_diff);
             }
             else {
-              /* Compute covariance of supplemental field */
-              if (nlon != sup_nlon || nlat != sup_nlat) {
-                (void) fprintf(stderr, "%s: Dimensions of downscaled large-scale secondary field (nlat=%d nlon=%d) are not the same as the learning field (nlat=%d nlon=%d. Cannot proceed...\n", __FILE__, nlat, nlon, sup_nlat, sup_nlon);
-                return -1;
-              }
-              (void) covariance_fields_spatial(&sup_diff, sup_field, sup_field_learn, mask, t, tl, sup_nlon, sup_nlat);
+              /* Compute covariance of supplemental field using precomputed spatial anomalies */
+              sup_diff = covariance_anomalies_spatial(sup_anom, sup_anom_learn, t, tl, sup_npts);
               metric_sup[ntime_days] = sqrt(sup_diff * sup_diff);
             }
             /* Store the maximum value and its index */
@@ -286,15 +301,9 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
           }
 
           /* Compute cluster difference */
-          clust_diff = (int *) realloc(clust_diff, (ntime_days+1) * sizeof(int));
-          if (clust_diff == NULL) alloc_error(__FILE__, __LINE__);
-
           clust_diff[ntime_days] = class_clusters_learn[tl] - class_clusters[t];
 
           /* Store the index in the time vector of the selected day */
-          ntime_days_learn = (int *) realloc(ntime_days_learn, (ntime_days+1) * sizeof(int));
-          if (ntime_days_learn == NULL) alloc_error(__FILE__, __LINE__);
-
           ntime_days_learn[ntime_days] = buf_learn_sub_i[tl];
 
           /*        
@@ -394,7 +403,9 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
         analog_days.month[t] = month_learn[analog_days.tindex[t]];
         analog_days.day[t] = day_learn[analog_days.tindex[t]];
         analog_days.tindex_all[t] = buf_learn_sub_i[analog_days.tindex[t]];
+        (void) udunits_lock();
         istat = utInvCalendar2(analog_days.year[t], analog_days.month[t], analog_days.day[t], 0, 0, 0.0, dataunits, &timei);
+        (void) udunits_unlock();
         analog_days.time[t] = (int) timei;
 
         /* Save date of day being downscaled */
@@ -403,13 +414,7 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
         analog_days.day_s[t] = day[buf_sub_i[t]];
         analog_days.tindex_s_all[t] = buf_sub_i[t];
 
-        /* Save all analog days in special time structure */
-        analog_days.analog_dayschoice[t] = (tstruct *) malloc(ndayschoices * sizeof(tstruct));
-        if (analog_days.analog_dayschoice[t] == NULL) alloc_error(__FILE__, __LINE__);
-        analog_days.metric_norm[t] = (float *) malloc(ndayschoices * sizeof(float));
-        if (analog_days.metric_norm[t] == NULL) alloc_error(__FILE__, __LINE__);
-        analog_days.tindex_dayschoice[t] = (int *) malloc(ndayschoices * sizeof(int));
-        if (analog_days.tindex_dayschoice[t] == NULL) alloc_error(__FILE__, __LINE__);
+        /* Save all analog days in special time structure (rows preallocated with alloc_dayschoice) */
         for (ii=0; ii<ndayschoices; ii++) {
           analog_days.metric_norm[t][ii] = metric_norm[metric_index[ii]];
           analog_days.tindex_dayschoice[t][ii] = ntime_days_learn[metric_index[ii]];
@@ -463,7 +468,9 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
         analog_days.month[t] = month_learn[analog_days.tindex[t]];
         analog_days.day[t] = day_learn[analog_days.tindex[t]];
         analog_days.tindex_all[t] = buf_learn_sub_i[analog_days.tindex[t]];
+        (void) udunits_lock();
         istat = utInvCalendar2(analog_days.year[t], analog_days.month[t], analog_days.day[t], 0, 0, 0.0, dataunits, &timei);
+        (void) udunits_unlock();
         analog_days.time[t] = (int) timei;
 
         /* Save date of day being downscaled */
@@ -472,13 +479,7 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
         analog_days.day_s[t] = day[buf_sub_i[t]];
         analog_days.tindex_s_all[t] = buf_sub_i[t];
 
-        /* Save all analog days in special time structure */
-        analog_days.analog_dayschoice[t] = (tstruct *) malloc(ndayschoices * sizeof(tstruct));
-        if (analog_days.analog_dayschoice[t] == NULL) alloc_error(__FILE__, __LINE__);
-        analog_days.metric_norm[t] = (float *) malloc(ndayschoices * sizeof(float));
-        if (analog_days.metric_norm[t] == NULL) alloc_error(__FILE__, __LINE__);
-        analog_days.tindex_dayschoice[t] = (int *) malloc(ndayschoices * sizeof(int));
-        if (analog_days.tindex_dayschoice[t] == NULL) alloc_error(__FILE__, __LINE__);
+        /* Save all analog days in special time structure (rows preallocated with alloc_dayschoice) */
         for (ii=0; ii<ndayschoices; ii++) {
           analog_days.metric_norm[t][ii] = metric_norm[metric_index[ii]];
           analog_days.tindex_dayschoice[t][ii] = ntime_days_learn[metric_index[ii]];
@@ -490,22 +491,6 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
           analog_days.analog_dayschoice[t][ii].sec = 0;
         }
       }
-      
-      /* Free memory */
-      (void) free(metric);
-      (void) free(metric_norm);
-      metric = NULL;
-      metric_norm = NULL;
-      if (sup_choice == TRUE || sup == TRUE) {
-        (void) free(metric_sup);
-        metric_sup = NULL;
-        (void) free(metric_sup_norm);
-        metric_sup_norm = NULL;
-      }
-      (void) free(clust_diff);
-      clust_diff = NULL;
-      (void) free(ntime_days_learn);
-      ntime_days_learn = NULL;
     }
         if (year[buf_sub_i[t]] == 1999 && month[buf_sub_i[t]] == 5)
           if (month[buf_sub_i[t]] == 3 || month[buf_sub_i[t]] == 4 || month[buf_sub_i[t]] == 5)
@@ -524,8 +509,23 @@ find_the_days(analog_day_struct analog_days, double *precip_index, double *preci
   (void) free(buf_sub_i);
   (void) free(buf_learn_sub_i);
 
+  (void) free(metric);
+  (void) free(metric_norm);
+  if (metric_sup != NULL) {
+    (void) free(metric_sup);
+    (void) free(metric_sup_norm);
+  }
+  (void) free(clust_diff);
+  (void) free(ntime_days_learn);
+  if (sup_anom != NULL) {
+    (void) free(sup_anom);
+    (void) free(sup_anom_learn);
+  }
+
+  (void) udunits_lock();
   (void) ut_free(dataunits);
   (void) ut_free_system(unitSystem);  
+  (void) udunits_unlock();
       
   return 0;
 }
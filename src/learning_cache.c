@@ -0,0 +1,376 @@
+/* ***************************************************** */
+/* Cache of learning data keyed by a fingerprint         */
+/* of the learning inputs.                               */
+/* learning_cache.c                                      */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file learning_cache.c
+    \brief Cache of learning data keyed by a fingerprint of the learning inputs.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <dsclim.h>
+
+/** Version of the layout of cached learning data. Increase it when the learning algorithm or the learning files change. */
+#define LEARNING_CACHE_VERSION "dsclim-learning-cache-1"
+/** Maximum size of input files fingerprinted by their whole content. */
+#define LEARNING_CACHE_MAXCONTENT (16*1024*1024)
+
+/** Compute the fingerprint of everything the learning depends on. */
+static int
+learning_cache_fingerprint(data_struct *data, fingerprint_struct *fp) {
+  /**
+     @param[in]   data  MASTER data structure.
+     @param[out]  fp    Fingerprint.
+
+     \return            0 on success, -1 if an input file cannot be read.
+  */
+
+  learning_struct *learning = data->learning; /* Learning data structure */
+  conf_struct *conf = data->conf; /* Configuration structure */
+  var_struct *obs_var = data->conf->obs_var; /* Observation variables */
+  char *dirname = NULL; /* Observation data directory */
+  double bounds[12]; /* Domain bounds */
+  int ivals[8]; /* Integer parameters */
+  int s; /* Loop counter over seasons */
+  int i; /* Loop counter */
+
+  (void) fingerprint_init(fp);
+  (void) fingerprint_add_str(fp, LEARNING_CACHE_VERSION);
+  (void) fingerprint_add_str(fp, PACKAGE_VERSION);
+
+  /* Pre-computed EOF and secondary large-scale field files */
+  if (fingerprint_add_file(fp, learning->rea->filename_eof, LEARNING_CACHE_MAXCONTENT) != 0 ||
+      fingerprint_add_file(fp, learning->obs->filename_eof, LEARNING_CACHE_MAXCONTENT) != 0 ||
+      fingerprint_add_file(fp, learning->filename_rea_sup, LEARNING_CACHE_MAXCONTENT) != 0)
+    return -1;
+  (void) fingerprint_add_str(fp, learning->rea->nomvar_eof);
+  (void) fingerprint_add_str(fp, learning->rea->nomvar_sing);
+  (void) fingerprint_add_str(fp, learning->obs->nomvar_eof);
+  (void) fingerprint_add_str(fp, learning->obs->nomvar_sing);
+  (void) fingerprint_add_str(fp, learning->nomvar_rea_sup);
+
+  /* Observation database: files are identified by name, size and modification time */
+  dirname = (char *) malloc((strlen(obs_var->path) + strlen(obs_var->frequency) + 2) * sizeof(char));
+  if (dirname == NULL) alloc_error(__FILE__, __LINE__);
+  (void) sprintf(dirname, "%s/%s", obs_var->path, obs_var->frequency);
+  if (fingerprint_add_dir(fp, dirname, (size_t) 0) != 0) {
+    (void) free(dirname);
+    return -1;
+  }
+  (void) free(dirname);
+  (void) fingerprint_add_str(fp, obs_var->template);
+  for (i=0; i<obs_var->nobs_var; i++) {
+    (void) fingerprint_add_str(fp, obs_var->acronym[i]);
+    (void) fingerprint_add_str(fp, obs_var->netcdfname[i]);
+    (void) fingerprint_add(fp, &(obs_var->factor[i]), sizeof(double));
+    (void) fingerprint_add(fp, &(obs_var->delta[i]), sizeof(double));
+  }
+  ivals[0] = obs_var->month_begin;
+  ivals[1] = obs_var->year_digits;
+
+  /* Regression points */
+  ivals[2] = data->reg->npts;
+  (void) fingerprint_add(fp, data->reg->lon, (size_t) data->reg->npts * sizeof(double));
+  (void) fingerprint_add(fp, data->reg->lat, (size_t) data->reg->npts * sizeof(double));
+  (void) fingerprint_add(fp, &(data->reg->dist), sizeof(double));
+
+  /* Classification parameters */
+  ivals[3] = conf->nclassifications;
+  ivals[4] = conf->npartitions;
+  ivals[5] = learning->rea_neof;
+  ivals[6] = learning->obs_neof;
+  ivals[7] = conf->nseasons;
+  (void) fingerprint_add(fp, ivals, sizeof(ivals));
+  (void) fingerprint_add_str(fp, conf->classif_type);
+
+  /* Seasons */
+  for (s=0; s<conf->nseasons; s++) {
+    ivals[0] = conf->season[s].nmonths;
+    ivals[1] = conf->season[s].nclusters;
+    ivals[2] = conf->season[s].nreg;
+    (void) fingerprint_add(fp, ivals, (size_t) 3 * sizeof(int));
+    (void) fingerprint_add(fp, conf->season[s].month, (size_t) conf->season[s].nmonths * sizeof(int));
+  }
+
+  /* Learning and secondary masks and domains */
+  bounds[0] = conf->learning_mask_longitude_min;
+  bounds[1] = conf->learning_mask_longitude_max;
+  bounds[2] = conf->learning_mask_latitude_min;
+  bounds[3] = conf->learning_mask_latitude_max;
+  bounds[4] = conf->secondary_longitude_min;
+  bounds[5] = conf->secondary_longitude_max;
+  bounds[6] = conf->secondary_latitude_min;
+  bounds[7] = conf->secondary_latitude_max;
+  bounds[8] = conf->longitude_min;
+  bounds[9] = conf->longitude_max;
+  bounds[10] = conf->latitude_min;
+  bounds[11] = conf->latitude_max;
+  (void) fingerprint_add(fp, bounds, sizeof(bounds));
+  ivals[0] = conf->learning_maskfile->use_mask;
+  ivals[1] = data->secondary_mask->use_mask;
+  (void) fingerprint_add(fp, ivals, (size_t) 2 * sizeof(int));
+  if (conf->learning_maskfile->use_mask == TRUE)
+    if (fingerprint_add_file(fp, conf->learning_maskfile->filename, LEARNING_CACHE_MAXCONTENT) != 0)
+      return -1;
+  if (data->secondary_mask->use_mask == TRUE)
+    if (fingerprint_add_file(fp, data->secondary_mask->filename, LEARNING_CACHE_MAXCONTENT) != 0)
+      return -1;
+
+  /* Time reference and names of the variables and dimensions of the learning files */
+  (void) fingerprint_add_str(fp, conf->time_units);
+  (void) fingerprint_add_str(fp, conf->cal_type);
+  (void) fingerprint_add_str(fp, conf->eofname);
+  (void) fingerprint_add_str(fp, conf->ptsname);
+  (void) fingerprint_add_str(fp, conf->clustname);
+  (void) fingerprint_add_str(fp, learning->nomvar_weight);
+  (void) fingerprint_add_str(fp, learning->nomvar_class_clusters);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_reg);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_reg_cst);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_index);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_index_obs);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_reg_dist);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_reg_rsq);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_reg_err);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_reg_acor);
+  (void) fingerprint_add_str(fp, learning->nomvar_precip_reg_vif);
+  (void) fingerprint_add_str(fp, learning->nomvar_sup_index);
+  (void) fingerprint_add_str(fp, learning->nomvar_sup_val);
+  (void) fingerprint_add_str(fp, learning->nomvar_sup_index_mean);
+  (void) fingerprint_add_str(fp, learning->nomvar_sup_index_var);
+  (void) fingerprint_add_str(fp, learning->nomvar_pc_normalized_var);
+  (void) fingerprint_add_str(fp, learning->nomvar_time);
+  (void) fingerprint_add_str(fp, learning->sup_lonname);
+  (void) fingerprint_add_str(fp, learning->sup_latname);
+
+  return 0;
+}
+
+/** Build the name of a file of a cache entry. */
+static char *
+learning_cache_filename(char *cache_dir, char *entry, char *name) {
+  /**
+     @param[in]  cache_dir  Cache directory.
+     @param[in]  entry      Cache entry directory name.
+     @param[in]  name       File name in the cache entry, or NULL for the entry directory itself.
+
+     \return                Allocated filename.
+  */
+
+  char *filename = NULL; /* Filename */
+
+  filename = (char *) malloc((strlen(cache_dir) + strlen(entry) + ((name == NULL) ? 0 : strlen(name)) + 3) * sizeof(char));
+  if (filename == NULL) alloc_error(__FILE__, __LINE__);
+  if (name == NULL)
+    (void) sprintf(filename, "%s/%s", cache_dir, entry);
+  else
+    (void) sprintf(filename, "%s/%s/%s", cache_dir, entry, name);
+
+  return filename;
+}
+
+/** Use the learning files of a complete learning entry as provided learning data. */
+int
+learning_cache_use_entry(data_struct *data, char *dir, char *entry) {
+  /**
+     @param[in]  data   MASTER data structure.
+     @param[in]  dir    Directory holding the entry.
+     @param[in]  entry  Entry directory name.
+
+     \return            1 if the entry is complete and will be used, 0 otherwise.
+  */
+
+  char *filename_weight = NULL; /* Entry weight data filename */
+  char *filename_learn = NULL; /* Entry learning data filename */
+  char *filename_clust_learn = NULL; /* Entry clusters learning data filename */
+  struct stat st; /* File status */
+  int hit; /* If the entry is complete */
+
+  filename_weight = learning_cache_filename(dir, entry, "weight.nc");
+  filename_learn = learning_cache_filename(dir, entry, "learn.nc");
+  filename_clust_learn = learning_cache_filename(dir, entry, "clust_learn.nc");
+
+  hit = (stat(filename_weight, &st) == 0 && stat(filename_learn, &st) == 0 && stat(filename_clust_learn, &st) == 0);
+  if (hit) {
+    data->learning->filename_open_weight = arena_strdup(data->arena[PHASE_CONF], filename_weight);
+    data->learning->filename_open_learn = arena_strdup(data->arena[PHASE_CONF], filename_learn);
+    data->learning->filename_open_clust_learn = arena_strdup(data->arena[PHASE_CONF], filename_clust_learn);
+
+    /* Learning data is now provided: release what was only needed to compute it */
+    (void) free(data->learning->obs->time_s);
+    (void) free(data->learning->rea->time_s);
+    (void) free(data->learning->obs);
+    (void) free(data->learning->rea);
+    data->learning->obs = NULL;
+    data->learning->rea = NULL;
+    data->learning->learning_provided = TRUE;
+  }
+
+  (void) free(filename_weight);
+  (void) free(filename_learn);
+  (void) free(filename_clust_learn);
+
+  return hit;
+}
+
+/** Save computed learning data as a learning entry. The entry is written in a temporary directory
+    which is then renamed, so that concurrent runs never read a partial entry. */
+int
+learning_cache_save_entry(data_struct *data, char *dir, char *entry) {
+  /**
+     @param[in]  data   MASTER data structure.
+     @param[in]  dir    Directory holding the entry.
+     @param[in]  entry  Entry directory name.
+
+     \return            Status.
+  */
+
+  learning_struct *learning = data->learning; /* Learning data structure */
+  char *save_weight = NULL; /* Configured weight data filename */
+  char *save_learn = NULL; /* Configured learning data filename */
+  char *save_clust_learn = NULL; /* Configured clusters learning data filename */
+  char *tmpentry = NULL; /* Temporary entry name */
+  char *tmpdir = NULL; /* Temporary entry directory */
+  char *entrydir = NULL; /* Entry directory */
+  int istat; /* Diagnostic status */
+
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+    (void) fprintf(stderr, "%s: WARNING: Cannot create learning directory %s: %s\n", __FILE__, dir, strerror(errno));
+    return -1;
+  }
+
+  tmpentry = (char *) malloc((strlen(entry) + 32) * sizeof(char));
+  if (tmpentry == NULL) alloc_error(__FILE__, __LINE__);
+  (void) sprintf(tmpentry, "%s.tmp.%ld", entry, (long) getpid());
+  tmpdir = learning_cache_filename(dir, tmpentry, NULL);
+  entrydir = learning_cache_filename(dir, entry, NULL);
+  if (mkdir(tmpdir, 0755) != 0) {
+    (void) fprintf(stderr, "%s: WARNING: Cannot create learning entry %s: %s\n", __FILE__, tmpdir, strerror(errno));
+    (void) free(tmpentry);
+    (void) free(tmpdir);
+    (void) free(entrydir);
+    return -1;
+  }
+
+  /* Write learning files in the temporary entry */
+  save_weight = learning->filename_save_weight;
+  save_learn = learning->filename_save_learn;
+  save_clust_learn = learning->filename_save_clust_learn;
+  learning->filename_save_weight = learning_cache_filename(dir, tmpentry, "weight.nc");
+  learning->filename_save_learn = learning_cache_filename(dir, tmpentry, "learn.nc");
+  learning->filename_save_clust_learn = learning_cache_filename(dir, tmpentry, "clust_learn.nc");
+
+  istat = write_learning_fields(data);
+
+  /* Publish the entry, unless another run already did */
+  if (istat == 0 && rename(tmpdir, entrydir) == 0)
+    (void) printf("%s: Stored learning data in %s.\n", __FILE__, entrydir);
+  else {
+    if (istat == 0 && errno != EEXIST && errno != ENOTEMPTY)
+      (void) fprintf(stderr, "%s: WARNING: Cannot publish learning entry %s: %s\n", __FILE__, entrydir, strerror(errno));
+    (void) unlink(learning->filename_save_weight);
+    (void) unlink(learning->filename_save_learn);
+    (void) unlink(learning->filename_save_clust_learn);
+    (void) rmdir(tmpdir);
+  }
+
+  (void) free(learning->filename_save_weight);
+  (void) free(learning->filename_save_learn);
+  (void) free(learning->filename_save_clust_learn);
+  learning->filename_save_weight = save_weight;
+  learning->filename_save_learn = save_learn;
+  learning->filename_save_clust_learn = save_clust_learn;
+
+  (void) free(tmpentry);
+  (void) free(tmpdir);
+  (void) free(entrydir);
+
+  return istat;
+}
+
+/** Look up learning data in the learning cache. On a hit, the learning files of the cache entry are used as provided learning data. */
+int
+learning_cache_lookup(data_struct *data) {
+  /**
+     @param[in]  data  MASTER data structure.
+
+     \return           1 if cached learning data will be used, 0 otherwise.
+  */
+
+  fingerprint_struct fp; /* Fingerprint of learning inputs */
+  char key[33]; /* Cache key */
+  int hit; /* If the cache entry is complete */
+
+  if (learning_cache_fingerprint(data, &fp) != 0) {
+    (void) fprintf(stderr, "%s: WARNING: Cannot fingerprint learning inputs. Learning cache is not used.\n", __FILE__);
+    return 0;
+  }
+  (void) fingerprint_hex(&fp, key);
+  data->learning->cache_key = arena_strdup(data->arena[PHASE_CONF], key);
+
+  hit = learning_cache_use_entry(data, data->learning->cache_dir, key);
+  if (hit)
+    (void) printf("%s: Using cached learning data %s/%s.\n", __FILE__, data->learning->cache_dir, key);
+  else
+    (void) printf("%s: No cached learning data for key %s.\n", __FILE__, key);
+
+  return hit;
+}
+
+/** Store computed learning data in the learning cache. */
+int
+learning_cache_store(data_struct *data) {
+  /**
+     @param[in]  data  MASTER data structure.
+
+     \return           Status.
+  */
+
+  if (data->learning->cache_key == NULL)
+    return 0;
+
+  return learning_cache_save_entry(data, data->learning->cache_dir, data->learning->cache_key);
+}
@@ -0,0 +1,115 @@
+/* ***************************************************** */
+/* Compute distances to clusters.                        */
+/* dist_clusters.c                                       */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file dist_clusters.c
+    \brief Compute distances to clusters.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <classif.h>
+
+/** Compute the distance matrix of normalized EOF-projected large-scale field to normalized clusters. */
+void
+dist_clusters(double *dist_pc, double *pc, double *clusters, double *var_pc, double *var_pc_norm_all,
+              int neof, int nclust, int ntime) {
+  /**
+     @param[out]  dist_pc         Distances of normalized EOF-projected large-scale field to clusters (ntime x nclust, time first)
+     @param[in]   pc              EOF-projected large-scale field
+     @param[in]   clusters        Cluster centroids for each EOF in EOF-projected space of the large-scale field
+     @param[in]   var_pc          Variance of EOF-projected large-scale field of the learning period, for each EOF separately.
+     @param[in]   var_pc_norm_all Norm of the variance of the first EOF of the EOF-projected large-scale field of the control run.
+     @param[in]   neof            EOF dimension
+     @param[in]   nclust          Clusters dimension
+     @param[in]   ntime           Time dimension
+  */
+
+  double *scale_pc = NULL; /* Inverse square root of the variance of each EOF of the large-scale field */
+  double *clusters_norm = NULL; /* Normalized cluster centroids */
+  double *pdist; /* Distances to current cluster */
+  double *ppc; /* Current EOF of the large-scale field */
+  double scale; /* Normalization of current EOF */
+  double center; /* Normalized centroid of current cluster and EOF */
+  double val; /* Normalized distance for one EOF */
+
+  int eof; /* EOF loop counter */
+  int nt; /* Time loop counter */
+  int clust; /* Cluster loop counter */
+
+  /* Precompute the normalizations, so that no square root is left in the inner loop */
+  scale_pc = (double *) malloc(neof * sizeof(double));
+  if (scale_pc == NULL) alloc_error(__FILE__, __LINE__);
+  clusters_norm = (double *) malloc(neof*nclust * sizeof(double));
+  if (clusters_norm == NULL) alloc_error(__FILE__, __LINE__);
+  for (eof=0; eof<neof; eof++) {
+    scale_pc[eof] = 1.0 / sqrt(var_pc_norm_all[eof]);
+    for (clust=0; clust<nclust; clust++)
+      clusters_norm[eof+clust*neof] = clusters[eof+clust*neof] / sqrt(var_pc[eof]);
+  }
+
+  /* Accumulate squared distances EOF by EOF, time being contiguous in both the field and the distances */
+  for (clust=0; clust<nclust; clust++) {
+    pdist = dist_pc + (size_t) clust * (size_t) ntime;
+    for (nt=0; nt<ntime; nt++)
+      pdist[nt] = 0.0;
+    for (eof=0; eof<neof; eof++) {
+      ppc = pc + (size_t) eof * (size_t) ntime;
+      scale = scale_pc[eof];
+      center = clusters_norm[eof+clust*neof];
+      for (nt=0; nt<ntime; nt++) {
+        val = ppc[nt] * scale - center;
+        pdist[nt] += val * val;
+      }
+    }
+    for (nt=0; nt<ntime; nt++)
+      pdist[nt] = sqrt(pdist[nt]);
+  }
+
+  /* Free memory */
+  (void) free(scale_pc);
+  (void) free(clusters_norm);
+}
@@ -72,27 +72,20 @@ dist_clusters_normctrl(double *dist_pc, double *pc, double *clusters, double *va
      @param[in]   ntime           Time dimension
   */
 
-  double sum;
-  double val;
-  
-  int eof;
-  int nt;
-  int clust;
+  double scale; /* Inverse of control run standard deviation of distances to current cluster */
+  double mean; /* Control run mean of distances to current cluster */
 
+  int nt; /* Time loop counter */
+  int clust; /* Cluster loop counter */
+
+  /* Compute distances to clusters */
+  (void) dist_clusters(dist_pc, pc, clusters, var_pc, var_pc_norm_all, neof, nclust, ntime);
+
+  /* Normalize by control run mean and variance */
   for (clust=0; clust<nclust; clust++) {
-    for (nt=0; nt<ntime; nt++) {
-      sum = 0.0;
-      for (eof=0; eof<neof; eof++) {
-        val = (pc[nt+eof*ntime] / sqrt(var_pc_norm_all[eof])) - (clusters[eof+clust*neof] / sqrt(var_pc[eof]));
-        sum += (val * val);
-        //        if (nt == (ntime-5)) {
-        //          printf("dist_val %d %d %d %lf %lf %lf %lf %lf\n",clust,nt,eof,val,pc[nt+eof*ntime],var_pc_norm_all[eof],clusters[eof+clust*neof],var_pc[eof]);
-        //        }
-      }
-      dist_pc[nt+clust*ntime] = ( (sqrt(sum) - mean_ctrl[clust]) / sqrt(var_ctrl[clust]) );
-      //      if (nt == (ntime -5))
-      //        printf("dist_pc %d %d %lf %lf %lf %lf %lf\n",clust,nt,dist_pc[nt+clust*ntime],sqrt(sum),mean_ctrl[clust],var_ctrl[clust]);
-      //    }
-    }
+    mean = mean_ctrl[clust];
+    scale = 1.0 / sqrt(var_ctrl[clust]);
+    for (nt=0; nt<ntime; nt++)
+      dist_pc[nt+clust*ntime] = (dist_pc[nt+clust*ntime] - mean) * scale;
   }
 }
@@ -86,6 +86,9 @@ generate_clusters(double *clusters, double *pc_eof_days, char *type, int nclassi
   int *days_class_cluster = NULL; /* Vector of classification of days into each cluster. */
 
   static unsigned long int seed = 0;
+#ifdef HAVE_PTHREAD
+  static pthread_mutex_t seed_mutex = PTHREAD_MUTEX_INITIALIZER; /* Seasons may be classified concurrently */
+#endif
 
   (void) fprintf(stdout, "%s:: BEGIN: Find clusters among data points.\n", __FILE__);
 
@@ -100,8 +103,14 @@ generate_clusters(double *clusters, double *pc_eof_days, char *type, int nclassi
   rng = gsl_rng_alloc(T);
   /** Warning: we are using time() as the seed. Don't run this subroutine twice with the same time.
       If you do you will get the exact same sequence. **/
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&seed_mutex);
+#endif
   if (seed == 0) seed = time(NULL);
   (void) gsl_rng_set(rng, seed++);
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&seed_mutex);
+#endif
   
   /* Generate ncluster random days and initialize cluster PC array */
   random_num = (unsigned long int *) calloc(ncluster, sizeof(unsigned long int));
@@ -69,42 +69,21 @@ mean_variance_dist_clusters(double *mean_dist, double *var_dist, double *pc, dou
      @param[in]   ntime           Time dimension
   */
 
-  double *dist_pc = NULL; /* Sum of the normalized distances to clusters over all EOFs */
+  double *dist_pc = NULL; /* Distances to clusters (time first) */
 
-  double sum = 0.0; /* Sum of normalized distances to clusters */
-  double val; /* Normalized distance to cluster */
-  
-  int eof; /* EOF loop counter */
-  int nt; /* Time loop counter */
   int clust; /* Cluster loop counter */
 
   /* Allocate memory */
-  dist_pc = (double *) malloc(ntime * sizeof(double));
+  dist_pc = (double *) malloc((size_t) ntime * (size_t) nclust * sizeof(double));
   if (dist_pc == NULL) alloc_error(__FILE__, __LINE__);
 
-  /* Loop over all clusters */
+  /* Compute the whole distance matrix in one pass */
+  (void) dist_clusters(dist_pc, pc, clusters, var_pc, var_pc_norm_all, neof, nclust, ntime);
+
+  /* Mean and variance over time of distances to each cluster */
   for (clust=0; clust<nclust; clust++) {
-    /* Loop over time */
-    for (nt=0; nt<ntime; nt++) {
-      /* Initialize the sum */
-      sum = 0.0;
-      /* Loop over all EOFs */
-      for (eof=0; eof<neof; eof++) {
-        /* Calculate normalized distance to clusters */
-        val = (pc[nt+eof*ntime] / sqrt(var_pc_norm_all[eof])) - (clusters[eof+clust*neof] / sqrt(var_pc[eof]));
-        /* Calculate squared sum */
-        sum += (val * val);
-      }
-      /* Save for this timestep the square root of the sum of the squares of the distance to clusters */
-      dist_pc[nt] = sqrt(sum);
-    }
-    /* Calculate mean over time */
-    mean_dist[clust] = gsl_stats_mean(dist_pc, 1, ntime);
-    /* Calculate variance over time */
-    var_dist[clust] = gsl_stats_variance(dist_pc, 1, ntime);
-
-    //    printf("ctrl dist pre... %d %lf %lf %lf %lf %lf\n",clust,sqrt(sum),pc[ntime-1+clust*ntime],sqrt(var_pc_norm_all[clust]),clusters[clust+clust*neof],sqrt(var_pc[clust]));
-    //    printf("ctrl dist.... %d %lf %lf %lf %lf\n",clust,dist_pc[ntime-1],sum,mean_dist[clust],sqrt(var_dist[clust]));
+    mean_dist[clust] = gsl_stats_mean(dist_pc + (size_t) clust * (size_t) ntime, 1, ntime);
+    var_dist[clust] = gsl_stats_variance_m(dist_pc + (size_t) clust * (size_t) ntime, 1, ntime, mean_dist[clust]);
   }
 
   /* Free memory */
@@ -78,6 +78,8 @@ LICENSE END */
 void clim_daily_tserie_climyear(double *bufout, double *bufin, tstruct *buftime, double missing_val, int ni, int nj, int ntime);
 void remove_seasonal_cycle(double *bufout, double *clim, double *bufin, tstruct *buftime, double missing_val,
                            int filter_width, char *type, int clim_provided, int ni, int nj, int ntime);
+void remove_seasonal_cycle_f(float *buf, double *clim, tstruct *buftime, double missing_val,
+                             int filter_width, char *type, int clim_provided, int ni, int nj, int ntime);
 int dayofclimyear(int day, int month);
 
 #endif
@@ -116,6 +116,7 @@ create_netcdf(char *title, char *title_french, char *summary, char *summary_fren
   if (tmpstr == NULL) alloc_error(__FILE__, __LINE__);
 
   /* Open NetCDF file for writing, overwrite and truncate existing file if any */
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   if (format == 4 && compression == TRUE)
 #ifdef NC_NETCDF4
     istat = nc_create(filename, NC_CLOBBER | NC_NETCDF4 | NC_CLASSIC_MODEL, &ncoutid);
@@ -0,0 +1,136 @@
+/* ***************************************************** */
+/* Encode values of an output NetCDF variable:           */
+/* packing into shorts or bit-grooming.                  */
+/* encode_netcdf_values.c                                */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file encode_netcdf_values.c
+    \brief Encode values of an output NetCDF variable: packing into shorts or bit-grooming.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <io.h>
+
+/** Number of mantissa bits explicitly stored in single precision floats. */
+#define BITGROOM_MANTISSA_BITS 23
+
+/** Bit-groom single precision values to keep a number of significant decimal digits: trailing mantissa bits are alternately shaved and set so that the rounding errors do not accumulate in averages, and compress much better. */
+void
+bitgroom_float(float *buf, size_t n, int nsd, float fillvalue) {
+  /**
+     @param[in,out]  buf        Values
+     @param[in]      n          Number of values
+     @param[in]      nsd        Number of significant decimal digits to keep
+     @param[in]      fillvalue  Missing value, left untouched
+  */
+
+  uint32_t shave; /* Mask clearing the discarded mantissa bits */
+  uint32_t set; /* Mask setting the discarded mantissa bits */
+  uint32_t u; /* Bits of a value */
+  int keep; /* Number of mantissa bits kept */
+  size_t i; /* Loop counter */
+
+  /* log2(10) bits per decimal digit, plus one guard bit */
+  keep = (int) ceil((double) nsd * 3.32192809488736) + 1;
+  if (keep >= BITGROOM_MANTISSA_BITS)
+    return;
+  if (keep < 1)
+    keep = 1;
+  shave = ~((1u << (BITGROOM_MANTISSA_BITS - keep)) - 1u);
+  set = ~shave;
+
+  for (i=0; i<n; i++) {
+    if (buf[i] == fillvalue || buf[i] == 0.0f)
+      continue;
+    (void) memcpy(&u, &(buf[i]), sizeof(uint32_t));
+    if (i % 2 == 0)
+      u &= shave;
+    else
+      u |= set;
+    (void) memcpy(&(buf[i]), &u, sizeof(uint32_t));
+  }
+}
+
+/** Encode double precision values as floats or packed shorts, according to the output encoding of the variable. */
+void
+encode_netcdf_values(void *out, double *buf, size_t n, double fillvalue, nc_encoding_struct *encoding) {
+  /**
+     @param[out]  out        Encoded values: n floats, or n shorts for NC_ENCODING_SHORT
+     @param[in]   buf        Values
+     @param[in]   n          Number of values
+     @param[in]   fillvalue  Missing value
+     @param[in]   encoding   Output encoding, NULL for plain floats
+  */
+
+  float *outf; /* Values as floats */
+  short int *outs; /* Values as packed shorts */
+  double packed; /* Packed value before rounding */
+  size_t i; /* Loop counter */
+
+  if (encoding != NULL && encoding->type == NC_ENCODING_SHORT) {
+    outs = (short int *) out;
+    for (i=0; i<n; i++) {
+      if (buf[i] == fillvalue)
+        outs[i] = NC_PACKED_FILL;
+      else {
+        /* Values out of the packed range are clipped to its bounds, which never hit the fill value */
+        packed = floor((buf[i] - encoding->add_offset) / encoding->scale_factor + 0.5);
+        if (packed < (double) (NC_PACKED_FILL + 1))
+          packed = (double) (NC_PACKED_FILL + 1);
+        else if (packed > 32767.0)
+          packed = 32767.0;
+        outs[i] = (short int) packed;
+      }
+    }
+    return;
+  }
+
+  outf = (float *) out;
+  for (i=0; i<n; i++)
+    outf[i] = (float) buf[i];
+  if (encoding != NULL && encoding->type == NC_ENCODING_DIGITS)
+    (void) bitgroom_float(outf, n, encoding->nsd, (float) fillvalue);
+}
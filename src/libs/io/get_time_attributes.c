@@ -85,6 +85,7 @@ get_time_attributes(char **time_units, char **cal_type, char *filename, char *va
 
   /* Open NetCDF file for reading */
   printf("%s: Opening for reading time attributes in NetCDF input file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
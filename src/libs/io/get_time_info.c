@@ -105,6 +105,7 @@ get_time_info(time_vect_struct *time_s, double **timeval, char **time_units, cha
   /* Open NetCDF file for reading */
   if (outinfo == TRUE)
     printf("%s: Opening for reading time information in NetCDF input file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) {
     (void) fprintf(stderr, "%s: filename = %s\n", __FILE__, filename);
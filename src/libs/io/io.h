@@ -87,6 +87,9 @@ LICENSE END */
 #ifdef HAVE_LIBGEN_H
 #include <libgen.h>
 #endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 /** TRUE value macro is 1. */
 #define TRUE 1
@@ -96,6 +99,15 @@ LICENSE END */
 /** Maximum length of paths/filenames strings. */
 #define MAXPATH 5000
 
+/** Output encoding: single precision at full precision. */
+#define NC_ENCODING_FLOAT 0
+/** Output encoding: short integers packed with scale_factor and add_offset. */
+#define NC_ENCODING_SHORT 1
+/** Output encoding: single precision bit-groomed to a number of significant digits. */
+#define NC_ENCODING_DIGITS 2
+/** Fill value of packed short integers. */
+#define NC_PACKED_FILL -32767
+
 /** Data structure for NetCDF metadata info_struct. */
 typedef struct {
   char *title; /**< Title (english). */
@@ -161,6 +173,24 @@ typedef struct {
   double *seconds; /**< Seconds of the minute 0-59. */
 } time_vect_struct;
 
+/** Encoding of an output NetCDF variable nc_encoding_struct. **/
+typedef struct {
+  int type; /**< NC_ENCODING_FLOAT, NC_ENCODING_SHORT or NC_ENCODING_DIGITS. */
+  double scale_factor; /**< Scale factor of packed values (NC_ENCODING_SHORT). */
+  double add_offset; /**< Offset of packed values (NC_ENCODING_SHORT). */
+  int nsd; /**< Number of significant decimal digits kept (NC_ENCODING_DIGITS). */
+} nc_encoding_struct;
+
+/** 2D field compressed chunk by chunk, for direct chunk writes in a 3D NetCDF-4 variable. **/
+typedef struct {
+  int nchunks; /**< Number of chunks. */
+  int chunk_nlat; /**< Number of latitude rows of each chunk. */
+  int nlon; /**< Longitude dimension of each chunk. */
+  int typesize; /**< Size in bytes of an encoded value: 4 for floats, 2 for packed shorts. */
+  unsigned char **data; /**< Deflated chunks. */
+  size_t *size; /**< Size in bytes of each deflated chunk. */
+} nc_chunks_struct;
+
 /* NetCDF-related includes */
 #include <zlib.h>
 #include <hdf5.h>
@@ -185,8 +215,19 @@ int read_netcdf_dims_eof(double **lon, double **lat, int *nlon, int *nlat, int *
                          char *lonname, char *latname, char *dimxname, char *dimyname, char *eofname, char *filename);
 int read_netcdf_var_3d(double **buf, info_field_struct *info_field, proj_struct *proj, char *filename, char *varname,
                        char *dimxname, char *dimyname, char *timename, int *nlon, int *nlat, int *ntime, int outinfo);
+int read_netcdf_var_3d_subdomain(double **buf, info_field_struct *info_field, proj_struct *proj, char *filename, char *varname,
+                                 char *dimxname, char *dimyname, char *timename, subdomain_struct *subdomain,
+                                 int *nlon, int *nlat, int *ntime, int outinfo);
+int read_netcdf_var_3d_subdomain_f(float **buf, info_field_struct *info_field, proj_struct *proj, char *filename, char *varname,
+                                   char *dimxname, char *dimyname, char *timename, subdomain_struct *subdomain,
+                                   int *nlon, int *nlat, int *ntime, int outinfo);
 int read_netcdf_var_3d_2d(double **buf, info_field_struct *info_field, proj_struct *proj, char *filename, char *varname,
                           char *dimxname, char *dimyname, char *timename, int t, int *nlon, int *nlat, int *ntime, int outinfo);
+int read_netcdf_chunks_3d(double *buf, char *filename, char *varname, size_t *start, size_t *count, ptrdiff_t *imap);
+int read_netcdf_chunks_3d_f(float *buf, char *filename, char *varname, size_t *start, size_t *count, ptrdiff_t *imap);
+void read_netcdf_chunks_set_nthreads(int nthreads);
+int read_netcdf_var_3d_range(double *buf, double *fillvalue, char *filename, char *varname, subdomain_struct *subdomain,
+                             size_t *tstart, size_t *tcount, int nruns, int nlon, int nlat);
 int read_netcdf_var_2d(double **buf, info_field_struct *info_field, proj_struct *proj, char *filename, char *varname,
                        char *dimxname, char *dimyname, int *nlon, int *nlat, int outinfo);
 int read_netcdf_var_1d(double **buf, info_field_struct *info_field, char *filename, char *varname,
@@ -198,7 +239,15 @@ int write_netcdf_var_3d(double *buf, double fillvalue, char *filename,
 int write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *filename,
                            char *varname, char *longname, char *units, char *height,
                            char *gridname, char *lonname, char *latname, char *timename,
-                           int t, int newfile, int format, int compression_level, int nlon, int nlat, int ntime, int outinfo);
+                           int t, int newfile, int format, int compression_level, int nlon, int nlat, int ntime,
+                           nc_encoding_struct *encoding, nc_chunks_struct *chunks, int outinfo);
+void encode_netcdf_values(void *out, double *buf, size_t n, double fillvalue, nc_encoding_struct *encoding);
+void bitgroom_float(float *buf, size_t n, int nsd, float fillvalue);
+int netcdf_chunks_rows(int nlat, int nlon);
+int encode_netcdf_chunks_2d(nc_chunks_struct *chunks, double *buf, double fillvalue, int nlat, int nlon,
+                            int compression_level, nc_encoding_struct *encoding, thread_pool_struct *pool);
+void free_netcdf_chunks(nc_chunks_struct *chunks);
+int write_netcdf_chunks_3d(nc_chunks_struct *chunks, char *filename, char *varname, int t);
 int write_netcdf_dims_3d(double *lon, double *lat, double *x, double *y, double *alt, double *timein, char *cal_type, char *time_units,
                          int nlon, int nlat, int ntime, char *timestep, char *gridname, char *coords,
                          char *grid_mapping_name, double latin1, double latin2,
@@ -219,5 +268,8 @@ int get_time_info(time_vect_struct *time_s, double **timeval, char **time_units,
                   char *varname, int outinfo);
 int compute_time_info(time_vect_struct *time_s, double *timeval, char *time_units, char *cal_type, int ntime);
 void handle_netcdf_error(int status, char *srcfilename, int lineno);
+void nc_io_lock(void);
+size_t nc_slab_bytes(int ncid, int varid, size_t *count);
+void nc_io_unlock(void);
 
 #endif
@@ -0,0 +1,89 @@
+/* ***************************************************** */
+/* Serialize NetCDF library calls between threads.       */
+/* nc_io_lock.c                                          */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file nc_io_lock.c
+    \brief Serialize NetCDF library calls between threads.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <io.h>
+
+#ifdef HAVE_PTHREAD
+/** Mutex serializing NetCDF library calls: the NetCDF-C library is not thread-safe. */
+static pthread_mutex_t nc_io_mutex;
+/** Control variable to initialize nc_io_mutex only once. */
+static pthread_once_t nc_io_once = PTHREAD_ONCE_INIT;
+
+/** Initialize the recursive NetCDF mutex. */
+static void
+nc_io_init(void) {
+  pthread_mutexattr_t attr; /* Mutex attributes */
+
+  (void) pthread_mutexattr_init(&attr);
+  (void) pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  (void) pthread_mutex_init(&nc_io_mutex, &attr);
+  (void) pthread_mutexattr_destroy(&attr);
+}
+#endif
+
+/** Acquire the NetCDF library lock. Must be held around any NetCDF call made while other threads may also call NetCDF. */
+void
+nc_io_lock(void) {
+#ifdef HAVE_PTHREAD
+  (void) pthread_once(&nc_io_once, nc_io_init);
+  (void) pthread_mutex_lock(&nc_io_mutex);
+#endif
+}
+
+/** Release the NetCDF library lock. */
+void
+nc_io_unlock(void) {
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&nc_io_mutex);
+#endif
+}
@@ -1,11 +1,11 @@
 /* ***************************************************** */
-/* Compute the time mean and variance of a 2D field      */
-/* time_mean_variance_field_2d.c                         */
+/* Bytes of a hyperslab of a NetCDF variable.            */
+/* nc_slab_bytes.c                                       */
 /* ***************************************************** */
 /* Author: Christian Page, CERFACS, Toulouse, France.    */
 /* ***************************************************** */
-/*! \file time_mean_variance_field_2d.c
-    \brief Compute the time mean and variance of a 2D field.
+/*! \file nc_slab_bytes.c
+    \brief Bytes of a hyperslab of a NetCDF variable.
 */
 
 /* LICENSE BEGIN
@@ -51,46 +51,31 @@ LICENSE END */
 
 
 
-#include <utils.h>
+#include <io.h>
 
-/** Compute the time mean and variance of a 2D field. */
-void
-time_mean_variance_field_2d(double *bufmean, double *bufvar, double *buf, int ni, int nj, int nt) {
+/** Number of bytes of a hyperslab of a NetCDF variable, in the type of the variable on disk. */
+size_t
+nc_slab_bytes(int ncid, int varid, size_t *count) {
+  /**
+     @param[in]  ncid   NetCDF file ID.
+     @param[in]  varid  NetCDF variable ID.
+     @param[in]  count  Count of elements along each dimension of the variable.
 
-  /** 
-      @param[out]  bufmean       Time mean of 2D field
-      @param[out]  bufvar        Time variance of 2D field
-      @param[in]   buf           Input 3D buffer
-      @param[in]   ni            First dimension
-      @param[in]   nj            Second dimension
-      @param[in]   nt            Time dimension
-   */
+     \return            Number of bytes, 0 if the variable cannot be inquired.
+  */
 
+  nc_type vartype; /* Type of the variable on disk */
+  int varndims; /* Number of dimensions of the variable */
+  size_t nbytes; /* Number of bytes */
   int i; /* Loop counter */
-  int j; /* Loop counter */
-  int t; /* Loop counter */
-
-  double sum; /* Temporary sum for buf */
-  double diff; /* Temporary difference for variance calculation */
-
-  /* First calculate mean over time of a 2D field */
-  for (j=0; j<nj; j++)
-    for (i=0; i<ni; i++) {
-      sum = 0.0;
-      for (t=0; t<nt; t++)
-        sum += buf[i+j*ni+t*ni*nj];
-      bufmean[i+j*ni] = sum / (double) nt;
-    }
-
-  /* Then calculate variance over time of a 2D field */
-  for (j=0; j<nj; j++)
-    for (i=0; i<ni; i++) {
-      sum = 0.0;
-      for (t=0; t<nt; t++) {
-        diff = buf[i+j*ni+t*ni*nj] - bufmean[i+j*ni];
-        sum += (diff * diff);
-      bufvar[i+j*ni] = sqrtf(sum / (double) (nt-1));
-      }
-    }
-}
 
+  if (nc_inq_varndims(ncid, varid, &varndims) != NC_NOERR || nc_inq_vartype(ncid, varid, &vartype) != NC_NOERR)
+    return 0;
+
+  /* Only the dimensions of the variable are counted */
+  nbytes = (size_t) nctypelen(vartype);
+  for (i=0; i<varndims; i++)
+    nbytes *= count[i];
+
+  return nbytes;
+}
@@ -0,0 +1,490 @@
+/* ***************************************************** */
+/* Read a 3D NetCDF-4 variable by inflating its          */
+/* compressed chunks on a thread pool.                   */
+/* read_netcdf_chunks_3d.c                               */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file read_netcdf_chunks_3d.c
+    \brief Read a 3D NetCDF-4 variable by inflating its compressed chunks on a thread pool.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <io.h>
+
+/** Maximum number of raw chunks held in memory by each batch. */
+#define NC_CHUNKS_BATCH 64
+/** Maximum number of filters in a supported dataset pipeline. */
+#define NC_CHUNKS_MAXFILTERS 4
+
+/** Number of threads used to inflate chunks: the direct chunk reader is disabled below 2. */
+static int nc_chunks_nthreads = 0;
+/** Thread pool inflating the chunks, shared by all reads. */
+static thread_pool_struct *nc_chunks_pool = NULL;
+/** Process which created the thread pool: worker threads are not inherited by forked processes. */
+static pid_t nc_chunks_pool_pid = 0;
+
+/** Layout and encoding of a chunked dataset, shared by the decoding tasks. */
+typedef struct {
+  hsize_t cdim[3]; /**< Chunk dimensions */
+  size_t chunkbytes; /**< Uncompressed size of a chunk in bytes */
+  int nfilters; /**< Number of filters in the pipeline */
+  H5Z_filter_t filter[NC_CHUNKS_MAXFILTERS]; /**< Filters in the order applied when writing */
+  H5T_class_t typeclass; /**< H5T_FLOAT or H5T_INTEGER */
+  H5T_sign_t typesign; /**< Sign of integer types */
+  size_t typesize; /**< Size of an element in bytes */
+  int swap; /**< TRUE if elements are not stored in native byte order */
+  double fillvalue; /**< Value of elements in chunks never written */
+  double *buf; /**< Output buffer in double precision, NULL if buf_f is used */
+  float *buf_f; /**< Output buffer in single precision, NULL if buf is used */
+  size_t *start; /**< Start of the hyperslab in the variable */
+  size_t *count; /**< Count of the hyperslab */
+  ptrdiff_t *imap; /**< Distance in the output buffer between successive elements of each dimension */
+} nc_chunks_layout_struct;
+
+/** Raw chunk to decode into the output buffer. */
+typedef struct {
+  nc_chunks_layout_struct *layout; /**< Dataset layout */
+  hsize_t offset[3]; /**< Position of the first element of the chunk */
+  unsigned char *raw; /**< Raw chunk as stored in the file, NULL for a chunk never written */
+  size_t rawsize; /**< Size of the raw chunk */
+  uint32_t filter_mask; /**< Filters skipped for this chunk */
+  int istat; /**< Status of decoding */
+} nc_chunks_task_struct;
+
+/** Set the number of threads used to inflate compressed NetCDF-4 chunks and create their thread pool.
+    Less than 2 disables the direct chunk reader and stops the threads. */
+void
+read_netcdf_chunks_set_nthreads(int nthreads) {
+  /**
+     @param[in]  nthreads  Number of threads.
+  */
+
+  /* A pool inherited from a parent process has no worker threads to stop: it is only dropped */
+  if (nc_chunks_pool != NULL && nc_chunks_pool_pid == getpid())
+    (void) thread_pool_free(nc_chunks_pool);
+  nc_chunks_pool = NULL;
+
+  nc_chunks_nthreads = (nthreads < 0) ? 0 : nthreads;
+  if (nc_chunks_nthreads >= 2) {
+    nc_chunks_pool = thread_pool_create(nc_chunks_nthreads);
+    nc_chunks_pool_pid = getpid();
+  }
+}
+
+/** Convert an element of a decoded chunk to double precision. */
+static double
+nc_chunks_value(unsigned char *elem, nc_chunks_layout_struct *layout) {
+  /**
+     @param[in]  elem    Element as stored in the chunk
+     @param[in]  layout  Dataset layout
+
+     \return             Value in double precision.
+  */
+
+  unsigned char tmp[8]; /* Element in native byte order */
+  float valf; /* Single precision value */
+  double vald; /* Double precision value */
+  size_t k; /* Loop counter */
+
+  if (layout->swap == TRUE)
+    for (k=0; k<layout->typesize; k++)
+      tmp[k] = elem[layout->typesize-1-k];
+  else
+    (void) memcpy(tmp, elem, layout->typesize);
+
+  if (layout->typeclass == H5T_FLOAT) {
+    if (layout->typesize == sizeof(float)) {
+      (void) memcpy(&valf, tmp, sizeof(float));
+      return (double) valf;
+    }
+    (void) memcpy(&vald, tmp, sizeof(double));
+    return vald;
+  }
+
+  if (layout->typesign == H5T_SGN_2) {
+    switch (layout->typesize) {
+    case 1: { int8_t v; (void) memcpy(&v, tmp, 1); return (double) v; }
+    case 2: { int16_t v; (void) memcpy(&v, tmp, 2); return (double) v; }
+    case 4: { int32_t v; (void) memcpy(&v, tmp, 4); return (double) v; }
+    default: { int64_t v; (void) memcpy(&v, tmp, 8); return (double) v; }
+    }
+  }
+  switch (layout->typesize) {
+  case 1: { uint8_t v; (void) memcpy(&v, tmp, 1); return (double) v; }
+  case 2: { uint16_t v; (void) memcpy(&v, tmp, 2); return (double) v; }
+  case 4: { uint32_t v; (void) memcpy(&v, tmp, 4); return (double) v; }
+  default: { uint64_t v; (void) memcpy(&v, tmp, 8); return (double) v; }
+  }
+}
+
+/** Inflate and unshuffle a raw chunk, then copy its part of the hyperslab into the output buffer. */
+static void
+nc_chunks_decode(void *arg) {
+  /**
+     @param[in,out]  arg  Chunk decoding task (nc_chunks_task_struct).
+  */
+
+  nc_chunks_task_struct *task = (nc_chunks_task_struct *) arg; /* Chunk decoding task */
+  nc_chunks_layout_struct *layout = task->layout; /* Dataset layout */
+
+  unsigned char *data = NULL; /* Chunk being decoded */
+  unsigned char *tmp = NULL; /* Output of the current filter */
+  unsigned char *swp; /* Buffer swap */
+  size_t size; /* Size of the chunk being decoded */
+  uLongf destlen; /* Size of inflated data */
+  size_t nelem; /* Number of elements in the chunk */
+  size_t lo[3]; /* First index of the hyperslab covered by the chunk */
+  size_t hi[3]; /* Last index plus one of the hyperslab covered by the chunk */
+  size_t e; /* Element loop counter */
+  size_t b; /* Byte loop counter */
+  size_t t; /* Time loop counter */
+  size_t j; /* Latitude loop counter */
+  size_t i; /* Longitude loop counter */
+  int f; /* Filter loop counter */
+  int d; /* Dimension loop counter */
+  size_t pos; /* Output position */
+  double val; /* Decoded value */
+
+  task->istat = 0;
+
+  if (task->raw != NULL) {
+    size = task->rawsize;
+    data = (unsigned char *) malloc((size > layout->chunkbytes ? size : layout->chunkbytes) * sizeof(unsigned char));
+    if (data == NULL) alloc_error(__FILE__, __LINE__);
+    tmp = (unsigned char *) malloc((size > layout->chunkbytes ? size : layout->chunkbytes) * sizeof(unsigned char));
+    if (tmp == NULL) alloc_error(__FILE__, __LINE__);
+    (void) memcpy(data, task->raw, size);
+
+    /* Undo the filters in the reverse order of the pipeline */
+    for (f=layout->nfilters-1; f>=0 && task->istat == 0; f--) {
+      if (task->filter_mask & (1u << f))
+        continue;
+      if (layout->filter[f] == H5Z_FILTER_DEFLATE) {
+        destlen = (uLongf) layout->chunkbytes;
+        if (uncompress(tmp, &destlen, data, (uLong) size) != Z_OK)
+          task->istat = -1;
+        size = (size_t) destlen;
+      }
+      else {
+        /* H5Z_FILTER_SHUFFLE: byte k of every element was stored contiguously */
+        nelem = size / layout->typesize;
+        for (b=0; b<layout->typesize; b++)
+          for (e=0; e<nelem; e++)
+            tmp[e*layout->typesize+b] = data[b*nelem+e];
+        for (e=nelem*layout->typesize; e<size; e++)
+          tmp[e] = data[e];
+      }
+      swp = data;
+      data = tmp;
+      tmp = swp;
+    }
+    if (task->istat == 0 && size != layout->chunkbytes)
+      task->istat = -1;
+    (void) free(tmp);
+    if (task->istat != 0) {
+      (void) fprintf(stderr, "%s: Cannot decode chunk at offset %d %d %d.\n", __FILE__,
+                     (int) task->offset[0], (int) task->offset[1], (int) task->offset[2]);
+      (void) free(data);
+      return;
+    }
+  }
+
+  /* Part of the hyperslab covered by this chunk */
+  for (d=0; d<3; d++) {
+    lo[d] = (task->offset[d] > layout->start[d]) ? (size_t) task->offset[d] : layout->start[d];
+    hi[d] = (size_t) task->offset[d] + (size_t) layout->cdim[d];
+    if (hi[d] > layout->start[d] + layout->count[d])
+      hi[d] = layout->start[d] + layout->count[d];
+  }
+
+  for (t=lo[0]; t<hi[0]; t++)
+    for (j=lo[1]; j<hi[1]; j++)
+      for (i=lo[2]; i<hi[2]; i++) {
+        if (data == NULL)
+          val = layout->fillvalue;
+        else {
+          e = (((t-task->offset[0])*layout->cdim[1] + (j-task->offset[1]))*layout->cdim[2] + (i-task->offset[2]));
+          val = nc_chunks_value(&(data[e*layout->typesize]), layout);
+        }
+        pos = (t-layout->start[0])*layout->imap[0] + (j-layout->start[1])*layout->imap[1] + (i-layout->start[2])*layout->imap[2];
+        if (layout->buf_f != NULL)
+          layout->buf_f[pos] = (float) val;
+        else
+          layout->buf[pos] = val;
+      }
+
+  if (data != NULL)
+    (void) free(data);
+}
+
+/** Read a hyperslab of a 3D compressed NetCDF-4 variable in double or single precision. */
+static int
+nc_chunks_read(double *buf, float *buf_f, char *filename, char *varname, size_t *start, size_t *count, ptrdiff_t *imap) {
+  /**
+     @param[out]  buf       Output buffer in double precision, already allocated, or NULL
+     @param[out]  buf_f     Output buffer in single precision, already allocated, or NULL
+     @param[in]   filename  NetCDF-4 input filename
+     @param[in]   varname   NetCDF variable name
+     @param[in]   start     Start of the hyperslab (time, latitude, longitude)
+     @param[in]   count     Count of the hyperslab
+     @param[in]   imap      Distance in buf between successive elements of each dimension
+
+     \return                0 on success, 1 if the variable cannot be read this way and the regular NetCDF
+                            path must be used instead, -1 on error.
+  */
+
+#if H5_VERSION_GE(1,10,2)
+  nc_chunks_layout_struct layout; /* Dataset layout */
+  nc_chunks_task_struct *tasks = NULL; /* Chunk decoding tasks, two batches */
+  nc_chunks_task_struct *task; /* Current chunk decoding task */
+  thread_pool_struct *pool = NULL; /* Thread pool inflating the chunks, created once */
+  H5E_auto2_t errfunc; /* Saved HDF5 error handler */
+  void *errdata; /* Saved HDF5 error handler data */
+  hid_t fid = -1; /* HDF5 file ID */
+  hid_t did = -1; /* HDF5 dataset ID */
+  hid_t sid = -1; /* HDF5 dataspace ID */
+  hid_t tid = -1; /* HDF5 datatype ID */
+  hid_t pid = -1; /* HDF5 dataset creation property list ID */
+  hsize_t dims[3]; /* Dataset dimensions */
+  hsize_t nchunks[3]; /* Number of chunks covering the hyperslab */
+  hsize_t first[3]; /* First chunk covering the hyperslab */
+  hsize_t c[3]; /* Chunk loop counters */
+  hsize_t ntotal; /* Total number of chunks to read */
+  hsize_t n; /* Chunk loop counter */
+  hsize_t storage; /* Size of a raw chunk */
+  size_t nelmts; /* Number of filter parameters */
+  unsigned int cd_values[8]; /* Filter parameters */
+  unsigned int flags; /* Filter flags */
+  int batch; /* Current batch */
+  int ntasks[2]; /* Number of tasks in each batch */
+  int k; /* Loop counter */
+  int f; /* Filter loop counter */
+  int istat = 0; /* Diagnostic status */
+
+  if (nc_chunks_nthreads < 2)
+    return 1;
+  /* Forked process: start its own worker threads */
+  if (nc_chunks_pool_pid != getpid())
+    (void) read_netcdf_chunks_set_nthreads(nc_chunks_nthreads);
+  pool = nc_chunks_pool;
+
+  /* HDF5 reports failures of the probing calls below on stderr unless its error handler is disabled */
+  (void) H5Eget_auto2(H5E_DEFAULT, &errfunc, &errdata);
+  (void) H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+  fid = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (fid >= 0)
+    did = H5Dopen2(fid, varname, H5P_DEFAULT);
+  if (did >= 0) {
+    sid = H5Dget_space(did);
+    tid = H5Dget_type(did);
+    pid = H5Dget_create_plist(did);
+  }
+  if (did < 0 || sid < 0 || tid < 0 || pid < 0)
+    istat = 1;
+
+  /* Only 3D chunked datasets of plain numbers compressed with deflate, optionally shuffled, are handled */
+  if (istat == 0 && (H5Sget_simple_extent_ndims(sid) != 3 || H5Pget_layout(pid) != H5D_CHUNKED ||
+                     H5Pget_chunk(pid, 3, layout.cdim) != 3))
+    istat = 1;
+  if (istat == 0) {
+    (void) H5Sget_simple_extent_dims(sid, dims, NULL);
+    layout.typeclass = H5Tget_class(tid);
+    layout.typesize = H5Tget_size(tid);
+    layout.typesign = H5Tget_sign(tid);
+    layout.swap = (H5Tget_order(tid) == H5Tget_order(H5T_NATIVE_INT)) ? FALSE : TRUE;
+    if (layout.typeclass == H5T_FLOAT && layout.typesize != sizeof(float) && layout.typesize != sizeof(double))
+      istat = 1;
+    else if (layout.typeclass == H5T_INTEGER && layout.typesize != 1 && layout.typesize != 2 &&
+             layout.typesize != 4 && layout.typesize != 8)
+      istat = 1;
+    else if (layout.typeclass != H5T_FLOAT && layout.typeclass != H5T_INTEGER)
+      istat = 1;
+  }
+  if (istat == 0) {
+    layout.nfilters = H5Pget_nfilters(pid);
+    if (layout.nfilters < 1 || layout.nfilters > NC_CHUNKS_MAXFILTERS)
+      istat = 1;
+    for (f=0; f<layout.nfilters && istat == 0; f++) {
+      nelmts = sizeof(cd_values) / sizeof(unsigned int);
+      layout.filter[f] = H5Pget_filter2(pid, (unsigned int) f, &flags, &nelmts, cd_values, 0, NULL, NULL);
+      if (layout.filter[f] != H5Z_FILTER_DEFLATE && layout.filter[f] != H5Z_FILTER_SHUFFLE)
+        istat = 1;
+    }
+    /* Deflate must come last for the output size check of the decoder to hold */
+    if (istat == 0 && layout.filter[layout.nfilters-1] != H5Z_FILTER_DEFLATE)
+      istat = 1;
+  }
+  if (istat == 0 && (start[0]+count[0] > dims[0] || start[1]+count[1] > dims[1] || start[2]+count[2] > dims[2]))
+    istat = 1;
+
+  if (istat == 0) {
+    if (H5Pget_fill_value(pid, H5T_NATIVE_DOUBLE, &(layout.fillvalue)) < 0)
+      layout.fillvalue = 0.0;
+    layout.chunkbytes = (size_t) (layout.cdim[0] * layout.cdim[1] * layout.cdim[2]) * layout.typesize;
+    layout.buf = buf;
+    layout.buf_f = buf_f;
+    layout.start = start;
+    layout.count = count;
+    layout.imap = imap;
+
+    ntotal = 1;
+    for (k=0; k<3; k++) {
+      first[k] = start[k] / layout.cdim[k];
+      nchunks[k] = (count[k] == 0) ? 0 : (start[k]+count[k]-1) / layout.cdim[k] - first[k] + 1;
+      ntotal *= nchunks[k];
+    }
+
+    tasks = (nc_chunks_task_struct *) malloc(2 * NC_CHUNKS_BATCH * sizeof(nc_chunks_task_struct));
+    if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+
+    /* Raw chunks are fetched on the calling thread, which may hold the NetCDF lock, while the previous batch */
+    /* is inflated by the pool: the HDF5 library itself is never called from the pool threads */
+    batch = 0;
+    ntasks[0] = ntasks[1] = 0;
+    for (n=0; n<ntotal && istat == 0; n++) {
+      c[2] = n % nchunks[2];
+      c[1] = (n / nchunks[2]) % nchunks[1];
+      c[0] = n / (nchunks[2] * nchunks[1]);
+      task = &(tasks[batch*NC_CHUNKS_BATCH + ntasks[batch]]);
+      task->layout = &layout;
+      task->raw = NULL;
+      task->rawsize = 0;
+      task->filter_mask = 0;
+      for (k=0; k<3; k++)
+        task->offset[k] = (first[k] + c[k]) * layout.cdim[k];
+      storage = 0;
+      if (H5Dget_chunk_storage_size(did, task->offset, &storage) >= 0 && storage > 0) {
+        task->raw = (unsigned char *) malloc((size_t) storage);
+        if (task->raw == NULL) alloc_error(__FILE__, __LINE__);
+        task->rawsize = (size_t) storage;
+        if (H5Dread_chunk(did, H5P_DEFAULT, task->offset, &(task->filter_mask), task->raw) < 0) {
+          (void) fprintf(stderr, "%s: Cannot read raw chunk of variable %s in file %s.\n", __FILE__, varname, filename);
+          (void) free(task->raw);
+          task->raw = NULL;
+          istat = -1;
+          break;
+        }
+      }
+      ntasks[batch]++;
+      if (ntasks[batch] == NC_CHUNKS_BATCH || n == ntotal-1) {
+        /* Wait for the previous batch before handing this one to the pool */
+        (void) thread_pool_wait(pool);
+        for (k=0; k<ntasks[1-batch]; k++) {
+          task = &(tasks[(1-batch)*NC_CHUNKS_BATCH + k]);
+          if (task->istat != 0)
+            istat = -1;
+          if (task->raw != NULL)
+            (void) free(task->raw);
+        }
+        ntasks[1-batch] = 0;
+        for (k=0; k<ntasks[batch]; k++)
+          (void) thread_pool_submit(pool, nc_chunks_decode, &(tasks[batch*NC_CHUNKS_BATCH + k]));
+        batch = 1 - batch;
+      }
+    }
+    (void) thread_pool_wait(pool);
+    for (batch=0; batch<2; batch++)
+      for (k=0; k<ntasks[batch]; k++) {
+        task = &(tasks[batch*NC_CHUNKS_BATCH + k]);
+        /* Tasks of an interrupted batch were never submitted */
+        if (n == ntotal && task->istat != 0)
+          istat = -1;
+        if (task->raw != NULL)
+          (void) free(task->raw);
+      }
+    (void) free(tasks);
+  }
+
+  if (pid >= 0) (void) H5Pclose(pid);
+  if (tid >= 0) (void) H5Tclose(tid);
+  if (sid >= 0) (void) H5Sclose(sid);
+  if (did >= 0) (void) H5Dclose(did);
+  if (fid >= 0) (void) H5Fclose(fid);
+  (void) H5Eset_auto2(H5E_DEFAULT, errfunc, errdata);
+
+  return istat;
+#else
+  /* Direct chunk reads need HDF5 1.10.2 or later */
+  return 1;
+#endif
+}
+
+/** Read a hyperslab of a 3D compressed NetCDF-4 variable by fetching its raw chunks and inflating them on a thread pool. */
+int
+read_netcdf_chunks_3d(double *buf, char *filename, char *varname, size_t *start, size_t *count, ptrdiff_t *imap) {
+  /**
+     @param[out]  buf       Output buffer, already allocated
+     @param[in]   filename  NetCDF-4 input filename
+     @param[in]   varname   NetCDF variable name
+     @param[in]   start     Start of the hyperslab (time, latitude, longitude)
+     @param[in]   count     Count of the hyperslab
+     @param[in]   imap      Distance in buf between successive elements of each dimension
+
+     \return                0 on success, 1 if the variable cannot be read this way and the regular NetCDF
+                            path must be used instead, -1 on error.
+  */
+
+  return nc_chunks_read(buf, (float *) NULL, filename, varname, start, count, imap);
+}
+
+/** Read a hyperslab of a 3D compressed NetCDF-4 variable in single precision by inflating its raw chunks on a thread pool. */
+int
+read_netcdf_chunks_3d_f(float *buf, char *filename, char *varname, size_t *start, size_t *count, ptrdiff_t *imap) {
+  /**
+     @param[out]  buf       Output buffer, already allocated
+     @param[in]   filename  NetCDF-4 input filename
+     @param[in]   varname   NetCDF variable name
+     @param[in]   start     Start of the hyperslab (time, latitude, longitude)
+     @param[in]   count     Count of the hyperslab
+     @param[in]   imap      Distance in buf between successive elements of each dimension
+
+     \return                0 on success, 1 if the variable cannot be read this way and the regular NetCDF
+                            path must be used instead, -1 on error.
+  */
+
+  return nc_chunks_read((double *) NULL, buf, filename, varname, start, count, imap);
+}
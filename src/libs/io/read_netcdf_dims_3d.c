@@ -118,6 +118,7 @@ read_netcdf_dims_3d(double **lon, double **lat, double **timeval, char **cal_typ
 
   /* Open NetCDF file for reading */
   printf("%s: Reading info from NetCDF input file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
@@ -110,6 +110,7 @@ read_netcdf_latlon(double **lon, double **lat, int *nlon, int *nlat, char *dimco
 
   /* Open NetCDF file for reading */
   printf("%s: Reading info from NetCDF input file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
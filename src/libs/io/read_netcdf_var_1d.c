@@ -104,6 +104,7 @@ read_netcdf_var_1d(double **buf, info_field_struct *info_field, char *filename,
   /* Open NetCDF file for reading */
   if (outinfo == TRUE)
     printf("%s: Opening for reading NetCDF input file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
@@ -221,6 +222,7 @@ read_netcdf_var_1d(double **buf, info_field_struct *info_field, char *filename,
   /* Read values from netCDF variable */
   istat = nc_get_vara_double(ncinid, varinid, start, count, *buf);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+  (void) instrument_count(INSTR_BYTES_READ, nc_slab_bytes(ncinid, varinid, count));
 
   /* Close the input netCDF file. */
   istat = ncclose(ncinid);
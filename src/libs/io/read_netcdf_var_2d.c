@@ -116,6 +116,7 @@ read_netcdf_var_2d(double **buf, info_field_struct *info_field, proj_struct *pro
   /* Open NetCDF file for reading */
   if (outinfo == TRUE)
     printf("%s: Opening for reading NetCDF input file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) {
     printf("%s: Failed Opening for reading NetCDF input file %s\n", __FILE__, filename);
@@ -406,6 +407,7 @@ read_netcdf_var_2d(double **buf, info_field_struct *info_field, proj_struct *pro
   /* Read values from netCDF variable */
   istat = nc_get_vara_double(ncinid, varinid, start, count, *buf);
   if (istat != NC_NOERR) { handle_netcdf_error(istat, __FILE__, __LINE__); return -1; }
+  (void) instrument_count(INSTR_BYTES_READ, nc_slab_bytes(ncinid, varinid, count));
 
   /* Close the input netCDF file. */
   istat = ncclose(ncinid);
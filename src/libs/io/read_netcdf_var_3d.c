@@ -83,6 +83,34 @@ read_netcdf_var_3d(double **buf, info_field_struct *info_field, proj_struct *pro
      \return           Status.
   */
 
+  return read_netcdf_var_3d_subdomain(buf, info_field, proj, filename, varname, dimxname, dimyname, timename,
+                                      (subdomain_struct *) NULL, nlon, nlat, ntime, outinfo);
+}
+
+/** Read only a subdomain of a 3D variable in a NetCDF file in double or single precision. */
+static int
+read_netcdf_var_3d_subdomain_buf(double **buf, float **buf_f, info_field_struct *info_field, proj_struct *proj, char *filename, char *varname,
+                                 char *dimxname, char *dimyname, char *timename, subdomain_struct *subdomain,
+                                 int *nlon, int *nlat, int *ntime, int outinfo) {
+  /**
+     @param[out]  buf        3D variable spanning only the subdomain in double precision, NULL if buf_f is used
+     @param[out]  buf_f      3D variable spanning only the subdomain in single precision, NULL if buf is used
+     @param[out]  info_field Information about the output variable
+     @param[out]  proj       Information about the horizontal projection of the output variable
+     @param[in]   filename   NetCDF input filename
+     @param[in]   varname    NetCDF variable name
+     @param[in]   dimxname    Longitude dimension name
+     @param[in]   dimyname    Latitude dimension name
+     @param[in]   timename   Time dimension name
+     @param[in]   subdomain  Index ranges of the subdomain to read, as computed by get_subdomain_index. NULL to read the whole domain.
+     @param[out]  nlon       Longitude dimension length in the file
+     @param[out]  nlat       Latitude dimension length in the file
+     @param[out]  ntime      Time dimension length
+     @param[in]   outinfo    TRUE if we want information output, FALSE if not
+     
+     \return           Status.
+  */
+
   int istat; /* Diagnostic status */
 
   size_t dimval; /* Variable used to retrieve dimension length */
@@ -99,6 +127,13 @@ read_netcdf_var_3d(double **buf, info_field_struct *info_field, proj_struct *pro
 
   size_t start[3]; /* Start position to read */
   size_t count[3]; /* Number of elements to read */
+  ptrdiff_t stride[3]; /* Stride of elements to read */
+  ptrdiff_t imap[3]; /* Position in memory of elements read */
+  int nsub; /* Number of points of the subdomain */
+  int ioff; /* Longitude offset of an index range in the subdomain */
+  int joff; /* Latitude offset of an index range in the subdomain */
+  int r; /* Index range loop counter */
+  int rr; /* Index range loop counter */
 
   float valf; /* Variable used to retrieve fillvalue */
   int vali; /* Variable used to retrieve integer values */
@@ -108,6 +143,12 @@ read_netcdf_var_3d(double **buf, info_field_struct *info_field, proj_struct *pro
   float *proj_latin = NULL; /* Parallel latitudes of projection */
   int npts = 0; /* Number of points for 1D variables */
   char *grid_mapping = NULL;
+  int ncformat; /* NetCDF file format */
+  int storage; /* Storage of the variable: contiguous or chunked */
+  int shuffle; /* Shuffle filter flag */
+  int deflate; /* Deflate filter flag */
+  int deflate_level; /* Deflate level */
+  int chunked = FALSE; /* TRUE if the variable is stored in compressed NetCDF-4 chunks */
 
   /* Allocate memory */
   tmpstr = (char *) malloc(MAXPATH * sizeof(char));
@@ -118,6 +159,7 @@ read_netcdf_var_3d(double **buf, info_field_struct *info_field, proj_struct *pro
   /* Open NetCDF file for reading */
   if (outinfo == TRUE)
     printf("%s: Opening for reading NetCDF input file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
@@ -153,6 +195,12 @@ read_netcdf_var_3d(double **buf, info_field_struct *info_field, proj_struct *pro
   istat = nc_inq_var(ncinid, varinid, (char *) NULL, &vartype_main, &varndims, vardimids, (int *) NULL);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
+  /* Compressed NetCDF-4 variables can be inflated in parallel by the direct chunk reader */
+  if (nc_inq_format(ncinid, &ncformat) == NC_NOERR && (ncformat == NC_FORMAT_NETCDF4 || ncformat == NC_FORMAT_NETCDF4_CLASSIC) &&
+      nc_inq_var_chunking(ncinid, varinid, &storage, (size_t *) NULL) == NC_NOERR && storage == NC_CHUNKED &&
+      nc_inq_var_deflate(ncinid, varinid, &shuffle, &deflate, &deflate_level) == NC_NOERR && deflate != 0)
+    chunked = TRUE;
+
   /* Verify that variable is really 3D or 2D */
   if (varndims != 3 && varndims != 2) {
     (void) fprintf(stderr, "%s: Error NetCDF type and/or dimensions nlon %d nlat %d.\n", __FILE__, *nlon, *nlat);
@@ -399,34 +447,127 @@ read_netcdf_var_3d(double **buf, info_field_struct *info_field, proj_struct *pro
     (void) free(grid_mapping);
   }
 
-  if (varndims == 3) {
-    /* Allocate memory and set start and count */
-    start[0] = 0;
-    start[1] = 0;
-    start[2] = 0;
-    count[0] = (size_t) *ntime;
-    count[1] = (size_t) *nlat;
-    count[2] = (size_t) *nlon;
-    /* Allocate memory */
-    (*buf) = (double *) malloc((*nlat)*(*nlon)*(*ntime) * sizeof(double));
-    if ((*buf) == NULL) alloc_error(__FILE__, __LINE__);
-  }
-  else if (varndims == 2) {
-    /* Allocate memory and set start and count */
+  if (varndims == 3 && subdomain != NULL && (subdomain->nlon_runs != 1 || subdomain->nlat_runs != 1)) {
+    /* Subdomain made of several index ranges, typically crossing the longitude wrap of the grid: */
+    /* read each block of the subdomain directly at its place in the output buffer */
+    nsub = subdomain->nlon * subdomain->nlat;
+    if (buf_f != NULL) {
+      (*buf_f) = (float *) malloc(nsub*(*ntime) * sizeof(float));
+      if ((*buf_f) == NULL) alloc_error(__FILE__, __LINE__);
+    }
+    else {
+      (*buf) = (double *) malloc(nsub*(*ntime) * sizeof(double));
+      if ((*buf) == NULL) alloc_error(__FILE__, __LINE__);
+    }
+    stride[0] = stride[1] = stride[2] = 1;
+    imap[0] = (ptrdiff_t) nsub;
+    imap[1] = (ptrdiff_t) subdomain->nlon;
+    imap[2] = 1;
     start[0] = 0;
-    start[1] = 0;
-    start[2] = 0;
     count[0] = (size_t) *ntime;
-    count[1] = (size_t) npts;
-    count[2] = 0;
-    /* Allocate memory */
-    (*buf) = (double *) malloc(npts*(*ntime) * sizeof(double));
-    if ((*buf) == NULL) alloc_error(__FILE__, __LINE__);
+    joff = 0;
+    for (rr=0; rr<subdomain->nlat_runs; rr++) {
+      start[1] = subdomain->lat_start[rr];
+      count[1] = subdomain->lat_count[rr];
+      ioff = 0;
+      for (r=0; r<subdomain->nlon_runs; r++) {
+        start[2] = subdomain->lon_start[r];
+        count[2] = subdomain->lon_count[r];
+        istat = 1;
+        if (chunked == TRUE && buf_f != NULL)
+          istat = read_netcdf_chunks_3d_f(&((*buf_f)[ioff+joff*subdomain->nlon]), filename, varname, start, count, imap);
+        else if (chunked == TRUE)
+          istat = read_netcdf_chunks_3d(&((*buf)[ioff+joff*subdomain->nlon]), filename, varname, start, count, imap);
+        if (istat != 0) {
+          if (buf_f != NULL)
+            istat = nc_get_varm_float(ncinid, varinid, start, count, stride, imap, &((*buf_f)[ioff+joff*subdomain->nlon]));
+          else
+            istat = nc_get_varm_double(ncinid, varinid, start, count, stride, imap, &((*buf)[ioff+joff*subdomain->nlon]));
+          if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+        }
+        (void) instrument_count(INSTR_BYTES_READ, nc_slab_bytes(ncinid, varinid, count));
+        ioff += (int) subdomain->lon_count[r];
+      }
+      joff += (int) subdomain->lat_count[rr];
+    }
   }
+  else {
+    if (varndims == 3 && subdomain != NULL) {
+      /* Subdomain is a single block: read it with one hyperslab */
+      start[0] = 0;
+      start[1] = subdomain->lat_start[0];
+      start[2] = subdomain->lon_start[0];
+      count[0] = (size_t) *ntime;
+      count[1] = subdomain->lat_count[0];
+      count[2] = subdomain->lon_count[0];
+      /* Allocate memory */
+      if (buf_f != NULL) {
+        (*buf_f) = (float *) malloc(subdomain->nlat*subdomain->nlon*(*ntime) * sizeof(float));
+        if ((*buf_f) == NULL) alloc_error(__FILE__, __LINE__);
+      }
+      else {
+        (*buf) = (double *) malloc(subdomain->nlat*subdomain->nlon*(*ntime) * sizeof(double));
+        if ((*buf) == NULL) alloc_error(__FILE__, __LINE__);
+      }
+    }
+    else if (varndims == 3) {
+      /* Allocate memory and set start and count */
+      start[0] = 0;
+      start[1] = 0;
+      start[2] = 0;
+      count[0] = (size_t) *ntime;
+      count[1] = (size_t) *nlat;
+      count[2] = (size_t) *nlon;
+      /* Allocate memory */
+      if (buf_f != NULL) {
+        (*buf_f) = (float *) malloc((*nlat)*(*nlon)*(*ntime) * sizeof(float));
+        if ((*buf_f) == NULL) alloc_error(__FILE__, __LINE__);
+      }
+      else {
+        (*buf) = (double *) malloc((*nlat)*(*nlon)*(*ntime) * sizeof(double));
+        if ((*buf) == NULL) alloc_error(__FILE__, __LINE__);
+      }
+    }
+    else {
+      /* 2D variable: list of points, always read whole */
+      /* Allocate memory and set start and count */
+      start[0] = 0;
+      start[1] = 0;
+      start[2] = 0;
+      count[0] = (size_t) *ntime;
+      count[1] = (size_t) npts;
+      count[2] = 0;
+      /* Allocate memory */
+      if (buf_f != NULL) {
+        (*buf_f) = (float *) malloc(npts*(*ntime) * sizeof(float));
+        if ((*buf_f) == NULL) alloc_error(__FILE__, __LINE__);
+      }
+      else {
+        (*buf) = (double *) malloc(npts*(*ntime) * sizeof(double));
+        if ((*buf) == NULL) alloc_error(__FILE__, __LINE__);
+      }
+    }
 
-  /* Read values from netCDF variable */
-  istat = nc_get_vara_double(ncinid, varinid, start, count, *buf);
-  if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+    /* Read values from netCDF variable, falling back to the NetCDF library when chunks cannot be read directly */
+    istat = 1;
+    if (varndims == 3 && chunked == TRUE) {
+      imap[0] = (ptrdiff_t) (count[1]*count[2]);
+      imap[1] = (ptrdiff_t) count[2];
+      imap[2] = 1;
+      if (buf_f != NULL)
+        istat = read_netcdf_chunks_3d_f(*buf_f, filename, varname, start, count, imap);
+      else
+        istat = read_netcdf_chunks_3d(*buf, filename, varname, start, count, imap);
+    }
+    if (istat != 0) {
+      if (buf_f != NULL)
+        istat = nc_get_vara_float(ncinid, varinid, start, count, *buf_f);
+      else
+        istat = nc_get_vara_double(ncinid, varinid, start, count, *buf);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+    }
+    (void) instrument_count(INSTR_BYTES_READ, nc_slab_bytes(ncinid, varinid, count));
+  }
 
   /* Close the input netCDF file. */
   istat = ncclose(ncinid);
@@ -438,3 +579,57 @@ read_netcdf_var_3d(double **buf, info_field_struct *info_field, proj_struct *pro
   /* Success status */
   return 0;
 }
+
+/** Read only a subdomain of a 3D variable in a NetCDF file, and return information in info_field_struct structure and proj_struct. */
+int
+read_netcdf_var_3d_subdomain(double **buf, info_field_struct *info_field, proj_struct *proj, char *filename, char *varname,
+                             char *dimxname, char *dimyname, char *timename, subdomain_struct *subdomain,
+                             int *nlon, int *nlat, int *ntime, int outinfo) {
+  /**
+     @param[out]  buf        3D variable spanning only the subdomain
+     @param[out]  info_field Information about the output variable
+     @param[out]  proj       Information about the horizontal projection of the output variable
+     @param[in]   filename   NetCDF input filename
+     @param[in]   varname    NetCDF variable name
+     @param[in]   dimxname    Longitude dimension name
+     @param[in]   dimyname    Latitude dimension name
+     @param[in]   timename   Time dimension name
+     @param[in]   subdomain  Index ranges of the subdomain to read, as computed by get_subdomain_index. NULL to read the whole domain.
+     @param[out]  nlon       Longitude dimension length in the file
+     @param[out]  nlat       Latitude dimension length in the file
+     @param[out]  ntime      Time dimension length
+     @param[in]   outinfo    TRUE if we want information output, FALSE if not
+     
+     \return           Status.
+  */
+
+  return read_netcdf_var_3d_subdomain_buf(buf, (float **) NULL, info_field, proj, filename, varname, dimxname, dimyname, timename,
+                                          subdomain, nlon, nlat, ntime, outinfo);
+}
+
+/** Read only a subdomain of a 3D variable in a NetCDF file directly in single precision. */
+int
+read_netcdf_var_3d_subdomain_f(float **buf, info_field_struct *info_field, proj_struct *proj, char *filename, char *varname,
+                               char *dimxname, char *dimyname, char *timename, subdomain_struct *subdomain,
+                               int *nlon, int *nlat, int *ntime, int outinfo) {
+  /**
+     @param[out]  buf        3D variable spanning only the subdomain, in single precision
+     @param[out]  info_field Information about the output variable
+     @param[out]  proj       Information about the horizontal projection of the output variable
+     @param[in]   filename   NetCDF input filename
+     @param[in]   varname    NetCDF variable name
+     @param[in]   dimxname    Longitude dimension name
+     @param[in]   dimyname    Latitude dimension name
+     @param[in]   timename   Time dimension name
+     @param[in]   subdomain  Index ranges of the subdomain to read, as computed by get_subdomain_index. NULL to read the whole domain.
+     @param[out]  nlon       Longitude dimension length in the file
+     @param[out]  nlat       Latitude dimension length in the file
+     @param[out]  ntime      Time dimension length
+     @param[in]   outinfo    TRUE if we want information output, FALSE if not
+     
+     \return           Status.
+  */
+
+  return read_netcdf_var_3d_subdomain_buf((double **) NULL, buf, info_field, proj, filename, varname, dimxname, dimyname, timename,
+                                          subdomain, nlon, nlat, ntime, outinfo);
+}
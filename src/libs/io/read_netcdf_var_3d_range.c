@@ -0,0 +1,215 @@
+/* ***************************************************** */
+/* read_netcdf_var_3d_range Read runs of consecutive     */
+/* 2D fields from a 3D NetCDF variable.                  */
+/* read_netcdf_var_3d_range.c                            */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file read_netcdf_var_3d_range.c
+    \brief Read runs of consecutive 2D fields from a 3D NetCDF variable.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <io.h>
+
+/** Read runs of consecutive 2D fields from a 3D NetCDF variable into a contiguous buffer, one hyperslab per run. */
+int
+read_netcdf_var_3d_range(double *buf, double *fillvalue, char *filename, char *varname, subdomain_struct *subdomain,
+                         size_t *tstart, size_t *tcount, int nruns, int nlon, int nlat) {
+  /**
+     @param[out]  buf        Preallocated output buffer, runs stored one after the other (time, lat, lon)
+     @param[out]  fillvalue  Missing value of the variable
+     @param[in]   filename   NetCDF input filename
+     @param[in]   varname    NetCDF variable name
+     @param[in]   subdomain  Index ranges of the subdomain to read, as computed by get_subdomain_index. NULL to read whole 2D fields.
+     @param[in]   tstart     First time index of each run
+     @param[in]   tcount     Number of timesteps of each run
+     @param[in]   nruns      Number of runs
+     @param[in]   nlon       Longitude dimension length (or number of points for lists of points)
+     @param[in]   nlat       Latitude dimension length (0 for lists of points)
+     
+     \return           Status.
+  */
+
+  int istat; /* Diagnostic status */
+
+  int ncinid; /* NetCDF input file handle ID */
+  int varinid; /* NetCDF variable ID */
+  int varndims; /* Number of dimensions of variable */
+  int vardimids[NC_MAX_VAR_DIMS]; /* Variable dimension ids */
+  size_t dimval; /* Variable used to retrieve dimension length */
+
+  size_t start[3]; /* Start position to read */
+  size_t count[3]; /* Number of elements to read */
+  ptrdiff_t stride[3]; /* Stride of elements to read */
+  ptrdiff_t imap[3]; /* Position in memory of elements read */
+  size_t npts; /* Number of points of each 2D field */
+  size_t offset = 0; /* Offset in output buffer */
+  size_t ioff; /* Longitude offset of an index range in the subdomain */
+  size_t joff; /* Latitude offset of an index range in the subdomain */
+  int run; /* Run counter */
+  int r; /* Index range loop counter */
+  int rr; /* Index range loop counter */
+
+  /* Open NetCDF file for reading */
+  (void) instrument_count(INSTR_NC_OPENS, 1);
+  istat = nc_open(filename, NC_NOWRITE, &ncinid);
+  if (istat != NC_NOERR) {
+    handle_netcdf_error(istat, __FILE__, __LINE__);
+    return -1;
+  }
+
+  /* Get main variable ID */
+  istat = nc_inq_varid(ncinid, varname, &varinid);
+  if (istat != NC_NOERR) {
+    (void) fprintf(stderr, "%s: Error with variable %s in file %s\n", __FILE__, varname, filename);
+    handle_netcdf_error(istat, __FILE__, __LINE__);
+    istat = ncclose(ncinid);
+    return -1;
+  }
+  istat = nc_inq_var(ncinid, varinid, (char *) NULL, (nc_type *) NULL, &varndims, vardimids, (int *) NULL);
+  if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+
+  /* Verify that variable dimensions match the expected ones */
+  if (varndims == 3 && nlat > 0) {
+    istat = nc_inq_dimlen(ncinid, vardimids[1], &dimval);
+    if (istat == NC_NOERR && (int) dimval == nlat)
+      istat = nc_inq_dimlen(ncinid, vardimids[2], &dimval);
+    if (istat != NC_NOERR || (int) dimval != nlon) {
+      (void) fprintf(stderr, "%s: Error NetCDF type and/or dimensions nlon %d nlat %d in file %s.\n", __FILE__, nlon, nlat, filename);
+      istat = ncclose(ncinid);
+      return -1;
+    }
+    if (subdomain != NULL)
+      npts = (size_t) subdomain->nlat * (size_t) subdomain->nlon;
+    else
+      npts = (size_t) nlat * (size_t) nlon;
+  }
+  else if (varndims == 2 && nlat == 0 && subdomain == NULL) {
+    istat = nc_inq_dimlen(ncinid, vardimids[1], &dimval);
+    if (istat != NC_NOERR || (int) dimval != nlon) {
+      (void) fprintf(stderr, "%s: Error NetCDF type and/or dimensions nlon %d in file %s.\n", __FILE__, nlon, filename);
+      istat = ncclose(ncinid);
+      return -1;
+    }
+    npts = (size_t) nlon;
+  }
+  else {
+    (void) fprintf(stderr, "%s: Error NetCDF type and/or dimensions nlon %d nlat %d in file %s.\n", __FILE__, nlon, nlat, filename);
+    istat = ncclose(ncinid);
+    return -1;
+  }
+
+  /* Get missing value */
+  istat = nc_get_att_double(ncinid, varinid, "missing_value", fillvalue);
+  if (istat != NC_NOERR) {
+    istat = nc_get_att_double(ncinid, varinid, "_FillValue", fillvalue);
+    if (istat != NC_NOERR)
+      *fillvalue = -9999.0;
+  }
+
+  /* Read each run of consecutive timesteps with one hyperslab */
+  stride[0] = stride[1] = stride[2] = 1;
+  for (run=0; run<nruns; run++) {
+    start[0] = tstart[run];
+    count[0] = tcount[run];
+    if (subdomain != NULL && (subdomain->nlon_runs != 1 || subdomain->nlat_runs != 1)) {
+      /* Subdomain made of several index ranges: read each block directly at its place in the output buffer */
+      imap[0] = (ptrdiff_t) npts;
+      imap[1] = (ptrdiff_t) subdomain->nlon;
+      imap[2] = 1;
+      istat = NC_NOERR;
+      joff = 0;
+      for (rr=0; rr<subdomain->nlat_runs && istat == NC_NOERR; rr++) {
+        start[1] = subdomain->lat_start[rr];
+        count[1] = subdomain->lat_count[rr];
+        ioff = 0;
+        for (r=0; r<subdomain->nlon_runs && istat == NC_NOERR; r++) {
+          start[2] = subdomain->lon_start[r];
+          count[2] = subdomain->lon_count[r];
+          istat = nc_get_varm_double(ncinid, varinid, start, count, stride, imap,
+                                     buf + offset + ioff + joff * (size_t) subdomain->nlon);
+          (void) instrument_count(INSTR_BYTES_READ, nc_slab_bytes(ncinid, varinid, count));
+          ioff += subdomain->lon_count[r];
+        }
+        joff += subdomain->lat_count[rr];
+      }
+    }
+    else {
+      start[1] = 0;
+      start[2] = 0;
+      if (varndims == 3 && subdomain != NULL) {
+        /* Subdomain is a single block */
+        start[1] = subdomain->lat_start[0];
+        start[2] = subdomain->lon_start[0];
+        count[1] = subdomain->lat_count[0];
+        count[2] = subdomain->lon_count[0];
+      }
+      else if (varndims == 3) {
+        count[1] = (size_t) nlat;
+        count[2] = (size_t) nlon;
+      }
+      else {
+        count[1] = (size_t) nlon;
+        count[2] = 0;
+      }
+      istat = nc_get_vara_double(ncinid, varinid, start, count, buf + offset);
+      (void) instrument_count(INSTR_BYTES_READ, nc_slab_bytes(ncinid, varinid, count));
+    }
+    if (istat != NC_NOERR) {
+      handle_netcdf_error(istat, __FILE__, __LINE__);
+      istat = ncclose(ncinid);
+      return -1;
+    }
+    offset += tcount[run] * npts;
+  }
+
+  /* Close the input netCDF file. */
+  istat = ncclose(ncinid);
+  if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+
+  /* Success status */
+  return 0;
+}
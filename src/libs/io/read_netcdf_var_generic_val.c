@@ -100,6 +100,7 @@ read_netcdf_var_generic_val(double *buf, info_field_struct *info_field, char *fi
 
   /* Open NetCDF file for reading */
   printf("%s: Opening for reading NetCDF input file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
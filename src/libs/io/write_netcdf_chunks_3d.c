@@ -0,0 +1,340 @@
+/* ***************************************************** */
+/* Compress a 2D field chunk by chunk and write it       */
+/* in a 3D NetCDF-4 variable with direct chunk writes.   */
+/* write_netcdf_chunks_3d.c                              */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file write_netcdf_chunks_3d.c
+    \brief Compress a 2D field chunk by chunk and write it in a 3D NetCDF-4 variable with direct chunk writes.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <io.h>
+
+/** Target uncompressed size in bytes of the chunks of a 2D field. */
+#define NC_CHUNKS_TARGET_BYTES 1048576
+
+/** Chunk compression task. */
+typedef struct {
+  nc_chunks_struct *chunks; /**< Compressed field */
+  double *buf; /**< 2D field */
+  double fillvalue; /**< Missing value, also padding the last chunk */
+  nc_encoding_struct *encoding; /**< Output encoding, NULL for plain floats */
+  int nlat; /**< Latitude dimension of the field */
+  int level; /**< Deflate level */
+  int c; /**< Chunk index */
+  int istat; /**< Status of compression */
+  int *npending; /**< Number of chunks of the field not yet compressed */
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t *mutex; /**< Mutex protecting npending */
+  pthread_cond_t *cond; /**< Signaled when npending drops to 0 */
+#endif
+} nc_chunks_encode_struct;
+
+/** Number of latitude rows in each chunk of a 2D field written with direct chunk writes. */
+int
+netcdf_chunks_rows(int nlat, int nlon) {
+  /**
+     @param[in]  nlat  Latitude dimension
+     @param[in]  nlon  Longitude dimension
+
+     \return           Number of rows per chunk.
+  */
+
+  int rows; /* Rows per chunk */
+
+  rows = NC_CHUNKS_TARGET_BYTES / ((nlon > 0 ? nlon : 1) * (int) sizeof(float));
+  if (rows < 1)
+    rows = 1;
+  if (rows > nlat)
+    rows = nlat;
+
+  return rows;
+}
+
+/** Encode one chunk of a 2D field as floats or packed shorts and deflate it. */
+static void
+nc_chunks_encode(void *arg) {
+  /**
+     @param[in,out]  arg  Chunk compression task (nc_chunks_encode_struct).
+  */
+
+  nc_chunks_encode_struct *task = (nc_chunks_encode_struct *) arg; /* Chunk compression task */
+  nc_chunks_struct *chunks = task->chunks; /* Compressed field */
+
+  unsigned char *raw = NULL; /* Uncompressed chunk */
+  size_t rawbytes; /* Size of the uncompressed chunk */
+  size_t nelem; /* Number of elements in the chunk */
+  size_t first; /* First element of the chunk in the field */
+  size_t nvalid; /* Number of elements of the chunk inside the field */
+  uLongf destlen; /* Compressed size */
+  size_t i; /* Loop counter */
+
+  nelem = (size_t) chunks->chunk_nlat * (size_t) chunks->nlon;
+  first = (size_t) task->c * nelem;
+  nvalid = (size_t) task->nlat * (size_t) chunks->nlon - first;
+  if (nvalid > nelem)
+    nvalid = nelem;
+
+  rawbytes = nelem * (size_t) chunks->typesize;
+  raw = (unsigned char *) malloc(rawbytes * sizeof(unsigned char));
+  if (raw == NULL) alloc_error(__FILE__, __LINE__);
+  (void) encode_netcdf_values(raw, &(task->buf[first]), nvalid, task->fillvalue, task->encoding);
+  /* HDF5 always stores whole chunks: pad the last one */
+  for (i=nvalid; i<nelem; i++)
+    if (chunks->typesize == sizeof(short int))
+      ((short int *) raw)[i] = NC_PACKED_FILL;
+    else
+      ((float *) raw)[i] = (float) task->fillvalue;
+
+  destlen = compressBound((uLong) rawbytes);
+  chunks->data[task->c] = (unsigned char *) malloc((size_t) destlen * sizeof(unsigned char));
+  if (chunks->data[task->c] == NULL) alloc_error(__FILE__, __LINE__);
+  task->istat = (compress2(chunks->data[task->c], &destlen, (Bytef *) raw, (uLong) rawbytes, task->level) == Z_OK) ? 0 : -1;
+  chunks->size[task->c] = (size_t) destlen;
+  (void) free(raw);
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(task->mutex);
+  if (--(*(task->npending)) == 0)
+    (void) pthread_cond_signal(task->cond);
+  (void) pthread_mutex_unlock(task->mutex);
+#else
+  (*(task->npending))--;
+#endif
+}
+
+/** Split a 2D field into chunks of whole latitude rows, and compress them in parallel on a thread pool. */
+int
+encode_netcdf_chunks_2d(nc_chunks_struct *chunks, double *buf, double fillvalue, int nlat, int nlon,
+                        int compression_level, nc_encoding_struct *encoding, thread_pool_struct *pool) {
+  /**
+     @param[out]  chunks             Compressed field, to be freed with free_netcdf_chunks
+     @param[in]   buf                2D field
+     @param[in]   fillvalue          Missing value, used to pad the last chunk
+     @param[in]   nlat               Latitude dimension
+     @param[in]   nlon               Longitude dimension
+     @param[in]   compression_level  Deflate level, between 1 and 9
+     @param[in]   encoding           Output encoding, NULL for plain floats
+     @param[in]   pool               Thread pool compressing the chunks, or NULL to compress them serially.
+                                     Other users of the pool are not waited for.
+
+     \return                         Status.
+  */
+
+  nc_chunks_encode_struct *tasks = NULL; /* Chunk compression tasks */
+  int npending; /* Number of chunks not yet compressed */
+  int c; /* Chunk loop counter */
+  int istat = 0; /* Diagnostic status */
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t mutex; /* Mutex protecting npending */
+  pthread_cond_t cond; /* Signaled when all chunks are compressed */
+
+  (void) pthread_mutex_init(&mutex, NULL);
+  (void) pthread_cond_init(&cond, NULL);
+#endif
+
+  chunks->nlon = nlon;
+  chunks->typesize = (encoding != NULL && encoding->type == NC_ENCODING_SHORT) ? (int) sizeof(short int) : (int) sizeof(float);
+  chunks->chunk_nlat = netcdf_chunks_rows(nlat, nlon);
+  chunks->nchunks = (nlat + chunks->chunk_nlat - 1) / chunks->chunk_nlat;
+  chunks->data = (unsigned char **) calloc(chunks->nchunks, sizeof(unsigned char *));
+  if (chunks->data == NULL) alloc_error(__FILE__, __LINE__);
+  chunks->size = (size_t *) malloc(chunks->nchunks * sizeof(size_t));
+  if (chunks->size == NULL) alloc_error(__FILE__, __LINE__);
+
+  tasks = (nc_chunks_encode_struct *) malloc(chunks->nchunks * sizeof(nc_chunks_encode_struct));
+  if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+  npending = chunks->nchunks;
+  for (c=0; c<chunks->nchunks; c++) {
+    tasks[c].chunks = chunks;
+    tasks[c].buf = buf;
+    tasks[c].fillvalue = fillvalue;
+    tasks[c].encoding = encoding;
+    tasks[c].nlat = nlat;
+    tasks[c].level = compression_level;
+    tasks[c].c = c;
+    tasks[c].istat = 0;
+    tasks[c].npending = &npending;
+#ifdef HAVE_PTHREAD
+    tasks[c].mutex = &mutex;
+    tasks[c].cond = &cond;
+#endif
+    if (pool != NULL)
+      (void) thread_pool_submit(pool, nc_chunks_encode, (void *) &(tasks[c]));
+    else
+      (void) nc_chunks_encode((void *) &(tasks[c]));
+  }
+
+  /* Wait for the chunks of this field only: the pool may be shared by concurrent writers */
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&mutex);
+  while (npending > 0)
+    (void) pthread_cond_wait(&cond, &mutex);
+  (void) pthread_mutex_unlock(&mutex);
+  (void) pthread_mutex_destroy(&mutex);
+  (void) pthread_cond_destroy(&cond);
+#endif
+
+  for (c=0; c<chunks->nchunks; c++)
+    if (tasks[c].istat != 0)
+      istat = -1;
+  (void) free(tasks);
+
+  if (istat != 0)
+    (void) fprintf(stderr, "%s: Cannot compress field chunks.\n", __FILE__);
+
+  return istat;
+}
+
+/** Free the memory of a compressed field. */
+void
+free_netcdf_chunks(nc_chunks_struct *chunks) {
+  /**
+     @param[in,out]  chunks  Compressed field
+  */
+
+  int c; /* Chunk loop counter */
+
+  if (chunks == NULL || chunks->data == NULL)
+    return;
+  for (c=0; c<chunks->nchunks; c++)
+    if (chunks->data[c] != NULL)
+      (void) free(chunks->data[c]);
+  (void) free(chunks->data);
+  (void) free(chunks->size);
+  chunks->data = NULL;
+  chunks->size = NULL;
+  chunks->nchunks = 0;
+}
+
+/** Write a compressed 2D field at a time index of a 3D NetCDF-4 variable with HDF5 direct chunk writes. The NetCDF file must be closed. */
+int
+write_netcdf_chunks_3d(nc_chunks_struct *chunks, char *filename, char *varname, int t) {
+  /**
+     @param[in]  chunks    Compressed field
+     @param[in]  filename  NetCDF-4 output filename
+     @param[in]  varname   NetCDF variable name
+     @param[in]  t         Time index where the field is written, extending the variable if needed
+
+     \return               0 on success, 1 if the variable layout does not match the chunks and the field must be
+                           written through the NetCDF library instead, -1 on error.
+  */
+
+#if H5_VERSION_GE(1,10,2)
+  H5E_auto2_t errfunc; /* Saved HDF5 error handler */
+  void *errdata; /* Saved HDF5 error handler data */
+  hid_t fid = -1; /* HDF5 file ID */
+  hid_t did = -1; /* HDF5 dataset ID */
+  hid_t sid = -1; /* HDF5 dataspace ID */
+  hid_t tid = -1; /* HDF5 datatype ID */
+  hid_t pid = -1; /* HDF5 dataset creation property list ID */
+  hsize_t dims[3]; /* Dataset dimensions */
+  hsize_t cdim[3]; /* Chunk dimensions */
+  hsize_t offset[3]; /* Position of the chunk being written */
+  size_t nelmts = 0; /* Number of filter parameters */
+  unsigned int flags; /* Filter flags */
+  int c; /* Chunk loop counter */
+  int istat = 0; /* Diagnostic status */
+
+  (void) H5Eget_auto2(H5E_DEFAULT, &errfunc, &errdata);
+  (void) H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+  fid = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+  if (fid >= 0)
+    did = H5Dopen2(fid, varname, H5P_DEFAULT);
+  if (did >= 0) {
+    sid = H5Dget_space(did);
+    tid = H5Dget_type(did);
+    pid = H5Dget_create_plist(did);
+  }
+  if (did < 0 || sid < 0 || tid < 0 || pid < 0)
+    istat = 1;
+
+  /* The variable must be of the encoded type and chunked exactly as the field was, with deflate as only filter */
+  if (istat == 0 && (H5Sget_simple_extent_ndims(sid) != 3 || H5Pget_layout(pid) != H5D_CHUNKED ||
+                     H5Pget_chunk(pid, 3, cdim) != 3 ||
+                     H5Tequal(tid, (chunks->typesize == sizeof(short int)) ? H5T_NATIVE_SHORT : H5T_NATIVE_FLOAT) <= 0 ||
+                     H5Pget_nfilters(pid) != 1 ||
+                     H5Pget_filter2(pid, 0, &flags, &nelmts, NULL, 0, NULL, NULL) != H5Z_FILTER_DEFLATE))
+    istat = 1;
+  if (istat == 0) {
+    (void) H5Sget_simple_extent_dims(sid, dims, NULL);
+    if (cdim[0] != 1 || cdim[1] != (hsize_t) chunks->chunk_nlat || cdim[2] != (hsize_t) chunks->nlon ||
+        dims[2] != (hsize_t) chunks->nlon ||
+        (dims[1] + cdim[1] - 1) / cdim[1] != (hsize_t) chunks->nchunks)
+      istat = 1;
+  }
+
+  if (istat == 0 && dims[0] <= (hsize_t) t) {
+    dims[0] = (hsize_t) t + 1;
+    if (H5Dset_extent(did, dims) < 0)
+      istat = -1;
+  }
+
+  offset[0] = (hsize_t) t;
+  offset[2] = 0;
+  for (c=0; c<chunks->nchunks && istat == 0; c++) {
+    offset[1] = (hsize_t) c * cdim[1];
+    if (H5Dwrite_chunk(did, H5P_DEFAULT, 0, offset, chunks->size[c], chunks->data[c]) < 0)
+      istat = -1;
+  }
+  if (istat < 0)
+    (void) fprintf(stderr, "%s: Cannot write chunks of variable %s in file %s.\n", __FILE__, varname, filename);
+
+  if (pid >= 0) (void) H5Pclose(pid);
+  if (tid >= 0) (void) H5Tclose(tid);
+  if (sid >= 0) (void) H5Sclose(sid);
+  if (did >= 0) (void) H5Dclose(did);
+  if (fid >= 0) (void) H5Fclose(fid);
+  (void) H5Eset_auto2(H5E_DEFAULT, errfunc, errdata);
+
+  return istat;
+#else
+  /* Direct chunk writes need HDF5 1.10.2 or later */
+  return 1;
+#endif
+}
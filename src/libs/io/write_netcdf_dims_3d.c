@@ -146,6 +146,7 @@ write_netcdf_dims_3d(double *lon, double *lat, double *x, double *y, double *alt
   /* Open NetCDF file */
   if (outinfo == TRUE)
     printf("%s: Writing info from NetCDF output file %s\n", __FILE__, filename);
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_WRITE, &ncoutid);  /* open NetCDF file */
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
@@ -135,6 +135,7 @@ write_netcdf_var_3d(double *buf, double fillvalue, char *filename,
     } */
 
   /** Open already existing output file **/
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_WRITE, &ncoutid);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
   
@@ -248,6 +249,7 @@ write_netcdf_var_3d(double *buf, double fillvalue, char *filename,
     printf("%s: WRITE %s %s\n", __FILE__, varname, filename);
   istat = nc_put_vara_double(ncoutid, varoutid, start, count, buf);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+  (void) instrument_count(INSTR_BYTES_WRITTEN, nc_slab_bytes(ncoutid, varoutid, count));
 
   /* Close the output netCDF file. */
   istat = ncclose(ncoutid);
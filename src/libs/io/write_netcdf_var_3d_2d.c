@@ -63,13 +63,35 @@ LICENSE END */
 
 #include <io.h>
 
+/** Write a hyperslab of a variable, already encoded or as doubles converted by the NetCDF library. */
+static int
+write_netcdf_encoded(int ncoutid, int varoutid, size_t *start, size_t *count, double *buf, void *encoded, nc_type vartype) {
+  /**
+     @param[in]  ncoutid   NetCDF output file handle ID
+     @param[in]  varoutid  NetCDF variable ID
+     @param[in]  start     Start element
+     @param[in]  count     Count of elements
+     @param[in]  buf       Values
+     @param[in]  encoded   Values encoded by encode_netcdf_values, or NULL to write buf
+     @param[in]  vartype   Type of the variable in the file
+
+     \return               NetCDF status.
+  */
+
+  if (encoded == NULL)
+    return nc_put_vara_double(ncoutid, varoutid, start, count, buf);
+  if (vartype == NC_SHORT)
+    return nc_put_vara_short(ncoutid, varoutid, start, count, (short int *) encoded);
+  return nc_put_vara_float(ncoutid, varoutid, start, count, (float *) encoded);
+}
+
 /** Write a 2D field in a 3D NetCDF variable. */
 int
 write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *filename,
                        char *varname, char *longname, char *units, char *height,
                        char *gridname, char *lonname, char *latname, char *timename,
                        int t, int newfile, int format, int compression_level,
-                       int nlon, int nlat, int ntime, int outinfo) {
+                       int nlon, int nlat, int ntime, nc_encoding_struct *encoding, nc_chunks_struct *chunks, int outinfo) {
   /**
      @param[in]  buf               3D Field to write
      @param[in]  timein            Time dimension value
@@ -91,6 +113,9 @@ write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *file
      @param[in]  nlon              Longitude dimension
      @param[in]  nlat              Latitude dimension
      @param[in]  ntime             Time dimension
+     @param[in]  encoding          Output encoding of the variable (packed shorts or bit-grooming), NULL for plain floats
+     @param[in]  chunks            Field already compressed by encode_netcdf_chunks_2d, written with direct chunk writes
+                                   (NetCDF-4 gridded output only), or NULL to write buf through the NetCDF library
      
      \return                       Status.
   */
@@ -115,6 +140,21 @@ write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *file
   int nlat_file; /* Latitude dimension in NetCDF output file */
   int nlon_file; /* Longitude dimension in NetCDF output file */
 
+  size_t chunksize[3]; /* Chunk dimensions */
+  int storage; /* Storage of the variable: contiguous or chunked */
+  int shuffle; /* Shuffle filter flag */
+  int deflate; /* Deflate filter flag */
+  int deflate_level; /* Deflate level */
+  int direct = FALSE; /* TRUE if the field is written with direct chunk writes */
+  nc_type vartype; /* Type of the variable in the file */
+  size_t nbytes = 0; /* Number of bytes of the hyperslab written */
+  nc_encoding_struct packing; /* Packing read from the file */
+  void *encoded = NULL; /* Encoded field */
+  short int packed_fill = NC_PACKED_FILL; /* Fill value of packed shorts */
+  float valf; /* Packing attribute value */
+  int nsd; /* Number of significant digits attribute value */
+  size_t npts; /* Number of points of the field */
+
   size_t start[3]; /* Start element when writing */
   size_t count[3]; /* Count of elements to write */
 
@@ -144,6 +184,7 @@ write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *file
     } */
 
   /** Open already existing output file **/
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_WRITE, &ncoutid);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);  
 
@@ -190,14 +231,15 @@ write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *file
     
     /* Define main output variable */
     vardimids[0] = timedimoutid;
+    vartype = (encoding != NULL && encoding->type == NC_ENCODING_SHORT) ? NC_SHORT : NC_FLOAT;
     if ( !strcmp(gridname, "list") ) {
       vardimids[1] = londimoutid;
-      istat = nc_def_var(ncoutid, varname, NC_FLOAT, 2, vardimids, &varoutid);  
+      istat = nc_def_var(ncoutid, varname, vartype, 2, vardimids, &varoutid);  
     }
     else {
       vardimids[1] = latdimoutid;
       vardimids[2] = londimoutid;
-      istat = nc_def_var(ncoutid, varname, NC_FLOAT, 3, vardimids, &varoutid);  
+      istat = nc_def_var(ncoutid, varname, vartype, 3, vardimids, &varoutid);  
     }
     if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
@@ -206,6 +248,14 @@ write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *file
       /* Set up compression level */
       istat = nc_def_var_deflate(ncoutid, varoutid, 0, 1, compression_level);
       if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      /* Chunks of whole latitude rows of a single timestep, as assembled by encode_netcdf_chunks_2d */
+      if (chunks != NULL && strcmp(gridname, "list")) {
+        chunksize[0] = (size_t) 1;
+        chunksize[1] = (size_t) netcdf_chunks_rows(nlat, nlon);
+        chunksize[2] = (size_t) nlon;
+        istat = nc_def_var_chunking(ncoutid, varoutid, NC_CHUNKED, chunksize);
+        if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      }
       /* Set up chunking */
       /*      if ( !strcmp(gridname, "list") ) {
         chunksize[0] = (size_t) 1;
@@ -223,13 +273,36 @@ write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *file
 #endif
 
     /* Set main variable attributes */
-    (void) strcpy(attname, "_FillValue");
-    istat = nc_put_att_double(ncoutid, varoutid, attname, NC_FLOAT, 1, &fillvalue);
-    if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+    if (vartype == NC_SHORT) {
+      /* Packed values: CF readers unpack them as floats with scale_factor and add_offset */
+      (void) strcpy(attname, "_FillValue");
+      istat = nc_put_att_short(ncoutid, varoutid, attname, NC_SHORT, 1, &packed_fill);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      (void) strcpy(attname, "missing_value");
+      istat = nc_put_att_short(ncoutid, varoutid, attname, NC_SHORT, 1, &packed_fill);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      valf = (float) encoding->scale_factor;
+      istat = nc_put_att_float(ncoutid, varoutid, "scale_factor", NC_FLOAT, 1, &valf);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      valf = (float) encoding->add_offset;
+      istat = nc_put_att_float(ncoutid, varoutid, "add_offset", NC_FLOAT, 1, &valf);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+    }
+    else {
+      (void) strcpy(attname, "_FillValue");
+      istat = nc_put_att_double(ncoutid, varoutid, attname, NC_FLOAT, 1, &fillvalue);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
     
-    (void) strcpy(attname, "missing_value");
-    istat = nc_put_att_double(ncoutid, varoutid, attname, NC_FLOAT, 1, &fillvalue);
-    if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      (void) strcpy(attname, "missing_value");
+      istat = nc_put_att_double(ncoutid, varoutid, attname, NC_FLOAT, 1, &fillvalue);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+
+      if (encoding != NULL && encoding->type == NC_ENCODING_DIGITS) {
+        nsd = encoding->nsd;
+        istat = nc_put_att_int(ncoutid, varoutid, "significant_digits", NC_INT, 1, &nsd);
+        if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      }
+    }
     
     tmpstr = (char *) malloc(100 * sizeof(char));
     if (tmpstr == NULL) alloc_error(__FILE__, __LINE__);
@@ -275,14 +348,82 @@ write_netcdf_var_3d_2d(double *buf, double *timein, double fillvalue, char *file
   }
   if (outinfo == TRUE)
     printf("%s: WRITE %s %s\n", __FILE__, varname, filename);
-  istat = nc_put_vara_double(ncoutid, varoutid, start, count, buf);
+
+  /* Encode values as the variable was defined: a file created with another encoding keeps its own */
+  istat = nc_inq_vartype(ncoutid, varoutid, &vartype);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+  nbytes = nc_slab_bytes(ncoutid, varoutid, count);
+  if (vartype == NC_SHORT && (encoding == NULL || encoding->type != NC_ENCODING_SHORT || newfile == FALSE)) {
+    /* Pack with the attributes of the file */
+    packing.type = NC_ENCODING_SHORT;
+    packing.nsd = 0;
+    if (nc_get_att_double(ncoutid, varoutid, "scale_factor", &(packing.scale_factor)) != NC_NOERR)
+      packing.scale_factor = 1.0;
+    if (nc_get_att_double(ncoutid, varoutid, "add_offset", &(packing.add_offset)) != NC_NOERR)
+      packing.add_offset = 0.0;
+    if (encoding == NULL || encoding->type != NC_ENCODING_SHORT || encoding->scale_factor != packing.scale_factor ||
+        encoding->add_offset != packing.add_offset) {
+      (void) fprintf(stderr, "%s: WARNING: Variable %s in file %s was packed with other settings: using them.\n",
+                     __FILE__, varname, filename);
+      chunks = NULL;
+    }
+    encoding = &packing;
+  }
+  else if (vartype != NC_SHORT && encoding != NULL && encoding->type == NC_ENCODING_SHORT) {
+    (void) fprintf(stderr, "%s: WARNING: Variable %s in file %s was not created packed: writing it as floats.\n",
+                   __FILE__, varname, filename);
+    encoding = NULL;
+    chunks = NULL;
+  }
+  if (encoding != NULL && encoding->type != NC_ENCODING_FLOAT) {
+    npts = (size_t) count[1] * ((count[2] > 0) ? count[2] : 1);
+    encoded = malloc(npts * ((vartype == NC_SHORT) ? sizeof(short int) : sizeof(float)));
+    if (encoded == NULL) alloc_error(__FILE__, __LINE__);
+    (void) encode_netcdf_values(encoded, buf, npts, fillvalue, encoding);
+  }
+
+  /* Pre-compressed chunks can be written directly only if the variable was chunked the same way */
+  if (chunks != NULL && chunks->data != NULL && strcmp(gridname, "list") &&
+      nc_inq_var_chunking(ncoutid, varoutid, &storage, chunksize) == NC_NOERR && storage == NC_CHUNKED &&
+      chunksize[0] == 1 && chunksize[1] == (size_t) chunks->chunk_nlat && chunksize[2] == (size_t) chunks->nlon &&
+      nc_inq_var_deflate(ncoutid, varoutid, &shuffle, &deflate, &deflate_level) == NC_NOERR && shuffle == 0 && deflate != 0)
+    direct = TRUE;
+
+  if (direct == FALSE) {
+    istat = write_netcdf_encoded(ncoutid, varoutid, start, count, buf, encoded, vartype);
+    if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+  }
 
   /* Close the output netCDF file. */
   istat = ncclose(ncoutid);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
+  if (direct == TRUE) {
+    /* The NetCDF file is closed: the chunks go straight to the HDF5 dataset of the variable */
+    istat = write_netcdf_chunks_3d(chunks, filename, varname, (int) start[0]);
+    if (istat < 0) {
+      if (encoded != NULL)
+        (void) free(encoded);
+      (void) free(attname);
+      return -1;
+    }
+    if (istat > 0) {
+      /* Layout not handled by direct chunk writes: write through the NetCDF library */
+      istat = nc_open(filename, NC_WRITE, &ncoutid);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      istat = nc_inq_varid(ncoutid, varname, &varoutid);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      istat = write_netcdf_encoded(ncoutid, varoutid, start, count, buf, encoded, vartype);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+      istat = ncclose(ncoutid);
+      if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+    }
+  }
+  (void) instrument_count(INSTR_BYTES_WRITTEN, nbytes);
+
   /* Free memory */
+  if (encoded != NULL)
+    (void) free(encoded);
   (void) free(attname);
 
   /* Diagnostic status */
@@ -0,0 +1,266 @@
+/* ***************************************************** */
+/* Region allocator with phase lifetimes.                */
+/* arena.c                                               */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file arena.c
+    \brief Region allocator with phase lifetimes.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <misc.h>
+
+/** Round a number of bytes up to the arena alignment. */
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1))
+
+/** Header size of an arena block, keeping the first allocation aligned. */
+#define ARENA_HEADER ARENA_ROUND(sizeof(arena_block_struct))
+
+/** Create an empty arena. Memory is obtained from the system in blocks of block_size bytes. */
+arena_struct *
+arena_create(char *name, size_t block_size) {
+  /**
+     @param[in]  name        Name of the arena, used in reports.
+     @param[in]  block_size  Size in bytes of the blocks obtained from the system. 0 selects ARENA_BLOCK_SIZE.
+
+     \return                 Arena structure.
+  */
+
+  arena_struct *arena = NULL; /* Arena */
+
+  arena = (arena_struct *) malloc(sizeof(arena_struct));
+  if (arena == NULL) alloc_error(__FILE__, __LINE__);
+
+  arena->name = strdup(name);
+  if (arena->name == NULL) alloc_error(__FILE__, __LINE__);
+  if (block_size == 0)
+    block_size = ARENA_BLOCK_SIZE;
+  arena->block_size = block_size;
+  arena->blocks = NULL;
+  arena->nallocs = 0;
+  arena->nbytes = 0;
+  arena->nblocks = 0;
+  arena->size = 0;
+  arena->peak_size = 0;
+  arena->nresets = 0;
+  arena->rss = 0;
+  arena->peak_rss = 0;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_init(&(arena->mutex), NULL);
+#endif
+
+  return arena;
+}
+
+/** Allocate memory in an arena. The memory is only released with arena_reset or arena_free. */
+void *
+arena_alloc(arena_struct *arena, size_t byte_size) {
+  /**
+     @param[in]  arena      Arena structure.
+     @param[in]  byte_size  Number of bytes to allocate.
+
+     \return                Pointer to allocated memory, aligned on ARENA_ALIGN bytes, NULL on failure.
+  */
+
+  arena_block_struct *block = NULL; /* Current block */
+  size_t size; /* Size of new block */
+  void *ptr = NULL; /* Allocated memory */
+
+  byte_size = ARENA_ROUND(byte_size > 0 ? byte_size : 1);
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(arena->mutex));
+#endif
+
+  block = arena->blocks;
+  if (block == NULL || block->used + byte_size > block->size) {
+    /* Start a new block. Requests larger than the block size get a block of their own. */
+    size = (byte_size > arena->block_size) ? byte_size : arena->block_size;
+    block = (arena_block_struct *) malloc(ARENA_HEADER + size);
+    if (block != NULL) {
+      block->size = size;
+      block->used = 0;
+      if (arena->blocks != NULL && size > arena->block_size) {
+        /* Keep filling the current block: insert the dedicated block behind it */
+        block->next = arena->blocks->next;
+        arena->blocks->next = block;
+      }
+      else {
+        block->next = arena->blocks;
+        arena->blocks = block;
+      }
+      arena->nblocks++;
+      arena->size += ARENA_HEADER + size;
+      if (arena->size > arena->peak_size)
+        arena->peak_size = arena->size;
+    }
+  }
+
+  if (block != NULL) {
+    ptr = (void *) ((char *) block + ARENA_HEADER + block->used);
+    block->used += byte_size;
+    arena->nallocs++;
+    arena->nbytes += byte_size;
+  }
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&(arena->mutex));
+#endif
+
+  return ptr;
+}
+
+/** Allocate zeroed memory for an array in an arena. */
+void *
+arena_calloc(arena_struct *arena, size_t nmemb, size_t size) {
+  /**
+     @param[in]  arena  Arena structure.
+     @param[in]  nmemb  Number of elements.
+     @param[in]  size   Size in bytes of one element.
+
+     \return            Pointer to allocated memory, NULL on failure.
+  */
+
+  void *ptr = NULL; /* Allocated memory */
+
+  ptr = arena_alloc(arena, nmemb * size);
+  if (ptr != NULL)
+    (void) memset(ptr, 0, nmemb * size);
+
+  return ptr;
+}
+
+/** Duplicate a string in an arena. */
+char *
+arena_strdup(arena_struct *arena, const char *str) {
+  /**
+     @param[in]  arena  Arena structure.
+     @param[in]  str    String to duplicate.
+
+     \return            Duplicated string, NULL on failure.
+  */
+
+  char *dup = NULL; /* Duplicated string */
+  size_t len; /* Length of string including terminating null byte */
+
+  len = strlen(str) + 1;
+  dup = (char *) arena_alloc(arena, len);
+  if (dup != NULL)
+    (void) memcpy(dup, str, len);
+
+  return dup;
+}
+
+/** Release all memory allocated in an arena in one call. The arena can be reused and its statistics are kept. */
+void
+arena_reset(arena_struct *arena) {
+  /**
+     @param[in]  arena  Arena structure.
+  */
+
+  arena_block_struct *block = NULL; /* Block to release */
+
+  if (arena == NULL)
+    return;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(arena->mutex));
+#endif
+  while (arena->blocks != NULL) {
+    block = arena->blocks;
+    arena->blocks = block->next;
+    (void) free(block);
+  }
+  arena->size = 0;
+  arena->nresets++;
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&(arena->mutex));
+#endif
+}
+
+/** Record the resident memory of the process at the end of the phase associated with an arena. */
+void
+arena_phase_end(arena_struct *arena) {
+  /**
+     @param[in]  arena  Arena structure.
+  */
+
+  (void) memory_usage(&(arena->rss), &(arena->peak_rss));
+}
+
+/** Print allocation statistics of an arena and resident memory recorded at the end of its phase. */
+void
+arena_report(arena_struct *arena) {
+  /**
+     @param[in]  arena  Arena structure.
+  */
+
+  (void) printf("%-14s allocs=%-10lu bytes=%-12lu blocks=%-6lu peak=%-12lu resets=%-3d rss=%.1f MiB peak_rss=%.1f MiB\n",
+                arena->name, (unsigned long) arena->nallocs, (unsigned long) arena->nbytes, (unsigned long) arena->nblocks,
+                (unsigned long) arena->peak_size, arena->nresets,
+                (double) arena->rss / 1048576.0, (double) arena->peak_rss / 1048576.0);
+}
+
+/** Free an arena and all memory allocated in it. */
+void
+arena_free(arena_struct *arena) {
+  /**
+     @param[in]  arena  Arena structure.
+  */
+
+  if (arena == NULL)
+    return;
+
+  (void) arena_reset(arena);
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_destroy(&(arena->mutex));
+#endif
+
+  (void) free(arena->name);
+  (void) free(arena);
+}
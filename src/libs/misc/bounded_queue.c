@@ -0,0 +1,192 @@
+/* ***************************************************** */
+/* Bounded FIFO queue connecting pipeline stages.        */
+/* bounded_queue.c                                       */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file bounded_queue.c
+    \brief Bounded FIFO queue connecting pipeline stages.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <misc.h>
+
+/** Create a bounded queue holding at most capacity items. */
+bounded_queue_struct *
+bounded_queue_create(int capacity) {
+  /**
+     @param[in]  capacity  Maximum number of items in the queue.
+
+     \return               Bounded queue structure.
+  */
+
+  bounded_queue_struct *queue = NULL; /* Bounded queue */
+
+  queue = (bounded_queue_struct *) malloc(sizeof(bounded_queue_struct));
+  if (queue == NULL) alloc_error(__FILE__, __LINE__);
+
+  if (capacity < 1)
+    capacity = 1;
+  queue->items = (void **) malloc(capacity * sizeof(void *));
+  if (queue->items == NULL) alloc_error(__FILE__, __LINE__);
+  queue->capacity = capacity;
+  queue->nitems = 0;
+  queue->head = 0;
+  queue->closed = 0;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_init(&(queue->mutex), NULL);
+  (void) pthread_cond_init(&(queue->cond_push), NULL);
+  (void) pthread_cond_init(&(queue->cond_pop), NULL);
+#endif
+
+  return queue;
+}
+
+/** Push an item at the end of a bounded queue, waiting while the queue is full. */
+int
+bounded_queue_push(bounded_queue_struct *queue, void *item) {
+  /**
+     @param[in]  queue  Bounded queue structure.
+     @param[in]  item   Item to push.
+
+     \return            0 if the item was queued, -1 if the queue is closed (or full without threads support).
+  */
+
+  int istat = 0; /* Diagnostic status */
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(queue->mutex));
+  while (queue->nitems == queue->capacity && queue->closed == 0)
+    (void) pthread_cond_wait(&(queue->cond_pop), &(queue->mutex));
+#endif
+
+  if (queue->closed != 0 || queue->nitems == queue->capacity)
+    istat = -1;
+  else {
+    queue->items[(queue->head + queue->nitems) % queue->capacity] = item;
+    queue->nitems++;
+#ifdef HAVE_PTHREAD
+    (void) pthread_cond_signal(&(queue->cond_push));
+#endif
+  }
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&(queue->mutex));
+#endif
+
+  return istat;
+}
+
+/** Pop the first item of a bounded queue, waiting while the queue is empty and not closed. */
+void *
+bounded_queue_pop(bounded_queue_struct *queue) {
+  /**
+     @param[in]  queue  Bounded queue structure.
+
+     \return            First item, or NULL when the queue is closed and empty (or empty without threads support).
+  */
+
+  void *item = NULL; /* Item popped */
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(queue->mutex));
+  while (queue->nitems == 0 && queue->closed == 0)
+    (void) pthread_cond_wait(&(queue->cond_push), &(queue->mutex));
+#endif
+
+  if (queue->nitems > 0) {
+    item = queue->items[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->nitems--;
+#ifdef HAVE_PTHREAD
+    (void) pthread_cond_signal(&(queue->cond_pop));
+#endif
+  }
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&(queue->mutex));
+#endif
+
+  return item;
+}
+
+/** Close a bounded queue: no more items can be pushed, remaining items can still be popped. */
+void
+bounded_queue_close(bounded_queue_struct *queue) {
+  /**
+     @param[in]  queue  Bounded queue structure.
+  */
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(queue->mutex));
+#endif
+  queue->closed = 1;
+#ifdef HAVE_PTHREAD
+  (void) pthread_cond_broadcast(&(queue->cond_push));
+  (void) pthread_cond_broadcast(&(queue->cond_pop));
+  (void) pthread_mutex_unlock(&(queue->mutex));
+#endif
+}
+
+/** Free a bounded queue. Items still queued are not freed. */
+void
+bounded_queue_free(bounded_queue_struct *queue) {
+  /**
+     @param[in]  queue  Bounded queue structure.
+  */
+
+  if (queue == NULL)
+    return;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_destroy(&(queue->mutex));
+  (void) pthread_cond_destroy(&(queue->cond_push));
+  (void) pthread_cond_destroy(&(queue->cond_pop));
+#endif
+
+  (void) free(queue->items);
+  (void) free(queue);
+}
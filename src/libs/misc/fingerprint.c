@@ -0,0 +1,280 @@
+/* ***************************************************** */
+/* Content fingerprint of data, files and directories.   */
+/* fingerprint.c                                         */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file fingerprint.c
+    \brief Content fingerprint of data, files and directories.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <misc.h>
+
+/** FNV-1a 64-bit offset basis. */
+#define FINGERPRINT_FNV_OFFSET 0xcbf29ce484222325ULL
+/** FNV-1a 64-bit prime. */
+#define FINGERPRINT_FNV_PRIME 0x100000001b3ULL
+/** Multiplier of the second hash. */
+#define FINGERPRINT_MIX_PRIME 0x9e3779b97f4a7c15ULL
+/** Size of the buffer used to read files. */
+#define FINGERPRINT_BUFSIZE 65536
+
+/** Initialize a fingerprint. */
+void
+fingerprint_init(fingerprint_struct *fp) {
+  /**
+     @param[out]  fp  Fingerprint.
+  */
+
+  fp->h1 = FINGERPRINT_FNV_OFFSET;
+  fp->h2 = 0x84222325cbf29ce4ULL;
+}
+
+/** Add a block of bytes to a fingerprint. */
+void
+fingerprint_add(fingerprint_struct *fp, const void *data, size_t nbytes) {
+  /**
+     @param[in,out]  fp      Fingerprint.
+     @param[in]      data    Data.
+     @param[in]      nbytes  Number of bytes of data.
+  */
+
+  const unsigned char *p = (const unsigned char *) data; /* Bytes */
+  uint64_t h1 = fp->h1; /* First hash */
+  uint64_t h2 = fp->h2; /* Second hash */
+  size_t i; /* Loop counter */
+
+  for (i=0; i<nbytes; i++) {
+    h1 = (h1 ^ (uint64_t) p[i]) * FINGERPRINT_FNV_PRIME;
+    h2 = (h2 + (uint64_t) p[i] + 1) * FINGERPRINT_MIX_PRIME;
+    h2 ^= h2 >> 29;
+  }
+  /* Mix in the length so that consecutive blocks cannot be shifted into each other */
+  h1 = (h1 ^ (uint64_t) nbytes) * FINGERPRINT_FNV_PRIME;
+  h2 = (h2 + (uint64_t) nbytes) * FINGERPRINT_MIX_PRIME;
+  h2 ^= h2 >> 29;
+
+  fp->h1 = h1;
+  fp->h2 = h2;
+}
+
+/** Add a string to a fingerprint. A NULL string is distinct from an empty string. */
+void
+fingerprint_add_str(fingerprint_struct *fp, const char *str) {
+  /**
+     @param[in,out]  fp   Fingerprint.
+     @param[in]      str  String.
+  */
+
+  if (str == NULL)
+    fingerprint_add(fp, "\377", (size_t) 1);
+  else
+    fingerprint_add(fp, str, strlen(str));
+}
+
+/** Add a range of bytes of an opened file to a fingerprint. */
+static int
+fingerprint_add_range(fingerprint_struct *fp, FILE *fd, long offset, size_t nbytes, unsigned char *buf) {
+  /**
+     @param[in,out]  fp      Fingerprint.
+     @param[in]      fd      Opened file.
+     @param[in]      offset  Offset of the first byte.
+     @param[in]      nbytes  Number of bytes.
+     @param[in]      buf     Buffer of FINGERPRINT_BUFSIZE bytes.
+
+     \return                 0 on success, -1 on read error.
+  */
+
+  size_t n; /* Number of bytes read */
+
+  if (fseek(fd, offset, SEEK_SET) != 0)
+    return -1;
+  while (nbytes > 0) {
+    n = fread(buf, (size_t) 1, (nbytes < FINGERPRINT_BUFSIZE) ? nbytes : FINGERPRINT_BUFSIZE, fd);
+    if (n == 0)
+      return -1;
+    fingerprint_add(fp, buf, n);
+    nbytes -= n;
+  }
+
+  return 0;
+}
+
+/** Add a file to a fingerprint. Files up to maxcontent bytes are fingerprinted by their whole content,
+    larger files by their size, modification time, and first and last maxcontent/2 bytes. */
+int
+fingerprint_add_file(fingerprint_struct *fp, char *filename, size_t maxcontent) {
+  /**
+     @param[in,out]  fp          Fingerprint.
+     @param[in]      filename    File name.
+     @param[in]      maxcontent  Maximum size in bytes of files fingerprinted by their whole content.
+
+     \return                     0 on success, -1 if the file cannot be read.
+  */
+
+  struct stat st; /* File status */
+  FILE *fd = NULL; /* File descriptor */
+  unsigned char *buf = NULL; /* Read buffer */
+  uint64_t meta[2]; /* File size and modification time */
+  size_t size; /* File size */
+  int istat = 0; /* Diagnostic status */
+
+  if (stat(filename, &st) != 0 || !S_ISREG(st.st_mode))
+    return -1;
+  size = (size_t) st.st_size;
+
+  meta[0] = (uint64_t) st.st_size;
+  meta[1] = (uint64_t) st.st_mtime;
+  if (size > maxcontent)
+    /* Large file: rely on its size and modification time, plus a sample of its content */
+    fingerprint_add(fp, meta, sizeof(meta));
+  else
+    fingerprint_add(fp, meta, sizeof(uint64_t));
+
+  if (maxcontent == 0 || size == 0)
+    return 0;
+
+  fd = fopen(filename, "rb");
+  if (fd == NULL)
+    return -1;
+  buf = (unsigned char *) malloc(FINGERPRINT_BUFSIZE * sizeof(unsigned char));
+  if (buf == NULL) alloc_error(__FILE__, __LINE__);
+
+  if (size <= maxcontent)
+    istat = fingerprint_add_range(fp, fd, 0L, size, buf);
+  else {
+    istat = fingerprint_add_range(fp, fd, 0L, maxcontent / 2, buf);
+    if (istat == 0)
+      istat = fingerprint_add_range(fp, fd, (long) (size - maxcontent / 2), maxcontent / 2, buf);
+  }
+
+  (void) free(buf);
+  (void) fclose(fd);
+
+  return istat;
+}
+
+/** Compare two directory entry names for qsort. */
+static int
+fingerprint_compare_names(const void *a, const void *b) {
+  /**
+     @param[in]  a  First name.
+     @param[in]  b  Second name.
+
+     \return        strcmp of the names.
+  */
+
+  return strcmp(*((char * const *) a), *((char * const *) b));
+}
+
+/** Add the regular files of a directory to a fingerprint, in name order: each file contributes its name
+    and is added with fingerprint_add_file. Subdirectories are not visited. */
+int
+fingerprint_add_dir(fingerprint_struct *fp, char *dirname, size_t maxcontent) {
+  /**
+     @param[in,out]  fp          Fingerprint.
+     @param[in]      dirname     Directory name.
+     @param[in]      maxcontent  Maximum size in bytes of files fingerprinted by their whole content.
+
+     \return                     0 on success, -1 if the directory cannot be read.
+  */
+
+  DIR *dir = NULL; /* Directory stream */
+  struct dirent *entry = NULL; /* Directory entry */
+  char **names = NULL; /* Entry names */
+  char *path = NULL; /* Full path of an entry */
+  int nnames = 0; /* Number of entry names */
+  int maxnames = 0; /* Allocated number of entry names */
+  int i; /* Loop counter */
+
+  dir = opendir(dirname);
+  if (dir == NULL)
+    return -1;
+
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.')
+      continue;
+    if (nnames == maxnames) {
+      maxnames = (maxnames == 0) ? 64 : 2 * maxnames;
+      names = (char **) realloc(names, maxnames * sizeof(char *));
+      if (names == NULL) alloc_error(__FILE__, __LINE__);
+    }
+    names[nnames] = strdup(entry->d_name);
+    if (names[nnames] == NULL) alloc_error(__FILE__, __LINE__);
+    nnames++;
+  }
+  (void) closedir(dir);
+
+  if (nnames > 0)
+    qsort(names, (size_t) nnames, sizeof(char *), fingerprint_compare_names);
+
+  fingerprint_add_str(fp, dirname);
+  for (i=0; i<nnames; i++) {
+    path = (char *) malloc((strlen(dirname) + strlen(names[i]) + 2) * sizeof(char));
+    if (path == NULL) alloc_error(__FILE__, __LINE__);
+    (void) sprintf(path, "%s/%s", dirname, names[i]);
+    /* Only regular files are fingerprinted */
+    if (fingerprint_add_file(fp, path, maxcontent) == 0)
+      fingerprint_add_str(fp, names[i]);
+    (void) free(path);
+    (void) free(names[i]);
+  }
+  if (names != NULL)
+    (void) free(names);
+
+  return 0;
+}
+
+/** Format a fingerprint as 32 hexadecimal characters. */
+void
+fingerprint_hex(fingerprint_struct *fp, char *hex) {
+  /**
+     @param[in]   fp   Fingerprint.
+     @param[out]  hex  Hexadecimal string, at least 33 characters long.
+  */
+
+  (void) sprintf(hex, "%016llx%016llx", (unsigned long long) fp->h1, (unsigned long long) fp->h2);
+}
@@ -0,0 +1,329 @@
+/* ***************************************************** */
+/* Timers and counters for performance reports.          */
+/* instrument.c                                          */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file instrument.c
+    \brief Timers and counters for performance reports.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <misc.h>
+
+/** Accumulated timings of a named timer. */
+typedef struct {
+  char name[INSTR_NAMELEN]; /**< Timer name. */
+  int count; /**< Number of timed intervals. */
+  double total; /**< Total time in seconds. */
+  double max; /**< Longest interval in seconds. */
+} instrument_stat_struct;
+
+/** Memory statistics of a run phase. */
+typedef struct {
+  char name[INSTR_NAMELEN]; /**< Phase name. */
+  size_t nallocs; /**< Number of allocations in the phase arena. */
+  size_t nbytes; /**< Number of bytes allocated in the phase arena. */
+  size_t peak_size; /**< Maximum number of bytes held by the phase arena. */
+  size_t rss; /**< Resident memory at the end of the phase. */
+  size_t peak_rss; /**< Peak resident memory at the end of the phase. */
+} instrument_phase_struct;
+
+/** Names of the counters, in the order of their identifiers. */
+static const char *instrument_counter_names[INSTR_NCOUNTERS] = { "bytes_read", "bytes_written", "netcdf_opens", "allocations" };
+/** Counters values. */
+static size_t instrument_counters[INSTR_NCOUNTERS];
+/** Accumulated timers. */
+static instrument_stat_struct instrument_stats[INSTR_MAXTIMERS];
+/** Number of distinct timers. */
+static int instrument_ntimers = 0;
+/** Statistics of the memory arenas, recorded at the end of their phase. */
+static instrument_phase_struct instrument_phases[INSTR_MAXPHASES];
+/** Number of recorded phases. */
+static int instrument_nphases = 0;
+/** Clock value when instrumentation was initialized. */
+static double instrument_start = 0.0;
+/** JSON summary filename, NULL if not wanted. */
+static char *instrument_summary_file = NULL;
+/** Chrome trace-event output file, NULL if not wanted. */
+static FILE *instrument_trace = NULL;
+/** Number of events written to the trace file. */
+static size_t instrument_nevents = 0;
+#ifdef HAVE_PTHREAD
+/** Mutex protecting timers, counters and the trace file. */
+static pthread_mutex_t instrument_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/** Monotonic clock in seconds. */
+double
+instrument_clock(void) {
+  /**
+     \return  Time in seconds from an arbitrary origin.
+  */
+
+  struct timespec ts; /* Clock value */
+
+  (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double) ts.tv_sec + (double) ts.tv_nsec * 1.0e-9;
+}
+
+/** Initialize instrumentation. Timers and counters are always active; the JSON summary and the trace file are optional. */
+int
+instrument_init(char *summary_file, char *trace_file) {
+  /**
+     @param[in]  summary_file  JSON summary filename written by instrument_finalize, NULL if not wanted.
+     @param[in]  trace_file    Chrome trace-event filename (chrome://tracing, Perfetto), NULL if not wanted.
+
+     \return                   Status.
+  */
+
+  instrument_start = instrument_clock();
+
+  if (summary_file != NULL) {
+    instrument_summary_file = strdup(summary_file);
+    if (instrument_summary_file == NULL) alloc_error(__FILE__, __LINE__);
+  }
+
+  if (trace_file != NULL) {
+    instrument_trace = fopen(trace_file, "w");
+    if (instrument_trace == NULL) {
+      (void) fprintf(stderr, "%s: Cannot open trace file %s: %s\n", __FILE__, trace_file, strerror(errno));
+      return -1;
+    }
+    (void) fprintf(instrument_trace, "{\"traceEvents\":[\n");
+  }
+
+  return 0;
+}
+
+/** Start a scoped timer. */
+void
+instrument_begin(instrument_timer_struct *timer, char *name) {
+  /**
+     @param[out]  timer  Timer structure, passed to instrument_end.
+     @param[in]   name   Timer name. Intervals of timers with the same name are accumulated.
+  */
+
+  timer->name = name;
+  timer->begin = instrument_clock();
+}
+
+/** Stop a scoped timer, accumulate its interval and write it to the trace file. */
+void
+instrument_end(instrument_timer_struct *timer) {
+  /**
+     @param[in]  timer  Timer structure started with instrument_begin.
+  */
+
+  double end; /* Clock value at end of interval */
+  double elapsed; /* Interval in seconds */
+  instrument_stat_struct *stat = NULL; /* Accumulated timings */
+  unsigned long tid = 0; /* Thread identifier for the trace */
+  int i; /* Loop counter */
+
+  end = instrument_clock();
+  elapsed = end - timer->begin;
+#ifdef HAVE_PTHREAD
+  tid = (unsigned long) pthread_self();
+#endif
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&instrument_mutex);
+#endif
+
+  for (i=0; i<instrument_ntimers; i++)
+    if ( !strcmp(instrument_stats[i].name, timer->name) ) {
+      stat = &(instrument_stats[i]);
+      break;
+    }
+  if (stat == NULL && instrument_ntimers < INSTR_MAXTIMERS) {
+    stat = &(instrument_stats[instrument_ntimers++]);
+    (void) strncpy(stat->name, timer->name, INSTR_NAMELEN-1);
+    stat->name[INSTR_NAMELEN-1] = '\0';
+    stat->count = 0;
+    stat->total = 0.0;
+    stat->max = 0.0;
+  }
+  if (stat != NULL) {
+    stat->count++;
+    stat->total += elapsed;
+    if (elapsed > stat->max)
+      stat->max = elapsed;
+  }
+
+  if (instrument_trace != NULL) {
+    /* Complete event, times in microseconds from start of run */
+    (void) fprintf(instrument_trace, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.1f,\"dur\":%.1f,\"pid\":%d,\"tid\":%lu}",
+                   (instrument_nevents > 0) ? ",\n" : "", timer->name,
+                   (timer->begin - instrument_start) * 1.0e6, elapsed * 1.0e6, (int) getpid(), tid);
+    instrument_nevents++;
+  }
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&instrument_mutex);
+#endif
+}
+
+/** Add a value to an instrumentation counter. */
+void
+instrument_count(int counter, size_t value) {
+  /**
+     @param[in]  counter  Counter identifier: INSTR_BYTES_READ, INSTR_BYTES_WRITTEN, INSTR_NC_OPENS or INSTR_ALLOCS.
+     @param[in]  value    Value to add.
+  */
+
+  if (counter < 0 || counter >= INSTR_NCOUNTERS)
+    return;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&instrument_mutex);
+#endif
+  instrument_counters[counter] += value;
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&instrument_mutex);
+#endif
+}
+
+/** Record the statistics of a memory arena in the report. */
+void
+instrument_arena(arena_struct *arena) {
+  /**
+     @param[in]  arena  Arena structure, usually at the end of its phase.
+  */
+
+  instrument_phase_struct *phase = NULL; /* Phase statistics */
+
+  (void) instrument_count(INSTR_ALLOCS, arena->nallocs);
+  if (instrument_nphases >= INSTR_MAXPHASES)
+    return;
+
+  phase = &(instrument_phases[instrument_nphases++]);
+  (void) strncpy(phase->name, arena->name, INSTR_NAMELEN-1);
+  phase->name[INSTR_NAMELEN-1] = '\0';
+  phase->nallocs = arena->nallocs;
+  phase->nbytes = arena->nbytes;
+  phase->peak_size = arena->peak_size;
+  phase->rss = arena->rss;
+  phase->peak_rss = arena->peak_rss;
+}
+
+/** Detach instrumentation in a forked child process: the trace and summary files stay owned by the parent,
+    which must flush them before forking. Timers and counters keep accumulating in the child. */
+void
+instrument_detach(void) {
+
+  /* Drop the inherited stream without closing it: only the parent terminates it */
+  instrument_trace = NULL;
+  if (instrument_summary_file != NULL)
+    (void) free(instrument_summary_file);
+  instrument_summary_file = NULL;
+}
+
+/** Print the timers and counters, write the JSON summary and close the trace file. */
+int
+instrument_finalize(void) {
+  /**
+     \return  Status.
+  */
+
+  FILE *fp = NULL; /* JSON summary file */
+  size_t rss; /* Current resident memory */
+  size_t peak_rss; /* Peak resident memory */
+  double wall; /* Total elapsed time */
+  int i; /* Loop counter */
+
+  wall = instrument_clock() - instrument_start;
+  (void) memory_usage(&rss, &peak_rss);
+
+  /* Human-readable summary */
+  (void) printf("%-24s %8s %12s %12s\n", "timer", "count", "total (s)", "max (s)");
+  for (i=0; i<instrument_ntimers; i++)
+    (void) printf("%-24s %8d %12.3f %12.3f\n", instrument_stats[i].name, instrument_stats[i].count,
+                  instrument_stats[i].total, instrument_stats[i].max);
+  for (i=0; i<INSTR_NCOUNTERS; i++)
+    (void) printf("%-24s %lu\n", instrument_counter_names[i], (unsigned long) instrument_counters[i]);
+  (void) printf("%-24s %.3f s\n%-24s %.1f MiB\n", "wall_time", wall, "peak_rss", (double) peak_rss / 1048576.0);
+
+  if (instrument_trace != NULL) {
+    (void) fprintf(instrument_trace, "\n]}\n");
+    (void) fclose(instrument_trace);
+    instrument_trace = NULL;
+  }
+
+  if (instrument_summary_file == NULL)
+    return 0;
+
+  fp = fopen(instrument_summary_file, "w");
+  if (fp == NULL) {
+    (void) fprintf(stderr, "%s: Cannot open summary file %s: %s\n", __FILE__, instrument_summary_file, strerror(errno));
+    (void) free(instrument_summary_file);
+    instrument_summary_file = NULL;
+    return -1;
+  }
+
+  (void) fprintf(fp, "{\n  \"program\": \"%s\",\n  \"version\": \"%s\",\n", PACKAGE_NAME, PACKAGE_VERSION);
+  (void) fprintf(fp, "  \"wall_time\": %.6f,\n  \"peak_rss\": %lu,\n", wall, (unsigned long) peak_rss);
+  (void) fprintf(fp, "  \"counters\": {");
+  for (i=0; i<INSTR_NCOUNTERS; i++)
+    (void) fprintf(fp, "%s\n    \"%s\": %lu", (i > 0) ? "," : "", instrument_counter_names[i], (unsigned long) instrument_counters[i]);
+  (void) fprintf(fp, "\n  },\n  \"timers\": [");
+  for (i=0; i<instrument_ntimers; i++)
+    (void) fprintf(fp, "%s\n    {\"name\": \"%s\", \"count\": %d, \"total\": %.6f, \"max\": %.6f}", (i > 0) ? "," : "",
+                   instrument_stats[i].name, instrument_stats[i].count, instrument_stats[i].total, instrument_stats[i].max);
+  (void) fprintf(fp, "\n  ],\n  \"phases\": [");
+  for (i=0; i<instrument_nphases; i++)
+    (void) fprintf(fp, "%s\n    {\"name\": \"%s\", \"allocations\": %lu, \"bytes\": %lu, \"peak_bytes\": %lu, \"rss\": %lu, \"peak_rss\": %lu}",
+                   (i > 0) ? "," : "", instrument_phases[i].name, (unsigned long) instrument_phases[i].nallocs,
+                   (unsigned long) instrument_phases[i].nbytes, (unsigned long) instrument_phases[i].peak_size,
+                   (unsigned long) instrument_phases[i].rss, (unsigned long) instrument_phases[i].peak_rss);
+  (void) fprintf(fp, "\n  ]\n}\n");
+  (void) fclose(fp);
+
+  (void) free(instrument_summary_file);
+  instrument_summary_file = NULL;
+
+  return 0;
+}
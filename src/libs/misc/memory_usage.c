@@ -0,0 +1,89 @@
+/* ***************************************************** */
+/* Resident memory of the process.                       */
+/* memory_usage.c                                        */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file memory_usage.c
+    \brief Resident memory of the process.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <misc.h>
+
+/** Get current and peak resident set size of the process. Values are 0 when not available on the system. */
+void
+memory_usage(size_t *rss, size_t *peak_rss) {
+  /**
+     @param[out]  rss       Current resident set size in bytes.
+     @param[out]  peak_rss  Peak resident set size in bytes.
+  */
+
+  FILE *fp = NULL; /* Process status file */
+  unsigned long size; /* Total program size in pages */
+  unsigned long resident; /* Resident size in pages */
+#ifdef HAVE_SYS_RESOURCE_H
+  struct rusage usage; /* Resource usage */
+#endif
+
+  *rss = 0;
+  *peak_rss = 0;
+
+  /* Current resident size, Linux-specific */
+  fp = fopen("/proc/self/statm", "r");
+  if (fp != NULL) {
+    if (fscanf(fp, "%lu %lu", &size, &resident) == 2)
+      *rss = (size_t) resident * (size_t) sysconf(_SC_PAGESIZE);
+    (void) fclose(fp);
+  }
+
+#ifdef HAVE_SYS_RESOURCE_H
+  /* Peak resident size, in kilobytes */
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    *peak_rss = (size_t) usage.ru_maxrss * (size_t) 1024;
+#endif
+  if (*peak_rss < *rss)
+    *peak_rss = *rss;
+}
@@ -78,8 +78,226 @@ LICENSE END */
 #ifdef HAVE_ERRNO_H
 #include <errno.h>
 #endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+/** Default size in bytes of the blocks of an arena. */
+#define ARENA_BLOCK_SIZE 1048576
+/** Alignment in bytes of memory allocated in an arena. */
+#define ARENA_ALIGN 16
+
+/** Instrumentation counter of bytes read from input files. */
+#define INSTR_BYTES_READ 0
+/** Instrumentation counter of bytes written to output files. */
+#define INSTR_BYTES_WRITTEN 1
+/** Instrumentation counter of NetCDF files opened or created. */
+#define INSTR_NC_OPENS 2
+/** Instrumentation counter of allocations in memory arenas. */
+#define INSTR_ALLOCS 3
+/** Number of instrumentation counters. */
+#define INSTR_NCOUNTERS 4
+/** Maximum number of distinct instrumentation timers. */
+#define INSTR_MAXTIMERS 64
+/** Maximum number of phases recorded in the instrumentation report. */
+#define INSTR_MAXPHASES 16
+/** Maximum length of instrumentation timer names. */
+#define INSTR_NAMELEN 64
+
+/** Function prototype of a task executed by a thread pool. */
+typedef void (*thread_task_func)(void *arg);
+
+/** Task queued in a thread pool thread_task_struct. */
+typedef struct thread_task_struct {
+  thread_task_func func; /**< Function to execute. */
+  void *arg; /**< Argument passed to the function. */
+  struct thread_task_struct *next; /**< Next task in the queue. */
+} thread_task_struct;
+
+/** Thread pool thread_pool_struct. Tasks are executed inline by the caller when nthreads is less than 2. */
+typedef struct {
+  int nthreads; /**< Number of worker threads. */
+  int npending; /**< Number of tasks submitted and not yet completed. */
+  int shutdown; /**< Set to TRUE when worker threads must exit. */
+  thread_task_struct *head; /**< First task in the queue. */
+  thread_task_struct *tail; /**< Last task in the queue. */
+#ifdef HAVE_PTHREAD
+  pthread_t *threads; /**< Worker threads. */
+  pthread_mutex_t mutex; /**< Mutex protecting the queue. */
+  pthread_cond_t cond_task; /**< Signaled when a task is queued or at shutdown. */
+  pthread_cond_t cond_done; /**< Signaled when all pending tasks are completed. */
+#endif
+} thread_pool_struct;
+
+/** Bounded FIFO queue bounded_queue_struct, used to pass items between threads. */
+typedef struct {
+  void **items; /**< Circular buffer of items. */
+  int capacity; /**< Maximum number of items. */
+  int nitems; /**< Number of items in the queue. */
+  int head; /**< Index of first item. */
+  int closed; /**< Set to TRUE when no more items can be pushed. */
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t mutex; /**< Mutex protecting the queue. */
+  pthread_cond_t cond_push; /**< Signaled when an item is pushed or the queue is closed. */
+  pthread_cond_t cond_pop; /**< Signaled when an item is popped or the queue is closed. */
+#endif
+} bounded_queue_struct;
+
+/** Function prototype of a task of a task graph. Returns 0 on success. */
+typedef int (*task_graph_func)(void *arg);
+
+/** Task of a task graph task_graph_node_struct. */
+typedef struct task_graph_node_struct {
+  task_graph_func func; /**< Function to execute. */
+  void *arg; /**< Argument passed to the function. */
+  int ndeps; /**< Number of dependencies not yet completed. */
+  int ndependents; /**< Number of tasks depending on this task. */
+  struct task_graph_node_struct **dependents; /**< Tasks depending on this task. */
+  int cancel; /**< Set when a dependency failed: the task is then not executed. */
+  int istat; /**< Return status of the task. */
+  struct task_graph_struct *graph; /**< Task graph of the task. */
+  struct task_graph_node_struct *next; /**< Next task of the graph. */
+} task_graph_node_struct;
+
+/** Dependency graph of tasks task_graph_struct. A task is submitted to a thread pool as soon as all its dependencies are completed. */
+typedef struct task_graph_struct {
+  int nthreads; /**< Number of worker threads. */
+  thread_pool_struct *pool; /**< Thread pool executing the tasks. */
+  task_graph_node_struct *nodes; /**< List of tasks, last added first. */
+  int ntasks; /**< Number of tasks. */
+  int ndone; /**< Number of tasks completed or cancelled. */
+  int istat; /**< Status of the first task which failed. */
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t mutex; /**< Mutex protecting dependency counters. */
+#endif
+} task_graph_struct;
+
+/** Function prototype of a read executed by a prefetch thread. Returns 0 on success and sets the number of bytes it allocated. */
+typedef int (*prefetch_func)(void *arg, size_t *nbytes);
+
+/** Read queued in a prefetch structure prefetch_item_struct. */
+typedef struct prefetch_item_struct {
+  prefetch_func func; /**< Read function. */
+  void *arg; /**< Argument passed to the read function. */
+  size_t nbytes; /**< Number of bytes allocated by the read. */
+  int istat; /**< Return status of the read. */
+  int started; /**< Set when the read has started. */
+  int done; /**< Set when the read is completed. */
+  int wanted; /**< Set when the consumer waits for the read: it is then started even if the memory budget is exhausted. */
+  int released; /**< Set when the consumer released the memory budget held by the read. */
+  struct prefetch_item_struct *next; /**< Next read in the queue. */
+  struct prefetch_item_struct *next_all; /**< Next read of the prefetch structure, for freeing. */
+} prefetch_item_struct;
+
+/** Background reads prefetch_struct, bounded by a memory budget. */
+typedef struct {
+  size_t budget; /**< Memory budget in bytes. */
+  size_t held; /**< Number of bytes held by completed reads not yet released. */
+  int background; /**< Set when reads are executed by a background thread. */
+  int shutdown; /**< Set when the background thread must exit. */
+  prefetch_item_struct *head; /**< First read not yet started. */
+  prefetch_item_struct *tail; /**< Last read not yet started. */
+  prefetch_item_struct *items; /**< All reads, last queued first. */
+#ifdef HAVE_PTHREAD
+  pthread_t thread; /**< Background thread. */
+  pthread_mutex_t mutex; /**< Mutex protecting the queue and the memory budget. */
+  pthread_cond_t cond; /**< Signaled when a read is queued, completed, wanted or released, or at shutdown. */
+#endif
+} prefetch_struct;
+
+/** Block of memory of an arena arena_block_struct. Allocated memory follows the header. */
+typedef struct arena_block_struct {
+  size_t size; /**< Number of bytes available in the block. */
+  size_t used; /**< Number of bytes already allocated in the block. */
+  struct arena_block_struct *next; /**< Next block. */
+} arena_block_struct;
+
+/** Region allocator arena_struct. All memory allocated in an arena is released at once with arena_reset or arena_free. */
+typedef struct {
+  char *name; /**< Name of the arena. */
+  size_t block_size; /**< Default size in bytes of the blocks. */
+  arena_block_struct *blocks; /**< List of blocks, current block first. */
+  size_t nallocs; /**< Number of allocations since creation. */
+  size_t nbytes; /**< Number of bytes allocated since creation. */
+  size_t nblocks; /**< Number of blocks obtained from the system since creation. */
+  size_t size; /**< Number of bytes currently held in blocks. */
+  size_t peak_size; /**< Maximum number of bytes held in blocks. */
+  int nresets; /**< Number of times the arena was reset. */
+  size_t rss; /**< Resident memory of the process recorded at the end of the phase of the arena. */
+  size_t peak_rss; /**< Peak resident memory of the process recorded at the end of the phase of the arena. */
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t mutex; /**< Mutex protecting the arena. */
+#endif
+} arena_struct;
+
+/** Content fingerprint fingerprint_struct: two independent 64-bit hashes of the data added to it. */
+typedef struct {
+  uint64_t h1; /**< FNV-1a hash. */
+  uint64_t h2; /**< Second hash, with a different multiplier and mixing. */
+} fingerprint_struct;
+
+/** Scoped timer instrument_timer_struct, started with instrument_begin and stopped with instrument_end. */
+typedef struct {
+  char *name; /**< Timer name. */
+  double begin; /**< Clock value at start. */
+} instrument_timer_struct;
 
 void alloc_error(char *filename, int line);
 void banner(char *pgm, char *verstat, char *type);
+thread_pool_struct *thread_pool_create(int nthreads);
+void thread_pool_submit(thread_pool_struct *pool, thread_task_func func, void *arg);
+void thread_pool_wait(thread_pool_struct *pool);
+void thread_pool_free(thread_pool_struct *pool);
+int thread_pool_in_worker(void);
+bounded_queue_struct *bounded_queue_create(int capacity);
+int bounded_queue_push(bounded_queue_struct *queue, void *item);
+void *bounded_queue_pop(bounded_queue_struct *queue);
+void bounded_queue_close(bounded_queue_struct *queue);
+void bounded_queue_free(bounded_queue_struct *queue);
+task_graph_struct *task_graph_create(int nthreads);
+task_graph_node_struct *task_graph_add(task_graph_struct *graph, task_graph_func func, void *arg);
+void task_graph_depend(task_graph_node_struct *node, task_graph_node_struct *dep);
+int task_graph_run(task_graph_struct *graph);
+void task_graph_free(task_graph_struct *graph);
+prefetch_struct *prefetch_create(size_t budget);
+prefetch_item_struct *prefetch_submit(prefetch_struct *pf, prefetch_func func, void *arg);
+int prefetch_wait(prefetch_struct *pf, prefetch_item_struct *item);
+void prefetch_release(prefetch_struct *pf, prefetch_item_struct *item);
+void prefetch_free(prefetch_struct *pf);
+void fingerprint_init(fingerprint_struct *fp);
+void fingerprint_add(fingerprint_struct *fp, const void *data, size_t nbytes);
+void fingerprint_add_str(fingerprint_struct *fp, const char *str);
+int fingerprint_add_file(fingerprint_struct *fp, char *filename, size_t maxcontent);
+int fingerprint_add_dir(fingerprint_struct *fp, char *dirname, size_t maxcontent);
+void fingerprint_hex(fingerprint_struct *fp, char *hex);
+arena_struct *arena_create(char *name, size_t block_size);
+void *arena_alloc(arena_struct *arena, size_t byte_size);
+void *arena_calloc(arena_struct *arena, size_t nmemb, size_t size);
+char *arena_strdup(arena_struct *arena, const char *str);
+void arena_reset(arena_struct *arena);
+void arena_phase_end(arena_struct *arena);
+void arena_report(arena_struct *arena);
+void arena_free(arena_struct *arena);
+void memory_usage(size_t *rss, size_t *peak_rss);
+double instrument_clock(void);
+int instrument_init(char *summary_file, char *trace_file);
+void instrument_begin(instrument_timer_struct *timer, char *name);
+void instrument_end(instrument_timer_struct *timer);
+void instrument_count(int counter, size_t value);
+void instrument_arena(arena_struct *arena);
+void instrument_detach(void);
+int instrument_finalize(void);
 
 #endif
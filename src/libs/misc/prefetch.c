@@ -0,0 +1,291 @@
+/* ***************************************************** */
+/* Background reads bounded by a memory budget.          */
+/* prefetch.c                                            */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file prefetch.c
+    \brief Background reads bounded by a memory budget.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <misc.h>
+
+#ifdef HAVE_PTHREAD
+/** Prefetch thread main loop: execute queued reads in order while the memory budget allows it. */
+static void *
+prefetch_worker(void *arg) {
+  /**
+     @param[in]  arg  Prefetch structure.
+
+     \return          NULL.
+  */
+
+  prefetch_struct *pf = (prefetch_struct *) arg; /* Prefetch structure */
+  prefetch_item_struct *item = NULL; /* Current read */
+  size_t nbytes; /* Number of bytes held by the current read */
+  int istat; /* Diagnostic status */
+
+  (void) pthread_mutex_lock(&(pf->mutex));
+  for (;;) {
+    /* Wait for a read to execute. When the budget is exhausted, only start a read the consumer is waiting for. */
+    while (pf->shutdown == 0 &&
+           (pf->head == NULL || (pf->held > 0 && pf->held >= pf->budget && pf->head->wanted == 0)))
+      (void) pthread_cond_wait(&(pf->cond), &(pf->mutex));
+    if (pf->shutdown != 0)
+      break;
+
+    /* Dequeue first read */
+    item = pf->head;
+    pf->head = item->next;
+    if (pf->head == NULL)
+      pf->tail = NULL;
+    item->started = 1;
+    (void) pthread_mutex_unlock(&(pf->mutex));
+
+    nbytes = 0;
+    istat = item->func(item->arg, &nbytes);
+
+    (void) pthread_mutex_lock(&(pf->mutex));
+    item->istat = istat;
+    item->nbytes = nbytes;
+    item->done = 1;
+    pf->held += nbytes;
+    (void) pthread_cond_broadcast(&(pf->cond));
+  }
+  (void) pthread_mutex_unlock(&(pf->mutex));
+
+  return NULL;
+}
+#endif
+
+/** Create a prefetch structure executing reads in a background thread. */
+prefetch_struct *
+prefetch_create(size_t budget) {
+  /**
+     @param[in]  budget  Memory budget in bytes: no new read is started while completed reads not yet released
+                         by the consumer hold this amount of memory. With a budget of 0, or without POSIX threads
+                         support, reads are executed by the consumer when it waits for them.
+
+     \return             Prefetch structure.
+  */
+
+  prefetch_struct *pf = NULL; /* Prefetch structure */
+#ifdef HAVE_PTHREAD
+  int istat; /* Diagnostic status */
+#endif
+
+  pf = (prefetch_struct *) malloc(sizeof(prefetch_struct));
+  if (pf == NULL) alloc_error(__FILE__, __LINE__);
+
+  pf->budget = budget;
+  pf->held = 0;
+  pf->head = NULL;
+  pf->tail = NULL;
+  pf->items = NULL;
+  pf->shutdown = 0;
+  pf->background = 0;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_init(&(pf->mutex), NULL);
+  (void) pthread_cond_init(&(pf->cond), NULL);
+  if (budget > 0) {
+    istat = pthread_create(&(pf->thread), NULL, prefetch_worker, (void *) pf);
+    if (istat != 0)
+      (void) fprintf(stderr, "%s: WARNING: Cannot create prefetch thread: %s. Reading without prefetch.\n", __FILE__,
+                     strerror(istat));
+    else
+      pf->background = 1;
+  }
+#endif
+
+  return pf;
+}
+
+/** Queue a read in a prefetch structure. Reads are started in the order they are queued. */
+prefetch_item_struct *
+prefetch_submit(prefetch_struct *pf, prefetch_func func, void *arg) {
+  /**
+     @param[in]  pf    Prefetch structure.
+     @param[in]  func  Read function. It returns 0 on success and sets the number of bytes it allocated.
+     @param[in]  arg   Argument passed to the read function.
+
+     \return           Read item, to be used with prefetch_wait and prefetch_release.
+  */
+
+  prefetch_item_struct *item = NULL; /* New read */
+
+  item = (prefetch_item_struct *) malloc(sizeof(prefetch_item_struct));
+  if (item == NULL) alloc_error(__FILE__, __LINE__);
+  item->func = func;
+  item->arg = arg;
+  item->nbytes = 0;
+  item->istat = 0;
+  item->started = 0;
+  item->done = 0;
+  item->wanted = 0;
+  item->released = 0;
+  item->next = NULL;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(pf->mutex));
+#endif
+  item->next_all = pf->items;
+  pf->items = item;
+  if (pf->background != 0) {
+    if (pf->tail == NULL)
+      pf->head = item;
+    else
+      pf->tail->next = item;
+    pf->tail = item;
+  }
+#ifdef HAVE_PTHREAD
+  if (pf->background != 0)
+    (void) pthread_cond_broadcast(&(pf->cond));
+  (void) pthread_mutex_unlock(&(pf->mutex));
+#endif
+
+  return item;
+}
+
+/** Wait for the completion of a read. */
+int
+prefetch_wait(prefetch_struct *pf, prefetch_item_struct *item) {
+  /**
+     @param[in]  pf    Prefetch structure.
+     @param[in]  item  Read item.
+
+     \return           Status returned by the read function.
+  */
+
+  instrument_timer_struct timer; /* Instrumentation timer */
+
+  if (pf->background == 0) {
+    /* No prefetch thread: read now */
+    if (item->done == 0) {
+      item->istat = item->func(item->arg, &(item->nbytes));
+      item->started = 1;
+      item->done = 1;
+      pf->held += item->nbytes;
+    }
+    return item->istat;
+  }
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(pf->mutex));
+  if (item->done == 0) {
+    /* Time spent waiting for reads which could not be hidden behind computations */
+    (void) instrument_begin(&timer, "prefetch_wait");
+    item->wanted = 1;
+    (void) pthread_cond_broadcast(&(pf->cond));
+    while (item->done == 0)
+      (void) pthread_cond_wait(&(pf->cond), &(pf->mutex));
+    (void) instrument_end(&timer);
+  }
+  (void) pthread_mutex_unlock(&(pf->mutex));
+#else
+  (void) timer;
+#endif
+
+  return item->istat;
+}
+
+/** Release the memory budget held by a completed read, once the consumer has taken ownership of its data. */
+void
+prefetch_release(prefetch_struct *pf, prefetch_item_struct *item) {
+  /**
+     @param[in]  pf    Prefetch structure.
+     @param[in]  item  Read item.
+  */
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(pf->mutex));
+#endif
+  if (item->done != 0 && item->released == 0) {
+    pf->held -= item->nbytes;
+    item->released = 1;
+#ifdef HAVE_PTHREAD
+    (void) pthread_cond_broadcast(&(pf->cond));
+#endif
+  }
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&(pf->mutex));
+#endif
+}
+
+/** Stop the prefetch thread and free a prefetch structure. Reads not yet started are discarded;
+    data of completed reads belong to the caller. */
+void
+prefetch_free(prefetch_struct *pf) {
+  /**
+     @param[in]  pf  Prefetch structure.
+  */
+
+  prefetch_item_struct *item = NULL; /* Read item */
+  prefetch_item_struct *next = NULL; /* Next read item */
+
+  if (pf == NULL)
+    return;
+
+#ifdef HAVE_PTHREAD
+  if (pf->background != 0) {
+    /* The read in progress, if any, is completed before the thread exits */
+    (void) pthread_mutex_lock(&(pf->mutex));
+    pf->shutdown = 1;
+    (void) pthread_cond_broadcast(&(pf->cond));
+    (void) pthread_mutex_unlock(&(pf->mutex));
+    (void) pthread_join(pf->thread, NULL);
+  }
+  (void) pthread_mutex_destroy(&(pf->mutex));
+  (void) pthread_cond_destroy(&(pf->cond));
+#endif
+
+  for (item=pf->items; item != NULL; item=next) {
+    next = item->next_all;
+    (void) free(item);
+  }
+
+  (void) free(pf);
+}
@@ -0,0 +1,251 @@
+/* ***************************************************** */
+/* Dependency graph of tasks run by a thread pool.       */
+/* task_graph.c                                          */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file task_graph.c
+    \brief Dependency graph of tasks run by a thread pool.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <misc.h>
+
+/** Execute a task of a graph, then release the tasks depending on it. */
+static void
+task_graph_exec(void *arg) {
+  /**
+     @param[in]  arg  Task graph node structure.
+  */
+
+  task_graph_node_struct *node = (task_graph_node_struct *) arg; /* Task being executed */
+  task_graph_struct *graph = node->graph; /* Task graph */
+  task_graph_node_struct **ready = NULL; /* Dependent tasks ready to be executed */
+  int nready = 0; /* Number of dependent tasks ready to be executed */
+  int i; /* Loop counter */
+
+  /* A task is not executed when one of its dependencies failed or was cancelled */
+  if (node->cancel == 0)
+    node->istat = node->func(node->arg);
+  else
+    node->istat = -1;
+
+  if (node->ndependents > 0) {
+    ready = (task_graph_node_struct **) malloc(node->ndependents * sizeof(task_graph_node_struct *));
+    if (ready == NULL) alloc_error(__FILE__, __LINE__);
+  }
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(graph->mutex));
+#endif
+  if (node->istat != 0 && node->cancel == 0 && graph->istat == 0)
+    graph->istat = node->istat;
+  graph->ndone++;
+  for (i=0; i<node->ndependents; i++) {
+    if (node->istat != 0)
+      node->dependents[i]->cancel = 1;
+    node->dependents[i]->ndeps--;
+    if (node->dependents[i]->ndeps == 0)
+      ready[nready++] = node->dependents[i];
+  }
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&(graph->mutex));
+#endif
+
+  /* Submit outside of the graph lock: without worker threads the pool executes the tasks inline */
+  for (i=0; i<nready; i++)
+    thread_pool_submit(graph->pool, task_graph_exec, (void *) ready[i]);
+
+  if (ready != NULL)
+    (void) free(ready);
+}
+
+/** Create an empty task graph executed by nthreads worker threads. */
+task_graph_struct *
+task_graph_create(int nthreads) {
+  /**
+     @param[in]  nthreads  Number of worker threads. With less than 2 threads tasks are executed serially,
+                           in an order compatible with their dependencies.
+
+     \return               Task graph structure.
+  */
+
+  task_graph_struct *graph = NULL; /* Task graph */
+
+  graph = (task_graph_struct *) malloc(sizeof(task_graph_struct));
+  if (graph == NULL) alloc_error(__FILE__, __LINE__);
+
+  graph->nthreads = nthreads;
+  graph->pool = NULL;
+  graph->nodes = NULL;
+  graph->ntasks = 0;
+  graph->ndone = 0;
+  graph->istat = 0;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_init(&(graph->mutex), NULL);
+#endif
+
+  return graph;
+}
+
+/** Add a task to a task graph. */
+task_graph_node_struct *
+task_graph_add(task_graph_struct *graph, task_graph_func func, void *arg) {
+  /**
+     @param[in]  graph  Task graph structure.
+     @param[in]  func   Function to execute. It must return 0 on success.
+     @param[in]  arg    Argument passed to the function.
+
+     \return            Task node, to be used with task_graph_depend.
+  */
+
+  task_graph_node_struct *node = NULL; /* New task */
+
+  node = (task_graph_node_struct *) malloc(sizeof(task_graph_node_struct));
+  if (node == NULL) alloc_error(__FILE__, __LINE__);
+
+  node->func = func;
+  node->arg = arg;
+  node->ndeps = 0;
+  node->ndependents = 0;
+  node->dependents = NULL;
+  node->cancel = 0;
+  node->istat = 0;
+  node->graph = graph;
+  node->next = graph->nodes;
+  graph->nodes = node;
+  graph->ntasks++;
+
+  return node;
+}
+
+/** Declare that a task must not start before another task of the same graph is completed. */
+void
+task_graph_depend(task_graph_node_struct *node, task_graph_node_struct *dep) {
+  /**
+     @param[in]  node  Task node.
+     @param[in]  dep   Task node which must be completed first. Ignored when NULL.
+  */
+
+  if (dep == NULL || dep == node)
+    return;
+
+  dep->dependents = (task_graph_node_struct **) realloc(dep->dependents, (dep->ndependents+1) * sizeof(task_graph_node_struct *));
+  if (dep->dependents == NULL) alloc_error(__FILE__, __LINE__);
+  dep->dependents[dep->ndependents++] = node;
+  node->ndeps++;
+}
+
+/** Execute all the tasks of a task graph and wait for their completion. */
+int
+task_graph_run(task_graph_struct *graph) {
+  /**
+     @param[in]  graph  Task graph structure.
+
+     \return            Status of the first task which failed, or 0 if all tasks succeeded.
+  */
+
+  task_graph_node_struct *node = NULL; /* Task node */
+  task_graph_node_struct **ready = NULL; /* Tasks without dependency */
+  int nready = 0; /* Number of tasks without dependency */
+  int i; /* Loop counter */
+
+  if (graph->ntasks == 0)
+    return 0;
+
+  graph->pool = thread_pool_create(graph->nthreads);
+
+  /* List tasks without dependency before submitting any of them, because tasks may be executed inline */
+  ready = (task_graph_node_struct **) malloc(graph->ntasks * sizeof(task_graph_node_struct *));
+  if (ready == NULL) alloc_error(__FILE__, __LINE__);
+  for (node=graph->nodes; node != NULL; node=node->next)
+    if (node->ndeps == 0)
+      ready[nready++] = node;
+  /* Nodes are stored last added first: submit them in the order they were added */
+  for (i=nready-1; i>=0; i--)
+    thread_pool_submit(graph->pool, task_graph_exec, (void *) ready[i]);
+  (void) free(ready);
+
+  thread_pool_wait(graph->pool);
+  thread_pool_free(graph->pool);
+  graph->pool = NULL;
+
+  if (graph->ndone != graph->ntasks) {
+    (void) fprintf(stderr, "%s: Only %d tasks out of %d were executed: the task dependencies contain a cycle.\n", __FILE__,
+                   graph->ndone, graph->ntasks);
+    if (graph->istat == 0)
+      graph->istat = -1;
+  }
+
+  return graph->istat;
+}
+
+/** Free a task graph and all its tasks. Task arguments are not freed. */
+void
+task_graph_free(task_graph_struct *graph) {
+  /**
+     @param[in]  graph  Task graph structure.
+  */
+
+  task_graph_node_struct *node = NULL; /* Task node */
+  task_graph_node_struct *next = NULL; /* Next task node */
+
+  if (graph == NULL)
+    return;
+
+  for (node=graph->nodes; node != NULL; node=next) {
+    next = node->next;
+    if (node->dependents != NULL)
+      (void) free(node->dependents);
+    (void) free(node);
+  }
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_destroy(&(graph->mutex));
+#endif
+
+  (void) free(graph);
+}
@@ -0,0 +1,268 @@
+/* ***************************************************** */
+/* Simple thread pool executing queued tasks.            */
+/* thread_pool.c                                         */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file thread_pool.c
+    \brief Simple thread pool executing queued tasks.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <misc.h>
+
+#ifdef HAVE_PTHREAD
+/** Key marking worker threads of any thread pool. */
+static pthread_key_t thread_pool_worker_key;
+/** Initialization of thread_pool_worker_key. */
+static pthread_once_t thread_pool_worker_once = PTHREAD_ONCE_INIT;
+
+/** Create the key marking worker threads. */
+static void
+thread_pool_worker_key_init(void) {
+  (void) pthread_key_create(&thread_pool_worker_key, NULL);
+}
+
+/** Worker thread main loop: execute queued tasks until shutdown. */
+static void *
+thread_pool_worker(void *arg) {
+  /**
+     @param[in]  arg  Thread pool structure.
+
+     \return          NULL.
+  */
+
+  thread_pool_struct *pool = (thread_pool_struct *) arg; /* Thread pool */
+  thread_task_struct *task = NULL; /* Current task */
+
+  /* Mark this thread as a worker: kernels it runs must not create nested pools */
+  (void) pthread_once(&thread_pool_worker_once, thread_pool_worker_key_init);
+  (void) pthread_setspecific(thread_pool_worker_key, (void *) pool);
+
+  for (;;) {
+    (void) pthread_mutex_lock(&(pool->mutex));
+    while (pool->head == NULL && pool->shutdown == 0)
+      (void) pthread_cond_wait(&(pool->cond_task), &(pool->mutex));
+    if (pool->head == NULL && pool->shutdown != 0) {
+      (void) pthread_mutex_unlock(&(pool->mutex));
+      break;
+    }
+    /* Dequeue first task */
+    task = pool->head;
+    pool->head = task->next;
+    if (pool->head == NULL)
+      pool->tail = NULL;
+    (void) pthread_mutex_unlock(&(pool->mutex));
+
+    /* Execute task */
+    task->func(task->arg);
+    (void) free(task);
+
+    /* Signal completion */
+    (void) pthread_mutex_lock(&(pool->mutex));
+    pool->npending--;
+    if (pool->npending == 0)
+      (void) pthread_cond_broadcast(&(pool->cond_done));
+    (void) pthread_mutex_unlock(&(pool->mutex));
+  }
+
+  return NULL;
+}
+#endif
+
+/** Create a thread pool with nthreads worker threads. */
+thread_pool_struct *
+thread_pool_create(int nthreads) {
+  /**
+     @param[in]  nthreads  Number of worker threads. With less than 2 threads, or without POSIX threads support,
+                           tasks are executed inline by the submitting thread.
+
+     \return               Thread pool structure.
+  */
+
+  thread_pool_struct *pool = NULL; /* Thread pool */
+#ifdef HAVE_PTHREAD
+  int i; /* Loop counter */
+  int istat; /* Diagnostic status */
+#endif
+
+  pool = (thread_pool_struct *) malloc(sizeof(thread_pool_struct));
+  if (pool == NULL) alloc_error(__FILE__, __LINE__);
+
+  pool->npending = 0;
+  pool->shutdown = 0;
+  pool->head = NULL;
+  pool->tail = NULL;
+  pool->nthreads = 0;
+
+#ifdef HAVE_PTHREAD
+  pool->threads = NULL;
+  if (nthreads > 1) {
+    (void) pthread_mutex_init(&(pool->mutex), NULL);
+    (void) pthread_cond_init(&(pool->cond_task), NULL);
+    (void) pthread_cond_init(&(pool->cond_done), NULL);
+    pool->threads = (pthread_t *) malloc(nthreads * sizeof(pthread_t));
+    if (pool->threads == NULL) alloc_error(__FILE__, __LINE__);
+    for (i=0; i<nthreads; i++) {
+      istat = pthread_create(&(pool->threads[i]), NULL, thread_pool_worker, (void *) pool);
+      if (istat != 0) {
+        (void) fprintf(stderr, "%s: WARNING: Cannot create worker thread #%d: %s. Using %d threads.\n", __FILE__, i,
+                       strerror(istat), i);
+        break;
+      }
+      pool->nthreads++;
+    }
+  }
+#else
+  if (nthreads > 1)
+    (void) fprintf(stderr, "%s: WARNING: Compiled without POSIX threads support: running serially.\n", __FILE__);
+#endif
+
+  return pool;
+}
+
+/** Submit a task to the thread pool. */
+void
+thread_pool_submit(thread_pool_struct *pool, thread_task_func func, void *arg) {
+  /**
+     @param[in]  pool  Thread pool structure.
+     @param[in]  func  Function to execute.
+     @param[in]  arg   Argument passed to the function.
+  */
+
+  thread_task_struct *task = NULL; /* New task */
+
+  if (pool->nthreads < 1) {
+    /* No worker thread: execute inline */
+    func(arg);
+    return;
+  }
+
+#ifdef HAVE_PTHREAD
+  task = (thread_task_struct *) malloc(sizeof(thread_task_struct));
+  if (task == NULL) alloc_error(__FILE__, __LINE__);
+  task->func = func;
+  task->arg = arg;
+  task->next = NULL;
+
+  (void) pthread_mutex_lock(&(pool->mutex));
+  if (pool->tail == NULL)
+    pool->head = task;
+  else
+    pool->tail->next = task;
+  pool->tail = task;
+  pool->npending++;
+  (void) pthread_cond_signal(&(pool->cond_task));
+  (void) pthread_mutex_unlock(&(pool->mutex));
+#else
+  (void) task;
+#endif
+}
+
+/** Wait until all submitted tasks are completed. */
+void
+thread_pool_wait(thread_pool_struct *pool) {
+  /**
+     @param[in]  pool  Thread pool structure.
+  */
+
+  if (pool->nthreads < 1)
+    return;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&(pool->mutex));
+  while (pool->npending > 0)
+    (void) pthread_cond_wait(&(pool->cond_done), &(pool->mutex));
+  (void) pthread_mutex_unlock(&(pool->mutex));
+#endif
+}
+
+/** Wait for pending tasks, stop worker threads and free the thread pool. */
+void
+thread_pool_free(thread_pool_struct *pool) {
+  /**
+     @param[in]  pool  Thread pool structure.
+  */
+
+#ifdef HAVE_PTHREAD
+  int i; /* Loop counter */
+#endif
+
+  if (pool == NULL)
+    return;
+
+#ifdef HAVE_PTHREAD
+  if (pool->threads != NULL) {
+    (void) thread_pool_wait(pool);
+    (void) pthread_mutex_lock(&(pool->mutex));
+    pool->shutdown = 1;
+    (void) pthread_cond_broadcast(&(pool->cond_task));
+    (void) pthread_mutex_unlock(&(pool->mutex));
+    for (i=0; i<pool->nthreads; i++)
+      (void) pthread_join(pool->threads[i], NULL);
+    (void) free(pool->threads);
+    (void) pthread_mutex_destroy(&(pool->mutex));
+    (void) pthread_cond_destroy(&(pool->cond_task));
+    (void) pthread_cond_destroy(&(pool->cond_done));
+  }
+#endif
+
+  (void) free(pool);
+}
+
+/** Tell if the calling thread is a worker thread of a thread pool. */
+int
+thread_pool_in_worker(void) {
+  /**
+     \return  1 if called from a task executed by a thread pool worker, 0 otherwise.
+  */
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_once(&thread_pool_worker_once, thread_pool_worker_key_init);
+  return (pthread_getspecific(thread_pool_worker_key) != NULL);
+#else
+  return 0;
+#endif
+}
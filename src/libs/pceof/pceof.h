@@ -107,5 +107,7 @@ LICENSE END */
 void normalize_pc(double *norm_all, double *first_variance, double *buf_renorm, double *bufin, int neof, int ntime);
 int project_field_eof(double *bufout, double *bufin, double *bufeof, double *singular_value,
                       double missing_value_eof, double *lon, double *lat, double scale, int ni, int nj, int ntime, int neof);
+int project_field_eof_f(double *bufout, float *bufin, double *bufeof, double *singular_value,
+                        double missing_value_eof, double *lon, double *lat, double scale, int ni, int nj, int ntime, int neof);
 
 #endif
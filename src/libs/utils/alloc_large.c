@@ -0,0 +1,247 @@
+/* ***************************************************** */
+/* Allocate large arrays on the heap or on memory-mapped */
+/* scratch files.                                        */
+/* alloc_large.c                                         */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file alloc_large.c
+    \brief Allocate large arrays on the heap or on memory-mapped scratch files.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <utils.h>
+
+/** Memory-mapped block of a large array. */
+typedef struct alloc_large_block {
+  void *map; /**< Mapped memory. */
+  size_t byte_size; /**< Number of bytes mapped. */
+  int fd; /**< File unit of the scratch file. */
+  struct alloc_large_block *next; /**< Next mapped block. */
+} alloc_large_block_struct;
+
+/** Scratch directory for memory-mapped arrays. NULL means allocate on the heap. */
+static char *alloc_large_dir = NULL;
+/** Minimum size in bytes of an array to be memory-mapped. */
+static size_t alloc_large_min_bytes = 0;
+/** List of memory-mapped blocks currently allocated. */
+static alloc_large_block_struct *alloc_large_blocks = NULL;
+#ifdef HAVE_PTHREAD
+/** Mutex protecting the list of memory-mapped blocks. */
+static pthread_mutex_t alloc_large_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/** Select where large arrays are allocated: on the heap, or on memory-mapped files in a scratch directory. */
+int
+alloc_large_init(char *scratch_dir, size_t min_bytes) {
+  /**
+     @param[in]  scratch_dir  Scratch directory for memory-mapped files. NULL to allocate on the heap.
+     @param[in]  min_bytes    Arrays smaller than this number of bytes are always allocated on the heap.
+
+     \return                  Status.
+  */
+
+  if (alloc_large_dir != NULL) {
+    (void) free(alloc_large_dir);
+    alloc_large_dir = NULL;
+  }
+  alloc_large_min_bytes = min_bytes;
+
+  if (scratch_dir == NULL)
+    return 0;
+
+  if (access(scratch_dir, W_OK | X_OK) != 0) {
+    (void) fprintf(stderr, "%s: Scratch directory %s is not writable: %s\n", __FILE__, scratch_dir, strerror(errno));
+    return -1;
+  }
+  alloc_large_dir = strdup(scratch_dir);
+  if (alloc_large_dir == NULL) alloc_error(__FILE__, __LINE__);
+
+  return 0;
+}
+
+/** Allocate a large array. It is memory-mapped on a scratch file if a scratch directory is set and the array is large enough. */
+void *
+alloc_large(size_t byte_size) {
+  /**
+     @param[in]  byte_size  Number of bytes to allocate.
+
+     \return                Pointer to allocated memory, NULL on failure.
+  */
+
+  alloc_large_block_struct *block = NULL; /* Memory-mapped block */
+  char *filename = NULL; /* Scratch filename */
+  double *map = NULL; /* Mapped memory */
+  size_t page_size; /* Paging size of the operating system */
+  size_t map_size; /* Number of bytes mapped */
+  int fd; /* Scratch file unit */
+  int istat; /* Diagnostic status */
+
+  if (alloc_large_dir == NULL || byte_size < alloc_large_min_bytes)
+    return malloc(byte_size);
+
+  /* Create a unique scratch file */
+  filename = (char *) malloc((strlen(alloc_large_dir) + 20) * sizeof(char));
+  if (filename == NULL) alloc_error(__FILE__, __LINE__);
+  (void) sprintf(filename, "%s/dsclim_XXXXXX", alloc_large_dir);
+  fd = mkstemp(filename);
+  if (fd == -1) {
+    (void) fprintf(stderr, "%s: Cannot create scratch file %s: %s\n", __FILE__, filename, strerror(errno));
+    (void) free(filename);
+    return NULL;
+  }
+  (void) close(fd);
+
+  page_size = (size_t) sysconf(_SC_PAGESIZE);
+  istat = alloc_mmap_double(&map, &fd, &map_size, filename, page_size, byte_size / sizeof(double) + 1);
+  /* The file is removed as soon as it is mapped, so it is cleaned up by the system however the program ends */
+  (void) unlink(filename);
+  (void) free(filename);
+  if (istat != 0)
+    return NULL;
+
+  block = (alloc_large_block_struct *) malloc(sizeof(alloc_large_block_struct));
+  if (block == NULL) alloc_error(__FILE__, __LINE__);
+  block->map = (void *) map;
+  block->byte_size = map_size;
+  block->fd = fd;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&alloc_large_mutex);
+#endif
+  block->next = alloc_large_blocks;
+  alloc_large_blocks = block;
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&alloc_large_mutex);
+#endif
+
+  return block->map;
+}
+
+/** Move a large array allocated on the heap to memory obtained with alloc_large, if it would be memory-mapped. */
+int
+alloc_large_move(void **ptr, size_t byte_size) {
+  /**
+     @param[in,out]  ptr        Pointer to the heap array. Replaced by the new array, the heap array being freed.
+     @param[in]      byte_size  Number of bytes of the array.
+
+     \return                    Status.
+  */
+
+  void *map = NULL; /* Memory-mapped array */
+
+  if (*ptr == NULL || alloc_large_dir == NULL || byte_size < alloc_large_min_bytes)
+    return 0;
+
+  map = alloc_large(byte_size);
+  if (map == NULL)
+    return -1;
+  (void) memcpy(map, *ptr, byte_size);
+  (void) free(*ptr);
+  *ptr = map;
+
+  return 0;
+}
+
+/** Free an array allocated with alloc_large. Arrays which were not memory-mapped are freed with free(). */
+void
+free_large(void *ptr) {
+  /**
+     @param[in]  ptr  Array to free.
+  */
+
+  alloc_large_block_struct *block = NULL; /* Memory-mapped block */
+  alloc_large_block_struct **prev = NULL; /* Link to current block in list */
+
+  if (ptr == NULL)
+    return;
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&alloc_large_mutex);
+#endif
+  for (prev = &alloc_large_blocks; *prev != NULL; prev = &((*prev)->next))
+    if ((*prev)->map == ptr) {
+      block = *prev;
+      *prev = block->next;
+      break;
+    }
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&alloc_large_mutex);
+#endif
+
+  if (block == NULL)
+    (void) free(ptr);
+  else {
+    (void) munmap(block->map, block->byte_size);
+    (void) close(block->fd);
+    (void) free(block);
+  }
+}
+
+/** Release all memory-mapped arrays still allocated and reset allocation to the heap. */
+void
+alloc_large_cleanup(void) {
+
+  alloc_large_block_struct *block = NULL; /* Memory-mapped block */
+
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_lock(&alloc_large_mutex);
+#endif
+  while (alloc_large_blocks != NULL) {
+    block = alloc_large_blocks;
+    alloc_large_blocks = block->next;
+    (void) munmap(block->map, block->byte_size);
+    (void) close(block->fd);
+    (void) free(block);
+  }
+#ifdef HAVE_PTHREAD
+  (void) pthread_mutex_unlock(&alloc_large_mutex);
+#endif
+
+  if (alloc_large_dir != NULL) {
+    (void) free(alloc_large_dir);
+    alloc_large_dir = NULL;
+  }
+}
@@ -54,8 +54,8 @@ LICENSE END */
 #include <utils.h>
 
 /** Allocate memory using mmap for a float array. */
-void
-alloc_mmap_float(float **map, int *fd, size_t *byte_size, char *filename, size_t page_size, int size) {
+int
+alloc_mmap_float(float **map, int *fd, size_t *byte_size, char *filename, size_t page_size, size_t size) {
   /**
      @param[in,out]  map        Pointer to a floating-point array.
      @param[in]      fd         File unit previously opened with open().
@@ -63,6 +63,8 @@ alloc_mmap_float(float **map, int *fd, size_t *byte_size, char *filename, size_t
      @param[in]      filename   Filename to use to store allocated mmap virtual memory.
      @param[in]      page_size  The paging size of the operating system in bytes.
      @param[in]      size       Number of elements in map array.
+
+     \return                    Status.
   */
   
   int result; /* Return status of functions */
@@ -77,7 +79,7 @@ alloc_mmap_float(float **map, int *fd, size_t *byte_size, char *filename, size_t
   *fd = open(filename, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
   if (*fd == -1) {
     (void) perror("alloc_mmap_float: ERROR: Error opening file for writing");
-    (void) kill(getpid(), 5);
+    return -1;
   }
   
   total_size = size * sizeof(float);
@@ -88,7 +90,7 @@ alloc_mmap_float(float **map, int *fd, size_t *byte_size, char *filename, size_t
   if (result != 0) {
     (void) close(*fd);
     (void) perror("alloc_mmap_float: ERROR: Error calling ftruncate() to 'stretch' the file");
-    (void) kill(getpid(), 5);
+    return -1;
   }
   
   /* Now the file is ready to be mmapped to the array. */
@@ -96,6 +98,13 @@ alloc_mmap_float(float **map, int *fd, size_t *byte_size, char *filename, size_t
   if (*map == (float *) MAP_FAILED) {
     (void) close(*fd);
     (void) perror("alloc_mmap_float: ERROR: Error mmapping the file");
-    (void) kill(getpid(), 5);
+    *map = NULL;
+    return -1;
   }
+
+  /* Large arrays are mostly swept sequentially: hint the kernel to read ahead and drop pages behind */
+  (void) madvise(*map, *byte_size, MADV_SEQUENTIAL);
+
+  /* Success status */
+  return 0;
 }
@@ -68,65 +68,103 @@ covariance_fields_spatial(double *cov, double *buf1, double *buf2, short int *ma
       @param[in]   nj            Second dimension
    */
 
-  int i; /* Loop counter */
-  int j; /* Loop counter */
-  int pts = 0; /* Points counter */
-  int num = 0; /* Elements counter */
-
-  double sum1; /* Temporary sum for buf1 */
-  double sum2; /* Temporary sum for buf2 */
-  double mean1; /* Mean for buf1 */
-  double mean2; /* Mean for buf2 */
-
-  /* Compute spatial covariance, optionally using a mask */
-  if (mask == NULL) {
-
-    /* Calculate mean of each field */
-    sum1 = 0.0;
-    sum2 = 0.0;
-    for (j=0; j<nj; j++)
-      for (i=0; i<ni; i++) {
-        sum1 += buf1[i+j*ni+t1*ni*nj];
-        sum2 += buf2[i+j*ni+t2*ni*nj];
-      }
-    mean1 = sum1 / (double) (ni*nj);
-    mean2 = sum2 / (double) (ni*nj);
-
-    /* Calculate spatial covariance */
-    *cov = 0.0;
-    num = 0;
-    for (j=0; j<nj; j++)
-      for (i=0; i<ni; i++) {
-        /* Sum of the squares (remove mean) */
-        (*cov) += ( ( (buf1[i+j*ni+t1*ni*nj] - mean1) * (buf2[i+j*ni+t2*ni*nj] - mean2) ) - (*cov)) / (double) (num + 1);
-        num++;
-      }
+  int *index = NULL; /* Valid points index list */
+  int npts; /* Number of valid points */
+  int pts; /* Points counter */
+  int p; /* Point index */
+
+  double *pbuf1 = buf1 + (size_t) t1 * (size_t) (ni*nj); /* Field 1 at time index t1 */
+  double *pbuf2 = buf2 + (size_t) t2 * (size_t) (ni*nj); /* Field 2 at time index t2 */
+  double mean1 = 0.0; /* Running mean for buf1 */
+  double mean2 = 0.0; /* Running mean for buf2 */
+  double delta1; /* Difference to running mean for buf1 */
+  double comoment = 0.0; /* Running sum of products of differences to the means */
+
+  /* Compute spatial covariance in one pass over valid points, optionally using a mask */
+  npts = mask_index_list(&index, mask, ni, nj);
+  for (pts=0; pts<npts; pts++) {
+    p = (index == NULL) ? pts : index[pts];
+    delta1 = pbuf1[p] - mean1;
+    mean1 += delta1 / (double) (pts+1);
+    mean2 += (pbuf2[p] - mean2) / (double) (pts+1);
+    comoment += delta1 * (pbuf2[p] - mean2);
   }
-  else {
-    /* Calculate mean of each field */
-    sum1 = 0.0;
-    sum2 = 0.0;
-    pts = 0;
-    for (j=0; j<nj; j++)
-      for (i=0; i<ni; i++)
-        if (mask[i+j*ni] == 1) {
-          sum1 += buf1[i+j*ni+t1*ni*nj];
-          sum2 += buf2[i+j*ni+t2*ni*nj];
-          pts++;
-        }
-    mean1 = sum1 / (double) (pts);
-    mean2 = sum2 / (double) (pts);
-
-    /* Calculate spatial covariance */
-    *cov = 0.0;
-    num = 0;
-    for (j=0; j<nj; j++)
-      for (i=0; i<ni; i++) {
-        if (mask[i+j*ni] == 1) {
-          /* Sum of the squares (remove mean) */
-          (*cov) += ( ( (buf1[i+j*ni+t1*ni*nj] - mean1) * (buf2[i+j*ni+t2*ni*nj] - mean2) ) - (*cov)) / (double) (num + 1);
-          num++;
-        }
-      }
+  *cov = comoment / (double) npts;
+
+  (void) free(index);
+}
+
+/** Compute spatial anomalies of each timestep of a field, compacted to the valid points of a mask. */
+int
+anomaly_fields_spatial(double *anom, double *buf, short int *mask, int ni, int nj, int ntime) {
+
+  /** 
+      @param[out]  anom          Output spatial anomalies (npts * ntime), npts being the number of valid points
+      @param[in]   buf           Input 3D buffer
+      @param[in]   mask          Input 2D mask (NULL to use all points)
+      @param[in]   ni            First dimension
+      @param[in]   nj            Second dimension
+      @param[in]   ntime         Time dimension
+
+      \return                    Number of valid points.
+   */
+
+  int *index = NULL; /* Valid points index list */
+  int npts; /* Number of valid points */
+  int pts; /* Points counter */
+  int t; /* Time loop counter */
+
+  double *pbuf; /* Current timestep of input field */
+  double *panom; /* Current timestep of anomalies */
+  double sum; /* Temporary sum */
+  double mean; /* Spatial mean */
+
+  /* Compact valid points once */
+  npts = mask_index_list(&index, mask, ni, nj);
+
+  for (t=0; t<ntime; t++) {
+    pbuf = buf + (size_t) t * (size_t) (ni*nj);
+    panom = anom + (size_t) t * (size_t) npts;
+
+    /* Gather valid points and compute their mean */
+    sum = 0.0;
+    for (pts=0; pts<npts; pts++) {
+      panom[pts] = (index == NULL) ? pbuf[pts] : pbuf[index[pts]];
+      sum += panom[pts];
+    }
+    mean = sum / (double) npts;
+
+    /* Remove spatial mean */
+    for (pts=0; pts<npts; pts++)
+      panom[pts] -= mean;
   }
+
+  (void) free(index);
+
+  return npts;
+}
+
+/** Compute the spatial covariance of two fields from their precomputed spatial anomalies. */
+double
+covariance_anomalies_spatial(double *anom1, double *anom2, int t1, int t2, int npts) {
+
+  /** 
+      @param[in]   anom1         Spatial anomalies 1, as computed by anomaly_fields_spatial
+      @param[in]   anom2         Spatial anomalies 2, as computed by anomaly_fields_spatial
+      @param[in]   t1            Time index of anom1 to process
+      @param[in]   t2            Time index of anom2 to process
+      @param[in]   npts          Number of valid points
+
+      \return                    Spatial covariance.
+   */
+
+  double *pa1 = anom1 + (size_t) t1 * (size_t) npts; /* Anomalies 1 of time index t1 */
+  double *pa2 = anom2 + (size_t) t2 * (size_t) npts; /* Anomalies 2 of time index t2 */
+  double cov = 0.0; /* Spatial covariance */
+  int pts; /* Points counter */
+
+  for (pts=0; pts<npts; pts++)
+    cov += pa1[pts] * pa2[pts];
+
+  return cov / (double) npts;
 }
@@ -0,0 +1,295 @@
+/* ***************************************************** */
+/* Time index selection on packed dates.                 */
+/* date_index.c                                          */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file date_index.c
+    \brief Time index selection on packed dates.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <utils.h>
+
+/** Packed date key shift for years. */
+#define DATE_YEAR_SHIFT 9
+/** Packed date key shift for months. */
+#define DATE_MONTH_SHIFT 5
+
+/** Packed date key and its index in the time vector. */
+typedef struct {
+  int key; /**< Packed date */
+  int index; /**< Time index */
+} date_index_struct;
+
+/** Compare two packed date keys, ties sorted by time index. */
+static int
+compare_date_index(const void *a, const void *b) {
+  /**
+     @param[in]  a  First packed date key.
+     @param[in]  b  Second packed date key.
+
+     \return       Comparison result for qsort.
+  */
+
+  const date_index_struct *da = (const date_index_struct *) a;
+  const date_index_struct *db = (const date_index_struct *) b;
+
+  if (da->key != db->key)
+    return (da->key < db->key) ? -1 : 1;
+  return (da->index < db->index) ? -1 : ((da->index > db->index) ? 1 : 0);
+}
+
+/** Pack a date into an integer preserving chronological order. */
+int
+pack_date(int year, int month, int day) {
+  /**
+     @param[in]  year   Year
+     @param[in]  month  Month (1-12)
+     @param[in]  day    Day (1-31)
+
+     \return           Packed date.
+  */
+
+  return (year << DATE_YEAR_SHIFT) | (month << DATE_MONTH_SHIFT) | day;
+}
+
+/** Find time indexes of the first time vector whose dates are also in the second time vector. */
+int
+match_common_dates(int *index, int *year, int *month, int *day, int *year_learn, int *month_learn, int *day_learn,
+                   int ntime, int ntime_learn) {
+  /**
+     @param[out]  index        Time indexes of common dates in the first time vector (preallocated to ntime)
+     @param[in]   year         Year vector for the first time vector
+     @param[in]   month        Month vector for the first time vector
+     @param[in]   day          Day vector for the first time vector
+     @param[in]   year_learn   Year vector for the second time vector
+     @param[in]   month_learn  Month vector for the second time vector
+     @param[in]   day_learn    Day vector for the second time vector
+     @param[in]   ntime        Time dimension of the first time vector
+     @param[in]   ntime_learn  Time dimension of the second time vector
+
+     \return                  Number of common dates.
+  */
+
+  date_index_struct *keys = NULL; /* Sorted packed dates of second time vector */
+  int *key = NULL; /* Packed dates of first time vector */
+  int *key_learn = NULL; /* Packed dates of second time vector */
+  int sorted; /* If both time vectors are in chronological order */
+  int nmatch = 0; /* Number of common dates */
+  int key_cur; /* Current packed date */
+  int lo; /* Binary search lower bound */
+  int hi; /* Binary search upper bound */
+  int mid; /* Binary search middle */
+  int t; /* Time loop counter */
+  int tt; /* Time loop counter for second time vector */
+
+  if (ntime <= 0 || ntime_learn <= 0)
+    return 0;
+
+  /* Pack dates and check that both time vectors are sorted */
+  key = (int *) malloc(ntime * sizeof(int));
+  if (key == NULL) alloc_error(__FILE__, __LINE__);
+  key_learn = (int *) malloc(ntime_learn * sizeof(int));
+  if (key_learn == NULL) alloc_error(__FILE__, __LINE__);
+  sorted = TRUE;
+  for (t=0; t<ntime; t++) {
+    key[t] = pack_date(year[t], month[t], day[t]);
+    if (t > 0 && key[t] < key[t-1])
+      sorted = FALSE;
+  }
+  for (tt=0; tt<ntime_learn; tt++) {
+    key_learn[tt] = pack_date(year_learn[tt], month_learn[tt], day_learn[tt]);
+    if (tt > 0 && key_learn[tt] < key_learn[tt-1])
+      sorted = FALSE;
+  }
+
+  if (sorted == TRUE) {
+    /* Merge-join of the two sorted time vectors */
+    tt = 0;
+    for (t=0; t<ntime; t++) {
+      while (tt < ntime_learn && key_learn[tt] < key[t])
+        tt++;
+      if (tt == ntime_learn)
+        break;
+      if (key_learn[tt] == key[t])
+        index[nmatch++] = t;
+    }
+  }
+  else {
+    /* Time vectors not in chronological order: sort the second one and use binary search */
+    keys = (date_index_struct *) malloc(ntime_learn * sizeof(date_index_struct));
+    if (keys == NULL) alloc_error(__FILE__, __LINE__);
+    for (tt=0; tt<ntime_learn; tt++) {
+      keys[tt].key = key_learn[tt];
+      keys[tt].index = tt;
+    }
+    (void) qsort(keys, (size_t) ntime_learn, sizeof(date_index_struct), compare_date_index);
+    for (t=0; t<ntime; t++) {
+      key_cur = key[t];
+      lo = 0;
+      hi = ntime_learn;
+      while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (keys[mid].key < key_cur)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      if (lo < ntime_learn && keys[lo].key == key_cur)
+        index[nmatch++] = t;
+    }
+    (void) free(keys);
+  }
+
+  (void) free(key);
+  (void) free(key_learn);
+
+  return nmatch;
+}
+
+/** Find time indexes of selected months, optionally restricted to a time range. */
+int
+select_months_index(int *index, int *month, int *smonths, double *time_ls, double time_begin, double time_end,
+                    int ntime, int nmonths) {
+  /**
+     @param[out]  index       Selected time indexes (preallocated to ntime)
+     @param[in]   month       Month vector
+     @param[in]   smonths     Selected months vector (values 1-12)
+     @param[in]   time_ls     Time values. NULL to select over the whole time vector.
+     @param[in]   time_begin  First time value of time range
+     @param[in]   time_end    Last time value of time range
+     @param[in]   ntime       Time dimension length
+     @param[in]   nmonths     Number of months in smonths vector
+
+     \return                 Number of selected times.
+  */
+
+  int selected[13]; /* Month selection lookup table */
+  int nsel = 0; /* Number of selected times */
+  int t; /* Time loop counter */
+  int mm; /* Month loop counter */
+
+  for (mm=0; mm<13; mm++)
+    selected[mm] = FALSE;
+  for (mm=0; mm<nmonths; mm++)
+    if (smonths[mm] >= 1 && smonths[mm] <= 12)
+      selected[smonths[mm]] = TRUE;
+
+  for (t=0; t<ntime; t++)
+    if (month[t] >= 1 && month[t] <= 12 && selected[month[t]] == TRUE)
+      if (time_ls == NULL || (time_ls[t] >= time_begin && time_ls[t] <= time_end))
+        index[nsel++] = t;
+
+  return nsel;
+}
+
+/** Gather selected timesteps of a 3D buffer, copying runs of consecutive time indexes as blocks. */
+void
+gather_time_index(double *buf_sub, double *bufin, int *index, int timedim, int ndima, int ndimb, int ntime, int ntime_sub) {
+  /**
+     @param[out]  buf_sub    Output 3D buffer (preallocated to ndima * ndimb * ntime_sub)
+     @param[in]   bufin      Input 3D buffer (ndima * ndimb * ntime)
+     @param[in]   index      Time indexes to gather
+     @param[in]   timedim    Position of the time dimension (1 or 3)
+     @param[in]   ndima      First dimension
+     @param[in]   ndimb      Second dimension
+     @param[in]   ntime      Input time dimension
+     @param[in]   ntime_sub  Number of time indexes to gather
+  */
+
+  size_t npts = (size_t) ndima * (size_t) ndimb; /* Number of points of each timestep */
+  size_t pt; /* Point loop counter */
+  int t; /* Time loop counter */
+  int tr; /* End of run of consecutive time indexes */
+
+  for (t=0; t<ntime_sub; t=tr) {
+    /* Find run of consecutive time indexes */
+    tr = t + 1;
+    while (tr < ntime_sub && index[tr] == index[tr-1] + 1)
+      tr++;
+    if (timedim == 3)
+      /* Time dimension is last: timesteps of a run are contiguous */
+      (void) memcpy(buf_sub + (size_t) t * npts, bufin + (size_t) index[t] * npts, (size_t) (tr - t) * npts * sizeof(double));
+    else
+      /* Time dimension is first: a run is contiguous for each point */
+      for (pt=0; pt<npts; pt++)
+        (void) memcpy(buf_sub + (size_t) t + pt * (size_t) ntime_sub, bufin + (size_t) index[t] + pt * (size_t) ntime,
+                      (size_t) (tr - t) * sizeof(double));
+  }
+}
+
+/** Gather selected timesteps of a 3D float buffer into a double buffer. */
+void
+gather_time_index_f(double *buf_sub, float *bufin, int *index, int timedim, int ndima, int ndimb, int ntime, int ntime_sub) {
+  /**
+     @param[out]  buf_sub    Output 3D buffer (preallocated to ndima * ndimb * ntime_sub)
+     @param[in]   bufin      Input 3D buffer (ndima * ndimb * ntime) in single precision
+     @param[in]   index      Time indexes to gather
+     @param[in]   timedim    Position of the time dimension (1 or 3)
+     @param[in]   ndima      First dimension
+     @param[in]   ndimb      Second dimension
+     @param[in]   ntime      Input time dimension
+     @param[in]   ntime_sub  Number of time indexes to gather
+  */
+
+  size_t npts = (size_t) ndima * (size_t) ndimb; /* Number of points of each timestep */
+  size_t pt; /* Point loop counter */
+  float *pin; /* Input timestep */
+  double *pout; /* Output timestep */
+  int t; /* Time loop counter */
+
+  if (timedim == 3)
+    for (t=0; t<ntime_sub; t++) {
+      pin = bufin + (size_t) index[t] * npts;
+      pout = buf_sub + (size_t) t * npts;
+      for (pt=0; pt<npts; pt++)
+        pout[pt] = (double) pin[pt];
+    }
+  else
+    for (pt=0; pt<npts; pt++)
+      for (t=0; t<ntime_sub; t++)
+        buf_sub[(size_t) t + pt * (size_t) ntime_sub] = (double) bufin[(size_t) index[t] + pt * (size_t) ntime];
+}
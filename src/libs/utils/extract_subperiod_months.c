@@ -66,11 +66,11 @@ extract_subperiod_months(double **buf_sub, int *ntime_sub, double *bufin, int *y
      @param[in]  month         Month vector
      @param[in]  day           Day vector
      @param[in]  smonths       Selected months vector (values 1-12)
-     @param[in]  time_units    Output base time units
+     @param[in]  time_units    Output base time units (not used when period is NULL)
      @param[in]  cal_type      Output calendar-type
-     @param[in]  period        Period structure for downscaling output
+     @param[in]  period        Period structure for downscaling output. NULL to select months over the whole time vector.
      @param[in]  timedim       Time dimension position (1 or 3)
-     @param[in]  time_ls       Time values
+     @param[in]  time_ls       Time values (not used when period is NULL)
      @param[in]  ndima         First dimension length
      @param[in]  ndimb         Second dimension length
      @param[in]  ntime         Time dimension length
@@ -79,11 +79,6 @@ extract_subperiod_months(double **buf_sub, int *ntime_sub, double *bufin, int *y
   
   int *buf_sub_i = NULL; /* Temporary buffer */
 
-  int i; /* Loop counter */
-  int j; /* Loop counter */
-  int t; /* Time loop counter */
-  int tt; /* Time subperiod loop counter */
-
   int istat; /* Diagnostic status */
 
   ut_system *unitSystem = NULL; /* Unit System (udunits) */
@@ -92,66 +87,157 @@ extract_subperiod_months(double **buf_sub, int *ntime_sub, double *bufin, int *y
   double period_begin;
   double period_end;
 
-  int year;
-  int month;
-  int day;
-  int hour;
-  int minutes;
-  double seconds;
+  int pyear; /* Year of period limit */
+  int pmonth; /* Month of period limit */
+  int pday; /* Day of period limit */
+  int hour; /* Hour of period limit */
+  int minutes; /* Minutes of period limit */
+  double seconds; /* Seconds of period limit */
 
   /* Initializing */
   *ntime_sub = 0;
-  
-  /* Initialize udunits */
-  ut_set_error_message_handler(ut_ignore);
-  unitSystem = ut_read_xml(NULL);
-  ut_set_error_message_handler(ut_write_to_stderr);
-  dataunits = ut_parse(unitSystem, time_units, UT_ASCII);
-
-  /* Compute time limits for writing */
-  if (period->year_begin != -1) {
-    (void) printf("%s: Analog output from %02d/%02d/%04d to %02d/%02d/%04d inclusively.\n", __FILE__,
-                  period->month_begin, period->day_begin, period->year_begin,
-                  period->month_end, period->day_end, period->year_end);
-    istat = utInvCalendar2(period->year_begin, period->month_begin, period->day_begin, 0, 0, 0.0, dataunits, &period_begin);
-    istat = utInvCalendar2(period->year_end, period->month_end, period->day_end, 23, 59, 0.0, dataunits, &period_end);
-  }
+
+  /* Allocate memory for time indexes */
+  buf_sub_i = (int *) malloc((ntime > 0 ? ntime : 1) * sizeof(int));
+  if (buf_sub_i == NULL) alloc_error(__FILE__, __LINE__);
+
+  if (period == NULL)
+    /* No period: select months over the whole time vector */
+    *ntime_sub = select_months_index(buf_sub_i, month, smonths, (double *) NULL, 0.0, 0.0, ntime, nmonths);
   else {
-    istat = utCalendar2(time_ls[0], dataunits, &year, &month, &day, &hour, &minutes, &seconds);
-    (void) printf("%s: Analog for the whole period: %02d/%02d/%04d", __FILE__, month, day, year);
-    istat = utCalendar2(time_ls[ntime-1], dataunits, &year, &month, &day, &hour, &minutes, &seconds);
-    (void) printf(" to %02d/%02d/%04d inclusively.\n", month, day, year);
-    period_begin = time_ls[0];
-    period_end = time_ls[ntime-1];
+    /* Initialize udunits */
+    (void) udunits_lock();
+    ut_set_error_message_handler(ut_ignore);
+    unitSystem = ut_read_xml(NULL);
+    ut_set_error_message_handler(ut_write_to_stderr);
+    dataunits = ut_parse(unitSystem, time_units, UT_ASCII);
+
+    /* Compute time limits for writing */
+    if (period->year_begin != -1) {
+      (void) printf("%s: Analog output from %02d/%02d/%04d to %02d/%02d/%04d inclusively.\n", __FILE__,
+                    period->month_begin, period->day_begin, period->year_begin,
+                    period->month_end, period->day_end, period->year_end);
+      istat = utInvCalendar2(period->year_begin, period->month_begin, period->day_begin, 0, 0, 0.0, dataunits, &period_begin);
+      istat = utInvCalendar2(period->year_end, period->month_end, period->day_end, 23, 59, 0.0, dataunits, &period_end);
+    }
+    else {
+      istat = utCalendar2(time_ls[0], dataunits, &pyear, &pmonth, &pday, &hour, &minutes, &seconds);
+      (void) printf("%s: Analog for the whole period: %02d/%02d/%04d", __FILE__, pmonth, pday, pyear);
+      istat = utCalendar2(time_ls[ntime-1], dataunits, &pyear, &pmonth, &pday, &hour, &minutes, &seconds);
+      (void) printf(" to %02d/%02d/%04d inclusively.\n", pmonth, pday, pyear);
+      period_begin = time_ls[0];
+      period_end = time_ls[ntime-1];
+    }
+
+    (void) ut_free(dataunits);
+    (void) ut_free_system(unitSystem);
+    (void) udunits_unlock();
+
+    /* Retrieve time index spanning selected months */
+    *ntime_sub = select_months_index(buf_sub_i, month, smonths, time_ls, period_begin, period_end, ntime, nmonths);
   }
+  
+  /* Allocate memory */
+  (*buf_sub) = (double *) malloc((*ntime_sub)*ndima*ndimb * sizeof(double));
+  if ((*buf_sub) == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Construct new 3D buffer */
+  (void) gather_time_index((*buf_sub), bufin, buf_sub_i, timedim, ndima, ndimb, ntime, (*ntime_sub));
+  
+  /* Free memory */
+  (void) free(buf_sub_i);
+}
+
+/** Extract a sub period of a float vector of selected months. Output is in double precision. */
+void
+extract_subperiod_months_f(double **buf_sub, int *ntime_sub, float *bufin, int *year, int *month, int *day,
+                         char *time_units, char *cal_type, period_struct *period,
+                         int *smonths, int timedim, double *time_ls, int ndima, int ndimb, int ntime, int nmonths) {
+  /**
+     @param[out] buf_sub       3D buffer spanning only time subperiod
+     @param[out] ntime_sub     Number of times in subperiod
+     @param[in]  bufin         3D input buffer in single precision
+     @param[in]  year          Year vector
+     @param[in]  month         Month vector
+     @param[in]  day           Day vector
+     @param[in]  smonths       Selected months vector (values 1-12)
+     @param[in]  time_units    Output base time units (not used when period is NULL)
+     @param[in]  cal_type      Output calendar-type
+     @param[in]  period        Period structure for downscaling output. NULL to select months over the whole time vector.
+     @param[in]  timedim       Time dimension position (1 or 3)
+     @param[in]  time_ls       Time values (not used when period is NULL)
+     @param[in]  ndima         First dimension length
+     @param[in]  ndimb         Second dimension length
+     @param[in]  ntime         Time dimension length
+     @param[in]  nmonths       Number of months in smonths vector
+   */
+  
+  int *buf_sub_i = NULL; /* Temporary buffer */
 
-  /* Retrieve time index spanning selected months */
-  for (t=0; t<ntime; t++)
-    if (time_ls[t] >= period_begin && time_ls[t] <= period_end)
-      for (tt=0; tt<nmonths; tt++)
-        if (month[t] == smonths[tt]) {
-          buf_sub_i = (int *) realloc(buf_sub_i, ((*ntime_sub)+1) * sizeof(int));
-          if (buf_sub_i == NULL) alloc_error(__FILE__, __LINE__);
-          buf_sub_i[(*ntime_sub)++] = t;
-        }
+  int istat; /* Diagnostic status */
+
+  ut_system *unitSystem = NULL; /* Unit System (udunits) */
+  ut_unit *dataunits = NULL; /* udunits variable */
+
+  double period_begin;
+  double period_end;
+
+  int pyear; /* Year of period limit */
+  int pmonth; /* Month of period limit */
+  int pday; /* Day of period limit */
+  int hour; /* Hour of period limit */
+  int minutes; /* Minutes of period limit */
+  double seconds; /* Seconds of period limit */
+
+  /* Initializing */
+  *ntime_sub = 0;
+
+  /* Allocate memory for time indexes */
+  buf_sub_i = (int *) malloc((ntime > 0 ? ntime : 1) * sizeof(int));
+  if (buf_sub_i == NULL) alloc_error(__FILE__, __LINE__);
+
+  if (period == NULL)
+    /* No period: select months over the whole time vector */
+    *ntime_sub = select_months_index(buf_sub_i, month, smonths, (double *) NULL, 0.0, 0.0, ntime, nmonths);
+  else {
+    /* Initialize udunits */
+    (void) udunits_lock();
+    ut_set_error_message_handler(ut_ignore);
+    unitSystem = ut_read_xml(NULL);
+    ut_set_error_message_handler(ut_write_to_stderr);
+    dataunits = ut_parse(unitSystem, time_units, UT_ASCII);
+
+    /* Compute time limits for writing */
+    if (period->year_begin != -1) {
+      (void) printf("%s: Analog output from %02d/%02d/%04d to %02d/%02d/%04d inclusively.\n", __FILE__,
+                    period->month_begin, period->day_begin, period->year_begin,
+                    period->month_end, period->day_end, period->year_end);
+      istat = utInvCalendar2(period->year_begin, period->month_begin, period->day_begin, 0, 0, 0.0, dataunits, &period_begin);
+      istat = utInvCalendar2(period->year_end, period->month_end, period->day_end, 23, 59, 0.0, dataunits, &period_end);
+    }
+    else {
+      istat = utCalendar2(time_ls[0], dataunits, &pyear, &pmonth, &pday, &hour, &minutes, &seconds);
+      (void) printf("%s: Analog for the whole period: %02d/%02d/%04d", __FILE__, pmonth, pday, pyear);
+      istat = utCalendar2(time_ls[ntime-1], dataunits, &pyear, &pmonth, &pday, &hour, &minutes, &seconds);
+      (void) printf(" to %02d/%02d/%04d inclusively.\n", pmonth, pday, pyear);
+      period_begin = time_ls[0];
+      period_end = time_ls[ntime-1];
+    }
+
+    (void) ut_free(dataunits);
+    (void) ut_free_system(unitSystem);
+    (void) udunits_unlock();
+
+    /* Retrieve time index spanning selected months */
+    *ntime_sub = select_months_index(buf_sub_i, month, smonths, time_ls, period_begin, period_end, ntime, nmonths);
+  }
   
   /* Allocate memory */
   (*buf_sub) = (double *) malloc((*ntime_sub)*ndima*ndimb * sizeof(double));
   if ((*buf_sub) == NULL) alloc_error(__FILE__, __LINE__);
 
   /* Construct new 3D buffer */
-  if (timedim == 3)
-    /* Time dimension is the last one */
-    for (t=0; t<(*ntime_sub); t++)
-      for (j=0; j<ndimb; j++)
-        for (i=0; i<ndima; i++)
-          (*buf_sub)[i+j*ndima+t*ndima*ndimb] = bufin[i+j*ndima+buf_sub_i[t]*ndima*ndimb];
-  else
-    /* Time dimension is the first one */
-    for (t=0; t<(*ntime_sub); t++)
-      for (j=0; j<ndimb; j++)
-        for (i=0; i<ndima; i++)
-          (*buf_sub)[t+i*(*ntime_sub)+j*(*ntime_sub)*ndima] = bufin[buf_sub_i[t]+i*ntime+j*ntime*ndima];
+  (void) gather_time_index_f((*buf_sub), bufin, buf_sub_i, timedim, ndima, ndimb, ntime, (*ntime_sub));
   
   /* Free memory */
   (void) free(buf_sub_i);
@@ -0,0 +1,280 @@
+/* ***************************************************** */
+/* Fused spatial and time statistics kernels.            */
+/* field_stats.c                                         */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file field_stats.c
+    \brief Fused spatial and time statistics kernels on compacted masked grids.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <utils.h>
+
+/** Minimum number of elements processed before splitting work over threads. */
+#define FIELD_STATS_MIN_WORK 1048576
+
+/** Number of threads used by statistics kernels. */
+static int field_stats_nthreads = 1;
+
+/** Work unit of a statistics kernel. */
+typedef struct {
+  double *mean; /**< Output mean */
+  double *var; /**< Output variance or standard deviation (time statistics) */
+  double *buf; /**< Input 3D buffer in double precision */
+  float *buf_f; /**< Input 3D buffer in single precision */
+  int *index; /**< Valid points index list, NULL for all points */
+  int npts; /**< Number of valid points */
+  int nij; /**< Number of grid points of each timestep */
+  int ntime; /**< Time dimension */
+  int begin; /**< First item (timestep or grid point) processed */
+  int end; /**< Last item processed plus one */
+} field_stats_task_struct;
+
+/** Set the number of threads used by statistics kernels. */
+void
+field_stats_set_nthreads(int nthreads) {
+  /**
+     @param[in]  nthreads  Number of threads.
+  */
+
+  field_stats_nthreads = (nthreads < 1) ? 1 : nthreads;
+}
+
+/** Compact a 2D mask into the list of indexes of its valid points. */
+int
+mask_index_list(int **index, short int *mask, int ni, int nj) {
+  /**
+     @param[out]  index  Indexes of valid points, in memory order. NULL when mask is NULL.
+     @param[in]   mask   Input 2D mask (valid points equal to 1), or NULL.
+     @param[in]   ni     First dimension
+     @param[in]   nj     Second dimension
+
+     \return             Number of valid points.
+  */
+
+  int npts = 0; /* Number of valid points */
+  int i; /* Loop counter */
+
+  *index = NULL;
+  if (mask == NULL)
+    return ni*nj;
+
+  for (i=0; i<ni*nj; i++)
+    if (mask[i] == 1)
+      npts++;
+  (*index) = (int *) malloc((npts > 0 ? npts : 1) * sizeof(int));
+  if ((*index) == NULL) alloc_error(__FILE__, __LINE__);
+  npts = 0;
+  for (i=0; i<ni*nj; i++)
+    if (mask[i] == 1)
+      (*index)[npts++] = i;
+
+  return npts;
+}
+
+/** Spatial mean of a range of timesteps. */
+static void
+spatial_mean_task(void *arg) {
+  /**
+     @param[in]  arg  Work unit.
+  */
+
+  field_stats_task_struct *task = (field_stats_task_struct *) arg; /* Work unit */
+  size_t offset; /* Offset of current timestep */
+  double sum; /* Sum used to calculate the mean */
+  int t; /* Time loop counter */
+  int pts; /* Points loop counter */
+
+  for (t=task->begin; t<task->end; t++) {
+    offset = (size_t) t * (size_t) task->nij;
+    sum = 0.0;
+    if (task->buf != NULL) {
+      if (task->index == NULL)
+        for (pts=0; pts<task->nij; pts++)
+          sum += task->buf[offset+pts];
+      else
+        for (pts=0; pts<task->npts; pts++)
+          sum += task->buf[offset+task->index[pts]];
+    }
+    else {
+      if (task->index == NULL)
+        for (pts=0; pts<task->nij; pts++)
+          sum += (double) task->buf_f[offset+pts];
+      else
+        for (pts=0; pts<task->npts; pts++)
+          sum += (double) task->buf_f[offset+task->index[pts]];
+    }
+    task->mean[t] = sum / (double) task->npts;
+  }
+}
+
+/** Time mean and standard deviation of a range of grid points, single pass in memory order. */
+static void
+time_mean_sd_task(void *arg) {
+  /**
+     @param[in]  arg  Work unit.
+  */
+
+  field_stats_task_struct *task = (field_stats_task_struct *) arg; /* Work unit */
+  double *pbuf; /* Current timestep */
+  double delta; /* Difference to running mean */
+  double weight; /* Inverse of number of timesteps accumulated */
+  int t; /* Time loop counter */
+  int pts; /* Points loop counter */
+
+  /* Welford accumulation: mean holds the running mean and var the running sum of squared differences */
+  for (pts=task->begin; pts<task->end; pts++) {
+    task->mean[pts] = 0.0;
+    task->var[pts] = 0.0;
+  }
+  for (t=0; t<task->ntime; t++) {
+    pbuf = task->buf + (size_t) t * (size_t) task->nij;
+    weight = 1.0 / (double) (t+1);
+    for (pts=task->begin; pts<task->end; pts++) {
+      delta = pbuf[pts] - task->mean[pts];
+      task->mean[pts] += delta * weight;
+      task->var[pts] += delta * (pbuf[pts] - task->mean[pts]);
+    }
+  }
+  for (pts=task->begin; pts<task->end; pts++)
+    task->var[pts] = sqrt(task->var[pts] / (double) (task->ntime-1));
+}
+
+/** Split items of a statistics kernel into ranges processed by a thread pool. */
+static void
+field_stats_run(thread_task_func func, field_stats_task_struct *proto, int nitems, size_t work) {
+  /**
+     @param[in]  func    Kernel processing a range of items.
+     @param[in]  proto   Work unit shared by all ranges (begin and end are set here).
+     @param[in]  nitems  Number of items to process.
+     @param[in]  work    Total number of elements processed, used to decide if threads are worth it.
+  */
+
+  field_stats_task_struct *tasks = NULL; /* Work units */
+  thread_pool_struct *pool = NULL; /* Thread pool */
+  int ntasks; /* Number of work units */
+  int n; /* Work unit loop counter */
+
+  ntasks = field_stats_nthreads;
+  if (ntasks > nitems)
+    ntasks = nitems;
+  /* Callers already running as tasks of a thread pool (e.g. one learning season per task) use all threads: no nested pool */
+  if (ntasks < 2 || work < FIELD_STATS_MIN_WORK || thread_pool_in_worker()) {
+    proto->begin = 0;
+    proto->end = nitems;
+    func((void *) proto);
+    return;
+  }
+
+  tasks = (field_stats_task_struct *) malloc(ntasks * sizeof(field_stats_task_struct));
+  if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+  pool = thread_pool_create(ntasks);
+  for (n=0; n<ntasks; n++) {
+    tasks[n] = *proto;
+    tasks[n].begin = (int) (((size_t) nitems * (size_t) n) / (size_t) ntasks);
+    tasks[n].end = (int) (((size_t) nitems * (size_t) (n+1)) / (size_t) ntasks);
+    (void) thread_pool_submit(pool, func, (void *) &(tasks[n]));
+  }
+  (void) thread_pool_wait(pool);
+  (void) thread_pool_free(pool);
+  (void) free(tasks);
+}
+
+/** Compute the spatial mean of each timestep of a double or float field over the valid points of an index list. */
+void
+spatial_mean_index(double *buf_mean, double *buf, float *buf_f, int *index, int npts, int ni, int nj, int ntime) {
+  /**
+     @param[out]  buf_mean  Vector (over time) of spatially averaged data
+     @param[in]   buf       Input 3D buffer, or NULL when buf_f is used
+     @param[in]   buf_f     Input 3D buffer in single precision, used when buf is NULL
+     @param[in]   index     Valid points index list as computed by mask_index_list, or NULL for all points
+     @param[in]   npts      Number of valid points
+     @param[in]   ni        First dimension
+     @param[in]   nj        Second dimension
+     @param[in]   ntime     Time dimension
+  */
+
+  field_stats_task_struct task; /* Work unit */
+
+  task.mean = buf_mean;
+  task.var = NULL;
+  task.buf = buf;
+  task.buf_f = buf_f;
+  task.index = index;
+  task.npts = npts;
+  task.nij = ni*nj;
+  task.ntime = ntime;
+
+  (void) field_stats_run(spatial_mean_task, &task, ntime, (size_t) npts * (size_t) ntime);
+}
+
+/** Compute the time mean and variance of a 2D field. */
+void
+time_mean_variance_field_2d(double *bufmean, double *bufvar, double *buf, int ni, int nj, int nt) {
+
+  /** 
+      @param[out]  bufmean       Time mean of 2D field
+      @param[out]  bufvar        Time variance of 2D field, stored as its square root (standard deviation)
+      @param[in]   buf           Input 3D buffer
+      @param[in]   ni            First dimension
+      @param[in]   nj            Second dimension
+      @param[in]   nt            Time dimension
+   */
+
+  field_stats_task_struct task; /* Work unit */
+
+  /* Single pass over time in memory order, split over grid tiles */
+  task.mean = bufmean;
+  task.var = bufvar;
+  task.buf = buf;
+  task.buf_f = NULL;
+  task.index = NULL;
+  task.npts = ni*nj;
+  task.nij = ni*nj;
+  task.ntime = nt;
+
+  (void) field_stats_run(time_mean_sd_task, &task, ni*nj, (size_t) ni * (size_t) nj * (size_t) nt);
+}
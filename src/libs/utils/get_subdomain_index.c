@@ -0,0 +1,167 @@
+/* ***************************************************** */
+/* Compute index ranges of a subdomain given             */
+/* latitudes and longitudes.                             */
+/* get_subdomain_index.c                                 */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file get_subdomain_index.c
+    \brief Compute index ranges of a subdomain given latitudes and longitudes.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <utils.h>
+
+/** Compute index ranges of a subdomain given latitudes and longitudes, with the same selection as extract_subdomain. */
+void
+get_subdomain_index(subdomain_struct *subdomain, double **lon_sub, double **lat_sub, double *lon, double *lat,
+                    double minlon, double maxlon, double minlat, double maxlat, int nlon, int nlat) {
+  /**
+     @param[out] subdomain       Index ranges of the subdomain
+     @param[out] lon_sub         Longitude array spanning only subdomain
+     @param[out] lat_sub         Latitude array spanning only subdomain
+     @param[in]  lon             Longitude array
+     @param[in]  lat             Latitude array
+     @param[in]  minlon          Subdomain bounds: minimum longitude
+     @param[in]  maxlon          Subdomain bounds: maximum longitude
+     @param[in]  minlat          Subdomain bounds: minimum latitude
+     @param[in]  maxlat          Subdomain bounds: maximum latitude
+     @param[in]  nlon            Longitude dimension length
+     @param[in]  nlat            Latitude dimension length
+   */
+
+  int i; /* Loop counter */
+  int j; /* Loop counter */
+  int ii; /* Subdomain loop counter */
+  int jj; /* Subdomain loop counter */
+  int r; /* Index range loop counter */
+  int rr; /* Index range loop counter */
+  int in; /* Current gridpoint is within bounds */
+  int prev; /* Previous gridpoint was within bounds */
+  double curlon; /* Current longitude */
+
+  /* Initializing */
+  subdomain->nlon = subdomain->nlat = 0;
+  subdomain->nlon_runs = subdomain->nlat_runs = 0;
+  /* At most one range every other index */
+  subdomain->lon_start = (size_t *) malloc((nlon/2+1) * sizeof(size_t));
+  if (subdomain->lon_start == NULL) alloc_error(__FILE__, __LINE__);
+  subdomain->lon_count = (size_t *) malloc((nlon/2+1) * sizeof(size_t));
+  if (subdomain->lon_count == NULL) alloc_error(__FILE__, __LINE__);
+  subdomain->lat_start = (size_t *) malloc((nlat/2+1) * sizeof(size_t));
+  if (subdomain->lat_start == NULL) alloc_error(__FILE__, __LINE__);
+  subdomain->lat_count = (size_t *) malloc((nlat/2+1) * sizeof(size_t));
+  if (subdomain->lat_count == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Latitude index ranges */
+  prev = FALSE;
+  for (j=0; j<nlat; j++) {
+    in = (lat[j*nlon] >= minlat && lat[j*nlon] <= maxlat);
+    if (in) {
+      if (prev == FALSE) {
+        subdomain->lat_start[subdomain->nlat_runs] = (size_t) j;
+        subdomain->lat_count[subdomain->nlat_runs++] = 0;
+      }
+      subdomain->lat_count[subdomain->nlat_runs-1]++;
+      subdomain->nlat++;
+    }
+    prev = in;
+  }
+
+  /* Longitude index ranges */
+  /* Adjust to span -180 to +180: a domain crossing the longitude wrap of the grid gives two ranges */
+  prev = FALSE;
+  for (i=0; i<nlon; i++) {
+    if (lon[i] > 180.0)
+      curlon = lon[i] - 360.0;
+    else
+      curlon = lon[i];
+    in = (curlon >= minlon && curlon <= maxlon);
+    if (in) {
+      if (prev == FALSE) {
+        subdomain->lon_start[subdomain->nlon_runs] = (size_t) i;
+        subdomain->lon_count[subdomain->nlon_runs++] = 0;
+      }
+      subdomain->lon_count[subdomain->nlon_runs-1]++;
+      subdomain->nlon++;
+    }
+    prev = in;
+  }
+
+  /* Create also latitude and longitude arrays */
+  (*lon_sub) = (double *) malloc(subdomain->nlon*subdomain->nlat * sizeof(double));
+  if ((*lon_sub) == NULL) alloc_error(__FILE__, __LINE__);
+  (*lat_sub) = (double *) malloc(subdomain->nlon*subdomain->nlat * sizeof(double));
+  if ((*lat_sub) == NULL) alloc_error(__FILE__, __LINE__);
+  jj = 0;
+  for (rr=0; rr<subdomain->nlat_runs; rr++)
+    for (j=(int) subdomain->lat_start[rr]; j<(int) (subdomain->lat_start[rr]+subdomain->lat_count[rr]); j++) {
+      ii = 0;
+      for (r=0; r<subdomain->nlon_runs; r++)
+        for (i=(int) subdomain->lon_start[r]; i<(int) (subdomain->lon_start[r]+subdomain->lon_count[r]); i++) {
+          (*lon_sub)[ii+jj*subdomain->nlon] = lon[i+j*nlon];
+          (*lat_sub)[ii+jj*subdomain->nlon] = lat[i+j*nlon];
+          ii++;
+        }
+      jj++;
+    }
+}
+
+/** Free memory of subdomain index ranges. */
+void
+free_subdomain_index(subdomain_struct *subdomain) {
+  /**
+     @param[in,out] subdomain    Index ranges of the subdomain
+   */
+
+  (void) free(subdomain->lon_start);
+  (void) free(subdomain->lon_count);
+  (void) free(subdomain->lat_start);
+  (void) free(subdomain->lat_count);
+  subdomain->lon_start = subdomain->lon_count = NULL;
+  subdomain->lat_start = subdomain->lat_count = NULL;
+  subdomain->nlon = subdomain->nlat = 0;
+  subdomain->nlon_runs = subdomain->nlat_runs = 0;
+}
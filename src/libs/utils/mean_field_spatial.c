@@ -66,33 +66,33 @@ mean_field_spatial(double *buf_mean, double *buf, short int *mask, int ni, int n
       @param[in]   ntime         Time dimension
    */
 
-  double sum; /* Sum used to calculate the mean */
-  
-  int t; /* Time loop counter */
-  int i; /* Loop counter */
-  int j; /* Loop counter */
-  int pts = 0; /* Points counter */
-
-  /* Loop over all time and average spatially, optionally using a mask */
-  if (mask == NULL)
-    for (t=0; t<ntime; t++) {
-      sum = 0.0;
-      for (j=0; j<nj; j++)
-        for (i=0; i<ni; i++)
-          sum += buf[i+j*ni+t*ni*nj];
-      buf_mean[t] = sum / (double) (ni*nj);
-    }
-  else {
-    for (t=0; t<ntime; t++) {
-      sum = 0.0;
-      pts = 0;
-      for (j=0; j<nj; j++)
-        for (i=0; i<ni; i++)
-          if (mask[i+j*ni] == 1) {
-            sum += buf[i+j*ni+t*ni*nj];
-            pts++;
-          }
-      buf_mean[t] = sum / (double) pts;
-    }
-  }
+  int *index = NULL; /* Valid points index list */
+  int npts; /* Number of valid points */
+
+  /* Compact the mask once, then average spatially each timestep over valid points */
+  npts = mask_index_list(&index, mask, ni, nj);
+  (void) spatial_mean_index(buf_mean, buf, (float *) NULL, index, npts, ni, nj, ntime);
+  (void) free(index);
+}
+
+/** Compute the spatial mean of a field for float input buffer. Sums are accumulated in double precision. */
+void
+mean_field_spatial_f(double *buf_mean, float *buf, short int *mask, int ni, int nj, int ntime) {
+
+  /** 
+      @param[out]  buf_mean      Vector (over time) of spatially averaged data
+      @param[in]   buf           Input 3D buffer (single precision)
+      @param[in]   mask          Input 2D mask
+      @param[in]   ni            First dimension
+      @param[in]   nj            Second dimension
+      @param[in]   ntime         Time dimension
+   */
+
+  int *index = NULL; /* Valid points index list */
+  int npts; /* Number of valid points */
+
+  /* Compact the mask once, then average spatially each timestep over valid points */
+  npts = mask_index_list(&index, mask, ni, nj);
+  (void) spatial_mean_index(buf_mean, (double *) NULL, buf, index, npts, ni, nj, ntime);
+  (void) free(index);
 }
@@ -68,44 +68,30 @@ mean_variance_field_spatial(double *buf_mean, double *buf_var, double *buf, shor
      @param[in]   ntime          Time dimension
    */
 
-  double sum; /* Sum to compute mean */
   double *buf_smean = NULL; /* Vector (over time) of spatially averaged data */
-  
+  int *index = NULL; /* Valid points index list */
+  int npts; /* Number of valid points */
+  double delta; /* Difference to running mean */
+  double m2 = 0.0; /* Running sum of squared differences to the mean */
   int t; /* Time loop counter */
-  int i; /* Loop counter */
-  int j; /* Loop counter */
-  int pts = 0; /* Points counter */
 
   /* Allocate memory */
   buf_smean = (double *) malloc(ntime * sizeof(double));
   if (buf_smean == NULL) alloc_error(__FILE__, __LINE__);
 
-  /* Loop over all times and calculate spatial average, optionally using a mask */
-  if (mask == NULL)
-    for (t=0; t<ntime; t++) {
-      sum = 0.0;
-      for (j=0; j<nj; j++)
-        for (i=0; i<ni; i++)
-          sum += buf[i+j*ni+t*ni*nj];
-      buf_smean[t] = sum / (double) (ni*nj);
-    }
-  else {
-    for (t=0; t<ntime; t++) {
-      sum = 0.0;
-      pts = 0;
-      for (j=0; j<nj; j++)
-        for (i=0; i<ni; i++)
-          if (mask[i+j*ni] == 1) {
-            sum += buf[i+j*ni+t*ni*nj];
-            pts++;
-          }
-      buf_smean[t] = sum / (double) pts;
-    }
+  /* Calculate spatial average of each timestep, optionally using a mask */
+  npts = mask_index_list(&index, mask, ni, nj);
+  (void) spatial_mean_index(buf_smean, buf, (float *) NULL, index, npts, ni, nj, ntime);
+  (void) free(index);
+
+  /* Compute mean and variance over time in one pass */
+  *buf_mean = 0.0;
+  for (t=0; t<ntime; t++) {
+    delta = buf_smean[t] - (*buf_mean);
+    (*buf_mean) += delta / (double) (t+1);
+    m2 += delta * (buf_smean[t] - (*buf_mean));
   }
-  
-  /* Compute mean and variance over time */
-  *buf_mean = gsl_stats_mean(buf_smean, 1, ntime);
-  *buf_var = gsl_stats_variance(buf_smean, 1, ntime);
+  *buf_var = m2 / (double) (ntime-1);
 
   /* Free memory */
   (void) free(buf_smean);
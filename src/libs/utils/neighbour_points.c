@@ -0,0 +1,179 @@
+/* ***************************************************** */
+/* Find grid points within a distance of a list of       */
+/* points using a latitude-sorted index.                 */
+/* neighbour_points.c                                    */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file neighbour_points.c
+    \brief Find grid points within a distance of a list of points using a latitude-sorted index.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#include <utils.h>
+
+/** Latitude of a grid point with its index, to sort grid points by latitude. */
+typedef struct {
+  double lat; /**< Latitude. */
+  int index; /**< Grid point index. */
+} lat_index_struct;
+
+/** Compare latitudes to sort ascending. */
+static int
+compar_lat_index(const void *a, const void *b)
+{
+  const lat_index_struct *n1 = (const lat_index_struct *) a;
+  const lat_index_struct *n2 = (const lat_index_struct *) b;
+
+  if (n1->lat < n2->lat)
+    return -1;
+  else if (n1->lat > n2->lat)
+    return 1;
+  else
+    return 0;
+}
+
+/** Compare integers to sort ascending. */
+static int
+compar_int(const void *a, const void *b)
+{
+  return (*((const int *) a) > *((const int *) b)) - (*((const int *) a) < *((const int *) b));
+}
+
+/** Find grid points within a distance of a list of points using a latitude-sorted index. */
+void
+neighbour_points(int **nb_start, int **nb_index, double *lon_pts, double *lat_pts, double *lon, double *lat,
+                 double dist, int npts, int ngrid)
+{
+  /**
+     @param[out]  nb_start  Start of the neighbours of each point in nb_index (npts+1 elements): the neighbours of
+                            point pt are nb_index[nb_start[pt]] to nb_index[nb_start[pt+1]-1]
+     @param[out]  nb_index  Grid point indexes of neighbours, in increasing order for each point
+     @param[in]   lon_pts   Longitudes of points
+     @param[in]   lat_pts   Latitudes of points
+     @param[in]   lon       Longitudes of grid points
+     @param[in]   lat       Latitudes of grid points
+     @param[in]   dist      Maximum distance in meters (same Earth radius as distance_point)
+     @param[in]   npts      Number of points
+     @param[in]   ngrid     Number of grid points
+   */
+
+  /* Earth equatorial radius, meters, Clarke 1866 ellipsoid, as in distance_point */
+  const double r_earth = 6378206.4;
+  const double degtorad = M_PI / 180.0;
+
+  lat_index_struct *sorted = NULL; /* Grid points sorted by latitude */
+  double radius; /* Angular radius in degrees, with a small safety margin */
+  double dlon; /* Longitude half-width of the bounding box, in degrees */
+  double difflon; /* Longitude difference */
+  int nalloc; /* Allocated number of neighbours */
+  int nnb = 0; /* Number of neighbours */
+  int first; /* First candidate in latitude-sorted index */
+  int low; /* Binary search lower bound */
+  int high; /* Binary search upper bound */
+  int mid; /* Binary search middle */
+  int pt; /* Points loop counter */
+  int i; /* Loop counter */
+
+  sorted = (lat_index_struct *) malloc((ngrid > 0 ? ngrid : 1) * sizeof(lat_index_struct));
+  if (sorted == NULL) alloc_error(__FILE__, __LINE__);
+  for (i=0; i<ngrid; i++) {
+    sorted[i].lat = lat[i];
+    sorted[i].index = i;
+  }
+  (void) qsort(sorted, (size_t) ngrid, sizeof(lat_index_struct), compar_lat_index);
+
+  (*nb_start) = (int *) malloc((npts+1) * sizeof(int));
+  if ((*nb_start) == NULL) alloc_error(__FILE__, __LINE__);
+  nalloc = (npts > 0 ? npts : 1) * 16;
+  (*nb_index) = (int *) malloc(nalloc * sizeof(int));
+  if ((*nb_index) == NULL) alloc_error(__FILE__, __LINE__);
+
+  radius = (dist / r_earth) / degtorad * (1.0 + 1.0e-6) + 1.0e-9;
+
+  for (pt=0; pt<npts; pt++) {
+    (*nb_start)[pt] = nnb;
+
+    /* Longitude half-width of the bounding box of the spherical cap, unless it contains a pole */
+    if (fabs(lat_pts[pt]) + radius < 90.0 && radius < 90.0)
+      dlon = asin(sin(radius * degtorad) / cos(lat_pts[pt] * degtorad)) / degtorad * (1.0 + 1.0e-6) + 1.0e-9;
+    else
+      dlon = 360.0;
+
+    /* First grid point in the latitude band */
+    low = 0;
+    high = ngrid;
+    while (low < high) {
+      mid = low + (high - low) / 2;
+      if (sorted[mid].lat < lat_pts[pt] - radius)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    first = low;
+
+    /* Exact distance test on the candidates of the bounding box */
+    for (i=first; i<ngrid && sorted[i].lat <= lat_pts[pt] + radius; i++) {
+      difflon = fmod(fabs(lon[sorted[i].index] - lon_pts[pt]), 360.0);
+      if (difflon > 180.0)
+        difflon = 360.0 - difflon;
+      if (difflon <= dlon &&
+          distance_point(lon_pts[pt], lat_pts[pt], lon[sorted[i].index], lat[sorted[i].index]) <= dist) {
+        if (nnb == nalloc) {
+          nalloc *= 2;
+          (*nb_index) = (int *) realloc((*nb_index), nalloc * sizeof(int));
+          if ((*nb_index) == NULL) alloc_error(__FILE__, __LINE__);
+        }
+        (*nb_index)[nnb++] = sorted[i].index;
+      }
+    }
+
+    /* Grid order, so that sums over neighbours are accumulated in the same order as a scan of the grid */
+    (void) qsort(&((*nb_index)[(*nb_start)[pt]]), (size_t) (nnb - (*nb_start)[pt]), sizeof(int), compar_int);
+  }
+  (*nb_start)[npts] = nnb;
+
+  (void) free(sorted);
+}
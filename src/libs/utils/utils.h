@@ -111,6 +111,18 @@ typedef struct {
   float sec; /**< Second (0-59). */
 } tstruct;
 
+/** Index ranges of a subdomain in a longitude-latitude grid. */
+typedef struct {
+  int nlon; /**< Longitude dimension length of the subdomain. */
+  int nlat; /**< Latitude dimension length of the subdomain. */
+  int nlon_runs; /**< Number of contiguous longitude index ranges (2 when the subdomain crosses the longitude wrap of the grid). */
+  size_t *lon_start; /**< First longitude index of each range. */
+  size_t *lon_count; /**< Number of longitudes in each range. */
+  int nlat_runs; /**< Number of contiguous latitude index ranges. */
+  size_t *lat_start; /**< First latitude index of each range. */
+  size_t *lat_count; /**< Number of latitudes in each range. */
+} subdomain_struct;
+
 #ifndef PERIOD_STRUCT_H
 /** Period definition period_struct */
 typedef struct {
@@ -125,11 +137,18 @@ typedef struct {
 #define PERIOD_STRUCT_H
 #endif
 
-void alloc_mmap_shortint(short int **map, int *fd, size_t *byte_size, char *filename, size_t page_size, int size);
-void alloc_mmap_longint(long int **map, int *fd, size_t *byte_size, char *filename, size_t page_size, int size);
-void alloc_mmap_int(int **map, int *fd, size_t *byte_size, char *filename, size_t page_size, int size);
-void alloc_mmap_float(float **map, int *fd, size_t *byte_size, char *filename, size_t page_size, int size);
-void alloc_mmap_double(double **map, int *fd, size_t *byte_size, char *filename, size_t page_size, int size);
+int alloc_large_init(char *scratch_dir, size_t min_bytes);
+void *alloc_large(size_t byte_size);
+int alloc_large_move(void **ptr, size_t byte_size);
+void free_large(void *ptr);
+void alloc_large_cleanup(void);
+int alloc_mmap_shortint(short int **map, int *fd, size_t *byte_size, char *filename, size_t page_size, size_t size);
+int alloc_mmap_longint(long int **map, int *fd, size_t *byte_size, char *filename, size_t page_size, size_t size);
+int alloc_mmap_int(int **map, int *fd, size_t *byte_size, char *filename, size_t page_size, size_t size);
+int alloc_mmap_float(float **map, int *fd, size_t *byte_size, char *filename, size_t page_size, size_t size);
+int alloc_mmap_double(double **map, int *fd, size_t *byte_size, char *filename, size_t page_size, size_t size);
+int data_to_gregorian_cal_index(int **tindex, double **outtimeval, int *ntimeout, double *intimeval, char *tunits_in,
+                                char *tunits_out, char *cal_type, int ntimein);
 int data_to_gregorian_cal_d(double **bufout, double **outtimeval, int *ntimeout, double *bufin,
                             double *intimeval, char *tunits_in, char *tunits_out, char *cal_type, int ni, int nj, int ntimein);
 int data_to_gregorian_cal_f(float **bufout, double **outtimeval, int *ntimeout, float *bufin,
@@ -137,19 +156,42 @@ int data_to_gregorian_cal_f(float **bufout, double **outtimeval, int *ntimeout,
 int get_calendar(int *year, int *month, int *day, int *hour, int *minutes, float *seconds, char *tunits, double *timein, int ntime);
 int get_calendar_ts(tstruct *timeout, char *tunits, double *timein, int ntime);
 void change_date_origin(double *timeout, char *tunits_out, double *timein, char *tunits_in, int ntime);
+void field_stats_set_nthreads(int nthreads);
+void udunits_lock(void);
+void udunits_unlock(void);
+int mask_index_list(int **index, short int *mask, int ni, int nj);
+void spatial_mean_index(double *buf_mean, double *buf, float *buf_f, int *index, int npts, int ni, int nj, int ntime);
 void mean_variance_field_spatial(double *buf_mean, double *buf_var, double *buf, short int *mask, int ni, int nj, int ntime);
 void mean_field_spatial(double *buf_mean, double *buf, short int *mask, int ni, int nj, int ntime);
+void mean_field_spatial_f(double *buf_mean, float *buf, short int *mask, int ni, int nj, int ntime);
 void normalize_field_2d(double *nbuf, double *buf, double *mean, double *var, int ndima, int ndimb, int ntime);
 void time_mean_variance_field_2d(double *bufmean, double *bufvar, double *buf, int ni, int nj, int nt);
 void covariance_fields_spatial(double *cov, double *buf1, double *buf2, short int *mask, int t1, int t2, int ni, int nj);
+int anomaly_fields_spatial(double *anom, double *buf, short int *mask, int ni, int nj, int ntime);
+double covariance_anomalies_spatial(double *anom1, double *anom2, int t1, int t2, int npts);
+int pack_date(int year, int month, int day);
+int match_common_dates(int *index, int *year, int *month, int *day, int *year_learn, int *month_learn, int *day_learn,
+                       int ntime, int ntime_learn);
+int select_months_index(int *index, int *month, int *smonths, double *time_ls, double time_begin, double time_end,
+                        int ntime, int nmonths);
+void gather_time_index(double *buf_sub, double *bufin, int *index, int timedim, int ndima, int ndimb, int ntime, int ntime_sub);
+void gather_time_index_f(double *buf_sub, float *bufin, int *index, int timedim, int ndima, int ndimb, int ntime, int ntime_sub);
 int sub_period_common(double **buf_sub, int *ntime_sub, double *bufin, int *year, int *month, int *day,
                       int *year_learn, int *month_learn, int *day_learn, int timedim, int ndima, int ndimb, int ntime, int ntime_learn);
+int sub_period_common_f(double **buf_sub, int *ntime_sub, float *bufin, int *year, int *month, int *day,
+                        int *year_learn, int *month_learn, int *day_learn, int timedim, int ndima, int ndimb, int ntime, int ntime_learn);
+void get_subdomain_index(subdomain_struct *subdomain, double **lon_sub, double **lat_sub, double *lon, double *lat,
+                         double minlon, double maxlon, double minlat, double maxlat, int nlon, int nlat);
+void free_subdomain_index(subdomain_struct *subdomain);
 void extract_subdomain(double **buf_sub, double **lon_sub, double **lat_sub, int *nlon_sub, int *nlat_sub, double *buf,
                        double *lon, double *lat, double minlon, double maxlon, double minlat, double maxlat,
                        int nlon, int nlat, int ndim);
 void extract_subperiod_months(double **buf_sub, int *ntime_sub, double *bufin, int *year, int *month, int *day,
                               char *time_units, char *cal_type, period_struct *period,
                               int *smonths, int timedim, double *time_ls, int ndima, int ndimb, int ntime, int nmonths);
+void extract_subperiod_months_f(double **buf_sub, int *ntime_sub, float *bufin, int *year, int *month, int *day,
+                                char *time_units, char *cal_type, period_struct *period,
+                                int *smonths, int timedim, double *time_ls, int ndima, int ndimb, int ntime, int nmonths);
 void mask_region(double *buffer, double missing_value, double *lon, double *lat,
                  double minlon, double maxlon, double minlat, double maxlat,
                  int nlon, int nlat, int ndim);
@@ -157,6 +199,8 @@ void mask_points(double *buffer, double missing_value, short int *mask, int nlon
 void normalize_field(double *nbuf, double *buf, double mean, double var, int ndima, int ndimb, int ntime);
 int comparf(const void *a, const void *b);
 double distance_point(double lon1, double lat1, double lon2, double lat2);
+void neighbour_points(int **nb_start, int **nb_index, double *lon_pts, double *lat_pts, double *lon, double *lat,
+                      double dist, int npts, int ngrid);
 int find_str_value(char *str, char **str_vect, int nelem);
 void alt_to_press(double *pres, double *alt, int ni, int nj);
 void spechum_to_hr(double *hr, double *tas, double *hus, double *pmsl, double fillvalue, int ni, int nj);
@@ -80,6 +80,12 @@ load_conf(data_struct *data, char *fileconf) {
   char *saveptr = NULL; /* Pointer to save buffer data for thread-safe strtok use */
   char *catstr; /* Category string */
   char *catstrt; /* Category string */
+  char *member_path; /* Path matching the ensemble members pattern */
+  char *checkpoint_file; /* Checkpoint filename */
+  int analog_resumed = FALSE; /* If analog data is read from checkpoints */
+#ifdef HAVE_GLOB_H
+  glob_t members_glob; /* Paths matching the ensemble members pattern */
+#endif
 
   (void) fprintf(stdout, "%s: *** Current Configuration ***\n\n", __FILE__);
 
@@ -268,6 +274,99 @@ load_conf(data_struct *data, char *fileconf) {
   else
     data->conf->compression_level = 0;
 
+  /** number_of_threads: threads used for parallel processing **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "number_of_threads");
+  val = xml_get_setting(conf, path);
+  if (val != NULL) {
+    data->conf->nthreads = (int) xmlXPathCastStringToNumber(val);
+    if (data->conf->nthreads < 1) {
+      data->conf->nthreads = 1;
+      (void) fprintf(stdout, "%s: WARNING: number_of_threads invalid value (must be 1 or more). Forced to %d.\n",
+                     __FILE__, data->conf->nthreads);
+    }
+    (void) xmlFree(val);
+  }
+  else
+    data->conf->nthreads = 1;
+  (void) fprintf(stdout, "%s: Number of threads = %d\n", __FILE__, data->conf->nthreads);
+  /* Statistics kernels on large grids are split over the same number of threads */
+  (void) field_stats_set_nthreads(data->conf->nthreads);
+
+  /** output_pipeline: overlap reading, corrections and writing of successive days of downscaled output **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "output_pipeline");
+  val = xml_get_setting(conf, path);
+  if ( !xmlStrcmp(val, (xmlChar *) "Off") )
+    data->conf->output_pipeline = FALSE;
+  else
+    data->conf->output_pipeline = TRUE;
+  (void) fprintf(stdout, "%s: output_pipeline = %d\n", __FILE__, data->conf->output_pipeline);
+  if (val != NULL)
+    (void) xmlFree(val);
+
+  /** prefetch_memory: memory budget in MB for large-scale inputs read in the background while earlier ones are processed **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "prefetch_memory");
+  val = xml_get_setting(conf, path);
+  if (val != NULL) {
+    data->conf->prefetch_memory = (int) xmlXPathCastStringToNumber(val);
+    if (data->conf->prefetch_memory < 0) {
+      data->conf->prefetch_memory = 0;
+      (void) fprintf(stdout, "%s: WARNING: prefetch_memory invalid value (must be 0 or more). Forced to %d.\n",
+                     __FILE__, data->conf->prefetch_memory);
+    }
+    (void) xmlFree(val);
+  }
+  else
+    data->conf->prefetch_memory = 512;
+  (void) fprintf(stdout, "%s: Memory budget for background reads of large-scale inputs = %d MB\n", __FILE__, data->conf->prefetch_memory);
+
+  /** decompression_threads: threads inflating compressed NetCDF-4 chunks of input variables **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "decompression_threads");
+  val = xml_get_setting(conf, path);
+  if (val != NULL) {
+    data->conf->decompression_threads = (int) xmlXPathCastStringToNumber(val);
+    if (data->conf->decompression_threads < 0) {
+      data->conf->decompression_threads = 0;
+      (void) fprintf(stdout, "%s: WARNING: decompression_threads invalid value (must be 0 or more). Forced to %d.\n",
+                     __FILE__, data->conf->decompression_threads);
+    }
+    (void) xmlFree(val);
+  }
+  else
+    data->conf->decompression_threads = data->conf->nthreads;
+  (void) fprintf(stdout, "%s: Threads inflating compressed NetCDF-4 inputs = %d\n", __FILE__, data->conf->decompression_threads);
+  /* Below 2 threads, inputs are read through the NetCDF library only */
+  (void) read_netcdf_chunks_set_nthreads(data->conf->decompression_threads);
+
+  /** scratch_directory: memory-map large arrays on files in this directory instead of allocating them on the heap **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "scratch_directory");
+  val = xml_get_setting(conf, path);
+  if (val != NULL) {
+    data->conf->scratch_dir = arena_strdup(data->arena[PHASE_CONF], (char *) val);
+    if (data->conf->scratch_dir == NULL) alloc_error(__FILE__, __LINE__);
+    (void) xmlFree(val);
+    (void) fprintf(stdout, "%s: Scratch directory for large arrays = %s\n", __FILE__, data->conf->scratch_dir);
+  }
+  else
+    data->conf->scratch_dir = NULL;
+
+  /** scratch_min_size: minimum size in MB of arrays memory-mapped in the scratch directory **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "scratch_min_size");
+  val = xml_get_setting(conf, path);
+  if (val != NULL) {
+    data->conf->scratch_min_size = (int) xmlXPathCastStringToNumber(val);
+    if (data->conf->scratch_min_size < 0)
+      data->conf->scratch_min_size = 0;
+    (void) xmlFree(val);
+  }
+  else
+    data->conf->scratch_min_size = 64;
+  if (data->conf->scratch_dir != NULL)
+    (void) fprintf(stdout, "%s: Minimum size of memory-mapped arrays = %d MB\n", __FILE__, data->conf->scratch_min_size);
+  if (alloc_large_init(data->conf->scratch_dir, (size_t) data->conf->scratch_min_size * 1024 * 1024) != 0) {
+    (void) fprintf(stderr, "%s: Cannot use scratch directory for large arrays. Aborting.\n", __FILE__);
+    return -1;
+  }
+
   /** Fix incorrect time in input climate model file, and use 01/01/YEARBEGIN as first day, and assume daily data since it is required. */
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "fixtime");
   val = xml_get_setting(conf, path);
@@ -324,7 +423,7 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "clim_filter_type");
   val = xml_get_setting(conf, path);
   if ( !xmlStrcmp(val, (xmlChar *) "hanning") )
-    data->conf->clim_filter_type = strdup("hanning");
+    data->conf->clim_filter_type = arena_strdup(data->arena[PHASE_CONF], "hanning");
   else {
     (void) fprintf(stderr, "%s: Invalid clim_filter_type value %s in configuration file. Aborting.\n", __FILE__, val);
     (void) abort();
@@ -348,7 +447,7 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "classif_type");
   val = xml_get_setting(conf, path);
   if ( !xmlStrcmp(val, (xmlChar *) "euclidian") )
-    data->conf->classif_type = strdup("euclidian");
+    data->conf->classif_type = arena_strdup(data->arena[PHASE_CONF], "euclidian");
   else {
     (void) fprintf(stderr, "%s: Invalid classif_type value %s in configuration file. Aborting.\n", __FILE__, val);
     (void) abort();
@@ -405,9 +504,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "base_time_units");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->time_units = strdup((char *) val);
+    data->conf->time_units = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->time_units = strdup("days since 1900-01-01 12:00:00");
+    data->conf->time_units = arena_strdup(data->arena[PHASE_CONF], "days since 1900-01-01 12:00:00");
   (void) fprintf(stdout, "%s: base_time_units = %s\n", __FILE__, data->conf->time_units);
   if (val != NULL)
     (void) xmlFree(val);
@@ -416,9 +515,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "base_calendar_type");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->cal_type = strdup((char *) val);
+    data->conf->cal_type = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->cal_type = strdup("gregorian");
+    data->conf->cal_type = arena_strdup(data->arena[PHASE_CONF], "gregorian");
   (void) fprintf(stdout, "%s: base_calendar_type = %s\n", __FILE__, data->conf->cal_type);
   if (val != NULL)
     (void) xmlFree(val);
@@ -427,9 +526,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "longitude_name_eof");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->lonname_eof = strdup((char *) val);
+    data->conf->lonname_eof = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->lonname_eof = strdup("lon");  
+    data->conf->lonname_eof = arena_strdup(data->arena[PHASE_CONF], "lon");  
   (void) fprintf(stdout, "%s: longitude_name_eof = %s\n", __FILE__, data->conf->lonname_eof);
   if (val != NULL)
     (void) xmlFree(val);
@@ -438,9 +537,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "latitude_name_eof");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->latname_eof = strdup((char *) val);
+    data->conf->latname_eof = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->latname_eof = strdup("lat");
+    data->conf->latname_eof = arena_strdup(data->arena[PHASE_CONF], "lat");
   (void) fprintf(stdout, "%s: latitude_name_eof = %s\n", __FILE__, data->conf->latname_eof);
   if (val != NULL)
     (void) xmlFree(val);
@@ -449,9 +548,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "dimx_name_eof");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->dimxname_eof = strdup((char *) val);
+    data->conf->dimxname_eof = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->dimxname_eof = strdup("lon");  
+    data->conf->dimxname_eof = arena_strdup(data->arena[PHASE_CONF], "lon");  
   (void) fprintf(stdout, "%s: dimx_name_eof = %s\n", __FILE__, data->conf->dimxname_eof);
   if (val != NULL)
     (void) xmlFree(val);
@@ -460,9 +559,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "dimy_name_eof");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->dimyname_eof = strdup((char *) val);
+    data->conf->dimyname_eof = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->dimyname_eof = strdup("lat");
+    data->conf->dimyname_eof = arena_strdup(data->arena[PHASE_CONF], "lat");
   (void) fprintf(stdout, "%s: dimy_name_eof = %s\n", __FILE__, data->conf->dimyname_eof);
   if (val != NULL)
     (void) xmlFree(val);
@@ -471,9 +570,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "eof_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->eofname = strdup((char *) val);
+    data->conf->eofname = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->eofname = strdup("eof");
+    data->conf->eofname = arena_strdup(data->arena[PHASE_CONF], "eof");
   (void) fprintf(stdout, "%s: eof_name = %s\n", __FILE__, data->conf->eofname);
   if (val != NULL)
     (void) xmlFree(val);
@@ -482,9 +581,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "pts_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->ptsname = strdup((char *) val);
+    data->conf->ptsname = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->ptsname = strdup("pts");
+    data->conf->ptsname = arena_strdup(data->arena[PHASE_CONF], "pts");
   (void) fprintf(stdout, "%s: pts_name = %s\n", __FILE__, data->conf->ptsname);
   if (val != NULL)
     (void) xmlFree(val);
@@ -493,9 +592,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "clust_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->clustname = strdup((char *) val);
+    data->conf->clustname = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->clustname = strdup("clust");
+    data->conf->clustname = arena_strdup(data->arena[PHASE_CONF], "clust");
   (void) fprintf(stdout, "%s: clust_name = %s\n", __FILE__, data->conf->clustname);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -615,7 +714,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "filename");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->secondary_mask->filename = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->secondary_mask->filename = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->secondary_mask->filename == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->secondary_mask->filename, (char *) val);
       (void) fprintf(stdout, "%s: Secondary large-scale fields mask filename = %s\n", __FILE__, data->secondary_mask->filename);
@@ -625,14 +724,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "mask_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->secondary_mask->maskname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->secondary_mask->maskname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->secondary_mask->maskname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->secondary_mask->maskname, (char *) val);
         (void) fprintf(stdout, "%s: Secondary large-scale fields mask name = %s\n", __FILE__, data->secondary_mask->maskname);
         (void) xmlFree(val);
       }
       else {
-        data->secondary_mask->maskname = strdup("mask");
+        data->secondary_mask->maskname = arena_strdup(data->arena[PHASE_CONF], "mask");
         (void) fprintf(stderr, "%s: Default secondary large-scale fields mask name = %s\n", __FILE__,
                        data->secondary_mask->maskname);
         (void) xmlFree(val);
@@ -641,14 +740,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "longitude_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->secondary_mask->lonname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->secondary_mask->lonname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->secondary_mask->lonname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->secondary_mask->lonname, (char *) val);
         (void) fprintf(stdout, "%s: Secondary large-scale fields mask longitude_name = %s\n", __FILE__, data->secondary_mask->lonname);
         (void) xmlFree(val);
       }
       else {
-        data->secondary_mask->lonname = strdup("lon");
+        data->secondary_mask->lonname = arena_strdup(data->arena[PHASE_CONF], "lon");
         (void) fprintf(stderr, "%s: Default secondary large-scale fields mask longitude_name = %s\n", __FILE__,
                        data->secondary_mask->lonname);
         (void) xmlFree(val);
@@ -657,14 +756,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "latitude_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->secondary_mask->latname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->secondary_mask->latname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->secondary_mask->latname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->secondary_mask->latname, (char *) val);
         (void) fprintf(stdout, "%s: Secondary large-scale fields mask latitude_name = %s\n", __FILE__, data->secondary_mask->latname);
         (void) xmlFree(val);
       }
       else {
-        data->secondary_mask->latname = strdup("lat");
+        data->secondary_mask->latname = arena_strdup(data->arena[PHASE_CONF], "lat");
         (void) fprintf(stderr, "%s: Default secondary large-scale fields mask latitude_name = %s\n", __FILE__,
                        data->secondary_mask->latname);
         (void) xmlFree(val);
@@ -673,9 +772,9 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "coordinates");
       val = xml_get_setting(conf, path);
       if (val != NULL)
-        data->secondary_mask->coords = strdup((char *) val);
+        data->secondary_mask->coords = arena_strdup(data->arena[PHASE_CONF], (char *) val);
       else
-        data->secondary_mask->coords = strdup("2D");
+        data->secondary_mask->coords = arena_strdup(data->arena[PHASE_CONF], "2D");
       (void) fprintf(stdout, "%s: Secondary large-scale fields mask coords = %s\n", __FILE__, data->secondary_mask->coords);
       if (val != NULL)
         (void) xmlFree(val);    
@@ -683,14 +782,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "dimx_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->secondary_mask->dimxname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->secondary_mask->dimxname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->secondary_mask->dimxname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->secondary_mask->dimxname, (char *) val);
         (void) fprintf(stdout, "%s: Secondary large-scale fields mask dimx_name = %s\n", __FILE__, data->secondary_mask->dimxname);
         (void) xmlFree(val);
       }
       else {
-        data->secondary_mask->dimxname = strdup("dimx");
+        data->secondary_mask->dimxname = arena_strdup(data->arena[PHASE_CONF], "dimx");
         (void) fprintf(stderr, "%s: Default secondary large-scale fields mask dimx_name = %s\n", __FILE__,
                        data->secondary_mask->dimxname);
         (void) xmlFree(val);
@@ -699,14 +798,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "dimy_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->secondary_mask->dimyname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->secondary_mask->dimyname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->secondary_mask->dimyname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->secondary_mask->dimyname, (char *) val);
         (void) fprintf(stdout, "%s: Secondary large-scale fields mask dimy_name = %s\n", __FILE__, data->secondary_mask->dimyname);
         (void) xmlFree(val);
       }
       else {
-        data->secondary_mask->dimyname = strdup("dimy");
+        data->secondary_mask->dimyname = arena_strdup(data->arena[PHASE_CONF], "dimy");
         (void) fprintf(stderr, "%s: Default secondary large-scale fields mask dimy_name = %s\n", __FILE__,
                        data->secondary_mask->dimyname);
         (void) xmlFree(val);
@@ -715,9 +814,9 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "dim_coordinates");
       val = xml_get_setting(conf, path);
       if (val != NULL)
-        data->secondary_mask->dimcoords = strdup((char *) val);
+        data->secondary_mask->dimcoords = arena_strdup(data->arena[PHASE_CONF], (char *) val);
       else
-        data->secondary_mask->dimcoords = strdup("2D");
+        data->secondary_mask->dimcoords = arena_strdup(data->arena[PHASE_CONF], "2D");
       (void) fprintf(stdout, "%s: Secondary large-scale fields mask dim_coords = %s\n", __FILE__, data->secondary_mask->dimcoords);
       if (val != NULL)
         (void) xmlFree(val);    
@@ -725,13 +824,13 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_secondary_large_scale_mask", "projection");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->secondary_mask->proj = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->secondary_mask->proj = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->secondary_mask->proj == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->secondary_mask->proj, (char *) val);
         (void) xmlFree(val);
       }
       else
-        data->secondary_mask->proj = strdup("latitude_longitude");
+        data->secondary_mask->proj = arena_strdup(data->arena[PHASE_CONF], "latitude_longitude");
       (void) fprintf(stdout, "%s: Secondary large-scale fields mask projection = %s\n",
                      __FILE__, data->secondary_mask->proj);
     }
@@ -812,7 +911,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "filename");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->conf->learning_maskfile->filename = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->conf->learning_maskfile->filename = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->conf->learning_maskfile->filename == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->conf->learning_maskfile->filename, (char *) val);
       (void) fprintf(stdout, "%s: Learning domain maskfile filename = %s\n", __FILE__, data->conf->learning_maskfile->filename);
@@ -822,14 +921,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "mask_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->learning_maskfile->maskname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->conf->learning_maskfile->maskname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->conf->learning_maskfile->maskname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->conf->learning_maskfile->maskname, (char *) val);
         (void) fprintf(stdout, "%s: Learning domain maskfile name = %s\n", __FILE__, data->conf->learning_maskfile->maskname);
         (void) xmlFree(val);
       }
       else {
-        data->conf->learning_maskfile->maskname = strdup("mask");
+        data->conf->learning_maskfile->maskname = arena_strdup(data->arena[PHASE_CONF], "mask");
         (void) fprintf(stderr, "%s: Default learning domain maskfile name = %s\n", __FILE__,
                        data->conf->learning_maskfile->maskname);
         (void) xmlFree(val);
@@ -838,14 +937,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "longitude_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->learning_maskfile->lonname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->conf->learning_maskfile->lonname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->conf->learning_maskfile->lonname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->conf->learning_maskfile->lonname, (char *) val);
         (void) fprintf(stdout, "%s: Learning domain maskfile longitude_name = %s\n", __FILE__, data->conf->learning_maskfile->lonname);
         (void) xmlFree(val);
       }
       else {
-        data->conf->learning_maskfile->lonname = strdup("lon");
+        data->conf->learning_maskfile->lonname = arena_strdup(data->arena[PHASE_CONF], "lon");
         (void) fprintf(stderr, "%s: Default learning domain maskfile longitude_name = %s\n", __FILE__,
                        data->conf->learning_maskfile->lonname);
         (void) xmlFree(val);
@@ -854,14 +953,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "latitude_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->learning_maskfile->latname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->conf->learning_maskfile->latname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->conf->learning_maskfile->latname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->conf->learning_maskfile->latname, (char *) val);
         (void) fprintf(stdout, "%s: Learning domain maskfile latitude_name = %s\n", __FILE__, data->conf->learning_maskfile->latname);
         (void) xmlFree(val);
       }
       else {
-        data->conf->learning_maskfile->latname = strdup("lat");
+        data->conf->learning_maskfile->latname = arena_strdup(data->arena[PHASE_CONF], "lat");
         (void) fprintf(stderr, "%s: Default learning domain maskfile latitude_name = %s\n", __FILE__,
                        data->conf->learning_maskfile->latname);
         (void) xmlFree(val);
@@ -870,9 +969,9 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "coordinates");
       val = xml_get_setting(conf, path);
       if (val != NULL)
-        data->conf->learning_maskfile->coords = strdup((char *) val);
+        data->conf->learning_maskfile->coords = arena_strdup(data->arena[PHASE_CONF], (char *) val);
       else
-        data->conf->learning_maskfile->coords = strdup("2D");
+        data->conf->learning_maskfile->coords = arena_strdup(data->arena[PHASE_CONF], "2D");
       (void) fprintf(stdout, "%s: Learning domain maskfile coords = %s\n", __FILE__, data->conf->learning_maskfile->coords);
       if (val != NULL)
         (void) xmlFree(val);    
@@ -880,14 +979,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "dimx_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->learning_maskfile->dimxname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->conf->learning_maskfile->dimxname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->conf->learning_maskfile->dimxname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->conf->learning_maskfile->dimxname, (char *) val);
         (void) fprintf(stdout, "%s: Learning domain maskfile dimx_name = %s\n", __FILE__, data->conf->learning_maskfile->dimxname);
         (void) xmlFree(val);
       }
       else {
-        data->conf->learning_maskfile->dimxname = strdup("dimx");
+        data->conf->learning_maskfile->dimxname = arena_strdup(data->arena[PHASE_CONF], "dimx");
         (void) fprintf(stderr, "%s: Default learning domain maskfile dimx_name = %s\n", __FILE__,
                        data->conf->learning_maskfile->dimxname);
         (void) xmlFree(val);
@@ -896,14 +995,14 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "dimy_name");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->learning_maskfile->dimyname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->conf->learning_maskfile->dimyname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->conf->learning_maskfile->dimyname == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->conf->learning_maskfile->dimyname, (char *) val);
         (void) fprintf(stdout, "%s: Learning domain maskfile dimy_name = %s\n", __FILE__, data->conf->learning_maskfile->dimyname);
         (void) xmlFree(val);
       }
       else {
-        data->conf->learning_maskfile->dimyname = strdup("dimy");
+        data->conf->learning_maskfile->dimyname = arena_strdup(data->arena[PHASE_CONF], "dimy");
         (void) fprintf(stderr, "%s: Default learning domain maskfile dimy_name = %s\n", __FILE__,
                        data->conf->learning_maskfile->dimyname);
         (void) xmlFree(val);
@@ -912,9 +1011,9 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "dim_coordinates");
       val = xml_get_setting(conf, path);
       if (val != NULL)
-        data->conf->learning_maskfile->dimcoords = strdup((char *) val);
+        data->conf->learning_maskfile->dimcoords = arena_strdup(data->arena[PHASE_CONF], (char *) val);
       else
-        data->conf->learning_maskfile->dimcoords = strdup("2D");
+        data->conf->learning_maskfile->dimcoords = arena_strdup(data->arena[PHASE_CONF], "2D");
       (void) fprintf(stdout, "%s: Learning domain maskfile dim_coords = %s\n", __FILE__, data->conf->learning_maskfile->dimcoords);
       if (val != NULL)
         (void) xmlFree(val);    
@@ -922,13 +1021,13 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "domain_learning_maskfile", "projection");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->learning_maskfile->proj = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+        data->conf->learning_maskfile->proj = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
         if (data->conf->learning_maskfile->proj == NULL) alloc_error(__FILE__, __LINE__);
         (void) strcpy(data->conf->learning_maskfile->proj, (char *) val);
         (void) xmlFree(val);
       }
       else
-        data->conf->learning_maskfile->proj = strdup("latitude_longitude");
+        data->conf->learning_maskfile->proj = arena_strdup(data->arena[PHASE_CONF], "latitude_longitude");
       (void) fprintf(stdout, "%s: Learning domain maskfile projection = %s\n",
                      __FILE__, data->conf->learning_maskfile->proj);
     }
@@ -946,7 +1045,7 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "path");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->output_path = strdup((char *) val);
+    data->conf->output_path = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
     (void) fprintf(stderr, "%s: Missing or invalid output path setting. Aborting.\n", __FILE__);
     return -1;
@@ -972,9 +1071,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "title");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->title = strdup((char *) val);
+    data->info->title = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->title = strdup("Downscaling data from Cerfacs");
+    data->info->title = arena_strdup(data->arena[PHASE_CONF], "Downscaling data from Cerfacs");
   }
   (void) fprintf(stdout, "%s: output metadata title = %s\n", __FILE__, data->info->title);
   if (val != NULL)
@@ -984,9 +1083,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "title_french");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->title_french = strdup((char *) val);
+    data->info->title_french = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->title_french = strdup("Donnees de desagregation produites par le Cerfacs");
+    data->info->title_french = arena_strdup(data->arena[PHASE_CONF], "Donnees de desagregation produites par le Cerfacs");
   }
   (void) fprintf(stdout, "%s: output metadata title_french = %s\n", __FILE__, data->info->title_french);
   if (val != NULL)
@@ -996,9 +1095,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "summary");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->summary = strdup((char *) val);
+    data->info->summary = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->summary = strdup("Downscaling data from Cerfacs");
+    data->info->summary = arena_strdup(data->arena[PHASE_CONF], "Downscaling data from Cerfacs");
   }
   (void) fprintf(stdout, "%s: output metadata summary = %s\n", __FILE__, data->info->summary);
   if (val != NULL)
@@ -1008,9 +1107,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "summary_french");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->summary_french = strdup((char *) val);
+    data->info->summary_french = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->summary_french = strdup("Donnees de desagregation produites par le Cerfacs");
+    data->info->summary_french = arena_strdup(data->arena[PHASE_CONF], "Donnees de desagregation produites par le Cerfacs");
   }
   (void) fprintf(stdout, "%s: output metadata summary_french = %s\n", __FILE__, data->info->summary_french);
   if (val != NULL)
@@ -1020,9 +1119,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "description");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->description = strdup((char *) val);
+    data->info->description = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->description = strdup("Downscaling data from Cerfacs");
+    data->info->description = arena_strdup(data->arena[PHASE_CONF], "Downscaling data from Cerfacs");
   }
   (void) fprintf(stdout, "%s: output metadata description = %s\n", __FILE__, data->info->description);
   if (val != NULL)
@@ -1032,9 +1131,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "keywords");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->keywords = strdup((char *) val);
+    data->info->keywords = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->keywords = strdup("climat,scenarios,desagregation,downscaling,Cerfacs");
+    data->info->keywords = arena_strdup(data->arena[PHASE_CONF], "climat,scenarios,desagregation,downscaling,Cerfacs");
   }
   (void) fprintf(stdout, "%s: output metadata keywords = %s\n", __FILE__, data->info->keywords);
   if (val != NULL)
@@ -1044,16 +1143,16 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "processor");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->processor = strdup((char *) val);
+    data->info->processor = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->processor = strdup("C programming language");
+    data->info->processor = arena_strdup(data->arena[PHASE_CONF], "C programming language");
   }
   (void) fprintf(stdout, "%s: output metadata processor = %s\n", __FILE__, data->info->processor);
   if (val != NULL)
     (void) xmlFree(val);    
 
   /* Initialize software string */
-  data->info->software = (char *) malloc(1000 * sizeof(char));
+  data->info->software = (char *) arena_alloc(data->arena[PHASE_CONF], 1000 * sizeof(char));
   if (data->info->software == NULL) alloc_error(__FILE__, __LINE__);
   (void) sprintf(data->info->software, "%s %s", PACKAGE_NAME, PACKAGE_VERSION);
 
@@ -1061,9 +1160,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "institution");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->institution = strdup((char *) val);
+    data->info->institution = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->institution = strdup("Cerfacs");
+    data->info->institution = arena_strdup(data->arena[PHASE_CONF], "Cerfacs");
   }
   (void) fprintf(stdout, "%s: output metadata institution = %s\n", __FILE__, data->info->institution);
   if (val != NULL)
@@ -1073,9 +1172,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "creator_email");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->creator_email = strdup((char *) val);
+    data->info->creator_email = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->creator_email = strdup("globc@cerfacs.fr");
+    data->info->creator_email = arena_strdup(data->arena[PHASE_CONF], "globc@cerfacs.fr");
   }
   (void) fprintf(stdout, "%s: output metadata creator_email = %s\n", __FILE__, data->info->creator_email);
   if (val != NULL)
@@ -1085,9 +1184,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "creator_url");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->creator_url = strdup((char *) val);
+    data->info->creator_url = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->creator_url = strdup("http://www.cerfacs.fr/globc/");
+    data->info->creator_url = arena_strdup(data->arena[PHASE_CONF], "http://www.cerfacs.fr/globc/");
   }
   (void) fprintf(stdout, "%s: output metadata creator_url = %s\n", __FILE__, data->info->creator_url);
   if (val != NULL)
@@ -1097,9 +1196,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "creator_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->creator_name = strdup((char *) val);
+    data->info->creator_name = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->creator_name = strdup("Global Change Team");
+    data->info->creator_name = arena_strdup(data->arena[PHASE_CONF], "Global Change Team");
   }
   (void) fprintf(stdout, "%s: output metadata creator_name = %s\n", __FILE__, data->info->creator_name);
   if (val != NULL)
@@ -1109,9 +1208,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "version");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->version = strdup((char *) val);
+    data->info->version = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->version = strdup("1.0");
+    data->info->version = arena_strdup(data->arena[PHASE_CONF], "1.0");
   }
   (void) fprintf(stdout, "%s: output metadata version = %s\n", __FILE__, data->info->version);
   if (val != NULL)
@@ -1121,9 +1220,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "scenario");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->scenario = strdup((char *) val);
+    data->info->scenario = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->scenario = strdup("SRESA1B");
+    data->info->scenario = arena_strdup(data->arena[PHASE_CONF], "SRESA1B");
   }
   (void) fprintf(stdout, "%s: output metadata scenario = %s\n", __FILE__, data->info->scenario);
   if (val != NULL)
@@ -1133,9 +1232,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "scenario_co2");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->scenario_co2 = strdup((char *) val);
+    data->info->scenario_co2 = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->scenario_co2 = strdup("A1B");
+    data->info->scenario_co2 = arena_strdup(data->arena[PHASE_CONF], "A1B");
   }
   (void) fprintf(stdout, "%s: output metadata scenario_co2 = %s\n", __FILE__, data->info->scenario_co2);
   if (val != NULL)
@@ -1145,9 +1244,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "model");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->model = strdup((char *) val);
+    data->info->model = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->model = strdup("ARPEGE grille etiree");
+    data->info->model = arena_strdup(data->arena[PHASE_CONF], "ARPEGE grille etiree");
   }
   (void) fprintf(stdout, "%s: output metadata model = %s\n", __FILE__, data->info->model);
   if (val != NULL)
@@ -1157,9 +1256,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "institution_model");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->institution_model = strdup((char *) val);
+    data->info->institution_model = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->institution_model = strdup("Meteo-France CNRM/GMGEC");
+    data->info->institution_model = arena_strdup(data->arena[PHASE_CONF], "Meteo-France CNRM/GMGEC");
   }
   (void) fprintf(stdout, "%s: output metadata institution_model = %s\n", __FILE__, data->info->institution_model);
   if (val != NULL)
@@ -1169,9 +1268,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "country");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->country = strdup((char *) val);
+    data->info->country = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->country = strdup("France");
+    data->info->country = arena_strdup(data->arena[PHASE_CONF], "France");
   }
   (void) fprintf(stdout, "%s: output metadata country = %s\n", __FILE__, data->info->country);
   if (val != NULL)
@@ -1181,9 +1280,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "member");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->member = strdup((char *) val);
+    data->info->member = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->member = strdup("1");
+    data->info->member = arena_strdup(data->arena[PHASE_CONF], "1");
   }
   (void) fprintf(stdout, "%s: output metadata member = %s\n", __FILE__, data->info->member);
   if (val != NULL)
@@ -1193,9 +1292,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "downscaling_forcing");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->downscaling_forcing = strdup((char *) val);
+    data->info->downscaling_forcing = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->downscaling_forcing = strdup("SAFRAN 1970-2005");
+    data->info->downscaling_forcing = arena_strdup(data->arena[PHASE_CONF], "SAFRAN 1970-2005");
   }
   (void) fprintf(stdout, "%s: output metadata downscaling_forcing = %s\n", __FILE__, data->info->downscaling_forcing);
   if (val != NULL)
@@ -1205,9 +1304,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "timestep");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->timestep = strdup((char *) val);
+    data->info->timestep = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->timestep = strdup("daily");
+    data->info->timestep = arena_strdup(data->arena[PHASE_CONF], "daily");
   }
   if ( !strcmp(data->info->timestep, "daily") || !strcmp(data->info->timestep, "hourly"))
     (void) fprintf(stdout, "%s: output metadata timestep = %s\n", __FILE__, data->info->timestep);
@@ -1221,9 +1320,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "contact_email");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->contact_email = strdup((char *) val);
+    data->info->contact_email = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->contact_email = strdup("christian.page@cerfacs.fr");
+    data->info->contact_email = arena_strdup(data->arena[PHASE_CONF], "christian.page@cerfacs.fr");
   }
   (void) fprintf(stdout, "%s: output metadata contact_email = %s\n", __FILE__, data->info->contact_email);
   if (val != NULL)
@@ -1233,9 +1332,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "contact_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->contact_name = strdup((char *) val);
+    data->info->contact_name = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->contact_name = strdup("Christian PAGE");
+    data->info->contact_name = arena_strdup(data->arena[PHASE_CONF], "Christian PAGE");
   }
   (void) fprintf(stdout, "%s: output metadata contact_name = %s\n", __FILE__, data->info->contact_name);
   if (val != NULL)
@@ -1245,9 +1344,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "other_contact_email");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->other_contact_email = strdup((char *) val);
+    data->info->other_contact_email = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->other_contact_email = strdup("laurent.terray@cerfacs.fr");
+    data->info->other_contact_email = arena_strdup(data->arena[PHASE_CONF], "laurent.terray@cerfacs.fr");
   }
   (void) fprintf(stdout, "%s: output metadata other_contact_email = %s\n", __FILE__, data->info->other_contact_email);
   if (val != NULL)
@@ -1257,9 +1356,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "output", "other_contact_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->info->other_contact_name = strdup((char *) val);
+    data->info->other_contact_name = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
-    data->info->other_contact_name = strdup("Laurent TERRAY");
+    data->info->other_contact_name = arena_strdup(data->arena[PHASE_CONF], "Laurent TERRAY");
   }
   (void) fprintf(stdout, "%s: output metadata other_contact_name = %s\n", __FILE__, data->info->other_contact_name);
   if (val != NULL)
@@ -1304,6 +1403,8 @@ load_conf(data_struct *data, char *fileconf) {
     if (data->conf->obs_var->units == NULL) alloc_error(__FILE__, __LINE__);
     data->conf->obs_var->height = (char **) malloc(data->conf->obs_var->nobs_var * sizeof(char *));
     if (data->conf->obs_var->height == NULL) alloc_error(__FILE__, __LINE__);
+    data->conf->obs_var->encoding = (nc_encoding_struct *) malloc(data->conf->obs_var->nobs_var * sizeof(nc_encoding_struct));
+    if (data->conf->obs_var->encoding == NULL) alloc_error(__FILE__, __LINE__);
 
     /* Loop over observation variables */
     for (i=0; i<data->conf->obs_var->nobs_var; i++) {
@@ -1311,7 +1412,7 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "acronym");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->obs_var->acronym[i] = strdup((char *) val);
+        data->conf->obs_var->acronym[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
         (void) xmlFree(val);
       }
       else {
@@ -1322,7 +1423,7 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "netcdfname");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->obs_var->netcdfname[i] = strdup((char *) val);
+        data->conf->obs_var->netcdfname[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
         (void) xmlFree(val);
       }
       else {
@@ -1333,7 +1434,7 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]", "setting", "observations", "variables", "name", i+1);
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->obs_var->name[i] = strdup((char *) val);
+        data->conf->obs_var->name[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
         (void) xmlFree(val);
       }
       else {
@@ -1366,11 +1467,11 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "postprocess");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->obs_var->post[i] = strdup((char *) val);
+        data->conf->obs_var->post[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
         (void) xmlFree(val);
       }
       else {
-        data->conf->obs_var->post[i] = strdup("no");
+        data->conf->obs_var->post[i] = arena_strdup(data->arena[PHASE_CONF], "no");
       }
 
       if ( strcmp(data->conf->obs_var->post[i], "yes") && strcmp(data->conf->obs_var->post[i], "no") ) {
@@ -1385,11 +1486,11 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "clim");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->obs_var->clim[i] = strdup((char *) val);
+        data->conf->obs_var->clim[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
         (void) xmlFree(val);
       }
       else {
-        data->conf->obs_var->clim[i] = strdup("no");
+        data->conf->obs_var->clim[i] = arena_strdup(data->arena[PHASE_CONF], "no");
       }
 
       if ( strcmp(data->conf->obs_var->clim[i], "yes") && strcmp(data->conf->obs_var->clim[i], "no") ) {
@@ -1401,11 +1502,11 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "output");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->obs_var->output[i] = strdup((char *) val);
+        data->conf->obs_var->output[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
         (void) xmlFree(val);
       }
       else {
-        data->conf->obs_var->output[i] = strdup("yes");
+        data->conf->obs_var->output[i] = arena_strdup(data->arena[PHASE_CONF], "yes");
       }
 
       if ( strcmp(data->conf->obs_var->output[i], "yes") && strcmp(data->conf->obs_var->output[i], "no") ) {
@@ -1417,20 +1518,77 @@ load_conf(data_struct *data, char *fileconf) {
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "units");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->obs_var->units[i] = strdup((char *) val);
+        data->conf->obs_var->units[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
         (void) xmlFree(val);
       }
       else {
-        data->conf->obs_var->units[i] = strdup("unknown");
+        data->conf->obs_var->units[i] = arena_strdup(data->arena[PHASE_CONF], "unknown");
       }
       (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "height");
       val = xml_get_setting(conf, path);
       if (val != NULL) {
-        data->conf->obs_var->height[i] = strdup((char *) val);
+        data->conf->obs_var->height[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
         (void) xmlFree(val);
       }
       else {
-        data->conf->obs_var->height[i] = strdup("unknown");
+        data->conf->obs_var->height[i] = arena_strdup(data->arena[PHASE_CONF], "unknown");
+      }
+
+      /* Output encoding: lossy encodings reduce the size of compressed output */
+      data->conf->obs_var->encoding[i].type = NC_ENCODING_FLOAT;
+      data->conf->obs_var->encoding[i].scale_factor = 1.0;
+      data->conf->obs_var->encoding[i].add_offset = 0.0;
+      data->conf->obs_var->encoding[i].nsd = 0;
+      (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "encoding");
+      val = xml_get_setting(conf, path);
+      if (val != NULL) {
+        if ( !xmlStrcmp(val, (xmlChar *) "short") )
+          data->conf->obs_var->encoding[i].type = NC_ENCODING_SHORT;
+        else if ( !xmlStrcmp(val, (xmlChar *) "digits") )
+          data->conf->obs_var->encoding[i].type = NC_ENCODING_DIGITS;
+        else if ( xmlStrcmp(val, (xmlChar *) "float") ) {
+          (void) fprintf(stderr, "%s: Invalid observation variable encoding setting %s (valid values are \"float\", \"short\" or \"digits\"). Aborting.\n",
+                         __FILE__, val);
+          (void) xmlFree(val);
+          return -1;
+        }
+        (void) xmlFree(val);
+      }
+      if (data->conf->obs_var->encoding[i].type == NC_ENCODING_SHORT) {
+        data->conf->obs_var->encoding[i].scale_factor = 0.0;
+        (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "scale_factor");
+        val = xml_get_setting(conf, path);
+        if (val != NULL) {
+          /* Kept in single precision, as written in the scale_factor and add_offset attributes */
+          data->conf->obs_var->encoding[i].scale_factor = (double) (float) xmlXPathCastStringToNumber(val);
+          (void) xmlFree(val);
+        }
+        if (data->conf->obs_var->encoding[i].scale_factor <= 0.0) {
+          (void) fprintf(stderr, "%s: Missing or invalid observation variable scale_factor setting for short encoding. Aborting.\n", __FILE__);
+          return -1;
+        }
+        (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "add_offset");
+        val = xml_get_setting(conf, path);
+        if (val != NULL) {
+          data->conf->obs_var->encoding[i].add_offset = (double) (float) xmlXPathCastStringToNumber(val);
+          (void) xmlFree(val);
+        }
+        (void) printf("%s: Variable id=%d packed in shorts with scale_factor=%g add_offset=%g\n", __FILE__, i+1,
+                      data->conf->obs_var->encoding[i].scale_factor, data->conf->obs_var->encoding[i].add_offset);
+      }
+      else if (data->conf->obs_var->encoding[i].type == NC_ENCODING_DIGITS) {
+        (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s/%s[@id=\"%d\"]/@%s", "setting", "observations", "variables", "name", i+1, "significant_digits");
+        val = xml_get_setting(conf, path);
+        if (val != NULL) {
+          data->conf->obs_var->encoding[i].nsd = (int) xmlXPathCastStringToNumber(val);
+          (void) xmlFree(val);
+        }
+        if (data->conf->obs_var->encoding[i].nsd < 1 || data->conf->obs_var->encoding[i].nsd > 7) {
+          (void) fprintf(stderr, "%s: Missing or invalid observation variable significant_digits setting for digits encoding (must be between 1 and 7). Aborting.\n", __FILE__);
+          return -1;
+        }
+        (void) printf("%s: Variable id=%d bit-groomed to %d significant digits\n", __FILE__, i+1,
+                      data->conf->obs_var->encoding[i].nsd);
       }
     
       (void) printf("%s: Variable id=%d name=\"%s\" netcdfname=%s acronym=%s factor=%f delta=%f postprocess=%s output=%s\n", __FILE__, i+1, data->conf->obs_var->name[i], data->conf->obs_var->netcdfname[i], data->conf->obs_var->acronym[i], data->conf->obs_var->factor[i], data->conf->obs_var->delta[i], data->conf->obs_var->post[i], data->conf->obs_var->output[i]);
@@ -1445,7 +1603,7 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "frequency");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->frequency = strdup((char *) val);
+    data->conf->obs_var->frequency = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
     (void) fprintf(stderr, "%s: Missing or invalid observations data frequency setting. Aborting.\n", __FILE__);
     return -1;
@@ -1465,7 +1623,7 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "template");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->template = strdup((char *) val);
+    data->conf->obs_var->template = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
     (void) fprintf(stderr, "%s: Missing or invalid output template setting. Aborting.\n", __FILE__);
     return -1;
@@ -1495,7 +1653,7 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "path");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->path = strdup((char *) val);
+    data->conf->obs_var->path = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
     (void) fprintf(stderr, "%s: Missing or invalid observations data path setting. Aborting.\n", __FILE__);
     return -1;
@@ -1519,9 +1677,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "dim_coordinates");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->dimcoords = strdup((char *) val);
+    data->conf->obs_var->dimcoords = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->obs_var->dimcoords = strdup("1D");
+    data->conf->obs_var->dimcoords = arena_strdup(data->arena[PHASE_CONF], "1D");
   (void) fprintf(stdout, "%s: Observations coords = %s\n", __FILE__, data->conf->obs_var->dimcoords);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1530,9 +1688,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "longitude_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->lonname = strdup((char *) val);
+    data->conf->obs_var->lonname = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->obs_var->lonname = strdup("lon");  
+    data->conf->obs_var->lonname = arena_strdup(data->arena[PHASE_CONF], "lon");  
   (void) fprintf(stdout, "%s: Observations longitude_name = %s\n", __FILE__, data->conf->obs_var->lonname);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1541,9 +1699,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "latitude_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->latname = strdup((char *) val);
+    data->conf->obs_var->latname = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->obs_var->latname = strdup("lat");
+    data->conf->obs_var->latname = arena_strdup(data->arena[PHASE_CONF], "lat");
   (void) fprintf(stdout, "%s: Observations latitude_name = %s\n", __FILE__, data->conf->obs_var->latname);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1552,9 +1710,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "dimx_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->dimxname = strdup((char *) val);
+    data->conf->obs_var->dimxname = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->obs_var->dimxname = strdup("lon");  
+    data->conf->obs_var->dimxname = arena_strdup(data->arena[PHASE_CONF], "lon");  
   (void) fprintf(stdout, "%s: Observations dimx_name = %s\n", __FILE__, data->conf->obs_var->dimxname);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1563,9 +1721,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "dimy_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->dimyname = strdup((char *) val);
+    data->conf->obs_var->dimyname = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->obs_var->dimyname = strdup("lat");
+    data->conf->obs_var->dimyname = arena_strdup(data->arena[PHASE_CONF], "lat");
   (void) fprintf(stdout, "%s: Observations dimy_name = %s\n", __FILE__, data->conf->obs_var->dimyname);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1574,9 +1732,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations",  "time_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->timename = strdup((char *) val);
+    data->conf->obs_var->timename = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->obs_var->timename = strdup("time");
+    data->conf->obs_var->timename = arena_strdup(data->arena[PHASE_CONF], "time");
   (void) fprintf(stdout, "%s: Observations time_name = %s\n", __FILE__, data->conf->obs_var->timename);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1585,9 +1743,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "coordinates");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->proj->coords = strdup((char *) val);
+    data->conf->obs_var->proj->coords = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->obs_var->proj->coords = strdup("2D");
+    data->conf->obs_var->proj->coords = arena_strdup(data->arena[PHASE_CONF], "2D");
   (void) fprintf(stdout, "%s: Observations coords = %s\n", __FILE__, data->conf->obs_var->proj->coords);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1596,10 +1754,10 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations", "altitude");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->altitude = strdup((char *) val);
+    data->conf->obs_var->altitude = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else {
     (void) fprintf(stderr, "%s: Missing observations altitude filename. Will not be able to calculate Relative Humidity if specified.\n", __FILE__);
-    data->conf->obs_var->altitude = strdup("");
+    data->conf->obs_var->altitude = arena_strdup(data->arena[PHASE_CONF], "");
   }
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1608,9 +1766,9 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "observations",  "altitude_name");
   val = xml_get_setting(conf, path);
   if (val != NULL)
-    data->conf->obs_var->altitudename = strdup((char *) val);
+    data->conf->obs_var->altitudename = arena_strdup(data->arena[PHASE_CONF], (char *) val);
   else
-    data->conf->obs_var->altitudename = strdup("Altitude");
+    data->conf->obs_var->altitudename = arena_strdup(data->arena[PHASE_CONF], "Altitude");
   (void) fprintf(stdout, "%s: Observations altitude_name = %s\n", __FILE__, data->conf->obs_var->altitudename);
   if (val != NULL)
     (void) xmlFree(val);    
@@ -1651,6 +1809,19 @@ load_conf(data_struct *data, char *fileconf) {
   if (val != NULL) 
     (void) xmlFree(val);
 
+  /** learning_cache: directory of learning data cached by fingerprint of the learning inputs **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "learning_cache");
+  val = xml_get_setting(conf, path);
+  if (val != NULL) {
+    data->learning->cache_dir = arena_strdup(data->arena[PHASE_CONF], (char *) val);
+    if (data->learning->cache_dir == NULL) alloc_error(__FILE__, __LINE__);
+    (void) xmlFree(val);
+    (void) fprintf(stdout, "%s: Learning cache directory = %s\n", __FILE__, data->learning->cache_dir);
+  }
+  else
+    data->learning->cache_dir = NULL;
+  data->learning->cache_key = NULL;
+
   /** number of EOFs one parameter **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "number_of_eofs");
   val = xml_get_setting(conf, path);
@@ -1692,7 +1863,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_save_weight");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->filename_save_weight = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->filename_save_weight = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->filename_save_weight == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->filename_save_weight, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_save_weight = %s\n", __FILE__, data->learning->filename_save_weight);
@@ -1708,7 +1879,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_save_learn");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->filename_save_learn = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->filename_save_learn = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->filename_save_learn == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->filename_save_learn, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_save_learn = %s\n", __FILE__, data->learning->filename_save_learn);
@@ -1724,7 +1895,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_save_clust_learn");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->filename_save_clust_learn = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->filename_save_clust_learn = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->filename_save_clust_learn == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->filename_save_clust_learn, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_save_clust_learn = %s\n", __FILE__, data->learning->filename_save_clust_learn);
@@ -1744,7 +1915,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_open_weight");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->filename_open_weight = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->filename_open_weight = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->filename_open_weight == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->filename_open_weight, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_open_weight = %s\n", __FILE__, data->learning->filename_open_weight);
@@ -1760,7 +1931,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_open_learn");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->filename_open_learn = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->filename_open_learn = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->filename_open_learn == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->filename_open_learn, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_open_learn = %s\n", __FILE__, data->learning->filename_open_learn);
@@ -1776,7 +1947,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_open_clust_learn");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->filename_open_clust_learn = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->filename_open_clust_learn = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->filename_open_clust_learn == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->filename_open_clust_learn, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_open_clust_learn = %s\n", __FILE__, data->learning->filename_open_clust_learn);
@@ -1804,7 +1975,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_obs_eof");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs->filename_eof = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs->filename_eof = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs->filename_eof == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs->filename_eof, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_obs_eof = %s\n", __FILE__, data->learning->obs->filename_eof);
@@ -1820,7 +1991,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_rea_eof");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea->filename_eof = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea->filename_eof = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea->filename_eof == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea->filename_eof, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_rea_eof = %s\n", __FILE__, data->learning->rea->filename_eof);
@@ -1836,7 +2007,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "filename_rea_sup");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->filename_rea_sup = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->filename_rea_sup = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->filename_rea_sup == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->filename_rea_sup, (char *) val);
       (void) fprintf(stdout, "%s: Learning filename_rea_sup = %s\n", __FILE__, data->learning->filename_rea_sup);
@@ -1852,13 +2023,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_obs_eof");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs->nomvar_eof = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs->nomvar_eof = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs->nomvar_eof == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs->nomvar_eof, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->obs->nomvar_eof = strdup("pre_pc");
+      data->learning->obs->nomvar_eof = arena_strdup(data->arena[PHASE_CONF], "pre_pc");
     }
     (void) fprintf(stdout, "%s: Learning nomvar_eof = %s\n", __FILE__, data->learning->obs->nomvar_eof);
     
@@ -1866,13 +2037,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_rea_eof");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea->nomvar_eof = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea->nomvar_eof = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea->nomvar_eof == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea->nomvar_eof, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->rea->nomvar_eof = strdup("psl_pc");
+      data->learning->rea->nomvar_eof = arena_strdup(data->arena[PHASE_CONF], "psl_pc");
     }
     (void) fprintf(stdout, "%s: Learning nomvar_eof = %s\n", __FILE__, data->learning->obs->nomvar_eof);
     
@@ -1880,39 +2051,39 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_obs_sing");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs->nomvar_sing = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs->nomvar_sing = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs->nomvar_sing == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs->nomvar_sing, (char *) val);
       (void) xmlFree(val);
     }
     else
-      data->learning->obs->nomvar_sing = strdup("pre_sing");
+      data->learning->obs->nomvar_sing = arena_strdup(data->arena[PHASE_CONF], "pre_sing");
     (void) fprintf(stdout, "%s: Learning nomvar_obs_sing = %s\n", __FILE__, data->learning->obs->nomvar_sing);
 
     /** nomvar_rea_sing **/
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_rea_sing");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea->nomvar_sing = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea->nomvar_sing = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea->nomvar_sing == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea->nomvar_sing, (char *) val);
       (void) xmlFree(val);
     }
     else
-      data->learning->rea->nomvar_sing = strdup("pre_sing");
+      data->learning->rea->nomvar_sing = arena_strdup(data->arena[PHASE_CONF], "pre_sing");
     (void) fprintf(stdout, "%s: Learning nomvar_rea_sing = %s\n", __FILE__, data->learning->rea->nomvar_sing);
 
     /** nomvar_rea_sup **/
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_rea_sup");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->nomvar_rea_sup = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->nomvar_rea_sup = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->nomvar_rea_sup == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->nomvar_rea_sup, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->nomvar_rea_sup = strdup("tas");
+      data->learning->nomvar_rea_sup = arena_strdup(data->arena[PHASE_CONF], "tas");
     }
     (void) fprintf(stdout, "%s: Learning nomvar_sup = %s\n", __FILE__, data->learning->nomvar_rea_sup);
 
@@ -1920,13 +2091,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "rea_coords");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea_coords = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea_coords = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea_coords == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea_coords, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->rea_coords = strdup("1D");
+      data->learning->rea_coords = arena_strdup(data->arena[PHASE_CONF], "1D");
     }
     (void) fprintf(stdout, "%s: Learning rea_coords = %s\n", __FILE__, data->learning->rea_coords);
 
@@ -1934,13 +2105,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "rea_gridname");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea_gridname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea_gridname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea_gridname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea_gridname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->rea_gridname = strdup("latitude_longitude");
+      data->learning->rea_gridname = arena_strdup(data->arena[PHASE_CONF], "latitude_longitude");
     }
     (void) fprintf(stdout, "%s: Learning rea_gridname = %s\n", __FILE__, data->learning->rea_gridname);
 
@@ -1948,13 +2119,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "rea_dimx_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea_dimxname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea_dimxname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea_dimxname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea_dimxname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->rea_dimxname = strdup("lon");
+      data->learning->rea_dimxname = arena_strdup(data->arena[PHASE_CONF], "lon");
     }
     (void) fprintf(stdout, "%s: Learning rea_dimx_name = %s\n", __FILE__, data->learning->rea_dimxname);
 
@@ -1962,13 +2133,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "rea_dimy_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea_dimyname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea_dimyname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea_dimyname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea_dimyname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->rea_dimyname = strdup("lat");
+      data->learning->rea_dimyname = arena_strdup(data->arena[PHASE_CONF], "lat");
     }
     (void) fprintf(stdout, "%s: Learning rea_latitude_name = %s\n", __FILE__, data->learning->rea_dimyname);
 
@@ -1976,13 +2147,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "rea_longitude_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea_lonname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea_lonname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea_lonname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea_lonname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->rea_lonname = strdup("lon");
+      data->learning->rea_lonname = arena_strdup(data->arena[PHASE_CONF], "lon");
     }
     (void) fprintf(stdout, "%s: Learning rea_longitude_name = %s\n", __FILE__, data->learning->rea_lonname);
 
@@ -1990,13 +2161,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "rea_latitude_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea_latname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea_latname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea_latname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea_latname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->rea_latname = strdup("lat");
+      data->learning->rea_latname = arena_strdup(data->arena[PHASE_CONF], "lat");
     }
     (void) fprintf(stdout, "%s: Learning rea_latitude_name = %s\n", __FILE__, data->learning->rea_latname);
 
@@ -2004,13 +2175,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "rea_time_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->rea_timename = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->rea_timename = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->rea_timename == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->rea_timename, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->rea_timename = strdup("time");
+      data->learning->rea_timename = arena_strdup(data->arena[PHASE_CONF], "time");
     }
     (void) fprintf(stdout, "%s: Learning rea_time_name = %s\n", __FILE__, data->learning->rea_timename);
 
@@ -2018,13 +2189,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "obs_dimx_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs_dimxname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs_dimxname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs_dimxname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs_dimxname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->obs_dimxname = strdup("lon");
+      data->learning->obs_dimxname = arena_strdup(data->arena[PHASE_CONF], "lon");
     }
     (void) fprintf(stdout, "%s: Learning obs_dimx_name = %s\n", __FILE__, data->learning->obs_dimxname);
 
@@ -2032,13 +2203,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "obs_dimy_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs_dimyname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs_dimyname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs_dimyname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs_dimyname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->obs_dimyname = strdup("lat");
+      data->learning->obs_dimyname = arena_strdup(data->arena[PHASE_CONF], "lat");
     }
     (void) fprintf(stdout, "%s: Learning obs_dimy_name = %s\n", __FILE__, data->learning->obs_dimyname);
 
@@ -2046,13 +2217,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "obs_longitude_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs_lonname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs_lonname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs_lonname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs_lonname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->obs_lonname = strdup("lon");
+      data->learning->obs_lonname = arena_strdup(data->arena[PHASE_CONF], "lon");
     }
     (void) fprintf(stdout, "%s: Learning obs_longitude_name = %s\n", __FILE__, data->learning->obs_lonname);
 
@@ -2060,13 +2231,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "obs_latitude_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs_latname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs_latname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs_latname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs_latname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->obs_latname = strdup("lat");
+      data->learning->obs_latname = arena_strdup(data->arena[PHASE_CONF], "lat");
     }
     (void) fprintf(stdout, "%s: Learning obs_latitude_name = %s\n", __FILE__, data->learning->obs_latname);
 
@@ -2074,13 +2245,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "obs_time_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs_timename = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs_timename = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs_timename == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs_timename, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->obs_timename = strdup("time");
+      data->learning->obs_timename = arena_strdup(data->arena[PHASE_CONF], "time");
     }
     (void) fprintf(stdout, "%s: Learning obs_time_name = %s\n", __FILE__, data->learning->obs_timename);
 
@@ -2088,13 +2259,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "obs_eof_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->learning->obs_eofname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->learning->obs_eofname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->learning->obs_eofname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->learning->obs_eofname, (char *) val);
       (void) xmlFree(val);
     }
     else {
-      data->learning->obs_eofname = strdup("eof");
+      data->learning->obs_eofname = arena_strdup(data->arena[PHASE_CONF], "eof");
     }
     (void) fprintf(stdout, "%s: Learning obs_eof_name = %s\n", __FILE__, data->learning->obs_eofname);
   }
@@ -2103,247 +2274,247 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "sup_lonname");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->sup_lonname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->sup_lonname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->sup_lonname == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->sup_lonname, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->sup_lonname = strdup("lon");
+    data->learning->sup_lonname = arena_strdup(data->arena[PHASE_CONF], "lon");
   (void) fprintf(stdout, "%s: Learning sup_lonname = %s\n", __FILE__, data->learning->sup_lonname);
 
   /** sup_latname **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "sup_latname");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->sup_latname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->sup_latname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->sup_latname == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->sup_latname, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->sup_latname = strdup("lat");
+    data->learning->sup_latname = arena_strdup(data->arena[PHASE_CONF], "lat");
   (void) fprintf(stdout, "%s: Learning sup_latname = %s\n", __FILE__, data->learning->sup_latname);
 
   /** nomvar_time **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_time");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_time = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_time = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_time == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_time, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_time = strdup("time");
+    data->learning->nomvar_time = arena_strdup(data->arena[PHASE_CONF], "time");
   (void) fprintf(stdout, "%s: Learning nomvar_time = %s\n", __FILE__, data->learning->nomvar_time);
   
   /** nomvar_weight **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_weight");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_weight = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_weight = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_weight == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_weight, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_weight = strdup("poid");
+    data->learning->nomvar_weight = arena_strdup(data->arena[PHASE_CONF], "poid");
   (void) fprintf(stdout, "%s: Learning nomvar_weight = %s\n", __FILE__, data->learning->nomvar_weight);
   
   /** nomvar_class_clusters **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_class_clusters");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_class_clusters = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_class_clusters = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_class_clusters == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_class_clusters, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_class_clusters = strdup("clust_learn");
+    data->learning->nomvar_class_clusters = arena_strdup(data->arena[PHASE_CONF], "clust_learn");
   (void) fprintf(stdout, "%s: Learning nomvar_class_clusters = %s\n", __FILE__, data->learning->nomvar_class_clusters);
   
   /** nomvar_precip_reg **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_reg");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_reg = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_reg = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_reg == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_reg, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_reg = strdup("reg");
+    data->learning->nomvar_precip_reg = arena_strdup(data->arena[PHASE_CONF], "reg");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_reg = %s\n", __FILE__, data->learning->nomvar_precip_reg);
   
   /** nomvar_precip_reg_cst **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_reg_cst");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_reg_cst = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_reg_cst = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_reg_cst == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_reg_cst, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_reg_cst = strdup("cst");
+    data->learning->nomvar_precip_reg_cst = arena_strdup(data->arena[PHASE_CONF], "cst");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_reg_cst = %s\n", __FILE__, data->learning->nomvar_precip_reg_cst);
   
   /** nomvar_precip_reg_rsq **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_reg_rsq");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_reg_rsq = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_reg_rsq = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_reg_rsq == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_reg_rsq, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_reg_rsq = strdup("rsquare");
+    data->learning->nomvar_precip_reg_rsq = arena_strdup(data->arena[PHASE_CONF], "rsquare");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_reg_rsq = %s\n", __FILE__, data->learning->nomvar_precip_reg_rsq);
   
   /** nomvar_precip_reg_acor **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_reg_acor");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_reg_acor = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_reg_acor = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_reg_acor == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_reg_acor, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_reg_acor = strdup("autocor");
+    data->learning->nomvar_precip_reg_acor = arena_strdup(data->arena[PHASE_CONF], "autocor");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_reg_acor = %s\n", __FILE__, data->learning->nomvar_precip_reg_acor);
   
   /** nomvar_precip_reg_vif **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_reg_vif");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_reg_vif = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_reg_vif = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_reg_vif == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_reg_vif, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_reg_vif = strdup("vif");
+    data->learning->nomvar_precip_reg_vif = arena_strdup(data->arena[PHASE_CONF], "vif");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_reg_vif = %s\n", __FILE__, data->learning->nomvar_precip_reg_vif);
   
   /** nomvar_precip_reg_dist **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_reg_dist");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_reg_dist = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_reg_dist = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_reg_dist == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_reg_dist, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_reg_dist = strdup("dist");
+    data->learning->nomvar_precip_reg_dist = arena_strdup(data->arena[PHASE_CONF], "dist");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_reg_dist = %s\n", __FILE__, data->learning->nomvar_precip_reg_dist);
   
   /** nomvar_precip_reg_err **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_reg_err");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_reg_err = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_reg_err = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_reg_err == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_reg_err, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_reg_err = strdup("err");
+    data->learning->nomvar_precip_reg_err = arena_strdup(data->arena[PHASE_CONF], "err");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_reg_err = %s\n", __FILE__, data->learning->nomvar_precip_reg_err);
   
   /** nomvar_precip_index **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_index");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_index = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_index = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_index == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_index, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_index = strdup("rrd");
+    data->learning->nomvar_precip_index = arena_strdup(data->arena[PHASE_CONF], "rrd");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_index = %s\n", __FILE__, data->learning->nomvar_precip_index);
   
   /** nomvar_precip_index_obs **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_precip_index_obs");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_precip_index_obs = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_precip_index_obs = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_precip_index_obs == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_precip_index_obs, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_precip_index_obs = strdup("rro");
+    data->learning->nomvar_precip_index_obs = arena_strdup(data->arena[PHASE_CONF], "rro");
   (void) fprintf(stdout, "%s: Learning nomvar_precip_index_obs = %s\n", __FILE__, data->learning->nomvar_precip_index_obs);
   
   /** nomvar_sup_index **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_sup_index");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_sup_index = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_sup_index = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_sup_index == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_sup_index, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_sup_index = strdup("ta");
+    data->learning->nomvar_sup_index = arena_strdup(data->arena[PHASE_CONF], "ta");
   (void) fprintf(stdout, "%s: Learning nomvar_sup_index = %s\n", __FILE__, data->learning->nomvar_sup_index);
 
   /** nomvar_sup_val **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_sup_val");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_sup_val = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_sup_val = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_sup_val == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_sup_val, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_sup_val = strdup("tad");
+    data->learning->nomvar_sup_val = arena_strdup(data->arena[PHASE_CONF], "tad");
   (void) fprintf(stdout, "%s: Learning nomvar_sup_val = %s\n", __FILE__, data->learning->nomvar_sup_val);
 
   /** nomvar_sup_index_mean **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_sup_index_mean");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_sup_index_mean = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_sup_index_mean = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_sup_index_mean == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_sup_index_mean, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_sup_index_mean = strdup("tancp_mean");
+    data->learning->nomvar_sup_index_mean = arena_strdup(data->arena[PHASE_CONF], "tancp_mean");
   (void) fprintf(stdout, "%s: Learning nomvar_sup_index_mean = %s\n", __FILE__, data->learning->nomvar_sup_index_mean);
   
   /** nomvar_sup_index_var **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_sup_index_var");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_sup_index_var = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_sup_index_var = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_sup_index_var == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_sup_index_var, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_sup_index_var = strdup("tancp_var");
+    data->learning->nomvar_sup_index_var = arena_strdup(data->arena[PHASE_CONF], "tancp_var");
   (void) fprintf(stdout, "%s: Learning nomvar_sup_index_var = %s\n", __FILE__, data->learning->nomvar_sup_index_var);
   
   /** nomvar_pc_normalized_var **/
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "learning", "nomvar_pc_normalized_var");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->learning->nomvar_pc_normalized_var = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->learning->nomvar_pc_normalized_var = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->learning->nomvar_pc_normalized_var == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->learning->nomvar_pc_normalized_var, (char *) val);
     (void) xmlFree(val);
   }
   else
-    data->learning->nomvar_pc_normalized_var = strdup("eca_pc_learn");
+    data->learning->nomvar_pc_normalized_var = arena_strdup(data->arena[PHASE_CONF], "eca_pc_learn");
   (void) fprintf(stdout, "%s: Learning nomvar_pc_normalized_var = %s\n", __FILE__, data->learning->nomvar_pc_normalized_var);
   
 
@@ -2352,7 +2523,7 @@ load_conf(data_struct *data, char *fileconf) {
   (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "filename");
   val = xml_get_setting(conf, path);
   if (val != NULL) {
-    data->reg->filename = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+    data->reg->filename = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
     if (data->reg->filename == NULL) alloc_error(__FILE__, __LINE__);
     (void) strcpy(data->reg->filename, (char *) val);
     (void) fprintf(stdout, "%s: Regression points filename = %s\n", __FILE__, data->reg->filename);
@@ -2362,14 +2533,14 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "dimx_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->reg->dimxname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->reg->dimxname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->reg->dimxname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->reg->dimxname, (char *) val);
       (void) fprintf(stdout, "%s: Regression points dimx_name = %s\n", __FILE__, data->reg->dimxname);
       (void) xmlFree(val);
     }
     else {
-      data->reg->dimxname = strdup("lon");
+      data->reg->dimxname = arena_strdup(data->arena[PHASE_CONF], "lon");
       (void) fprintf(stderr, "%s: Default regression points dimx_name setting = %s.\n", __FILE__, data->reg->dimxname);
       (void) xmlFree(val);
     }
@@ -2377,14 +2548,14 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "dimy_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->reg->dimyname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->reg->dimyname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->reg->dimyname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->reg->dimyname, (char *) val);
       (void) fprintf(stdout, "%s: Regression points dimy_name = %s\n", __FILE__, data->reg->dimyname);
       (void) xmlFree(val);
     }
     else {
-      data->reg->dimyname = strdup("dimy");
+      data->reg->dimyname = arena_strdup(data->arena[PHASE_CONF], "dimy");
       (void) fprintf(stderr, "%s: Default regression points dimy_name setting = %s.\n", __FILE__, data->reg->dimyname);
       (void) xmlFree(val);
     }
@@ -2392,14 +2563,14 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "longitude_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->reg->lonname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->reg->lonname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->reg->lonname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->reg->lonname, (char *) val);
       (void) fprintf(stdout, "%s: Regression points longitude_name = %s\n", __FILE__, data->reg->lonname);
       (void) xmlFree(val);
     }
     else {
-      data->reg->lonname = strdup("lon");
+      data->reg->lonname = arena_strdup(data->arena[PHASE_CONF], "lon");
       (void) fprintf(stderr, "%s: Default regression points longitude_name setting = %s.\n", __FILE__, data->reg->lonname);
       (void) xmlFree(val);
     }
@@ -2407,14 +2578,14 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "latitude_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->reg->latname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->reg->latname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->reg->latname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->reg->latname, (char *) val);
       (void) fprintf(stdout, "%s: Regression points latitude_name = %s\n", __FILE__, data->reg->latname);
       (void) xmlFree(val);
     }
     else {
-      data->reg->latname = strdup("lat");
+      data->reg->latname = arena_strdup(data->arena[PHASE_CONF], "lat");
       (void) fprintf(stderr, "%s: Default regression points latitude_name setting = %s.\n", __FILE__, data->reg->latname);
       (void) xmlFree(val);
     }
@@ -2422,14 +2593,14 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "pts_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->reg->ptsname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->reg->ptsname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->reg->ptsname == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->reg->ptsname, (char *) val);
       (void) fprintf(stdout, "%s: Regression points pts_name = %s\n", __FILE__, data->reg->ptsname);
       (void) xmlFree(val);
     }
     else {
-      data->reg->ptsname = strdup("pts");
+      data->reg->ptsname = arena_strdup(data->arena[PHASE_CONF], "pts");
       (void) fprintf(stderr, "%s: Default regression points pts_name setting = %s.\n", __FILE__, data->reg->ptsname);
       (void) xmlFree(val);
     }
@@ -2473,7 +2644,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "filename_save_ctrl_reg");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->reg->filename_save_ctrl_reg = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->reg->filename_save_ctrl_reg = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->reg->filename_save_ctrl_reg == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->reg->filename_save_ctrl_reg, (char *) val);
       (void) fprintf(stdout, "%s: Regression filename_save_ctrl_reg = %s\n", __FILE__, data->reg->filename_save_ctrl_reg);
@@ -2488,7 +2659,7 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "filename_save_other_reg");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->reg->filename_save_other_reg = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->reg->filename_save_other_reg = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->reg->filename_save_other_reg == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->reg->filename_save_other_reg, (char *) val);
       (void) fprintf(stdout, "%s: Regression filename_save_other_reg = %s\n", __FILE__, data->reg->filename_save_other_reg);
@@ -2504,13 +2675,13 @@ load_conf(data_struct *data, char *fileconf) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "regression", "time_name");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->reg->timename = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->reg->timename = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->reg->timename == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->reg->timename, (char *) val);
       (void) xmlFree(val);
     }
     else
-      data->reg->timename = strdup("time");
+      data->reg->timename = arena_strdup(data->arena[PHASE_CONF], "time");
     (void) fprintf(stdout, "%s: Regression time dimension name = %s\n", __FILE__, data->reg->timename);
   }
 
@@ -2614,6 +2785,7 @@ load_conf(data_struct *data, char *fileconf) {
         data->field[i].proj[j].coords = NULL;
         
         data->field[i].data[j].field_ls = NULL;
+        data->field[i].data[j].field_ls_f = NULL;
         data->field[i].data[j].field_eof_ls = NULL;
         data->field[i].data[j].eof_data->eof_ls = NULL;
         data->field[i].data[j].eof_data->sing_ls = NULL;
@@ -2648,6 +2820,19 @@ load_conf(data_struct *data, char *fileconf) {
       catstrt = strdup("Large-scale fields");
     }
 
+    /** single_precision: keep the fields of this category in single precision once read **/
+    (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", catstr, "single_precision");
+    val = xml_get_setting(conf, path);
+    if (val != NULL) {
+      data->field[cat].single_precision = (int) xmlXPathCastStringToNumber(val);
+      (void) xmlFree(val);
+    }
+    else
+      data->field[cat].single_precision = FALSE;
+    if (data->field[cat].single_precision != TRUE)
+      data->field[cat].single_precision = FALSE;
+    (void) fprintf(stdout, "%s: %s single_precision = %d\n", __FILE__, catstr, data->field[cat].single_precision);
+
     /* Process only if at least one large-scale field defined */
     if (data->field[cat].n_ls > 0) {
 
@@ -2660,7 +2845,7 @@ load_conf(data_struct *data, char *fileconf) {
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "name", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
-          data->field[cat].data[i].nomvar_ls = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));          
+          data->field[cat].data[i].nomvar_ls = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));          
           if (data->field[cat].data[i].nomvar_ls == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy( data->field[cat].data[i].nomvar_ls, (char *) val);
           (void) xmlFree(val);
@@ -2673,7 +2858,7 @@ load_conf(data_struct *data, char *fileconf) {
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "filename", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
-          data->field[cat].data[i].filename_ls = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+          data->field[cat].data[i].filename_ls = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
           if (data->field[cat].data[i].filename_ls == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy(data->field[cat].data[i].filename_ls, (char *) val);
           (void) xmlFree(val);
@@ -2688,62 +2873,63 @@ load_conf(data_struct *data, char *fileconf) {
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "dimy_name", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
-          data->field[cat].data[i].dimyname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));          
+          data->field[cat].data[i].dimyname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));          
           if (data->field[cat].data[i].dimyname == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy(data->field[cat].data[i].dimyname, (char *) val);
           (void) xmlFree(val);
         }
         else
-          data->field[cat].data[i].dimyname = strdup("lat");
+          data->field[cat].data[i].dimyname = arena_strdup(data->arena[PHASE_CONF], "lat");
 
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "dimx_name", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
-          data->field[cat].data[i].dimxname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));          
+          data->field[cat].data[i].dimxname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));          
           if (data->field[cat].data[i].dimxname == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy(data->field[cat].data[i].dimxname, (char *) val);
           (void) xmlFree(val);
         }
         else
-          data->field[cat].data[i].dimxname = strdup("lon");
+          data->field[cat].data[i].dimxname = arena_strdup(data->arena[PHASE_CONF], "lon");
 
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "latitude_name", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
-          data->field[cat].data[i].latname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));          
+          data->field[cat].data[i].latname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));          
           if (data->field[cat].data[i].latname == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy(data->field[cat].data[i].latname, (char *) val);
           (void) xmlFree(val);
         }
         else
-          data->field[cat].data[i].latname = strdup("lat");
+          data->field[cat].data[i].latname = arena_strdup(data->arena[PHASE_CONF], "lat");
 
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "longitude_name", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
-          data->field[cat].data[i].lonname = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));          
+          data->field[cat].data[i].lonname = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));          
           if (data->field[cat].data[i].lonname == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy(data->field[cat].data[i].lonname, (char *) val);
           (void) xmlFree(val);
         }
         else
-          data->field[cat].data[i].lonname = strdup("lon");
+          data->field[cat].data[i].lonname = arena_strdup(data->arena[PHASE_CONF], "lon");
 
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "time_name", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
-          data->field[cat].data[i].timename = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));          
+          data->field[cat].data[i].timename = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));          
           if (data->field[cat].data[i].timename == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy(data->field[cat].data[i].timename, (char *) val);
           (void) xmlFree(val);
         }
         else
-          data->field[cat].data[i].timename = strdup("time");
+          data->field[cat].data[i].timename = arena_strdup(data->arena[PHASE_CONF], "time");
 
         /* Fallback projection type */
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "projection", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
+          /* Not in the configuration arena: large-scale field readers replace the projection name */
           data->field[cat].proj[i].name = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
           if (data->field[cat].proj[i].name == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy(data->field[cat].proj[i].name, (char *) val);
@@ -2758,7 +2944,7 @@ load_conf(data_struct *data, char *fileconf) {
         (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "coordinates", i+1);
         val = xml_get_setting(conf, path);
         if (val != NULL) {
-          data->field[cat].proj[i].coords = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+          data->field[cat].proj[i].coords = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
           if (data->field[cat].proj[i].coords == NULL) alloc_error(__FILE__, __LINE__);
           (void) strcpy(data->field[cat].proj[i].coords, (char *) val);
           (void) xmlFree(val);
@@ -2766,7 +2952,7 @@ load_conf(data_struct *data, char *fileconf) {
                          __FILE__, catstrt, i, data->field[cat].data[i].nomvar_ls, data->field[cat].proj[i].coords);
         }
         else
-          data->field[cat].proj[i].coords = strdup("2D");
+          data->field[cat].proj[i].coords = arena_strdup(data->arena[PHASE_CONF], "2D");
 
 
         /** Climatology values **/
@@ -2800,7 +2986,7 @@ load_conf(data_struct *data, char *fileconf) {
             (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "clim_openfilename",i+1);
             val = xml_get_setting(conf, path);
             if (val != NULL) {
-              data->field[cat].data[i].clim_info->clim_filein_ls = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+              data->field[cat].data[i].clim_info->clim_filein_ls = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
               if (data->field[cat].data[i].clim_info->clim_filein_ls == NULL) alloc_error(__FILE__, __LINE__);
               (void) strcpy(data->field[cat].data[i].clim_info->clim_filein_ls, (char *) val);
               (void) fprintf(stdout, "%s:  Climatology input filename #%d = %s\n", __FILE__, i+1,
@@ -2833,7 +3019,7 @@ load_conf(data_struct *data, char *fileconf) {
             (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "clim_savefilename",i+1);
             val = xml_get_setting(conf, path);
             if (val != NULL) {
-              data->field[cat].data[i].clim_info->clim_fileout_ls = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+              data->field[cat].data[i].clim_info->clim_fileout_ls = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
               if (data->field[cat].data[i].clim_info->clim_fileout_ls == NULL) alloc_error(__FILE__, __LINE__);
               (void) strcpy(data->field[cat].data[i].clim_info->clim_fileout_ls, (char *) val);
               (void) fprintf(stdout, "%s:  Climatology output filename #%d = %s\n", __FILE__, i+1,
@@ -2851,7 +3037,7 @@ load_conf(data_struct *data, char *fileconf) {
             (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "clim_name", i+1);
             val = xml_get_setting(conf, path);
             if (val != NULL) {
-              data->field[cat].data[i].clim_info->clim_nomvar_ls = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+              data->field[cat].data[i].clim_info->clim_nomvar_ls = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
               if (data->field[cat].data[i].clim_info->clim_nomvar_ls == NULL) alloc_error(__FILE__, __LINE__);
               (void) strcpy(data->field[cat].data[i].clim_info->clim_nomvar_ls, (char *) val);
               (void) fprintf(stdout, "%s:  Climatology variable name #%d = %s\n", __FILE__, i+1,
@@ -2900,7 +3086,7 @@ load_conf(data_struct *data, char *fileconf) {
           (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "eof_coordinates", i+1);
           val = xml_get_setting(conf, path);
           if (val != NULL) {
-            data->field[cat].data[i].eof_info->eof_coords = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+            data->field[cat].data[i].eof_info->eof_coords = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
             if (data->field[cat].data[i].eof_info->eof_coords == NULL) alloc_error(__FILE__, __LINE__);
             (void) strcpy(data->field[cat].data[i].eof_info->eof_coords, (char *) val);
             (void) fprintf(stdout, "%s: %s #%d: name = %s eof_coordinates = %s\n",
@@ -2908,13 +3094,13 @@ load_conf(data_struct *data, char *fileconf) {
             (void) xmlFree(val);
           }
           else
-            data->field[cat].data[i].eof_info->eof_coords = strdup("2D");
+            data->field[cat].data[i].eof_info->eof_coords = arena_strdup(data->arena[PHASE_CONF], "2D");
           
           /** eof_openfilename **/
           (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "eof_openfilename", i+1);
           val = xml_get_setting(conf, path);
           if (val != NULL) {
-            data->field[cat].data[i].eof_info->eof_filein_ls = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+            data->field[cat].data[i].eof_info->eof_filein_ls = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
             if (data->field[cat].data[i].eof_info->eof_filein_ls == NULL) alloc_error(__FILE__, __LINE__);
             (void) strcpy(data->field[cat].data[i].eof_info->eof_filein_ls, (char *) val);
             (void) fprintf(stdout, "%s: EOF/Singular values input filename #%d = %s\n", __FILE__, i+1,
@@ -2956,7 +3142,7 @@ load_conf(data_struct *data, char *fileconf) {
           (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "eof_name", i+1);
           val = xml_get_setting(conf, path);
           if (val != NULL) {
-            data->field[cat].data[i].eof_data->eof_nomvar_ls = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+            data->field[cat].data[i].eof_data->eof_nomvar_ls = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
             if (data->field[cat].data[i].eof_data->eof_nomvar_ls == NULL) alloc_error(__FILE__, __LINE__);
             (void) strcpy(data->field[cat].data[i].eof_data->eof_nomvar_ls, (char *) val);
             (void) fprintf(stdout, "%s: EOF variable name #%d = %s\n", __FILE__, i+1, data->field[cat].data[i].eof_data->eof_nomvar_ls);
@@ -2970,7 +3156,7 @@ load_conf(data_struct *data, char *fileconf) {
           (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", catstr, "sing_name", i+1);
           val = xml_get_setting(conf, path);
           if (val != NULL) {
-            data->field[cat].data[i].eof_data->sing_nomvar_ls = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+            data->field[cat].data[i].eof_data->sing_nomvar_ls = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
             if (data->field[cat].data[i].eof_data->sing_nomvar_ls == NULL) alloc_error(__FILE__, __LINE__);
             (void) strcpy(data->field[cat].data[i].eof_data->sing_nomvar_ls, (char *) val);
             (void) fprintf(stdout, "%s: Singular values variable name #%d = %s\n", __FILE__, i+1,
@@ -3395,6 +3581,28 @@ load_conf(data_struct *data, char *fileconf) {
     return -1;
   }
 
+  /**** CHECKPOINT CONFIGURATION ****/
+
+  /** run_directory: checkpoints of long runs are kept in its checkpoints sub-directory **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "run_directory");
+  val = xml_get_setting(conf, path);
+  if (val != NULL) {
+    data->checkpoint->run_dir = arena_strdup(data->arena[PHASE_CONF], (char *) val);
+    if (data->checkpoint->run_dir == NULL) alloc_error(__FILE__, __LINE__);
+    (void) xmlFree(val);
+    data->checkpoint->dir = (char *) arena_alloc(data->arena[PHASE_CONF], (strlen(data->checkpoint->run_dir)+13) * sizeof(char));
+    if (data->checkpoint->dir == NULL) alloc_error(__FILE__, __LINE__);
+    (void) sprintf(data->checkpoint->dir, "%s/checkpoints", data->checkpoint->run_dir);
+    (void) fprintf(stdout, "%s: Run directory = %s\n", __FILE__, data->checkpoint->run_dir);
+    istat = checkpoint_init(data);
+    if (istat != 0)
+      return istat;
+  }
+  else if (data->checkpoint->resume == TRUE) {
+    (void) fprintf(stderr, "%s: Cannot resume a run without a run_directory setting in configuration file. Aborting.\n", __FILE__);
+    return -1;
+  }
+
   /**** ANALOG DATA CONFIGURATION ****/
 
   /** output_only **/
@@ -3408,9 +3616,15 @@ load_conf(data_struct *data, char *fileconf) {
     (void) fprintf(stderr, "%s: Invalid or missing analog data output_only value %s in configuration file. Aborting.\n", __FILE__, val);
     return -1;
   }
-  (void) fprintf(stdout, "%s: analog data output_only=%d\n", __FILE__, data->conf->output_only);
   if (val != NULL) 
     (void) xmlFree(val);
+  if (data->conf->output_only == FALSE && checkpoint_analog_resume(data) == TRUE) {
+    /* Analog data of all periods was checkpointed: only output remains to be done */
+    (void) fprintf(stdout, "%s: Analog data is read from checkpoints when resuming the run.\n", __FILE__);
+    analog_resumed = TRUE;
+    data->conf->output_only = TRUE;
+  }
+  (void) fprintf(stdout, "%s: analog data output_only=%d\n", __FILE__, data->conf->output_only);
   if (data->conf->output_only == TRUE) {
     if (data->learning->learning_provided == FALSE) {
       (void) fprintf(stderr, "%s: WARNING: Desactivating learning process because option for output only has been set!\n", __FILE__);
@@ -3465,11 +3679,12 @@ load_conf(data_struct *data, char *fileconf) {
     (void) xmlFree(val);
 
   /** analog_file_ctrl **/
-  if ( (data->conf->analog_save == TRUE || data->conf->output_only == TRUE) && data->conf->period_ctrl->downscale == TRUE) {
+  if ( (data->conf->analog_save == TRUE || data->conf->output_only == TRUE) && data->conf->period_ctrl->downscale == TRUE &&
+       analog_resumed == FALSE) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "analog_file_ctrl");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->conf->analog_file_ctrl = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->conf->analog_file_ctrl = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->conf->analog_file_ctrl == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->conf->analog_file_ctrl, (char *) val);
       (void) fprintf(stdout, "%s: analog_file_ctrl = %s\n", __FILE__, data->conf->analog_file_ctrl);
@@ -3483,11 +3698,11 @@ load_conf(data_struct *data, char *fileconf) {
   }
 
   /** analog_file_other **/
-  if (data->conf->analog_save == TRUE || data->conf->output_only == TRUE) {
+  if ( (data->conf->analog_save == TRUE || data->conf->output_only == TRUE) && analog_resumed == FALSE) {
     (void) sprintf(path, "/configuration/%s[@name=\"%s\"]", "setting", "analog_file_other");
     val = xml_get_setting(conf, path);
     if (val != NULL) {
-      data->conf->analog_file_other = (char *) malloc((xmlStrlen(val)+1) * sizeof(char));
+      data->conf->analog_file_other = (char *) arena_alloc(data->arena[PHASE_CONF], (xmlStrlen(val)+1) * sizeof(char));
       if (data->conf->analog_file_other == NULL) alloc_error(__FILE__, __LINE__);
       (void) strcpy(data->conf->analog_file_other, (char *) val);
       (void) fprintf(stdout, "%s: analog_file_other = %s\n", __FILE__, data->conf->analog_file_other);
@@ -3500,6 +3715,113 @@ load_conf(data_struct *data, char *fileconf) {
     }
   }
 
+  /** analog data files of a resumed run are its checkpoints **/
+  if (analog_resumed == TRUE) {
+    if (data->conf->period_ctrl->downscale == TRUE) {
+      checkpoint_file = checkpoint_analog_filename(data, CTRL_FIELD_LS);
+      data->conf->analog_file_ctrl = arena_strdup(data->arena[PHASE_CONF], checkpoint_file);
+      (void) fprintf(stdout, "%s: analog_file_ctrl = %s\n", __FILE__, data->conf->analog_file_ctrl);
+      (void) free(checkpoint_file);
+    }
+    checkpoint_file = checkpoint_analog_filename(data, FIELD_LS);
+    data->conf->analog_file_other = arena_strdup(data->arena[PHASE_CONF], checkpoint_file);
+    (void) fprintf(stdout, "%s: analog_file_other = %s\n", __FILE__, data->conf->analog_file_other);
+    (void) free(checkpoint_file);
+  }
+
+  /**** ENSEMBLE BATCH MODE CONFIGURATION ****/
+
+  data->conf->nmembers = 0;
+  data->conf->members = NULL;
+
+  /** number_of_members: members listed explicitly **/
+  (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "ensemble", "number_of_members");
+  val = xml_get_setting(conf, path);
+  if (val != NULL) {
+    data->conf->nmembers = (int) xmlXPathCastStringToNumber(val);
+    (void) xmlFree(val);
+    if (data->conf->nmembers < 1) {
+      (void) fprintf(stderr, "%s: Invalid ensemble number_of_members setting. Aborting.\n", __FILE__);
+      return -1;
+    }
+    data->conf->members = (char **) arena_alloc(data->arena[PHASE_CONF], data->conf->nmembers * sizeof(char *));
+    if (data->conf->members == NULL) alloc_error(__FILE__, __LINE__);
+    for (i=0; i<data->conf->nmembers; i++) {
+      (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s[@id=\"%d\"]", "setting", "ensemble", "member", i+1);
+      val = xml_get_setting(conf, path);
+      if (val == NULL) {
+        (void) fprintf(stderr, "%s: Missing ensemble member id=%d setting. Aborting.\n", __FILE__, i+1);
+        return -1;
+      }
+      data->conf->members[i] = arena_strdup(data->arena[PHASE_CONF], (char *) val);
+      if (data->conf->members[i] == NULL) alloc_error(__FILE__, __LINE__);
+      (void) xmlFree(val);
+    }
+  }
+  else {
+    /** members_glob: members are the base names of the paths matching a pattern, one directory per member **/
+    (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "ensemble", "members_glob");
+    val = xml_get_setting(conf, path);
+    if (val != NULL) {
+#ifdef HAVE_GLOB_H
+      if (glob((char *) val, 0, NULL, &members_glob) != 0 || members_glob.gl_pathc == 0) {
+        (void) fprintf(stderr, "%s: No ensemble member matches members_glob %s. Aborting.\n", __FILE__, val);
+        (void) xmlFree(val);
+        return -1;
+      }
+      data->conf->nmembers = (int) members_glob.gl_pathc;
+      data->conf->members = (char **) arena_alloc(data->arena[PHASE_CONF], data->conf->nmembers * sizeof(char *));
+      if (data->conf->members == NULL) alloc_error(__FILE__, __LINE__);
+      for (i=0; i<data->conf->nmembers; i++) {
+        member_path = arena_strdup(data->arena[PHASE_CONF], members_glob.gl_pathv[i]);
+        if (member_path == NULL) alloc_error(__FILE__, __LINE__);
+        data->conf->members[i] = basename(member_path);
+      }
+      (void) globfree(&members_glob);
+#else
+      (void) fprintf(stderr, "%s: ensemble members_glob setting is not supported on this system. Aborting.\n", __FILE__);
+      (void) xmlFree(val);
+      return -1;
+#endif
+      (void) xmlFree(val);
+    }
+  }
+
+  if (data->conf->nmembers > 0) {
+    for (i=0; i<data->conf->nmembers; i++)
+      (void) fprintf(stdout, "%s: ensemble member %d = %s\n", __FILE__, i+1, data->conf->members[i]);
+    if (data->conf->nmembers > 1 && strstr(data->conf->output_path, ENSEMBLE_MEMBER_TOKEN) == NULL) {
+      (void) fprintf(stderr, "%s: The output path must contain %s in ensemble batch mode. Aborting.\n", __FILE__, ENSEMBLE_MEMBER_TOKEN);
+      return -1;
+    }
+
+    /** concurrent_members: maximum number of members downscaled at the same time **/
+    (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "ensemble", "concurrent_members");
+    val = xml_get_setting(conf, path);
+    if (val != NULL) {
+      data->conf->concurrent_members = (int) xmlXPathCastStringToNumber(val);
+      (void) xmlFree(val);
+    }
+    else
+      data->conf->concurrent_members = 1;
+    if (data->conf->concurrent_members < 1)
+      data->conf->concurrent_members = 1;
+    (void) fprintf(stdout, "%s: ensemble concurrent_members = %d\n", __FILE__, data->conf->concurrent_members);
+
+    /** memory_budget: memory in MB shared by members downscaled at the same time **/
+    (void) sprintf(path, "/configuration/%s[@name=\"%s\"]/%s", "setting", "ensemble", "memory_budget");
+    val = xml_get_setting(conf, path);
+    if (val != NULL) {
+      data->conf->members_memory = (int) xmlXPathCastStringToNumber(val);
+      (void) xmlFree(val);
+    }
+    else
+      data->conf->members_memory = 0;
+    if (data->conf->members_memory < 0)
+      data->conf->members_memory = 0;
+    (void) fprintf(stdout, "%s: ensemble memory_budget = %d MB\n", __FILE__, data->conf->members_memory);
+  }
+
   /* Warning for some combinations of settings */
   for (i=0; i<data->conf->obs_var->nobs_var; i++) {
     if (strcmp(data->conf->obs_var->netcdfname[i], "rsds") && strcmp(data->conf->obs_var->clim[i], "no") )
@@ -73,7 +73,6 @@ merge_seasonal_data_2d(double **buf_merged, double **buf, analog_day_struct anal
   int t; /* Time loop counter */
   int i; /* Loop counter */
   int j; /* Loop counter */
-  int ii; /* Loop counter */
   int curindex; /* Current index in the merged times vector */
   int index_all; /* Current index in the whole time vector */
 
@@ -86,8 +85,7 @@ merge_seasonal_data_2d(double **buf_merged, double **buf, analog_day_struct anal
     /* Retrieve values */
     for (i=0; i<dimx; i++)
       for (j=0; j<dimy; j++)
-        for (ii=0; ii<supdim; ii++)
-          buf_merged[i+j*dimx+curindex*dimx*dimy][ii] = buf[i+j*dimx+t*dimx*dimy][ii];
+        (void) memcpy(buf_merged[i+j*dimx+curindex*dimx*dimy], buf[i+j*dimx+t*dimx*dimy], supdim * sizeof(double));
   }
   
   /* Success status */
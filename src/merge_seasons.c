@@ -65,7 +65,6 @@ merge_seasons(analog_day_struct analog_days_merged, analog_day_struct analog_day
   */
   
   int t; /* Time loop counter */
-  int i; /* Loop counter */
   int curindex; /* Current index in the merged times vector */
   int index_all; /* Current index in the whole time vector */
 
@@ -87,31 +86,14 @@ merge_seasons(analog_day_struct analog_days_merged, analog_day_struct analog_day
     analog_days_merged.month_s[curindex] = analog_days.month_s[t];
     analog_days_merged.day_s[curindex] = analog_days.day_s[t];
     //    printf("IDM %d %d %d\n",t,curindex,index_all);
+    /* Gather the analog day choices row of this day: rows of the merged structure are at least as long */
     analog_days_merged.ndayschoice[curindex] = analog_days.ndayschoice[t];
-    //    printf("%d %d\n",analog_days_merged.ndayschoice[curindex],analog_days.ndayschoice[t]);
-    if (analog_days_merged.analog_dayschoice[curindex] == NULL) {
-      analog_days_merged.analog_dayschoice[curindex] =
-        (tstruct *) malloc(analog_days_merged.ndayschoice[curindex] * sizeof(tstruct));
-    //    printf("%d %d\n",analog_days_merged.ndayschoice[curindex],analog_days.ndayschoice[t]);
-      if (analog_days_merged.analog_dayschoice[curindex] == NULL) alloc_error(__FILE__, __LINE__);
-    }
-    //    printf("%d %d\n",analog_days_merged.ndayschoice[curindex],analog_days.ndayschoice[t]);
-    if (analog_days_merged.metric_norm[curindex] == NULL) {
-      analog_days_merged.metric_norm[curindex] = (float *) malloc(analog_days_merged.ndayschoice[curindex] * sizeof(float));
-    //    printf("%d %d\n",analog_days_merged.ndayschoice[curindex],analog_days.ndayschoice[t]);
-      if (analog_days_merged.metric_norm[curindex] == NULL) alloc_error(__FILE__, __LINE__);
-    }
-    //    printf("%d %d\n",analog_days_merged.ndayschoice[curindex],analog_days.ndayschoice[t]);
-    for (i=0; i<analog_days_merged.ndayschoice[curindex]; i++) {
-      analog_days_merged.metric_norm[curindex][i] = analog_days.metric_norm[t][i];
-      analog_days_merged.analog_dayschoice[curindex][i].year = analog_days.analog_dayschoice[t][i].year;
-      analog_days_merged.analog_dayschoice[curindex][i].month = analog_days.analog_dayschoice[t][i].month;
-      analog_days_merged.analog_dayschoice[curindex][i].day = analog_days.analog_dayschoice[t][i].day;
-      analog_days_merged.analog_dayschoice[curindex][i].hour = analog_days.analog_dayschoice[t][i].hour;
-      analog_days_merged.analog_dayschoice[curindex][i].min = analog_days.analog_dayschoice[t][i].min;
-      analog_days_merged.analog_dayschoice[curindex][i].sec = analog_days.analog_dayschoice[t][i].sec;
-    }      
-
+    (void) memcpy(analog_days_merged.analog_dayschoice[curindex], analog_days.analog_dayschoice[t],
+                  analog_days.ndayschoice[t] * sizeof(tstruct));
+    (void) memcpy(analog_days_merged.metric_norm[curindex], analog_days.metric_norm[t],
+                  analog_days.ndayschoice[t] * sizeof(float));
+    (void) memcpy(analog_days_merged.tindex_dayschoice[curindex], analog_days.tindex_dayschoice[t],
+                  analog_days.ndayschoice[t] * sizeof(int));
   }
 
   /* Success status */
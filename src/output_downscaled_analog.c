@@ -54,12 +54,108 @@ LICENSE END */
 
 #include <dsclim.h>
 
+/** Data shared by all stages processing the analog days. */
+typedef struct {
+  var_struct *obs_var; /**< Observation variables data structure */
+  info_struct *info; /**< General meta-data information structure */
+  char *cal_type; /**< Output calendar-type */
+  char *time_units; /**< Output base time units */
+  double *delta; /**< Temperature difference to apply to analog day data */
+  double deltat; /**< Absolute difference of large-scale temperature threshold to apply as a correction */
+  double *lon; /**< Longitudes */
+  double *lat; /**< Latitudes */
+  double *x; /**< X coordinates */
+  double *y; /**< Y coordinates */
+  double *alt; /**< Altitudes of observation points */
+  double *pmsl; /**< Standard Pressure of observation points */
+  double **bufsave; /**< Data buffer of each variable for averaging hourly data (transformer only) */
+  int *written; /**< If data was already written for current day in each output file (writer only) */
+  int varid_tas; /**< Variable index ID */
+  int varid_tasmax; /**< Variable index ID */
+  int varid_tasmin; /**< Variable index ID */
+  int varid_prsn; /**< Variable index ID */
+  int varid_prr; /**< Variable index ID */
+  int varid_rlds; /**< Variable index ID */
+  int varid_rsds; /**< Variable index ID */
+  int varid_hur; /**< Variable index ID */
+  int varid_hus; /**< Variable index ID */
+  int varid_husmin; /**< Variable index ID */
+  int varid_husmax; /**< Variable index ID */
+  int varid_etp; /**< Variable index ID */
+  int varid_uvas; /**< Variable index ID */
+  int varid_prtot; /**< Variable index ID */
+  short int tas_correction; /**< If temperature correction can be applied */
+  int minh; /**< First hour of day */
+  int maxh; /**< Last hour of day */
+  int file_format; /**< File format version for NetCDF */
+  int file_compression_level; /**< Compression level for NetCDF-4 file format */
+  thread_pool_struct *var_pool; /**< Thread pool processing the variables of a slice once read (transformer only) */
+  thread_pool_struct *encode_pool; /**< Thread pool compressing chunks of NetCDF-4 output fields, NULL when output is not compressed */
+  char *checkpoint_prefix; /**< Prefix of completed output year checkpoints, NULL when checkpoints are disabled */
+  int checkpoint_year; /**< Output year being written, -1 before the first day (writer only) */
+  int debug; /**< Debugging supplemental info */
+} output_ctx_struct;
+
+/** Slice of all observation variables for one analog day (and hour), passed between stages. */
+typedef struct {
+  output_ctx_struct *ctx; /**< Data shared by all stages */
+  char **infile; /**< Input filename of each variable (reader only) */
+  char **outfile; /**< Output filename of each variable */
+  int *newfile; /**< If output file of each variable was created for this day */
+  double **buf; /**< Data buffer of each variable */
+  int *ready; /**< If the field of each variable is complete and must be written for this slice */
+  nc_chunks_struct *chunks; /**< Compressed field of each variable, valid when encoded is TRUE */
+  int *encoded; /**< If the field of each variable was compressed before writing */
+  info_field_struct **info_tmp; /**< Field information structure of each variable */
+  proj_struct *proj; /**< Field projection structure */
+  int t; /**< Time index of downscaled day */
+  int year; /**< Output year of downscaled day */
+  int tl; /**< Time index in observation file */
+  int hour; /**< Current hour */
+  int nlon; /**< Longitude dimension */
+  int nlat; /**< Latitude dimension */
+  int ntime_file; /**< Time dimension of observation file */
+  double timeval; /**< Time value of downscaled day */
+  double curtime; /**< Time value to write */
+} output_day_struct;
+
+/** Task processing one observation variable of an analog day slice. */
+typedef struct {
+  output_day_struct *day; /**< Analog day slice */
+  proj_struct *proj; /**< Projection structure read with variable */
+  int var; /**< Variable index */
+  int nlon; /**< Longitude dimension read */
+  int nlat; /**< Latitude dimension read */
+  int ntime_file; /**< Time dimension of observation file read */
+  int istat; /**< Diagnostic status */
+} output_var_task_struct;
+
+/** Queues connecting the reader, transformer and writer stages. */
+typedef struct {
+  bounded_queue_struct *transform_queue; /**< Slices read, waiting for corrections */
+  bounded_queue_struct *write_queue; /**< Slices corrected, waiting for writing */
+  int istat; /**< Diagnostic status of writer stage */
+} output_pipeline_struct;
+
+static output_day_struct *output_new_day(output_ctx_struct *ctx);
+static void output_free_day(output_day_struct *day);
+static int output_read_day(output_day_struct *day, thread_pool_struct *pool);
+static void output_correct_day(output_day_struct *day);
+static void output_encode_day(output_day_struct *day);
+static int output_write_day(output_day_struct *day);
+static void output_read_var(void *arg);
+static void output_post_var(void *arg);
+static void output_encode_var(void *arg);
+static void output_write_var(output_var_task_struct *task);
+static void output_transform_stage(void *arg);
+static void output_write_stage(void *arg);
+
 /** Read analog day data and write it for downscaled period. */
 int
 output_downscaled_analog(analog_day_struct analog_days, double *delta, int output_month_begin, char *output_path,
                          char *config, char *time_units, char *cal_type,
                          double deltat, int file_format, int file_compression, int file_compression_level,
-                         int debug,
+                         int debug, int nthreads, int pipeline, char *checkpoint_prefix, int resume,
                          info_struct *info, var_struct *obs_var, period_struct *period,
                          double *time_ls, int ntime) {
   /**
@@ -75,6 +171,10 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
      @param[in]   file_compression       Compression flag for NetCDF-4 file format
      @param[in]   file_compression_level Compression level for NetCDF-4 file format
      @param[in]   debug                  Debugging supplemental info (TRUE or FALSE)
+     @param[in]   nthreads               Number of threads processing the variables of each output slice (NetCDF accesses stay serialized)
+     @param[in]   pipeline               Overlap reading, corrections and writing of successive days (TRUE or FALSE)
+     @param[in]   checkpoint_prefix      Prefix of completed output year checkpoints, NULL when checkpoints are disabled
+     @param[in]   resume                 Skip output years completed in checkpoints and rewrite the others (TRUE or FALSE)
      @param[in]   info                   General meta-data information structure for NetCDF output file
      @param[in]   obs_var                Input/output observation variables data structure
      @param[in]   period                 Period structure for downscaling output
@@ -88,9 +188,9 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
   char ***outfiles = NULL; /* Output filelist */
   int year1 = 0; /* First year of data input file */
   int year2 = 0; /* End year of data input file */
-  double **buf = NULL; /* Temporary data buffer */
-  double **bufsave = NULL; /* Temporary data buffer for averaging hourly data */
-  double *buftmp = NULL; /* Temporary buffer for mean temperature */
+  int outyear = 0; /* Output year of downscaled day */
+  int resume_year = -1; /* Last output year checked against checkpoints */
+  int skip_year = FALSE; /* If output year was completed in checkpoints */
   double *alt = NULL; /* Altitudes of observation points (optional) */
   double *pmsl = NULL; /* Standard Pressure of observation points (optional) */
   double *timeval = NULL; /* Temporary time information buffer */
@@ -100,8 +200,6 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
   double *x = NULL; /* Temporary X buffer */
   char *cal_type_tmp = NULL; /* Input observations calendar type (udunits) */
   char *time_units_tmp = NULL; /* Input observations time units (udunits) */
-  double ctimeval[1]; /* Dummy time info */
-  int ntime_file; /* Number of times dimension */
   int ntime_obs; /* Number of times dimension in observation database */
   int nlon; /* Longitude dimension */
   int nlat; /* Latitude dimension */
@@ -113,29 +211,15 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
   int output_month_end; /* Ending month for observation database */
   time_vect_struct *time_s = NULL; /* Time structure for observation database */
 
-  info_field_struct **info_tmp = NULL; /* Temporary field information structure */
-  proj_struct *proj_tmp = NULL; /* Temporary field projection structure */
+  output_ctx_struct ctx; /* Data shared by all stages */
+  output_day_struct *day = NULL; /* Analog day slice */
+  output_pipeline_struct pipe; /* Queues connecting the pipeline stages */
+  thread_pool_struct *pool = NULL; /* Thread pool reading the variables */
+  thread_pool_struct *stages = NULL; /* Threads running the transformer and writer stages */
 
   int tmpi; /* Temporay integer value */
-  double curtas; /* Current temperature value */
-  double newcurtas; /* New current temperature value */
   char *format = NULL; /* Temporay format string */
 
-  int varid_tas; /* Variable index ID */
-  int varid_tasmax; /* Variable index ID */
-  int varid_tasmin; /* Variable index ID */
-  int varid_prsn; /* Variable index ID */
-  int varid_prr; /* Variable index ID */
-  int varid_rlds; /* Variable index ID */
-  int varid_rsds; /* Variable index ID */
-  int varid_hur; /* Variable index ID */
-  int varid_hus; /* Variable index ID */
-  int varid_husmin; /* Variable index ID */
-  int varid_husmax; /* Variable index ID */
-  int varid_etp; /* Variable index ID */
-  int varid_uvas; /* Variable index ID */
-  int varid_prtot; /* Variable index ID */
-
   int configstrdimid; /* Variable dimension ID for configuration */
   int configstroutid; /* Variable ID for configuration */
   size_t start[1]; /* Start element when writing */
@@ -144,11 +228,9 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
   int t; /* Time loop counter */
   int tl; /* Time loop counter */
   int var; /* Variable counter */
-  int vare; /* Variable counter */
   int istat; /* Diagnostic status */
+  int status = 0; /* Returned diagnostic status */
   int f; /* Loop counter for files */
-  int i; /* Loop counter */
-  int j; /* Loop counter */
 
   double curtime;
 
@@ -161,7 +243,7 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
 
   int year;
   int month;
-  int day;
+  int day_cal;
   int hour;
   int minutes;
   double seconds;
@@ -171,35 +253,35 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
   int dd;
   int hh;
 
-  int minh;
-  int maxh;
-
   char *tmpstr = NULL;
-  short int tas_correction = TRUE;
 
   /*                                       J   F   M   A   M   J   J   A   S   O   N   D    */
   static int days_per_month_reg_year[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
 
+  /* Check output timestep and observation variables frequency */
+  if ( strcmp(info->timestep, obs_var->frequency) &&
+       ( strcmp(info->timestep, "daily") || strcmp(obs_var->frequency, "hourly") ) ) {
+    for (var=0; var<obs_var->nobs_var; var++)
+      if ( !strcmp(obs_var->output[var], "yes") ) {
+        (void) fprintf(stderr, "%s: Fatal error in configuration of output timestep and observation variables frequency! Output timestep = %s    Observation variables frequency = %s\n", __FILE__, info->timestep, obs_var->frequency);
+        return -3;
+      }
+  }
+
   infile = (char **) malloc(obs_var->nobs_var * sizeof(char *));
   if (infile == NULL) alloc_error(__FILE__, __LINE__);
   outfile = (char **) malloc(obs_var->nobs_var * sizeof(char *));
   if (outfile == NULL) alloc_error(__FILE__, __LINE__);
   outfiles = (char ***) malloc(obs_var->nobs_var * sizeof(char **));
   if (outfiles == NULL) alloc_error(__FILE__, __LINE__);
-  buf = (double **) malloc(obs_var->nobs_var * sizeof(double *));
-  if (buf == NULL) alloc_error(__FILE__, __LINE__);
-  for (i=0; i<obs_var->nobs_var; i++)
-    buf[i] = NULL;
-  if ( !strcmp(info->timestep, "daily") && !strcmp(obs_var->frequency, "hourly") ) {
-    bufsave = (double **) malloc(obs_var->nobs_var * sizeof(double *));
-    if (bufsave == NULL) alloc_error(__FILE__, __LINE__);
-  }
+  ctx.bufsave = (double **) malloc(obs_var->nobs_var * sizeof(double *));
+  if (ctx.bufsave == NULL) alloc_error(__FILE__, __LINE__);
+  ctx.written = (int *) malloc(obs_var->nobs_var * sizeof(int));
+  if (ctx.written == NULL) alloc_error(__FILE__, __LINE__);
   found_file = (int *) malloc(obs_var->nobs_var * sizeof(int));
   if (found_file == NULL) alloc_error(__FILE__, __LINE__);
   noutf = (int *) malloc(obs_var->nobs_var * sizeof(int));
   if (noutf == NULL) alloc_error(__FILE__, __LINE__);
-  info_tmp = (info_field_struct **) malloc(obs_var->nobs_var * sizeof(info_field_struct *));
-  if (info_tmp == NULL) alloc_error(__FILE__, __LINE__);
   
   found = FALSE;
   for (var=0; var<obs_var->nobs_var; var++) {
@@ -208,6 +290,8 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
     outfile[var] = (char *) malloc(MAXPATH * sizeof(char));
     if (outfile[var] == NULL) alloc_error(__FILE__, __LINE__);
     found_file[var] = FALSE;
+    ctx.bufsave[var] = NULL;
+    ctx.written[var] = FALSE;
   }
   format = (char *) malloc(MAXPATH * sizeof(char));
   if (format == NULL) alloc_error(__FILE__, __LINE__);
@@ -253,20 +337,117 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
     istat = utInvCalendar2(period->year_end, period->month_end, period->day_end, 23, 59, 0.0, dataunits, &period_end);
   }
   else {
-    istat = utCalendar2(time_ls[0], dataunits, &year, &month, &day, &hour, &minutes, &seconds);
-    (void) printf("%s: Downscaling whole period: %02d/%02d/%04d", __FILE__, month, day, year);
-    istat = utCalendar2(time_ls[ntime-1], dataunits, &year, &month, &day, &hour, &minutes, &seconds);
-    (void) printf(" to %02d/%02d/%04d inclusively.\n", month, day, year);
+    istat = utCalendar2(time_ls[0], dataunits, &year, &month, &day_cal, &hour, &minutes, &seconds);
+    (void) printf("%s: Downscaling whole period: %02d/%02d/%04d", __FILE__, month, day_cal, year);
+    istat = utCalendar2(time_ls[ntime-1], dataunits, &year, &month, &day_cal, &hour, &minutes, &seconds);
+    (void) printf(" to %02d/%02d/%04d inclusively.\n", month, day_cal, year);
     period_begin = time_ls[0];
     period_end = time_ls[ntime-1];
   }
 
+  /*** Data shared by all stages ***/
+  ctx.obs_var = obs_var;
+  ctx.info = info;
+  ctx.cal_type = cal_type;
+  ctx.time_units = time_units;
+  ctx.delta = delta;
+  ctx.deltat = deltat;
+  ctx.lon = NULL;
+  ctx.lat = NULL;
+  ctx.x = NULL;
+  ctx.y = NULL;
+  ctx.alt = alt;
+  ctx.pmsl = pmsl;
+  ctx.file_format = file_format;
+  ctx.file_compression_level = file_compression_level;
+  ctx.checkpoint_prefix = checkpoint_prefix;
+  ctx.checkpoint_year = -1;
+  ctx.debug = debug;
+
+  if ( !strcmp(obs_var->frequency, "hourly") ) {
+    /* For hourly frequency data, find hours from 0 to 23 */
+    ctx.minh = 0;
+    ctx.maxh = 23;
+  }
+  else {
+    /* For daily data, only read data for one day */
+    ctx.minh = 0;
+    ctx.maxh = 0;
+  }
+
+  /* Find known variable IDs for correction or calculation */
+  ctx.varid_tas = find_str_value("tas", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_tasmin = find_str_value("tasmin", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_tasmax = find_str_value("tasmax", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_prsn = find_str_value("prsn", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_prr = find_str_value("prr", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_rlds = find_str_value("rlds", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_rsds = find_str_value("rsds", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_hus = find_str_value("hus", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_husmin = find_str_value("husmin", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_husmax = find_str_value("husmax", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_uvas = find_str_value("uvas", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_hur = find_str_value("hur", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_etp = find_str_value("evapn", obs_var->netcdfname, obs_var->nobs_var);
+  ctx.varid_prtot = find_str_value("prtot", obs_var->netcdfname, obs_var->nobs_var);
+
+  ctx.tas_correction = TRUE;
+
+  if ( (ctx.varid_tasmax >= 0 || ctx.varid_tasmin >= 0 || ctx.varid_husmin >= 0 || ctx.varid_husmax >= 0) && !strcmp(obs_var->frequency, "hourly")) {
+    (void) fprintf(stderr, "%s: WARNING: Cannot mix min and/or max observation variables with hourly data! Min and/or max variables will be ignored! \n", __FILE__);
+    ctx.varid_tasmin = -1;
+    ctx.varid_tasmax = -1;
+    ctx.varid_husmin = -1;
+    ctx.varid_husmax = -1;
+  }
+
+  if ( !strcmp(obs_var->frequency, "daily") ) {
+    if (ctx.varid_tas < 0 && ( ctx.varid_tasmin < 0 || ctx.varid_tasmax < 0 ) )
+      ctx.tas_correction = FALSE;
+  }
+  else {
+    if (ctx.varid_tas < 0)
+      ctx.tas_correction = FALSE;
+  }
+
+  /* Create thread pools to process variables in parallel. NetCDF accesses are serialized by the NetCDF lock:
+     the per-variable work around them runs concurrently (scaling after each read, post-processed variables,
+     hourly to daily averaging and compression), and a single thread writes all variables. */
+  pool = thread_pool_create(nthreads);
+  ctx.var_pool = pool;
+  /* Compressed output fields are also deflated chunk by chunk on their own pool */
+  if (file_format == 4 && file_compression_level > 0)
+    ctx.encode_pool = thread_pool_create(nthreads);
+  else
+    ctx.encode_pool = NULL;
+
+  /* Start transformer and writer stages: this thread is the reader stage */
+  if (pipeline == TRUE) {
+    stages = thread_pool_create(2);
+    if (stages->nthreads < 2) {
+      (void) fprintf(stderr, "%s: WARNING: Cannot start output pipeline threads: reading, corrections and writing will be done serially.\n",
+                     __FILE__);
+      (void) thread_pool_free(stages);
+      stages = NULL;
+      pipeline = FALSE;
+    }
+    else {
+      pipe.transform_queue = bounded_queue_create(OUTPUT_QUEUE_SIZE);
+      pipe.write_queue = bounded_queue_create(OUTPUT_QUEUE_SIZE);
+      pipe.istat = 0;
+      /* The transformer stage processes variables on its own pool, independently of the reads of following days */
+      ctx.var_pool = thread_pool_create(nthreads);
+      (void) thread_pool_submit(stages, output_transform_stage, (void *) &pipe);
+      (void) thread_pool_submit(stages, output_write_stage, (void *) &pipe);
+    }
+  }
+
   /* Process each downscaled day */
   for (var=0; var<obs_var->nobs_var; var++) {
     noutf[var] = 0;
     outfiles[var] = NULL;
   }
-  for (t=0; t<ntime; t++) {
+  for (t=0; t<ntime && status == 0; t++) {
 
     /* Check if we want to write data for this date */
     if (time_ls[t] >= period_begin && time_ls[t] <= period_end) {
@@ -280,6 +461,20 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
         year2 = year1 + 1;
       else
         year2 = year1;
+      outyear = year1;
+
+      /* Skip output years completed before the run was resumed */
+      if (checkpoint_prefix != NULL && resume == TRUE) {
+        if (outyear != resume_year) {
+          resume_year = outyear;
+          skip_year = checkpoint_output_done(checkpoint_prefix, outyear);
+          if (skip_year == TRUE)
+            (void) printf("%s: Output year %04d was completed before the run was resumed: skipping.\n", __FILE__, outyear);
+        }
+        if (skip_year == TRUE)
+          continue;
+      }
+
       /* Process each variable and create output filenames, and output files if necessary */
       for (var=0; var<obs_var->nobs_var; var++) {
         /* Example: evapn_1d_19790801_19800731.nc */
@@ -305,7 +500,15 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
             if (outfiles[var] == NULL) alloc_error(__FILE__, __LINE__);
             outfiles[var][noutf[var]++] = strdup(outfile[var]);
             
+            /* Output year was not completed before the run was resumed: rewrite partially written file */
+            if (checkpoint_prefix != NULL && resume == TRUE)
+              (void) unlink(outfile[var]);
+
+            /* NetCDF library is not thread-safe: writer stage may be running */
+            (void) nc_io_lock();
+
             /* Verify if file exists and if we can write into it */
+            (void) instrument_count(INSTR_NC_OPENS, 1);
             istat = nc_open(outfile[var], NC_WRITE, &ncoutid);
             
             if (istat != NC_NOERR) {
@@ -323,20 +526,14 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
                                     outfile[var], TRUE, file_format, file_compression);
               if (istat != 0) {
                 /* In case of failure */
-                (void) free(outfile[var]);
-                for (f=0; f<noutf[var]; f++)
-                  (void) free(outfiles[var][f]);
-                if (noutf[var] > 0)
-                  (void) free(outfiles[var]);
-                if (pmsl != NULL) (void) free(pmsl);
-                if (alt != NULL) (void) free(alt);
-                (void) ut_free(dataunits);
-                (void) ut_free_system(unitSystem);  
-                return istat;
+                (void) nc_io_unlock();
+                status = istat;
+                break;
               }
             
               /** Add algorithm configuration **/
 
+              (void) instrument_count(INSTR_NC_OPENS, 1);
               istat = nc_open(outfile[var], NC_WRITE, &ncoutid);  /* open NetCDF file */
               if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
               
@@ -382,9 +579,13 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
             /* Close the output netCDF file. */
             istat = ncclose(ncoutid);
             if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
+
+            (void) nc_io_unlock();
           }
         }
       }
+      if (status != 0)
+        break;
           
       /* Create input filename for reading data */
       (void) strcpy(format, "%s/%s/");
@@ -433,26 +634,16 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
       /* Get time information for first input observation file and assume all files are alike */
       time_s = (time_vect_struct *) malloc(sizeof(time_vect_struct));
       if (time_s == NULL) alloc_error(__FILE__, __LINE__);
+      (void) nc_io_lock();
       istat = get_time_info(time_s, &timeval, &time_units_tmp, &cal_type_tmp, &ntime_obs, infile[0], obs_var->timename, FALSE);
+      (void) nc_io_unlock();
       (void) free(cal_type_tmp);
       (void) free(time_units_tmp);
       (void) free(timeval);
       if (istat < 0) {
-        for (var=0; var<obs_var->nobs_var; var++) {
-          (void) free(outfile[var]);
-          for (f=0; f<noutf[var]; f++) {
-            (void) free(outfiles[var][f]);
-          }
-          if (noutf[var] > 0) {
-            (void) free(outfiles[var]);
-          }
-        }
         (void) free(time_s);
-        if (pmsl != NULL) (void) free(pmsl);
-        if (alt != NULL) (void) free(alt);
-        (void) ut_free(dataunits);
-        (void) ut_free_system(unitSystem);  
-        return istat;
+        status = istat;
+        break;
       }
 
       /* Find date in observation database */
@@ -460,19 +651,8 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
       (void) printf("Processing %d %d %d %d\n",t,analog_days.year_s[t],analog_days.month_s[t],analog_days.day_s[t]);
 #endif
       
-      if ( !strcmp(obs_var->frequency, "hourly") ) {
-        /* For hourly frequency data, find hours from 0 to 23 */
-        minh = 0;
-        maxh = 23;
-      }
-      else {
-        /* For daily data, only read data for one day */
-        minh = 0;
-        maxh = 0;
-      }
-
       /* Loop over hours if needed */
-      for (hour=minh; hour<=maxh; hour++) {
+      for (hour=ctx.minh; hour<=ctx.maxh; hour++) {
         found = FALSE;
         tl = 0;
         
@@ -510,76 +690,48 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
         if (found == TRUE) {
           
           tl--;
-          
-          proj_tmp = (proj_struct *) malloc(sizeof(proj_struct));
-          if (proj_tmp == NULL) alloc_error(__FILE__, __LINE__);
-          proj_tmp->name = NULL;
-          proj_tmp->grid_mapping_name = NULL;
-          
-          /* Process each variable and read data */
+
+          /* New slice for this analog day */
+          day = output_new_day(&ctx);
+          day->infile = infile;
           for (var=0; var<obs_var->nobs_var; var++) {
-            info_tmp[var] = (info_field_struct *) malloc(sizeof(info_field_struct));
-            if (info_tmp[var] == NULL) alloc_error(__FILE__, __LINE__);
-            /* Don't read variables which will be calculated : read only variables already available in datafiles */
-            if ( !strcmp(obs_var->post[var], "no") ) {
-              if (proj_tmp->name != NULL) {
-                (void) free(proj_tmp->name);
-                proj_tmp->name = NULL;
-              }
-              if (proj_tmp->grid_mapping_name != NULL) {
-                (void) free(proj_tmp->grid_mapping_name);
-                proj_tmp->grid_mapping_name = NULL;
-              }
-              istat = read_netcdf_var_3d_2d(&(buf[var]), info_tmp[var], proj_tmp, infile[var], obs_var->acronym[var],
-                                            obs_var->dimxname, obs_var->dimyname, obs_var->timename,
-                                            tl, &nlon, &nlat, &ntime_file, debug);
-              /* Apply factor and delta */
-              for (j=0; j<nlat; j++)
-                for (i=0; i<nlon; i++)
-                  buf[var][i+j*nlon] = (buf[var][i+j*nlon] * obs_var->factor[var]) + obs_var->delta[var];
-              /* Overwrite units and height if it was specified in configuration file. In that case, the value is not unknown. */
-              if ( strcmp(obs_var->units[var], "unknown")) {
-                (void) free(info_tmp[var]->units);
-                info_tmp[var]->units = strdup(obs_var->units[var]);
-              }
-              if ( strcmp(obs_var->height[var], "unknown")) {
-                (void) free(info_tmp[var]->height);
-                info_tmp[var]->height = strdup(obs_var->height[var]);
-              }
-            }
-            else {
-              /* For post-processing variables, must fill in the info field structure info_tmp.
-                 The projection structure proj_tmp used is the one of the previous variable,
-                 because the first variable in the list is enforced to be a non post-processing variable
-                 when loading the configuration file. */
-              info_tmp[var]->fillvalue = info_tmp[0]->fillvalue;
-              info_tmp[var]->coordinates = strdup(info_tmp[0]->coordinates);
-              info_tmp[var]->grid_mapping = strdup(info_tmp[0]->grid_mapping);
-              info_tmp[var]->units = strdup(obs_var->units[var]);
-              info_tmp[var]->height = strdup(obs_var->height[var]);
-              info_tmp[var]->long_name = strdup(obs_var->name[var]);
-            }              
+            day->outfile[var] = strdup(outfile[var]);
+            day->newfile[var] = !(found_file[var]);
+          }
+          day->t = t;
+          day->year = outyear;
+          day->tl = tl;
+          day->hour = hour;
+          day->timeval = time_ls[t];
+
+          /* Read data of each variable */
+          istat = output_read_day(day, pool);
+          if (istat < 0) {
+            (void) output_free_day(day);
+            status = istat;
+            break;
           }
 
           if (obs_var->proj->name == NULL) {
             /* Retrieve observation grid parameters if not done already */
-            obs_var->proj->name = strdup(proj_tmp->name);
-            obs_var->proj->grid_mapping_name = strdup(proj_tmp->grid_mapping_name);
-            obs_var->proj->latin1 = proj_tmp->latin1;
-            obs_var->proj->latin2 = proj_tmp->latin2;
-            obs_var->proj->lonc = proj_tmp->lonc;
-            obs_var->proj->lat0 = proj_tmp->lat0;
-            obs_var->proj->false_easting = proj_tmp->false_easting;
-            obs_var->proj->false_northing = proj_tmp->false_northing;
+            obs_var->proj->name = strdup(day->proj->name);
+            obs_var->proj->grid_mapping_name = strdup(day->proj->grid_mapping_name);
+            obs_var->proj->latin1 = day->proj->latin1;
+            obs_var->proj->latin2 = day->proj->latin2;
+            obs_var->proj->lonc = day->proj->lonc;
+            obs_var->proj->lat0 = day->proj->lat0;
+            obs_var->proj->false_easting = day->proj->false_easting;
+            obs_var->proj->false_northing = day->proj->false_northing;
             
             /* Get latitude and longitude coordinates information from first file */
-            istat = read_netcdf_latlon(&lon, &lat, &nlon, &nlat, obs_var->dimcoords, obs_var->proj->coords,
+            (void) nc_io_lock();
+            istat = read_netcdf_latlon(&lon, &lat, &(day->nlon), &(day->nlat), obs_var->dimcoords, obs_var->proj->coords,
                                        obs_var->proj->name, obs_var->lonname,
                                        obs_var->latname, obs_var->dimxname,
                                        obs_var->dimyname, infile[0]);
             if ( !strcmp(obs_var->proj->name, "list") )
               /* List of lat + lon points only : keep only X dimension */
-              nlat = 0;
+              day->nlat = 0;
             else {
               /* Read coordinates information */
               istat = read_netcdf_xy(&x, &y, &nlon_file, &nlat_file, obs_var->dimxname, obs_var->dimyname, 
@@ -587,268 +739,15 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
               if (istat < 0)
                 x = y = (double *) NULL;
               else {
-                nlon = nlon_file;
-                nlat = nlat_file;
-              }
-            }
-          }
-          
-          /*** Apply modifications to data ***/
-          /** Retrieve temperature change and apply to analog day temperature and other variables **/
-          
-          /* Find known variable IDs for correction or calculation */
-          varid_tas = find_str_value("tas", obs_var->netcdfname, obs_var->nobs_var);
-          varid_tasmin = find_str_value("tasmin", obs_var->netcdfname, obs_var->nobs_var);
-          varid_tasmax = find_str_value("tasmax", obs_var->netcdfname, obs_var->nobs_var);
-          varid_prsn = find_str_value("prsn", obs_var->netcdfname, obs_var->nobs_var);
-          varid_prr = find_str_value("prr", obs_var->netcdfname, obs_var->nobs_var);
-          varid_rlds = find_str_value("rlds", obs_var->netcdfname, obs_var->nobs_var);
-          varid_rsds = find_str_value("rsds", obs_var->netcdfname, obs_var->nobs_var);
-          varid_hus = find_str_value("hus", obs_var->netcdfname, obs_var->nobs_var);
-          varid_husmin = find_str_value("husmin", obs_var->netcdfname, obs_var->nobs_var);
-          varid_husmax = find_str_value("husmax", obs_var->netcdfname, obs_var->nobs_var);
-          varid_uvas = find_str_value("uvas", obs_var->netcdfname, obs_var->nobs_var);
-          varid_hur = find_str_value("hur", obs_var->netcdfname, obs_var->nobs_var);
-          varid_etp = find_str_value("evapn", obs_var->netcdfname, obs_var->nobs_var);
-          varid_prtot = find_str_value("prtot", obs_var->netcdfname, obs_var->nobs_var);
-
-          tas_correction = TRUE;
-
-          if ( (varid_tasmax >= 0 || varid_tasmin >= 0 || varid_husmin >= 0 || varid_husmax >= 0) && !strcmp(obs_var->frequency, "hourly")) {
-            (void) fprintf(stderr, "%s: WARNING: Cannot mix min and/or max observation variables with hourly data! Min and/or max variables will be ignored! \n", __FILE__);
-            varid_tasmin = -1;
-            varid_tasmax = -1;
-            varid_husmin = -1;
-            varid_husmax = -1;
-          }
-
-          if ( !strcmp(obs_var->frequency, "daily") ) {
-            if (varid_tas < 0 && ( varid_tasmin < 0 || varid_tasmax < 0 ) )
-              tas_correction = FALSE;
-          }
-          else {
-            if (varid_tas < 0)
-              tas_correction = FALSE;
-          }
-
-          //            (void) fprintf(stderr, "%s: WARNING: No temperature correction can be done to precipitation partition or infra-red radiation required temperature variables are not available! It needs at least either average daily or hourly temperature, or, with daily data, min and max temperatures.\n", __FILE__);
-
-          /* Correct average temperature and related variables (precipitation partition, infra-red radiation) */
-          if (varid_tas >= 0 && tas_correction == TRUE) {
-            if (fabs(delta[t]) >= deltat)
-              for (j=0; j<nlat; j++)
-                for (i=0; i<nlon; i++)
-                  
-                  if (buf[varid_tas][i+j*nlon] != info_tmp[varid_tas]->fillvalue) {
-                    
-                    /* Save non-corrected temperature */
-                    curtas = buf[varid_tas][i+j*nlon];
-                    /* Compute new temperature */                
-                    buf[varid_tas][i+j*nlon] += delta[t];
-                    
-                    /* Compute new rain/snow partition, if needed */
-                    if (varid_prsn != -1 && varid_prr != -1)
-                      if (buf[varid_prsn][i+j*nlon] != info_tmp[varid_prsn]->fillvalue &&
-                          buf[varid_prr][i+j*nlon] != info_tmp[varid_prr]->fillvalue)
-                        if ( buf[varid_tas][i+j*nlon] >= (K_TKELVIN + 1.5) ) {
-                          buf[varid_prr][i+j*nlon] += buf[varid_prsn][i+j*nlon];
-                          buf[varid_prsn][i+j*nlon] = 0.0;
-                        }
-                    
-                    /* Compute new infra-red radiation, if needed */
-                    if (varid_rlds != -1)
-                      if (buf[varid_rlds][i+j*nlon] != info_tmp[varid_rlds]->fillvalue)
-                        buf[varid_rlds][i+j*nlon] += (4.0 * delta[t] / curtas ) * buf[varid_rlds][i+j*nlon];
-                    
-                  }
-          }
-
-          /* Correct min and max temperatures and related variables when having daily data */
-          if (varid_tasmax >= 0 && varid_tasmin >= 0 && tas_correction == TRUE && !strcmp(obs_var->frequency, "daily")) {
-            if (fabs(delta[t]) >= deltat)
-              for (j=0; j<nlat; j++)
-                for (i=0; i<nlon; i++)
-                  
-                  if (buf[varid_tasmax][i+j*nlon] != info_tmp[varid_tasmax]->fillvalue) {
-                    
-                    /* Save non-corrected mean temperature */
-                    curtas = (buf[varid_tasmax][i+j*nlon] + buf[varid_tasmin][i+j*nlon]) / 2.0;
-                    /* Compute new temperature */                
-                    buf[varid_tasmax][i+j*nlon] += delta[t];
-                    buf[varid_tasmin][i+j*nlon] += delta[t];
-                    /* New averaged temperature */
-                    newcurtas = (buf[varid_tasmax][i+j*nlon] + buf[varid_tasmin][i+j*nlon]) / 2.0;
-
-                    /* Do not perform correction twice! */
-                    if (varid_tas < 0) {
-                      /* Compute new rain/snow partition, if needed */
-                      if (varid_prsn != -1 && varid_prr != -1)
-                        if (buf[varid_prsn][i+j*nlon] != info_tmp[varid_prsn]->fillvalue &&
-                            buf[varid_prr][i+j*nlon] != info_tmp[varid_prr]->fillvalue)
-                          if ( newcurtas >= (K_TKELVIN + 1.5) ) {
-                            buf[varid_prr][i+j*nlon] += buf[varid_prsn][i+j*nlon];
-                            buf[varid_prsn][i+j*nlon] = 0.0;
-                          }
-                  
-                      /* Compute new infra-red radiation, if needed */
-                      if (varid_rlds != -1)
-                        if (buf[varid_rlds][i+j*nlon] != info_tmp[varid_rlds]->fillvalue)
-                          buf[varid_rlds][i+j*nlon] += (4.0 * delta[t] / curtas ) * buf[varid_rlds][i+j*nlon];
-                    }
-                  }
-          }
-
-          /* Calculate only known post-processed variables */
-
-          if (varid_hur >= 0) {
-            /* Relative humidity */
-            if ( !strcmp(obs_var->post[varid_hur], "yes") ) {
-              if ( varid_hus >= 0 && (varid_tas >= 0 || (varid_tasmax >= 0 && varid_tasmin >= 0 )) && pmsl != NULL ) {
-                /* Calculate relative humidity from temperature and specific humidity */
-                buf[varid_hur] = (double *) malloc(nlat*nlon * sizeof(double));
-                if (buf[varid_hur] == NULL) alloc_error(__FILE__, __LINE__);
-                if (varid_tas >= 0)
-                  info_tmp[varid_hur]->fillvalue = info_tmp[varid_tas]->fillvalue;
-                else if (varid_tasmax >= 0)
-                  info_tmp[varid_hur]->fillvalue = info_tmp[varid_tasmax]->fillvalue;
-                else
-                  info_tmp[varid_hur]->fillvalue = -9999.0;
-                /* Create mean temperature temporary matrix when having only min and max temperature */
-                if (varid_tas < 0) {
-                  buftmp = (double *) malloc(nlat*nlon* sizeof(double));
-                  if (buftmp == NULL) alloc_error(__FILE__, __LINE__);
-                  info_tmp[varid_tas]->fillvalue = info_tmp[varid_tasmax]->fillvalue;
-                  for (i=0; i<(nlon*nlat); i++)
-                    if ((buf[varid_tasmax][i] != info_tmp[varid_tasmax]->fillvalue) &&
-                        (buf[varid_tasmin][i] != info_tmp[varid_tasmin]->fillvalue))
-                      buftmp[i] = (buf[varid_tasmax][i] + buf[varid_tasmin][i]) / 2.0;
-                    else
-                      buftmp[i] = info_tmp[varid_tas]->fillvalue;
-                }
-                else
-                  buftmp = buf[varid_tas];
-                (void) spechum_to_hr(buf[varid_hur], buftmp, buf[varid_hus], pmsl, info_tmp[varid_hur]->fillvalue, nlon, nlat);
-                if (varid_tas < 0)
-                  (void) free(buftmp);
-              }
-              else {
-                (void) fprintf(stderr, "%s: WARNING: Cannot calculate Relative Humidity because needed variables are not available: Specific Humidity; Averaged temperature or Min/Max temperature, Standard Pressure from altitude.\n", __FILE__);                
-                buf[varid_hur] = NULL;
-              }
-            }
-          }
-
-          if (varid_prsn >= 0 && varid_prr >= 0 && varid_prtot >= 0) {
-            /* Total precipitation */
-            if ( !strcmp(obs_var->post[varid_prtot], "yes") ) {
-              /* Calculate total precipitation from liquid and solid precipitation */
-                buf[varid_prtot] = (double *) malloc(nlat*nlon * sizeof(double));
-                if (buf[varid_prtot] == NULL) alloc_error(__FILE__, __LINE__);
-                info_tmp[varid_prtot]->fillvalue = info_tmp[varid_prr]->fillvalue;
-                for (i=0; i<(nlon*nlat); i++) {
-                  if ( (buf[varid_prr][i] != info_tmp[varid_prr]->fillvalue) && (buf[varid_prsn][i] != info_tmp[varid_prsn]->fillvalue))
-                    buf[varid_prtot][i] = buf[varid_prr][i] + buf[varid_prsn][i];
-                  else
-                    buf[varid_prtot][i] = info_tmp[varid_prtot]->fillvalue;
-                }
-              }
-            else {
-                (void) fprintf(stderr, "%s: WARNING: Cannot calculate Total Precipitation because needed variables are not available: Liquid and Solid Precipitation.\n", __FILE__);                
-                buf[varid_prtot] = NULL;
-            }
-          }
-
-          if (varid_etp >= 0) {
-            /* ETP */
-            if ( !strcmp(obs_var->post[varid_etp], "yes") ) {
-              if ( varid_hus >= 0 && (varid_tas >= 0 || (varid_tasmax >= 0 && varid_tasmin >= 0 )) && varid_rsds >= 0 && varid_rlds >= 0 &&
-                   varid_uvas >= 0 && pmsl != NULL ) {
-                /* Calculate ETP */
-                buf[varid_etp] = (double *) malloc(nlat*nlon * sizeof(double));
-                if (buf[varid_etp] == NULL) alloc_error(__FILE__, __LINE__);
-                if (varid_tas >= 0)
-                  info_tmp[varid_etp]->fillvalue = info_tmp[varid_tas]->fillvalue;
-                else if (varid_tasmax >= 0)
-                  info_tmp[varid_etp]->fillvalue = info_tmp[varid_tasmax]->fillvalue;
-                else
-                  info_tmp[varid_etp]->fillvalue = -9999.0;
-                /* Create mean temperature temporary matrix when having only min and max temperature */
-                if (varid_tas < 0) {
-                  buftmp = (double *) malloc(nlat*nlon* sizeof(double));
-                  if (buftmp == NULL) alloc_error(__FILE__, __LINE__);
-                  for (i=0; i<(nlon*nlat); i++) {
-                    if ((buf[varid_tasmax][i] != info_tmp[varid_tasmax]->fillvalue) &&
-                        (buf[varid_tasmin][i] != info_tmp[varid_tasmin]->fillvalue))
-                      buftmp[i] = (buf[varid_tasmax][i] + buf[varid_tasmin][i]) / 2.0;
-                    else
-                      buftmp[i] = info_tmp[varid_tasmax]->fillvalue;
-                  }
-                }
-                else
-                  buftmp = buf[varid_tas];
-                (void) calc_etp_mf(buf[varid_etp], buftmp, buf[varid_hus], buf[varid_rsds], buf[varid_rlds], buf[varid_uvas],
-                                   pmsl, info_tmp[varid_etp]->fillvalue, nlon, nlat);
-                if (varid_tas < 0)
-                  (void) free(buftmp);
-              }
-              else {
-                (void) fprintf(stderr, "%s: WARNING: Cannot calculate ETP because needed variables are not available: Specific Humidity; Averaged Temperature or Min/Max Temperature; Short and Long Wave Radiation; Wind Module, Standard Pressure from altitude.\n", __FILE__);
-                buf[varid_etp] = NULL;
-              }
-            }
-          }
-
-          /* Process each variable for writing */
-          for (var=0; var<obs_var->nobs_var; var++) {
-            if ( !strcmp(obs_var->output[var], "yes") ) {
-              /* Write dimensions of field in newly-created NetCDF output file */
-              if (found_file[var] == FALSE && hour == minh && buf[var] != NULL) {
-                /* We just created output file: we need to write dimensions */
-                ctimeval[0] = time_ls[t];
-                istat = write_netcdf_dims_3d(lon, lat, x, y, alt, ctimeval, cal_type,
-                                             time_units, nlon, nlat, 0,
-                                             info->timestep, obs_var->proj->name, obs_var->proj->coords,
-                                             obs_var->proj->grid_mapping_name, obs_var->proj->latin1,
-                                             obs_var->proj->latin2, obs_var->proj->lonc, obs_var->proj->lat0,
-                                             obs_var->proj->false_easting, obs_var->proj->false_northing,
-                                             obs_var->proj->lonpole, obs_var->proj->latpole,
-                                             obs_var->lonname, obs_var->latname, obs_var->dimxname, obs_var->dimyname,
-                                             obs_var->timename, outfile[var], debug);
-                if (istat != 0) {
-                  /* In case of failure */
-                  (void) free(time_s->year);
-                  (void) free(time_s->month);
-                  (void) free(time_s->day);
-                  (void) free(time_s->hour);
-                  (void) free(time_s->minutes);
-                  (void) free(time_s->seconds);
-                  
-                  (void) free(time_s);
-            
-                  (void) free(infile[var]);
-                  (void) free(outfile[var]);
-                  (void) free(info_tmp[var]->grid_mapping);
-                  (void) free(info_tmp[var]->units);
-                  (void) free(info_tmp[var]->height);
-                  (void) free(info_tmp[var]->coordinates);
-                  (void) free(info_tmp[var]->long_name);
-                  (void) free(info_tmp[var]);
-                  (void) free(proj_tmp->name);
-                  (void) free(proj_tmp->grid_mapping_name);
-                  (void) free(proj_tmp);
-                  for (f=0; f<noutf[var]; f++)
-                    (void) free(outfiles[var][f]);
-                  if (noutf[var] > 0)
-                    (void) free(outfiles[var]);
-                  (void) free(outfiles);
-                  if (pmsl != NULL) (void) free(pmsl);
-                  if (alt != NULL) (void) free(alt);
-                  (void) ut_free(dataunits);
-                  (void) ut_free_system(unitSystem);  
-                  return istat;
-                }
+                day->nlon = nlon_file;
+                day->nlat = nlat_file;
               }
             }
+            (void) nc_io_unlock();
+            ctx.lon = lon;
+            ctx.lat = lat;
+            ctx.x = x;
+            ctx.y = y;
           }
 
           /* Compute time if output timestep is hourly and not daily */
@@ -858,122 +757,28 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
           }
           else
             curtime = time_ls[t];
-
-          /* Process each variable */
-          for (var=0; var<obs_var->nobs_var; var++) {
-            if (buf[var] != NULL && !strcmp(obs_var->output[var], "yes")) {
-              if ( !strcmp(info->timestep, obs_var->frequency) ) {
-                /* Output and input data are at same frequency */
-                if (found_file[var] == FALSE && hour == minh)
-                  (void) fprintf(stderr, "%s: Writing data to %s\n", __FILE__, outfile[var]);
-                /* Write data */
-                istat = write_netcdf_var_3d_2d(buf[var], &curtime, info_tmp[var]->fillvalue, outfile[var], obs_var->netcdfname[var],
-                                               info_tmp[var]->long_name, info_tmp[var]->units, info_tmp[var]->height, proj_tmp->name, 
-                                               obs_var->dimxname, obs_var->dimyname, obs_var->timename,
-                                               0, !(found_file[var]), file_format, file_compression_level,
-                                               nlon, nlat, ntime_file, debug);
-                found_file[var] = TRUE;
-              }
-              else if ( !strcmp(info->timestep, "daily") && !strcmp(obs_var->frequency, "hourly") ) {
-                if (hour == maxh) {
-                  /* Last hour of day */
-                  for (i=0; i<nlon*nlat; i++)
-                    /* Average data */
-                    buf[var][i] = (bufsave[var][i] + buf[var][i]) / 24.0;
-                  /* Free memory */
-                  (void) free(bufsave[var]);
-                  bufsave[var] = NULL;
-                  if (found_file[var] == FALSE && hour == minh)
-                    (void) fprintf(stderr, "%s: Writing data to %s\n",__FILE__, outfile[var]);
-                  /* Write data */
-                  istat = write_netcdf_var_3d_2d(buf[var], &curtime, info_tmp[var]->fillvalue, outfile[var], obs_var->netcdfname[var],
-                                                 info_tmp[var]->long_name, info_tmp[var]->units, info_tmp[var]->height, proj_tmp->name, 
-                                                 obs_var->dimxname, obs_var->dimyname, obs_var->timename,
-                                                 0, !(found_file[var]),  file_format, file_compression_level,
-                                                 nlon, nlat, ntime_file, debug);
-                  found_file[var] = TRUE;
-                }
-                else {
-                  /* Allocate memory if first hour accumulating */
-                  if (bufsave[var] == NULL) {
-                    bufsave[var] = (double *) calloc(nlat*nlon, sizeof(double));
-                    if (bufsave[var] == NULL) alloc_error(__FILE__, __LINE__);
-                  }
-                  /* Accumulate data to compute average when input data is hourly and output is daily */
-                  for (i=0; i<nlon*nlat; i++)
-                    bufsave[var][i] += buf[var][i];
-                }
-              }
-              else {
-                (void) fprintf(stderr, "%s: Fatal error in configuration of output timestep and observation variables frequency! Output timestep = %s    Observation variables frequency = %s\n", __FILE__, info->timestep, obs_var->frequency);
-                
-                /* Fatal error */
-                if (buf[var] != NULL) (void) free(buf[var]);
-                (void) free(info_tmp[var]->grid_mapping);
-                (void) free(info_tmp[var]->units);
-                (void) free(info_tmp[var]->height);
-                (void) free(info_tmp[var]->coordinates);
-                (void) free(info_tmp[var]->long_name);
-                (void) free(info_tmp[var]);
-                
-                for (vare=0; vare<=var; vare++) {
-                  for (f=0; f<noutf[vare]; f++)
-                    (void) free(outfiles[vare][f]);
-                  if (noutf[vare] > 0)
-                    (void) free(outfiles[vare]);
-                  (void) free(infile[vare]);
-                  (void) free(outfile[vare]);
-                }
-                (void) free(outfiles);
-                (void) free(noutf);
-                (void) free(found_file);
-                (void) free(info_tmp);
-                (void) free(buf);
-                
-                (void) free(lat);
-                (void) free(lon);
-                
-                (void) free(x);
-                (void) free(y);
-                
-                (void) free(format);
-                
-                (void) free(proj_tmp->name);
-                (void) free(proj_tmp->grid_mapping_name);
-                (void) free(proj_tmp);
-                
-                (void) free(time_s->year);
-                (void) free(time_s->month);
-                (void) free(time_s->day);
-                (void) free(time_s->hour);
-                (void) free(time_s->minutes);
-                (void) free(time_s->seconds);
-                
-                (void) free(time_s);
-
-                if (alt != NULL) (void) free(alt);
-
-                (void) ut_free(dataunits);
-                (void) ut_free_system(unitSystem);  
-
-                return -3;
-              }
+          day->curtime = curtime;
+
+          if (pipeline == TRUE) {
+            /* Hand over slice to transformer stage */
+            if (bounded_queue_push(pipe.transform_queue, (void *) day) != 0) {
+              /* Writer stage failed */
+              (void) output_free_day(day);
+              status = -1;
+              break;
+            }
+          }
+          else {
+            /* Apply corrections and calculate post-processed variables, then compress and write */
+            (void) output_correct_day(day);
+            (void) output_encode_day(day);
+            istat = output_write_day(day);
+            (void) output_free_day(day);
+            if (istat != 0) {
+              status = istat;
+              break;
             }
-            
-            /* Free allocated memory */
-            if (buf[var] != NULL) (void) free(buf[var]);
-            (void) free(info_tmp[var]->grid_mapping);
-            (void) free(info_tmp[var]->units);
-            (void) free(info_tmp[var]->height);
-            (void) free(info_tmp[var]->coordinates);
-            (void) free(info_tmp[var]->long_name);
-            (void) free(info_tmp[var]);
           }
-
-          /* Free allocated memory */
-          (void) free(proj_tmp->name);
-          (void) free(proj_tmp->grid_mapping_name);
-          (void) free(proj_tmp);        
         }
         else {
           //output_downscaled_analog.c: Fatal error in algorithm: analog date 3276 2000 12 31 19 not found in database!!
@@ -982,15 +787,13 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
           if ( !strcmp(obs_var->frequency, "hourly") ) {
             (void) fprintf(stderr, "%s: Fatal error in algorithm: analog date %d %d %d %d %d not found in database!!\n", __FILE__, t,
                            analog_days.year[t],analog_days.month[t],analog_days.day[t],hour);
-            minh = 0;
-            maxh = 23;
-            for (hour=minh; hour<=maxh; hour++) {
+            for (hh=ctx.minh; hh<=ctx.maxh; hh++) {
               found = FALSE;
               tl = 0;
               while (tl<ntime_obs && found == FALSE) {
                 (void) printf("%d %d %d %d %d\n",tl,time_s->year[tl],time_s->month[tl],time_s->day[tl],time_s->hour[tl]);
                 if (analog_days.year[t] == time_s->year[tl] && analog_days.month[t] == time_s->month[tl] &&
-                    analog_days.day[t] == time_s->day[tl] && hour == time_s->hour[tl]) {
+                    analog_days.day[t] == time_s->day[tl] && hh == time_s->hour[tl]) {
                   found = TRUE;
                   (void) printf("Found analog %d %d %d %d\n",tl,analog_days.year[t],analog_days.month[t],analog_days.day[t]);
                 }
@@ -1002,47 +805,8 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
             (void) fprintf(stderr, "%s: Fatal error in algorithm: analog date %d %d %d %d not found in database!!\n", __FILE__, t,
                            analog_days.year[t],analog_days.month[t],analog_days.day[t]);
           /* Fatal error */
-          for (var=0; var<obs_var->nobs_var; var++) {
-            for (f=0; f<noutf[var]; f++)
-              (void) free(outfiles[var][f]);
-            if (noutf[var] > 0)
-              (void) free(outfiles[var]);
-            (void) free(infile[var]);
-            (void) free(outfile[var]);
-          }
-          (void) free(outfiles);
-          (void) free(noutf);
-          (void) free(found_file);
-          (void) free(info_tmp);
-          (void) free(buf);
-      
-          (void) free(lat);
-          (void) free(lon);
-      
-          (void) free(x);
-          (void) free(y);
-      
-          (void) free(format);
-      
-          (void) free(proj_tmp->name);
-          (void) free(proj_tmp->grid_mapping_name);
-          (void) free(proj_tmp);
-      
-          (void) free(time_s->year);
-          (void) free(time_s->month);
-          (void) free(time_s->day);
-          (void) free(time_s->hour);
-          (void) free(time_s->minutes);
-          (void) free(time_s->seconds);
-      
-          (void) free(time_s);
-      
-          if (alt != NULL) (void) free(alt);
-
-          (void) ut_free(dataunits);
-          (void) ut_free_system(unitSystem);  
-
-          return -1;
+          status = -1;
+          break;
         }
       }
       (void) free(time_s->year);
@@ -1055,6 +819,24 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
       (void) free(time_s);
     }
   }
+
+  if (stages != NULL) {
+    /* No more slices: wait for transformer and writer stages to complete */
+    (void) bounded_queue_close(pipe.transform_queue);
+    (void) thread_pool_free(stages);
+    if (pipe.istat != 0)
+      status = pipe.istat;
+    (void) bounded_queue_free(pipe.transform_queue);
+    (void) bounded_queue_free(pipe.write_queue);
+  }
+  /* All days of last output year have been written */
+  if (status == 0 && checkpoint_prefix != NULL && ctx.checkpoint_year != -1)
+    (void) checkpoint_output_year(checkpoint_prefix, ctx.checkpoint_year);
+  if (ctx.var_pool != pool)
+    (void) thread_pool_free(ctx.var_pool);
+  (void) thread_pool_free(pool);
+  if (ctx.encode_pool != NULL)
+    (void) thread_pool_free(ctx.encode_pool);
   
   /* Free allocated memory */
   for (var=0; var<obs_var->nobs_var; var++) {
@@ -1064,12 +846,13 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
       (void) free(outfiles[var]);
     (void) free(infile[var]);
     (void) free(outfile[var]);
+    if (ctx.bufsave[var] != NULL) (void) free(ctx.bufsave[var]);
   }
   (void) free(outfiles);
   (void) free(noutf);
   (void) free(found_file);
-  (void) free(info_tmp);
-  (void) free(buf);
+  (void) free(ctx.bufsave);
+  (void) free(ctx.written);
   
   (void) free(x);
   (void) free(y);
@@ -1087,6 +870,669 @@ output_downscaled_analog(analog_day_struct analog_days, double *delta, int outpu
   (void) ut_free(dataunits);
   (void) ut_free_system(unitSystem);  
 
-  /* Success diagnostic */
+  /* Diagnostic status */
+  return status;
+}
+
+
+/** Allocate a new analog day slice. */
+static output_day_struct *
+output_new_day(output_ctx_struct *ctx) {
+  /**
+     @param[in]  ctx  Data shared by all stages
+
+     \return          Analog day slice.
+  */
+
+  output_day_struct *day = NULL; /* Analog day slice */
+  int nvar = ctx->obs_var->nobs_var; /* Number of variables */
+
+  day = (output_day_struct *) malloc(sizeof(output_day_struct));
+  if (day == NULL) alloc_error(__FILE__, __LINE__);
+  day->ctx = ctx;
+  day->infile = NULL;
+  day->proj = NULL;
+  day->outfile = (char **) calloc(nvar, sizeof(char *));
+  if (day->outfile == NULL) alloc_error(__FILE__, __LINE__);
+  day->newfile = (int *) calloc(nvar, sizeof(int));
+  if (day->newfile == NULL) alloc_error(__FILE__, __LINE__);
+  day->buf = (double **) calloc(nvar, sizeof(double *));
+  if (day->buf == NULL) alloc_error(__FILE__, __LINE__);
+  day->ready = (int *) calloc(nvar, sizeof(int));
+  if (day->ready == NULL) alloc_error(__FILE__, __LINE__);
+  day->chunks = (nc_chunks_struct *) calloc(nvar, sizeof(nc_chunks_struct));
+  if (day->chunks == NULL) alloc_error(__FILE__, __LINE__);
+  day->encoded = (int *) calloc(nvar, sizeof(int));
+  if (day->encoded == NULL) alloc_error(__FILE__, __LINE__);
+  day->info_tmp = (info_field_struct **) calloc(nvar, sizeof(info_field_struct *));
+  if (day->info_tmp == NULL) alloc_error(__FILE__, __LINE__);
+
+  return day;
+}
+
+
+/** Free an analog day slice. */
+static void
+output_free_day(output_day_struct *day) {
+  /**
+     @param[in]  day  Analog day slice
+  */
+
+  int var; /* Variable counter */
+
+  for (var=0; var<day->ctx->obs_var->nobs_var; var++) {
+    if (day->buf[var] != NULL) (void) free(day->buf[var]);
+    if (day->encoded[var] == TRUE) (void) free_netcdf_chunks(&(day->chunks[var]));
+    if (day->info_tmp[var] != NULL) {
+      (void) free(day->info_tmp[var]->grid_mapping);
+      (void) free(day->info_tmp[var]->units);
+      (void) free(day->info_tmp[var]->height);
+      (void) free(day->info_tmp[var]->coordinates);
+      (void) free(day->info_tmp[var]->long_name);
+      (void) free(day->info_tmp[var]);
+    }
+    if (day->outfile[var] != NULL) (void) free(day->outfile[var]);
+  }
+  if (day->proj != NULL) {
+    (void) free(day->proj->name);
+    (void) free(day->proj->grid_mapping_name);
+    (void) free(day->proj);
+  }
+  (void) free(day->buf);
+  (void) free(day->ready);
+  (void) free(day->chunks);
+  (void) free(day->encoded);
+  (void) free(day->info_tmp);
+  (void) free(day->outfile);
+  (void) free(day->newfile);
+  (void) free(day);
+}
+
+
+/** Read all observation variables of an analog day slice, in parallel. */
+static int
+output_read_day(output_day_struct *day, thread_pool_struct *pool) {
+  /**
+     @param[in,out]  day   Analog day slice
+     @param[in]      pool  Thread pool processing the variables
+
+     \return               Status.
+  */
+
+  output_var_task_struct *tasks = NULL; /* Per-variable tasks */
+  var_struct *obs_var = day->ctx->obs_var; /* Observation variables data structure */
+  info_field_struct **info_tmp = day->info_tmp; /* Field information structure of each variable */
+  int var; /* Variable counter */
+  int istat = 0; /* Diagnostic status */
+
+  tasks = (output_var_task_struct *) malloc(obs_var->nobs_var * sizeof(output_var_task_struct));
+  if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Process each variable and read data */
+  for (var=0; var<obs_var->nobs_var; var++) {
+    info_tmp[var] = (info_field_struct *) calloc(1, sizeof(info_field_struct));
+    if (info_tmp[var] == NULL) alloc_error(__FILE__, __LINE__);
+    tasks[var].day = day;
+    tasks[var].proj = NULL;
+    tasks[var].var = var;
+    tasks[var].istat = 0;
+    /* Don't read variables which will be calculated : read only variables already available in datafiles */
+    if ( !strcmp(obs_var->post[var], "no") )
+      (void) thread_pool_submit(pool, output_read_var, (void *) &(tasks[var]));
+  }
+  (void) thread_pool_wait(pool);
+
+  /* The projection structure used is the one of the first variable,
+     because the first variable in the list is enforced to be a non post-processing variable
+     when loading the configuration file. */
+  day->proj = tasks[0].proj;
+  day->nlon = tasks[0].nlon;
+  day->nlat = tasks[0].nlat;
+  day->ntime_file = tasks[0].ntime_file;
+  for (var=0; var<obs_var->nobs_var; var++) {
+    if (tasks[var].istat < 0) {
+      (void) fprintf(stderr, "%s: Fatal error: cannot read variable %s in file %s.\n", __FILE__,
+                     obs_var->acronym[var], day->infile[var]);
+      istat = tasks[var].istat;
+    }
+    if (var > 0 && tasks[var].proj != NULL) {
+      (void) free(tasks[var].proj->name);
+      (void) free(tasks[var].proj->grid_mapping_name);
+      (void) free(tasks[var].proj);
+    }
+  }
+  (void) free(tasks);
+  if (istat < 0)
+    return istat;
+
+  for (var=0; var<obs_var->nobs_var; var++) {
+    if ( strcmp(obs_var->post[var], "no") ) {
+      /* For post-processing variables, must fill in the info field structure info_tmp. */
+      info_tmp[var]->fillvalue = info_tmp[0]->fillvalue;
+      info_tmp[var]->coordinates = strdup(info_tmp[0]->coordinates);
+      info_tmp[var]->grid_mapping = strdup(info_tmp[0]->grid_mapping);
+      info_tmp[var]->units = strdup(obs_var->units[var]);
+      info_tmp[var]->height = strdup(obs_var->height[var]);
+      info_tmp[var]->long_name = strdup(obs_var->name[var]);
+    }              
+  }
+
   return 0;
 }
+
+
+/** Apply temperature corrections to an analog day slice and calculate post-processed variables. */
+static void
+output_correct_day(output_day_struct *day) {
+  /**
+     @param[in,out]  day  Analog day slice
+  */
+
+  output_ctx_struct *ctx = day->ctx; /* Data shared by all stages */
+  var_struct *obs_var = ctx->obs_var; /* Observation variables data structure */
+  double **buf = day->buf; /* Data buffer of each variable */
+  info_field_struct **info_tmp = day->info_tmp; /* Field information structure of each variable */
+  double *delta = ctx->delta; /* Temperature difference to apply to analog day data */
+  double deltat = ctx->deltat; /* Absolute difference of large-scale temperature threshold to apply as a correction */
+  output_var_task_struct *tasks = NULL; /* Per-variable tasks */
+  double curtas; /* Current temperature value */
+  double newcurtas; /* New current temperature value */
+  int nlon = day->nlon; /* Longitude dimension */
+  int nlat = day->nlat; /* Latitude dimension */
+  int t = day->t; /* Time index of downscaled day */
+  int var; /* Variable counter */
+  int i; /* Loop counter */
+  int j; /* Loop counter */
+
+  int varid_tas = ctx->varid_tas; /* Variable index ID */
+  int varid_tasmax = ctx->varid_tasmax; /* Variable index ID */
+  int varid_tasmin = ctx->varid_tasmin; /* Variable index ID */
+  int varid_prsn = ctx->varid_prsn; /* Variable index ID */
+  int varid_prr = ctx->varid_prr; /* Variable index ID */
+  int varid_rlds = ctx->varid_rlds; /* Variable index ID */
+  int varid_hur = ctx->varid_hur; /* Variable index ID */
+  int varid_etp = ctx->varid_etp; /* Variable index ID */
+  int varid_prtot = ctx->varid_prtot; /* Variable index ID */
+  short int tas_correction = ctx->tas_correction; /* If temperature correction can be applied */
+
+  /*** Apply modifications to data ***/
+  /** Retrieve temperature change and apply to analog day temperature and other variables **/
+
+  /* Correct average temperature and related variables (precipitation partition, infra-red radiation) */
+  if (varid_tas >= 0 && tas_correction == TRUE) {
+    if (fabs(delta[t]) >= deltat)
+      for (j=0; j<nlat; j++)
+        for (i=0; i<nlon; i++)
+          
+          if (buf[varid_tas][i+j*nlon] != info_tmp[varid_tas]->fillvalue) {
+            
+            /* Save non-corrected temperature */
+            curtas = buf[varid_tas][i+j*nlon];
+            /* Compute new temperature */                
+            buf[varid_tas][i+j*nlon] += delta[t];
+            
+            /* Compute new rain/snow partition, if needed */
+            if (varid_prsn != -1 && varid_prr != -1)
+              if (buf[varid_prsn][i+j*nlon] != info_tmp[varid_prsn]->fillvalue &&
+                  buf[varid_prr][i+j*nlon] != info_tmp[varid_prr]->fillvalue)
+                if ( buf[varid_tas][i+j*nlon] >= (K_TKELVIN + 1.5) ) {
+                  buf[varid_prr][i+j*nlon] += buf[varid_prsn][i+j*nlon];
+                  buf[varid_prsn][i+j*nlon] = 0.0;
+                }
+            
+            /* Compute new infra-red radiation, if needed */
+            if (varid_rlds != -1)
+              if (buf[varid_rlds][i+j*nlon] != info_tmp[varid_rlds]->fillvalue)
+                buf[varid_rlds][i+j*nlon] += (4.0 * delta[t] / curtas ) * buf[varid_rlds][i+j*nlon];
+            
+          }
+  }
+
+  /* Correct min and max temperatures and related variables when having daily data */
+  if (varid_tasmax >= 0 && varid_tasmin >= 0 && tas_correction == TRUE && !strcmp(obs_var->frequency, "daily")) {
+    if (fabs(delta[t]) >= deltat)
+      for (j=0; j<nlat; j++)
+        for (i=0; i<nlon; i++)
+          
+          if (buf[varid_tasmax][i+j*nlon] != info_tmp[varid_tasmax]->fillvalue) {
+            
+            /* Save non-corrected mean temperature */
+            curtas = (buf[varid_tasmax][i+j*nlon] + buf[varid_tasmin][i+j*nlon]) / 2.0;
+            /* Compute new temperature */                
+            buf[varid_tasmax][i+j*nlon] += delta[t];
+            buf[varid_tasmin][i+j*nlon] += delta[t];
+            /* New averaged temperature */
+            newcurtas = (buf[varid_tasmax][i+j*nlon] + buf[varid_tasmin][i+j*nlon]) / 2.0;
+
+            /* Do not perform correction twice! */
+            if (varid_tas < 0) {
+              /* Compute new rain/snow partition, if needed */
+              if (varid_prsn != -1 && varid_prr != -1)
+                if (buf[varid_prsn][i+j*nlon] != info_tmp[varid_prsn]->fillvalue &&
+                    buf[varid_prr][i+j*nlon] != info_tmp[varid_prr]->fillvalue)
+                  if ( newcurtas >= (K_TKELVIN + 1.5) ) {
+                    buf[varid_prr][i+j*nlon] += buf[varid_prsn][i+j*nlon];
+                    buf[varid_prsn][i+j*nlon] = 0.0;
+                  }
+          
+              /* Compute new infra-red radiation, if needed */
+              if (varid_rlds != -1)
+                if (buf[varid_rlds][i+j*nlon] != info_tmp[varid_rlds]->fillvalue)
+                  buf[varid_rlds][i+j*nlon] += (4.0 * delta[t] / curtas ) * buf[varid_rlds][i+j*nlon];
+            }
+          }
+  }
+
+  /* Calculate only known post-processed variables, each in its own task: they only read the corrected variables */
+  tasks = (output_var_task_struct *) malloc(obs_var->nobs_var * sizeof(output_var_task_struct));
+  if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+  for (var=0; var<obs_var->nobs_var; var++) {
+    tasks[var].day = day;
+    tasks[var].proj = NULL;
+    tasks[var].var = var;
+    tasks[var].istat = 0;
+    if ((var == varid_hur && !strcmp(obs_var->post[var], "yes")) ||
+        (var == varid_prtot && varid_prsn >= 0 && varid_prr >= 0) ||
+        (var == varid_etp && !strcmp(obs_var->post[var], "yes")))
+      (void) thread_pool_submit(ctx->var_pool, output_post_var, (void *) &(tasks[var]));
+  }
+  (void) thread_pool_wait(ctx->var_pool);
+  (void) free(tasks);
+}
+
+
+/** Calculate one post-processed variable of an analog day slice from the corrected variables. */
+static void
+output_post_var(void *arg) {
+  /**
+     @param[in,out]  arg  Task structure (output_var_task_struct)
+  */
+
+  output_var_task_struct *task = (output_var_task_struct *) arg; /* Task structure */
+  output_day_struct *day = task->day; /* Analog day slice */
+  output_ctx_struct *ctx = day->ctx; /* Data shared by all stages */
+  var_struct *obs_var = ctx->obs_var; /* Observation variables data structure */
+  double **buf = day->buf; /* Data buffer of each variable */
+  info_field_struct **info_tmp = day->info_tmp; /* Field information structure of each variable */
+  double *pmsl = ctx->pmsl; /* Standard Pressure of observation points */
+  double *buftmp = NULL; /* Temporary buffer for mean temperature */
+  int nlon = day->nlon; /* Longitude dimension */
+  int nlat = day->nlat; /* Latitude dimension */
+  int var = task->var; /* Variable index */
+  int i; /* Loop counter */
+
+  int varid_tas = ctx->varid_tas; /* Variable index ID */
+  int varid_tasmax = ctx->varid_tasmax; /* Variable index ID */
+  int varid_tasmin = ctx->varid_tasmin; /* Variable index ID */
+  int varid_prsn = ctx->varid_prsn; /* Variable index ID */
+  int varid_prr = ctx->varid_prr; /* Variable index ID */
+  int varid_rlds = ctx->varid_rlds; /* Variable index ID */
+  int varid_rsds = ctx->varid_rsds; /* Variable index ID */
+  int varid_hur = ctx->varid_hur; /* Variable index ID */
+  int varid_hus = ctx->varid_hus; /* Variable index ID */
+  int varid_etp = ctx->varid_etp; /* Variable index ID */
+  int varid_uvas = ctx->varid_uvas; /* Variable index ID */
+  int varid_prtot = ctx->varid_prtot; /* Variable index ID */
+
+  if (var == varid_hur) {
+    /* Relative humidity */
+    if ( !strcmp(obs_var->post[varid_hur], "yes") ) {
+      if ( varid_hus >= 0 && (varid_tas >= 0 || (varid_tasmax >= 0 && varid_tasmin >= 0 )) && pmsl != NULL ) {
+        /* Calculate relative humidity from temperature and specific humidity */
+        buf[varid_hur] = (double *) malloc(nlat*nlon * sizeof(double));
+        if (buf[varid_hur] == NULL) alloc_error(__FILE__, __LINE__);
+        if (varid_tas >= 0)
+          info_tmp[varid_hur]->fillvalue = info_tmp[varid_tas]->fillvalue;
+        else if (varid_tasmax >= 0)
+          info_tmp[varid_hur]->fillvalue = info_tmp[varid_tasmax]->fillvalue;
+        else
+          info_tmp[varid_hur]->fillvalue = -9999.0;
+        /* Create mean temperature temporary matrix when having only min and max temperature */
+        if (varid_tas < 0) {
+          buftmp = (double *) malloc(nlat*nlon* sizeof(double));
+          if (buftmp == NULL) alloc_error(__FILE__, __LINE__);
+          for (i=0; i<(nlon*nlat); i++)
+            if ((buf[varid_tasmax][i] != info_tmp[varid_tasmax]->fillvalue) &&
+                (buf[varid_tasmin][i] != info_tmp[varid_tasmin]->fillvalue))
+              buftmp[i] = (buf[varid_tasmax][i] + buf[varid_tasmin][i]) / 2.0;
+            else
+              buftmp[i] = info_tmp[varid_tasmax]->fillvalue;
+        }
+        else
+          buftmp = buf[varid_tas];
+        (void) spechum_to_hr(buf[varid_hur], buftmp, buf[varid_hus], pmsl, info_tmp[varid_hur]->fillvalue, nlon, nlat);
+        if (varid_tas < 0)
+          (void) free(buftmp);
+      }
+      else {
+        (void) fprintf(stderr, "%s: WARNING: Cannot calculate Relative Humidity because needed variables are not available: Specific Humidity; Averaged temperature or Min/Max temperature, Standard Pressure from altitude.\n", __FILE__);                
+        buf[varid_hur] = NULL;
+      }
+    }
+  }
+  else if (var == varid_prtot) {
+    /* Total precipitation */
+    if ( !strcmp(obs_var->post[varid_prtot], "yes") ) {
+      /* Calculate total precipitation from liquid and solid precipitation */
+        buf[varid_prtot] = (double *) malloc(nlat*nlon * sizeof(double));
+        if (buf[varid_prtot] == NULL) alloc_error(__FILE__, __LINE__);
+        info_tmp[varid_prtot]->fillvalue = info_tmp[varid_prr]->fillvalue;
+        for (i=0; i<(nlon*nlat); i++) {
+          if ( (buf[varid_prr][i] != info_tmp[varid_prr]->fillvalue) && (buf[varid_prsn][i] != info_tmp[varid_prsn]->fillvalue))
+            buf[varid_prtot][i] = buf[varid_prr][i] + buf[varid_prsn][i];
+          else
+            buf[varid_prtot][i] = info_tmp[varid_prtot]->fillvalue;
+        }
+      }
+    else {
+        (void) fprintf(stderr, "%s: WARNING: Cannot calculate Total Precipitation because needed variables are not available: Liquid and Solid Precipitation.\n", __FILE__);                
+        buf[varid_prtot] = NULL;
+    }
+  }
+  else if (var == varid_etp) {
+    /* ETP */
+    if ( !strcmp(obs_var->post[varid_etp], "yes") ) {
+      if ( varid_hus >= 0 && (varid_tas >= 0 || (varid_tasmax >= 0 && varid_tasmin >= 0 )) && varid_rsds >= 0 && varid_rlds >= 0 &&
+           varid_uvas >= 0 && pmsl != NULL ) {
+        /* Calculate ETP */
+        buf[varid_etp] = (double *) malloc(nlat*nlon * sizeof(double));
+        if (buf[varid_etp] == NULL) alloc_error(__FILE__, __LINE__);
+        if (varid_tas >= 0)
+          info_tmp[varid_etp]->fillvalue = info_tmp[varid_tas]->fillvalue;
+        else if (varid_tasmax >= 0)
+          info_tmp[varid_etp]->fillvalue = info_tmp[varid_tasmax]->fillvalue;
+        else
+          info_tmp[varid_etp]->fillvalue = -9999.0;
+        /* Create mean temperature temporary matrix when having only min and max temperature */
+        if (varid_tas < 0) {
+          buftmp = (double *) malloc(nlat*nlon* sizeof(double));
+          if (buftmp == NULL) alloc_error(__FILE__, __LINE__);
+          for (i=0; i<(nlon*nlat); i++) {
+            if ((buf[varid_tasmax][i] != info_tmp[varid_tasmax]->fillvalue) &&
+                (buf[varid_tasmin][i] != info_tmp[varid_tasmin]->fillvalue))
+              buftmp[i] = (buf[varid_tasmax][i] + buf[varid_tasmin][i]) / 2.0;
+            else
+              buftmp[i] = info_tmp[varid_tasmax]->fillvalue;
+          }
+        }
+        else
+          buftmp = buf[varid_tas];
+        (void) calc_etp_mf(buf[varid_etp], buftmp, buf[varid_hus], buf[varid_rsds], buf[varid_rlds], buf[varid_uvas],
+                           pmsl, info_tmp[varid_etp]->fillvalue, nlon, nlat);
+        if (varid_tas < 0)
+          (void) free(buftmp);
+      }
+      else {
+        (void) fprintf(stderr, "%s: WARNING: Cannot calculate ETP because needed variables are not available: Specific Humidity; Averaged Temperature or Min/Max Temperature; Short and Long Wave Radiation; Wind Module, Standard Pressure from altitude.\n", __FILE__);
+        buf[varid_etp] = NULL;
+      }
+    }
+  }
+}
+
+
+/** Average hourly data and compress the fields of an analog day slice to write, in parallel: the NetCDF library is not used. */
+static void
+output_encode_day(output_day_struct *day) {
+  /**
+     @param[in,out]  day  Analog day slice
+  */
+
+  output_var_task_struct *tasks = NULL; /* Per-variable tasks */
+  var_struct *obs_var = day->ctx->obs_var; /* Observation variables data structure */
+  int var; /* Variable counter */
+
+  tasks = (output_var_task_struct *) malloc(obs_var->nobs_var * sizeof(output_var_task_struct));
+  if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+
+  for (var=0; var<obs_var->nobs_var; var++) {
+    tasks[var].day = day;
+    tasks[var].proj = NULL;
+    tasks[var].var = var;
+    tasks[var].istat = 0;
+    if ( !strcmp(obs_var->output[var], "yes") && day->buf[var] != NULL )
+      (void) thread_pool_submit(day->ctx->var_pool, output_encode_var, (void *) &(tasks[var]));
+  }
+  (void) thread_pool_wait(day->ctx->var_pool);
+  (void) free(tasks);
+}
+
+
+/** Average hourly data of one observation variable and compress its field when it is complete. */
+static void
+output_encode_var(void *arg) {
+  /**
+     @param[in,out]  arg  Task structure (output_var_task_struct)
+  */
+
+  output_var_task_struct *task = (output_var_task_struct *) arg; /* Task structure */
+  output_day_struct *day = task->day; /* Analog day slice */
+  output_ctx_struct *ctx = day->ctx; /* Data shared by all stages */
+  var_struct *obs_var = ctx->obs_var; /* Observation variables data structure */
+  info_struct *info = ctx->info; /* General meta-data information structure */
+  int var = task->var; /* Variable index */
+  double *buf = day->buf[var]; /* Data buffer */
+  int i; /* Loop counter */
+
+  if ( !strcmp(info->timestep, obs_var->frequency) )
+    /* Output and input data are at same frequency */
+    day->ready[var] = TRUE;
+  else {
+    /* Input data is hourly and output is daily */
+    if (day->hour == ctx->maxh) {
+      /* Last hour of day */
+      for (i=0; i<day->nlon*day->nlat; i++)
+        /* Average data */
+        buf[i] = (ctx->bufsave[var][i] + buf[i]) / 24.0;
+      /* Free memory */
+      (void) free(ctx->bufsave[var]);
+      ctx->bufsave[var] = NULL;
+      day->ready[var] = TRUE;
+    }
+    else {
+      /* Allocate memory if first hour accumulating */
+      if (ctx->bufsave[var] == NULL) {
+        ctx->bufsave[var] = (double *) calloc(day->nlat*day->nlon, sizeof(double));
+        if (ctx->bufsave[var] == NULL) alloc_error(__FILE__, __LINE__);
+      }
+      /* Accumulate data to compute average when input data is hourly and output is daily */
+      for (i=0; i<day->nlon*day->nlat; i++)
+        ctx->bufsave[var][i] += buf[i];
+    }
+  }
+
+  /* Deflating is the costly part of writing: chunks are compressed here, while the writer holds the NetCDF lock */
+  if (day->ready[var] == TRUE && ctx->encode_pool != NULL && strcmp(day->proj->name, "list")) {
+    if (encode_netcdf_chunks_2d(&(day->chunks[var]), buf, day->info_tmp[var]->fillvalue, day->nlat, day->nlon,
+                                ctx->file_compression_level, &(obs_var->encoding[var]), ctx->encode_pool) == 0)
+      day->encoded[var] = TRUE;
+    else
+      (void) free_netcdf_chunks(&(day->chunks[var]));
+  }
+}
+
+
+/** Write all observation variables of an analog day slice. */
+static int
+output_write_day(output_day_struct *day) {
+  /**
+     @param[in,out]  day   Analog day slice
+
+     \return               Status.
+  */
+
+  output_var_task_struct task; /* Variable task */
+  var_struct *obs_var = day->ctx->obs_var; /* Observation variables data structure */
+  int var; /* Variable counter */
+
+  /* Days are written in order: all days of previous output year have been written */
+  if (day->ctx->checkpoint_prefix != NULL && day->year != day->ctx->checkpoint_year) {
+    if (day->ctx->checkpoint_year != -1)
+      (void) checkpoint_output_year(day->ctx->checkpoint_prefix, day->ctx->checkpoint_year);
+    day->ctx->checkpoint_year = day->year;
+  }
+
+  /* Write each variable */
+  for (var=0; var<obs_var->nobs_var; var++) {
+    if ( strcmp(obs_var->output[var], "yes") )
+      continue;
+    task.day = day;
+    task.proj = NULL;
+    task.var = var;
+    task.istat = 0;
+    (void) output_write_var(&task);
+    if (task.istat != 0) {
+      (void) fprintf(stderr, "%s: Fatal error: cannot write variable %s in file %s.\n", __FILE__,
+                     obs_var->netcdfname[var], day->outfile[var]);
+      return task.istat;
+    }
+  }
+
+  return 0;
+}
+
+
+/** Read one observation variable for an analog day, and apply factor and delta. */
+static void
+output_read_var(void *arg) {
+  /**
+     @param[in,out]  arg  Task structure (output_var_task_struct)
+  */
+
+  output_var_task_struct *task = (output_var_task_struct *) arg; /* Task structure */
+  output_day_struct *day = task->day; /* Analog day slice */
+  var_struct *obs_var = day->ctx->obs_var; /* Observation variables data structure */
+  int var = task->var; /* Variable index */
+  int i; /* Loop counter */
+
+  task->proj = (proj_struct *) malloc(sizeof(proj_struct));
+  if (task->proj == NULL) alloc_error(__FILE__, __LINE__);
+  task->proj->name = NULL;
+  task->proj->grid_mapping_name = NULL;
+
+  /* NetCDF library is not thread-safe */
+  (void) nc_io_lock();
+  task->istat = read_netcdf_var_3d_2d(&(day->buf[var]), day->info_tmp[var], task->proj, day->infile[var], obs_var->acronym[var],
+                                      obs_var->dimxname, obs_var->dimyname, obs_var->timename,
+                                      day->tl, &(task->nlon), &(task->nlat), &(task->ntime_file), day->ctx->debug);
+  (void) nc_io_unlock();
+  if (task->istat < 0)
+    return;
+
+  /* Apply factor and delta */
+  for (i=0; i<(task->nlon*task->nlat); i++)
+    day->buf[var][i] = (day->buf[var][i] * obs_var->factor[var]) + obs_var->delta[var];
+  /* Overwrite units and height if it was specified in configuration file. In that case, the value is not unknown. */
+  if ( strcmp(obs_var->units[var], "unknown")) {
+    (void) free(day->info_tmp[var]->units);
+    day->info_tmp[var]->units = strdup(obs_var->units[var]);
+  }
+  if ( strcmp(obs_var->height[var], "unknown")) {
+    (void) free(day->info_tmp[var]->height);
+    day->info_tmp[var]->height = strdup(obs_var->height[var]);
+  }
+}
+
+
+/** Write one observation variable for an analog day, once its field is complete. */
+static void
+output_write_var(output_var_task_struct *task) {
+  /**
+     @param[in,out]  task  Task structure of the variable
+  */
+
+  output_day_struct *day = task->day; /* Analog day slice */
+  output_ctx_struct *ctx = day->ctx; /* Data shared by all stages */
+  var_struct *obs_var = ctx->obs_var; /* Observation variables data structure */
+  info_struct *info = ctx->info; /* General meta-data information structure */
+  info_field_struct *info_tmp = day->info_tmp[task->var]; /* Field information structure */
+  double *buf = day->buf[task->var]; /* Data buffer */
+  int var = task->var; /* Variable index */
+  int newfile; /* If this is the first write in newly-created output file */
+
+  task->istat = 0;
+
+  /* New day: nothing written yet for it */
+  if (day->hour == ctx->minh)
+    ctx->written[var] = FALSE;
+  newfile = (day->newfile[var] == TRUE && ctx->written[var] == FALSE);
+
+  (void) nc_io_lock();
+
+  /* Write dimensions of field in newly-created NetCDF output file */
+  if (day->newfile[var] == TRUE && day->hour == ctx->minh && buf != NULL) {
+    /* We just created output file: we need to write dimensions */
+    task->istat = write_netcdf_dims_3d(ctx->lon, ctx->lat, ctx->x, ctx->y, ctx->alt, &(day->timeval), ctx->cal_type,
+                                       ctx->time_units, day->nlon, day->nlat, 0,
+                                       info->timestep, obs_var->proj->name, obs_var->proj->coords,
+                                       obs_var->proj->grid_mapping_name, obs_var->proj->latin1,
+                                       obs_var->proj->latin2, obs_var->proj->lonc, obs_var->proj->lat0,
+                                       obs_var->proj->false_easting, obs_var->proj->false_northing,
+                                       obs_var->proj->lonpole, obs_var->proj->latpole,
+                                       obs_var->lonname, obs_var->latname, obs_var->dimxname, obs_var->dimyname,
+                                       obs_var->timename, day->outfile[var], ctx->debug);
+  }
+
+  /* Hourly data being averaged to daily is written with the last hour of the day */
+  if (task->istat == 0 && day->ready[var] == TRUE) {
+    if (newfile == TRUE && day->hour == ctx->minh)
+      (void) fprintf(stderr, "%s: Writing data to %s\n", __FILE__, day->outfile[var]);
+    /* Write data */
+    task->istat = write_netcdf_var_3d_2d(buf, &(day->curtime), info_tmp->fillvalue, day->outfile[var], obs_var->netcdfname[var],
+                                         info_tmp->long_name, info_tmp->units, info_tmp->height, day->proj->name,
+                                         obs_var->dimxname, obs_var->dimyname, obs_var->timename,
+                                         0, newfile, ctx->file_format, ctx->file_compression_level,
+                                         day->nlon, day->nlat, day->ntime_file, &(obs_var->encoding[var]),
+                                         (day->encoded[var] == TRUE) ? &(day->chunks[var]) : (nc_chunks_struct *) NULL, ctx->debug);
+    ctx->written[var] = TRUE;
+  }
+
+  (void) nc_io_unlock();
+}
+
+
+/** Transformer stage of output pipeline: apply corrections to analog day slices, compress them and pass them to writer stage. */
+static void
+output_transform_stage(void *arg) {
+  /**
+     @param[in,out]  arg  Pipeline structure (output_pipeline_struct)
+  */
+
+  output_pipeline_struct *pipe = (output_pipeline_struct *) arg; /* Pipeline structure */
+  output_day_struct *day = NULL; /* Analog day slice */
+
+  while ((day = (output_day_struct *) bounded_queue_pop(pipe->transform_queue)) != NULL) {
+    (void) output_correct_day(day);
+    (void) output_encode_day(day);
+    if (bounded_queue_push(pipe->write_queue, (void *) day) != 0)
+      /* Writer stage failed */
+      (void) output_free_day(day);
+  }
+  (void) bounded_queue_close(pipe->write_queue);
+}
+
+
+/** Writer stage of output pipeline: write analog day slices in order. */
+static void
+output_write_stage(void *arg) {
+  /**
+     @param[in,out]  arg  Pipeline structure (output_pipeline_struct)
+  */
+
+  output_pipeline_struct *pipe = (output_pipeline_struct *) arg; /* Pipeline structure */
+  output_day_struct *day = NULL; /* Analog day slice */
+  int istat; /* Diagnostic status */
+
+  while ((day = (output_day_struct *) bounded_queue_pop(pipe->write_queue)) != NULL) {
+    if (pipe->istat == 0) {
+      istat = output_write_day(day);
+      if (istat != 0) {
+        /* Stop reader and transformer stages */
+        pipe->istat = istat;
+        (void) bounded_queue_close(pipe->transform_queue);
+        (void) bounded_queue_close(pipe->write_queue);
+      }
+    }
+    (void) output_free_day(day);
+  }
+}
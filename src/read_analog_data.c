@@ -91,6 +91,7 @@ read_analog_data(analog_day_struct *analog_days, double **delta, double **time_l
   size_t count[1]; /* Count of elements to read */
   size_t ntime; /* Time dimension length */
 
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_open(filename, NC_NOWRITE, &ncinid);  /* open for reading */
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
@@ -62,6 +62,30 @@ LICENSE END */
 
 #include <dsclim.h>
 
+/** Date key of a timestep and its index in the input file. */
+typedef struct {
+  int key; /**< Date key year*10000+month*100+day */
+  int index; /**< Time index in input file */
+} date_key_struct;
+
+/** Compare two date keys, ties sorted by time index so that the first matching timestep is kept. */
+static int
+compare_date_key(const void *a, const void *b) {
+  /**
+     @param[in]  a  First date key.
+     @param[in]  b  Second date key.
+
+     \return       Comparison result for qsort.
+  */
+
+  const date_key_struct *da = (const date_key_struct *) a;
+  const date_key_struct *db = (const date_key_struct *) b;
+
+  if (da->key != db->key)
+    return (da->key < db->key) ? -1 : 1;
+  return (da->index < db->index) ? -1 : ((da->index > db->index) ? 1 : 0);
+}
+
 /** Read NetCDF field and extract subdomain and subperiod. */
 int
 read_field_subdomain_period(double **buffer, double **lon, double **lat, double *missing_value, char *varname,
@@ -98,9 +122,6 @@ read_field_subdomain_period(double **buffer, double **lon, double **lat, double
 
   int istat; /* Diagnostic status */
   info_struct *info;
-  info_field_struct *info_field;
-  double *buf_total = NULL;
-  double *buf_sub = NULL;
   double *time_ls = NULL; /* Temporary time information buffer */
   time_vect_struct *time_s = NULL;
   char *cal_type = NULL; /* Calendar type (udunits) */
@@ -110,12 +131,21 @@ read_field_subdomain_period(double **buffer, double **lon, double **lat, double
   int ntime_file; /* Number of times dimension in input file */
   int nlon_file;
   int nlat_file;
-  int ntime_sub;
+  int ntime_sub; /* Number of matched dates */
+
+  date_key_struct *keys = NULL; /* Sorted date keys of input file */
+  int *tmatch = NULL; /* Matched time indexes in input file, in subperiod order */
+  size_t *tstart = NULL; /* First time index of each run of consecutive matched timesteps */
+  size_t *tcount = NULL; /* Number of timesteps of each run */
+  int nruns; /* Number of runs */
+  subdomain_struct subdomain; /* Index ranges of the subdomain */
+  int key; /* Date key to search */
+  int lo; /* Binary search lower bound */
+  int hi; /* Binary search upper bound */
+  int mid; /* Binary search middle */
 
   int nt;
   int tt;
-  int i;
-  int j;
 
   *lon = NULL;
   *lat = NULL;
@@ -126,9 +156,6 @@ read_field_subdomain_period(double **buffer, double **lon, double **lat, double
   info = (info_struct *) malloc(sizeof(info_struct));
   if (info == NULL) alloc_error(__FILE__, __LINE__);
 
-  info_field = (info_field_struct *) malloc(sizeof(info_field_struct));
-  if (info_field == NULL) alloc_error(__FILE__, __LINE__);
-
   time_s = (time_vect_struct *) malloc(sizeof(time_vect_struct));
   if (time_s == NULL) alloc_error(__FILE__, __LINE__);
 
@@ -143,70 +170,40 @@ read_field_subdomain_period(double **buffer, double **lon, double **lat, double
   /* Compute time information */
   istat = compute_time_info(time_s, time_ls, time_units, cal_type, ntime_file);
 
-  /* Loop over time */
+  /* Sort dates of input file so that each date of the subperiod is found with a binary search */
+  keys = (date_key_struct *) malloc(ntime_file * sizeof(date_key_struct));
+  if (keys == NULL) alloc_error(__FILE__, __LINE__);
+  for (tt=0; tt<ntime_file; tt++) {
+    keys[tt].key = time_s->year[tt] * 10000 + time_s->month[tt] * 100 + time_s->day[tt];
+    keys[tt].index = tt;
+  }
+  (void) qsort(keys, (size_t) ntime_file, sizeof(date_key_struct), compare_date_key);
+
+  /* Match dates of subperiod, keeping subperiod order */
+  tmatch = (int *) malloc(ntime * sizeof(int));
+  if (tmatch == NULL) alloc_error(__FILE__, __LINE__);
   ntime_sub = 0;
   for (nt=0; nt<ntime; nt++) {
-    /* Search in all second time vector times for matching date */
-    for (tt=0; tt<ntime_file; tt++) {
-      if (year[nt]  == time_s->year[tt] &&
-          month[nt] == time_s->month[tt] &&
-          day[nt]   == time_s->day[tt]) {
-        /* Found common date, process it. */
-        istat = read_netcdf_var_3d_2d(&buf_total, info_field, (proj_struct *) NULL, filename, varname, dimxname, dimyname, timename,
-                                      tt, nlon, nlat, &ntime_file, FALSE);
-        /* Free non-needed variables */
-        (void) free(info_field->coordinates);
-        (void) free(info_field->grid_mapping);
-        (void) free(info_field->units);
-        (void) free(info_field->height);
-        (void) free(info_field->long_name);
-        if (istat != 0) {
-          /* In case of failure */
-          (void) free(buf_total);
-          (void) free(lon_total);
-          (void) free(lat_total);
-          (void) free(time_ls);
-          (void) free(time_units);
-          (void) free(cal_type);
-          (void) free(time_s->year);
-          (void) free(time_s->month);
-          (void) free(time_s->day);
-          (void) free(time_s->hour);
-          (void) free(time_s->minutes);
-          (void) free(time_s->seconds);
-          (void) free(time_s);
-          (void) free(info_field);
-          return istat;
-        }
-        *missing_value = info_field->fillvalue;
-        
-        /* Extract subdomain */
-        if ((*lat) != NULL)
-          (void) free(*lat);
-        if ((*lon) != NULL)
-          (void) free(*lon);
-        (void) extract_subdomain(&buf_sub, lon, lat, nlon, nlat, buf_total, lon_total, lat_total,
-                                 lonmin, lonmax, latmin, latmax, nlon_file, nlat_file, 1);
-        (void) free(buf_total);
-
-        /* Store into output field */
-        (*buffer) = realloc((*buffer), (*nlon)*(*nlat)*(ntime_sub+1) * sizeof(double));
-        if ((*buffer) == NULL) alloc_error(__FILE__, __LINE__);
-        for (j=0; j<(*nlat); j++)
-          for (i=0; i<(*nlon); i++)
-            (*buffer)[i+j*(*nlon)+(ntime_sub)*(*nlon)*(*nlat)] = buf_sub[i+j*(*nlon)];
-
-        (void) free(buf_sub);
-        
-        ntime_sub++;
-
-        break;
-      }
+    key = year[nt] * 10000 + month[nt] * 100 + day[nt];
+    lo = 0;
+    hi = ntime_file;
+    while (lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      if (keys[mid].key < key)
+        lo = mid + 1;
+      else
+        hi = mid;
     }
+    if (lo < ntime_file && keys[lo].key == key)
+      tmatch[ntime_sub++] = keys[lo].index;
   }
+  (void) free(keys);
 
-  if (*nlat == -1 || *nlon == -1) {
+  if (ntime_sub == 0) {
     /* In case of failure */
+    (void) fprintf(stderr, "%s: Cannot find any date!! Dates we try to find:: At index 0: %d %d %d, at last index: %d %d %d. Dates we are searching in (in the file):: At index 0: %d %d %d, at last index: %d %d %d. \n", __FILE__, year[0], month[0], day[0], year[ntime-1], month[ntime-1], day[ntime-1], time_s->year[0], time_s->month[0], time_s->day[0], time_s->year[ntime_file-1], time_s->month[ntime_file-1], time_s->day[ntime_file-1]);
+
+    (void) free(tmatch);
     (void) free(lon_total);
     (void) free(lat_total);
     (void) free(time_ls);
@@ -219,13 +216,42 @@ read_field_subdomain_period(double **buffer, double **lon, double **lat, double
     (void) free(time_s->minutes);
     (void) free(time_s->seconds);
     (void) free(time_s);
-    (void) free(info_field);
-    
-    (void) fprintf(stderr, "%s: Cannot find any date!! Dates we try to find:: At index 0: %d %d %d, at last index: %d %d %d. Dates we are searching in (in the file):: At index 0: %d %d %d, at last index: %d %d %d. \n", __FILE__, year[0], month[0], day[0], year[ntime-1], month[ntime-1], day[ntime-1], time_s->year[0], time_s->month[0], time_s->day[0], time_s->year[ntime_file-1], time_s->month[ntime_file-1], time_s->day[ntime_file-1]);
 
     return -1;
   }
 
+  /* Group matched timesteps into runs of consecutive time indexes */
+  tstart = (size_t *) malloc(ntime_sub * sizeof(size_t));
+  if (tstart == NULL) alloc_error(__FILE__, __LINE__);
+  tcount = (size_t *) malloc(ntime_sub * sizeof(size_t));
+  if (tcount == NULL) alloc_error(__FILE__, __LINE__);
+  nruns = 0;
+  for (nt=0; nt<ntime_sub; nt++) {
+    if (nruns > 0 && tmatch[nt] == (int) (tstart[nruns-1] + tcount[nruns-1]))
+      tcount[nruns-1]++;
+    else {
+      tstart[nruns] = (size_t) tmatch[nt];
+      tcount[nruns] = 1;
+      nruns++;
+    }
+  }
+  (void) free(tmatch);
+
+  /* Compute subdomain index ranges and coordinates */
+  (void) get_subdomain_index(&subdomain, lon, lat, lon_total, lat_total, lonmin, lonmax, latmin, latmax, nlon_file, nlat_file);
+  *nlon = subdomain.nlon;
+  *nlat = subdomain.nlat;
+
+  /* Read subdomain of all matched timesteps, one hyperslab per run */
+  (*buffer) = (double *) malloc((size_t) (*nlon) * (size_t) (*nlat) * (size_t) ntime_sub * sizeof(double));
+  if ((*buffer) == NULL) alloc_error(__FILE__, __LINE__);
+  istat = read_netcdf_var_3d_range(*buffer, missing_value, filename, varname, &subdomain, tstart, tcount, nruns,
+                                   nlon_file, nlat_file);
+
+  (void) free_subdomain_index(&subdomain);
+  (void) free(tstart);
+  (void) free(tcount);
+
   (void) free(lon_total);
   (void) free(lat_total);
 
@@ -241,7 +267,12 @@ read_field_subdomain_period(double **buffer, double **lon, double **lat, double
   (void) free(time_units);
   (void) free(cal_type);
 
-  (void) free(info_field);
+  if (istat != 0) {
+    /* In case of failure */
+    (void) free(*buffer);
+    *buffer = NULL;
+    return istat;
+  }
 
   /* Diagnostic status */
   return 0;
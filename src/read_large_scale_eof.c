@@ -73,7 +73,7 @@ read_large_scale_eof(data_struct *data) {
   int istat; /* Diagnostic status */
   int i; /* Loop counter */
   int cat; /* Field category loop counter */
-  double *buf = NULL; /* Temporary buffer for reading */
+  subdomain_struct subdomain; /* Index ranges of the subdomain to read */
   double *lat = NULL; /* Temporary buffer for latitudes */
   double *lon = NULL; /* Temporary buffer for longitudes */
   int nlon; /* Longitude dimension */
@@ -87,6 +87,9 @@ read_large_scale_eof(data_struct *data) {
   proj_eof.name = (char *) NULL;
   proj_eof.grid_mapping_name = (char *) NULL;
 
+  subdomain.lon_start = subdomain.lon_count = NULL;
+  subdomain.lat_start = subdomain.lat_count = NULL;
+
   /* Loop over large-scale field categories (control and model run) */
   for (cat=0; cat<2; cat++) {
     /* Loop over large-scale fields */
@@ -114,14 +117,28 @@ read_large_scale_eof(data_struct *data) {
           proj_eof.eof_coords = strdup(data->field[cat].proj[i].coords);
           proj_eof.name = strdup(data->field[cat].proj[i].name);
           proj_eof.grid_mapping_name = strdup(data->field[cat].proj[i].grid_mapping_name);
+
+          /* Resolve subdomain bounds to index ranges, so that only the subdomain is read */
+          (void) free_subdomain_index(&subdomain);
+          (void) get_subdomain_index(&subdomain, &(data->field[cat].lon_eof_ls), &(data->field[cat].lat_eof_ls), lon, lat,
+                                     data->conf->longitude_min, data->conf->longitude_max,
+                                     data->conf->latitude_min, data->conf->latitude_max, nlon, nlat);
+          data->field[cat].nlon_eof_ls = subdomain.nlon;
+          data->field[cat].nlat_eof_ls = subdomain.nlat;
         }
       
-        /* Read EOF */
-        istat = read_netcdf_var_3d(&buf, data->field[cat].data[i].eof_info->info, &proj_eof,
-                                   data->field[cat].data[i].eof_info->eof_filein_ls,
-                                   data->field[cat].data[i].eof_data->eof_nomvar_ls,
-                                   data->conf->dimxname_eof, data->conf->dimyname_eof,
-                                   data->conf->eofname, &nlon_file, &nlat_file, &neof_file, TRUE);
+        /* Free memory if needed because of loop */
+        if (data->field[cat].data[i].eof_data->eof_ls != NULL) {
+          (void) free(data->field[cat].data[i].eof_data->eof_ls);
+          data->field[cat].data[i].eof_data->eof_ls = NULL;
+        }
+
+        /* Read EOF over subdomain */
+        istat = read_netcdf_var_3d_subdomain(&(data->field[cat].data[i].eof_data->eof_ls), data->field[cat].data[i].eof_info->info,
+                                             &proj_eof, data->field[cat].data[i].eof_info->eof_filein_ls,
+                                             data->field[cat].data[i].eof_data->eof_nomvar_ls,
+                                             data->conf->dimxname_eof, data->conf->dimyname_eof,
+                                             data->conf->eofname, &subdomain, &nlon_file, &nlat_file, &neof_file, TRUE);
         if (nlon != nlon_file || nlat != nlat_file) {
           (void) fprintf(stderr, "%s: Problems in dimensions! nlat=%d nlat_file=%d nlon=%d nlon_file=%d\n",
                          __FILE__, nlat, nlat_file, nlon, nlon_file);
@@ -136,9 +153,11 @@ read_large_scale_eof(data_struct *data) {
         }
         if (istat != 0) {
           /* In case of failure */
-          (void) free(buf);
+          (void) free(data->field[cat].data[i].eof_data->eof_ls);
+          data->field[cat].data[i].eof_data->eof_ls = NULL;
           (void) free(lon);
           (void) free(lat);
+          (void) free_subdomain_index(&subdomain);
           if (proj_eof.eof_coords != NULL)
             (void) free(proj_eof.eof_coords);
           if (proj_eof.name != NULL)
@@ -148,28 +167,6 @@ read_large_scale_eof(data_struct *data) {
           return istat;
         }
       
-        /** Extract subdomain **/
-        /* Free memory if needed because of loop. Set pointers to NULL for realloc. */
-        if (data->field[cat].lon_eof_ls != NULL) {
-          (void) free(data->field[cat].lon_eof_ls);
-          data->field[cat].lon_eof_ls = NULL;
-        }
-        if (data->field[cat].lat_eof_ls != NULL) {
-          (void) free(data->field[cat].lat_eof_ls);
-          data->field[cat].lat_eof_ls = NULL;
-        }
-        if (data->field[cat].data[i].eof_data->eof_ls != NULL) {
-          (void) free(data->field[cat].data[i].eof_data->eof_ls);
-          data->field[cat].data[i].eof_data->eof_ls = NULL;
-        }
-        /* Extraction */
-        (void) extract_subdomain(&(data->field[cat].data[i].eof_data->eof_ls), &(data->field[cat].lon_eof_ls),
-                                 &(data->field[cat].lat_eof_ls),
-                                 &(data->field[cat].nlon_eof_ls), &(data->field[cat].nlat_eof_ls), buf, lon, lat,
-                                 data->conf->longitude_min, data->conf->longitude_max, data->conf->latitude_min, data->conf->latitude_max,
-                                 nlon, nlat, data->field[cat].data[i].eof_info->neof_ls);
-        (void) free(buf);
-        
         /* Print missing value */
         printf("%s: EOF missing_value = %lf\n", __FILE__, (double) data->field[cat].data[i].eof_info->info->fillvalue);
       
@@ -187,6 +184,7 @@ read_large_scale_eof(data_struct *data) {
           /* In case of failure */
           (void) free(lon);
           (void) free(lat);
+          (void) free_subdomain_index(&subdomain);
           if (proj_eof.eof_coords != NULL)
             (void) free(proj_eof.eof_coords);
           if (proj_eof.name != NULL)
@@ -215,6 +213,8 @@ read_large_scale_eof(data_struct *data) {
         proj_eof.grid_mapping_name = NULL;
       }
     }
+    /* Free index ranges of the subdomain of this category */
+    (void) free_subdomain_index(&subdomain);
   }
   
   /* Diagnostic status */
@@ -57,10 +57,60 @@ LICENSE END */
 
 
 
+#include <dsclim.h>
 
+/** Read of one large-scale field, executed in the background while previous fields are processed. */
+typedef struct {
+  data_struct *data; /**< MASTER data structure. */
+  int cat; /**< Field category. */
+  int i; /**< Large-scale field index. */
+  subdomain_struct *subdomain; /**< Index ranges of the subdomain to read. */
+  double *buf; /**< Field data read, NULL until read. */
+  float *buf_f; /**< Field data read in single precision if requested for the category, NULL until read. */
+  int nlon_file; /**< Longitude dimension in input file. */
+  int nlat_file; /**< Latitude dimension in input file. */
+  int ntime_file; /**< Time dimension in input file. */
+  prefetch_item_struct *item; /**< Prefetch read item. */
+} field_read_struct;
+
+/** Read the subdomain of one large-scale field. */
+static int
+read_large_scale_field_data(void *arg, size_t *nbytes) {
+  /**
+     @param[in]  arg     Field read structure.
+     @param[out] nbytes  Number of bytes allocated.
 
+     \return             Status.
+  */
 
-#include <dsclim.h>
+  field_read_struct *read = (field_read_struct *) arg; /* Field read */
+  field_struct *field = &(read->data->field[read->cat]); /* Field category */
+  int istat; /* Diagnostic status */
+
+  /* The NetCDF library is not thread-safe */
+  (void) nc_io_lock();
+  if (field->single_precision == TRUE)
+    /* Fields kept in single precision are never held in double precision */
+    istat = read_netcdf_var_3d_subdomain_f(&(read->buf_f), field->data[read->i].info, &(field->proj[read->i]),
+                                           field->data[read->i].filename_ls, field->data[read->i].nomvar_ls,
+                                           field->data[read->i].dimxname, field->data[read->i].dimyname,
+                                           field->data[read->i].timename, read->subdomain,
+                                           &(read->nlon_file), &(read->nlat_file), &(read->ntime_file), TRUE);
+  else
+    istat = read_netcdf_var_3d_subdomain(&(read->buf), field->data[read->i].info, &(field->proj[read->i]),
+                                         field->data[read->i].filename_ls, field->data[read->i].nomvar_ls,
+                                         field->data[read->i].dimxname, field->data[read->i].dimyname,
+                                         field->data[read->i].timename, read->subdomain,
+                                         &(read->nlon_file), &(read->nlat_file), &(read->ntime_file), TRUE);
+  (void) nc_io_unlock();
+
+  if (read->buf != NULL)
+    *nbytes = (size_t) read->nlon_file * (size_t) read->nlat_file * (size_t) read->ntime_file * sizeof(double);
+  else if (read->buf_f != NULL)
+    *nbytes = (size_t) read->nlon_file * (size_t) read->nlat_file * (size_t) read->ntime_file * sizeof(float);
+
+  return istat;
+}
 
 /** Read large-scale fields data from input files. Currently only NetCDF is implemented. */
 int
@@ -71,12 +121,18 @@ read_large_scale_fields(data_struct *data) {
      \return           Status.
   */
 
-  int istat; /* Diagnostic status */
+  int istat = 0; /* Diagnostic status */
   int i; /* Loop counter */
   int t; /* Time loop counter */
+  int npts; /* Number of values of a large-scale field */
   int cat; /* Field category loop counter */
-  double *buf = NULL; /* Temporary data buffer */
-  double *time_ls = NULL; /* Temporary time information buffer */
+  int nreads; /* Number of large-scale fields to read */
+  int r; /* Field read loop counter */
+  field_read_struct *reads = NULL; /* Reads of all large-scale fields */
+  field_read_struct *read = NULL; /* Current field read */
+  prefetch_struct *prefetch = NULL; /* Background reads of large-scale fields */
+  subdomain_struct subdomain[NCAT]; /* Index ranges of the subdomain to read for each field category */
+  double *time_ls[NCAT]; /* Temporary time information buffer for each field category */
   double *lat = NULL; /* Temporary latitude buffer for main large-scale fields */
   double *lon = NULL; /* Temporary longitude buffer for main large-scale fields */
   char **cal_type; /* Calendar type (udunits) */
@@ -85,12 +141,9 @@ read_large_scale_fields(data_struct *data) {
   double longitude_max; /* Domain bounding box maximum longitude */
   double latitude_min; /* Domain bounding box minimum latitude */
   double latitude_max; /* Domain bounding box maximum latitude */
-  int ntime; /* Number of times dimension */
-  int nlon; /* Longitude dimension for main large-scale fields */
-  int nlat; /* Latitude dimension for main large-scale fields */
-  int ntime_file; /* Number of times dimension in input file */
-  int nlon_file; /* Longitude dimension for main large-scale fields in input file */
-  int nlat_file; /* Latitude dimension for main large-scale fields in input file */
+  int ntime[NCAT]; /* Number of times dimension */
+  int nlon[NCAT]; /* Longitude dimension for main large-scale fields */
+  int nlat[NCAT]; /* Latitude dimension for main large-scale fields */
   
   int year_begin; /* When fixing time units, year to use as start date. */
 
@@ -99,11 +152,21 @@ read_large_scale_fields(data_struct *data) {
   time_units = (char **) malloc(NCAT * sizeof(char *));
   if (time_units == NULL) alloc_error(__FILE__, __LINE__);
 
-  /* Loop over all large-scale field categories */
+  nreads = 0;
   for (cat=0; cat<NCAT; cat++) {
-
     cal_type[cat] = NULL;
     time_units[cat] = NULL;
+    time_ls[cat] = NULL;
+    subdomain[cat].lon_start = subdomain[cat].lon_count = NULL;
+    subdomain[cat].lat_start = subdomain[cat].lat_count = NULL;
+    nreads += data->field[cat].n_ls;
+  }
+  reads = (field_read_struct *) malloc((nreads > 0 ? nreads : 1) * sizeof(field_read_struct));
+  if (reads == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* First retrieve dimensions and subdomain of all large-scale field categories, */
+  /* so that all field reads can be queued before processing the first one */
+  for (cat=0; cat<NCAT && istat == 0; cat++) {
 
     /* Select proper domain given large-scale field category */
     if (cat == 0 || cat == 1) {
@@ -133,205 +196,195 @@ read_large_scale_fields(data_struct *data) {
       data->field[cat].lon_ls = NULL;
     }
 
-    /* Loop over large-scale fields */
-    for (i=0; i<data->field[cat].n_ls; i++) {
-      /* Retrieve dimensions if time buffer is not already set for this field category */
-      if (data->field[cat].time_ls == NULL) {
-        istat = read_netcdf_dims_3d(&lon, &lat, &time_ls, &(cal_type[cat]), &(time_units[cat]), &nlon, &nlat, &ntime,
-                                    data->info, data->field[cat].proj[i].coords, data->field[cat].proj[i].name,
-                                    data->field[cat].data[i].lonname, data->field[cat].data[i].latname,
-                                    data->field[cat].data[i].dimxname, data->field[cat].data[i].dimyname,
-                                    data->field[cat].data[i].timename,
-                                    data->field[cat].data[i].filename_ls);
-        if (istat < 0) {
-          /* In case of failure */
-          (void) free(lon);
-          (void) free(lat);
-          (void) free(time_ls);
-          (void) free(time_units[cat]);
-          (void) free(cal_type[cat]);
-          return istat;
-        }
-        /* Adjust time units if we want to fix time (set in the configuration file) */
-        if (data->conf->fixtime == TRUE) {
-          if (cat == FIELD_LS || cat == SEC_FIELD_LS)
-            year_begin = data->conf->year_begin_other;
-          else
-            year_begin = data->conf->year_begin_ctrl;
-          if (istat != 1) {
-            (void) fprintf(stderr, "\n%s: IMPORTANT WARNING: Time variable values all zero!!! Fixing time variable to index value, STARTING at 0...\n\n", __FILE__);
-            for (t=0; t<ntime; t++)
-              time_ls[t] = (double) t;
-          }
-          (void) fprintf(stdout, "%s: Fixing time units using start date %d-01-01 12:00:00.\n", __FILE__, year_begin);
-          time_units[cat] = realloc(time_units[cat], 500 * sizeof(char));
-          if (time_units[cat] == NULL) alloc_error(__FILE__, __LINE__);
-          /* days since 1950-01-01 12:00:00 */
-          (void) sprintf(time_units[cat], "days since %d-01-01 12:00:00", year_begin);
+    /* Retrieve dimensions from the first large-scale field of this category */
+    if (data->field[cat].n_ls > 0) {
+      i = 0;
+      istat = read_netcdf_dims_3d(&lon, &lat, &(time_ls[cat]), &(cal_type[cat]), &(time_units[cat]), &(nlon[cat]), &(nlat[cat]),
+                                  &(ntime[cat]), data->info, data->field[cat].proj[i].coords, data->field[cat].proj[i].name,
+                                  data->field[cat].data[i].lonname, data->field[cat].data[i].latname,
+                                  data->field[cat].data[i].dimxname, data->field[cat].data[i].dimyname,
+                                  data->field[cat].data[i].timename,
+                                  data->field[cat].data[i].filename_ls);
+      if (istat < 0) {
+        /* In case of failure */
+        (void) free(lon);
+        (void) free(lat);
+        lon = lat = NULL;
+        break;
+      }
+      /* Adjust time units if we want to fix time (set in the configuration file) */
+      if (data->conf->fixtime == TRUE) {
+        if (cat == FIELD_LS || cat == SEC_FIELD_LS)
+          year_begin = data->conf->year_begin_other;
+        else
+          year_begin = data->conf->year_begin_ctrl;
+        if (istat != 1) {
+          (void) fprintf(stderr, "\n%s: IMPORTANT WARNING: Time variable values all zero!!! Fixing time variable to index value, STARTING at 0...\n\n", __FILE__);
+          for (t=0; t<ntime[cat]; t++)
+            time_ls[cat][t] = (double) t;
         }
+        (void) fprintf(stdout, "%s: Fixing time units using start date %d-01-01 12:00:00.\n", __FILE__, year_begin);
+        time_units[cat] = realloc(time_units[cat], 500 * sizeof(char));
+        if (time_units[cat] == NULL) alloc_error(__FILE__, __LINE__);
+        /* days since 1950-01-01 12:00:00 */
+        (void) sprintf(time_units[cat], "days since %d-01-01 12:00:00", year_begin);
       }
+      istat = 0;
 
-      /* For standard calendar data */
-      if ( !strcmp(cal_type[cat], "gregorian") || !strcmp(cal_type[cat], "standard") ) {
-        
-        /* Read data */
-        istat = read_netcdf_var_3d(&buf, data->field[cat].data[i].info, &(data->field[cat].proj[i]),
-                                   data->field[cat].data[i].filename_ls,
-                                   data->field[cat].data[i].nomvar_ls,
-                                   data->field[cat].data[i].dimxname, data->field[cat].data[i].dimyname, data->field[cat].data[i].timename,
-                                   &nlon_file, &nlat_file, &ntime_file, TRUE);
-        if (nlon != nlon_file || nlat != nlat_file || ntime != ntime_file) {
-          (void) fprintf(stderr, "%s: Problems in dimensions! nlat=%d nlat_file=%d nlon=%d nlon_file=%d ntime=%d ntime_file=%d\n",
-                         __FILE__, nlat, nlat_file, nlon, nlon_file, ntime, ntime_file);
-          istat = -1;
-        }
-        if (istat != 0) {
-          /* In case of failure */
-          (void) free(buf);
-          (void) free(lon);
-          (void) free(lat);
-          (void) free(time_ls);
-          (void) free(time_units[cat]);
-          (void) free(cal_type[cat]);
-          return istat;
-        }
-        
-        /* Extract subdomain of spatial fields */
-        if (data->field[cat].lon_ls != NULL) {
-          (void) free(data->field[cat].lon_ls);
-          data->field[cat].lon_ls = NULL;
-        }
-        if (data->field[cat].lat_ls != NULL) {
-          (void) free(data->field[cat].lat_ls);
-          data->field[cat].lat_ls = NULL;
-        }
-        if (data->field[cat].data[i].field_ls != NULL) {
-          (void) free(data->field[cat].data[i].field_ls);
-          data->field[cat].data[i].field_ls = NULL;
-        }
+      /* Resolve subdomain bounds to index ranges, so that only the subdomain is read */
+      (void) get_subdomain_index(&(subdomain[cat]), &(data->field[cat].lon_ls), &(data->field[cat].lat_ls), lon, lat,
+                                 longitude_min, longitude_max, latitude_min, latitude_max, nlon[cat], nlat[cat]);
+      data->field[cat].nlon_ls = subdomain[cat].nlon;
+      data->field[cat].nlat_ls = subdomain[cat].nlat;
+      (void) free(lon);
+      (void) free(lat);
+      lon = lat = NULL;
+    }
+  }
 
-        /* Extraction of subdomain */
-        (void) extract_subdomain(&(data->field[cat].data[i].field_ls), &(data->field[cat].lon_ls), &(data->field[cat].lat_ls),
-                                 &(data->field[cat].nlon_ls), &(data->field[cat].nlat_ls), buf, lon, lat,
-                                 longitude_min, longitude_max, latitude_min, latitude_max, nlon, nlat, ntime);
-        (void) free(buf);
-
-        /* Save number of times dimension */
-        data->field[cat].ntime_ls = ntime;
-
-        /* If time info not already retrieved for this category, get time information and generate time structure */
-        if (data->field[cat].time_ls == NULL) {
-          data->field[cat].time_ls = (double *) malloc(data->field[cat].ntime_ls * sizeof(double));
-          if (data->field[cat].time_ls == NULL) alloc_error(__FILE__, __LINE__);
-          if ( strcmp(time_units[cat], data->conf->time_units) )
-            (void) change_date_origin(data->field[cat].time_ls, data->conf->time_units, time_ls, time_units[cat], ntime);
-          else
-            for (t=0; t<data->field[cat].ntime_ls; t++)
-              data->field[cat].time_ls[t] = time_ls[t];
-          istat = compute_time_info(data->field[cat].time_s, data->field[cat].time_ls, data->conf->time_units, data->conf->cal_type,
-                                    data->field[cat].ntime_ls);
-        }
-      }
-      else {
-        /* Non-standard calendar type */
+  /* Queue the reads of all large-scale fields: each field is read in the background while the previous ones are processed */
+  prefetch = prefetch_create((size_t) data->conf->prefetch_memory * 1024 * 1024);
+  nreads = 0;
+  for (cat=0; cat<NCAT && istat == 0; cat++)
+    for (i=0; i<data->field[cat].n_ls; i++) {
+      read = &(reads[nreads++]);
+      read->data = data;
+      read->cat = cat;
+      read->i = i;
+      read->subdomain = &(subdomain[cat]);
+      read->buf = NULL;
+      read->buf_f = NULL;
+      read->item = prefetch_submit(prefetch, read_large_scale_field_data, (void *) read);
+    }
 
-        double *dummy = NULL;
+  /* Process each large-scale field as soon as it is read */
+  for (r=0; r<nreads && istat == 0; r++) {
+    read = &(reads[r]);
+    cat = read->cat;
+    i = read->i;
+
+    istat = prefetch_wait(prefetch, read->item);
+    if (istat == 0 && (nlon[cat] != read->nlon_file || nlat[cat] != read->nlat_file || ntime[cat] != read->ntime_file)) {
+      (void) fprintf(stderr, "%s: Problems in dimensions! nlat=%d nlat_file=%d nlon=%d nlon_file=%d ntime=%d ntime_file=%d\n",
+                     __FILE__, nlat[cat], read->nlat_file, nlon[cat], read->nlon_file, ntime[cat], read->ntime_file);
+      istat = -1;
+    }
+    if (istat != 0)
+      break;
 
-        /* Free memory if previously allocated */
-        if (data->field[cat].lon_ls != NULL) {
-          (void) free(data->field[cat].lon_ls);
-          data->field[cat].lon_ls = NULL;
-        }
-        if (data->field[cat].lat_ls != NULL) {
-          (void) free(data->field[cat].lat_ls);
-          data->field[cat].lat_ls = NULL;
-        }
-        if (data->field[cat].data[i].field_ls != NULL) {
-          (void) free(data->field[cat].data[i].field_ls);
-          data->field[cat].data[i].field_ls = NULL;
-        }
-        /* Read data and fix calendar */
-        istat = read_netcdf_var_3d(&(data->field[cat].data[i].field_ls), data->field[cat].data[i].info,
-                                   &(data->field[cat].proj[i]), data->field[cat].data[i].filename_ls,
-                                   data->field[cat].data[i].nomvar_ls,
-                                   data->field[cat].data[i].dimxname, data->field[cat].data[i].dimyname, data->field[cat].data[i].timename,
-                                   &nlon_file, &nlat_file, &ntime_file, TRUE);
-        if (nlon != nlon_file || nlat != nlat_file || ntime != ntime_file) {
-          (void) fprintf(stderr, "%s: Problems in dimensions! nlat=%d nlat_file=%d nlon=%d nlon_file=%d ntime=%d ntime_file=%d\n",
-                         __FILE__, nlat, nlat_file, nlon, nlon_file, ntime, ntime_file);
-          istat = -1;
-        }
-        if (istat != 0) {
-          /* In case of failure */
-          (void) free(lon);
-          (void) free(lat);
-          (void) free(time_ls);
-          (void) free(time_units[cat]);
-          (void) free(cal_type[cat]);
-          return istat;
-        }
+    /* Free memory if previously allocated */
+    if (data->field[cat].data[i].field_ls != NULL) {
+      (void) free_large(data->field[cat].data[i].field_ls);
+      data->field[cat].data[i].field_ls = NULL;
+    }
+    if (data->field[cat].data[i].field_ls_f != NULL) {
+      (void) free_large(data->field[cat].data[i].field_ls_f);
+      data->field[cat].data[i].field_ls_f = NULL;
+    }
 
-        /* Extract subdomain of spatial fields */
-        (void) extract_subdomain(&buf, &(data->field[cat].lon_ls), &(data->field[cat].lat_ls),
-                                 &(data->field[cat].nlon_ls), &(data->field[cat].nlat_ls), data->field[cat].data[i].field_ls, lon, lat,
-                                 longitude_min, longitude_max, latitude_min, latitude_max, nlon, nlat, ntime);
-        (void) free(data->field[cat].data[i].field_ls);
+    /* For standard calendar data */
+    if ( !strcmp(cal_type[cat], "gregorian") || !strcmp(cal_type[cat], "standard") ) {
+        
+      data->field[cat].data[i].field_ls = read->buf;
+      data->field[cat].data[i].field_ls_f = read->buf_f;
+      read->buf = NULL;
+      read->buf_f = NULL;
 
-        /* Adjust calendar to standard calendar */
-        istat = data_to_gregorian_cal_d(&(data->field[cat].data[i].field_ls), &dummy, &(data->field[cat].ntime_ls),
-                                        buf, time_ls, time_units[cat], data->conf->time_units,
-                                        cal_type[cat], data->field[cat].nlon_ls, data->field[cat].nlat_ls, ntime);
-        if (istat < 0) {
-          /* In case of failure */
-          (void) free(lon);
-          (void) free(lat);
-          (void) free(time_ls);
-          (void) free(time_units[cat]);
-          (void) free(cal_type[cat]);
-          (void) free(buf);
-          (void) free(data->field[cat].lon_ls);
-          (void) free(data->field[cat].lat_ls);
-          (void) free(data->field[cat].data[i].field_ls);
-          return istat;
-        }
-        if (data->field[cat].time_ls == NULL) {
-          data->field[cat].time_ls = (double *) malloc(data->field[cat].ntime_ls * sizeof(double));
-          if (data->field[cat].time_ls == NULL) alloc_error(__FILE__, __LINE__);
+      /* Save number of times dimension */
+      data->field[cat].ntime_ls = ntime[cat];
+
+      /* If time info not already retrieved for this category, get time information and generate time structure */
+      if (data->field[cat].time_ls == NULL) {
+        data->field[cat].time_ls = (double *) malloc(data->field[cat].ntime_ls * sizeof(double));
+        if (data->field[cat].time_ls == NULL) alloc_error(__FILE__, __LINE__);
+        if ( strcmp(time_units[cat], data->conf->time_units) )
+          (void) change_date_origin(data->field[cat].time_ls, data->conf->time_units, time_ls[cat], time_units[cat], ntime[cat]);
+        else
           for (t=0; t<data->field[cat].ntime_ls; t++)
-            data->field[cat].time_ls[t] = dummy[t];
-          istat = compute_time_info(data->field[cat].time_s, data->field[cat].time_ls, data->conf->time_units, data->conf->cal_type,
-                                    data->field[cat].ntime_ls);
-        }
-        (void) free(dummy);
-        (void) free(buf);
+            data->field[cat].time_ls[t] = time_ls[cat][t];
+        istat = compute_time_info(data->field[cat].time_s, data->field[cat].time_ls, data->conf->time_units, data->conf->cal_type,
+                                  data->field[cat].ntime_ls);
       }
     }
-    /* Free memory */
-    if (lat != NULL) {
-      (void) free(lat);
-      lat = NULL;
-    }
-    if (lon != NULL) {
-      (void) free(lon);
-      lon = NULL;
-    }
-    if (time_ls != NULL) {
-      (void) free(time_ls);
-      time_ls = NULL;
+    else {
+      /* Non-standard calendar type */
+
+      double *dummy = NULL;
+
+      /* Adjust calendar to standard calendar */
+      if (data->field[cat].single_precision == TRUE) {
+        istat = data_to_gregorian_cal_f(&(data->field[cat].data[i].field_ls_f), &dummy, &(data->field[cat].ntime_ls),
+                                        read->buf_f, time_ls[cat], time_units[cat], data->conf->time_units,
+                                        cal_type[cat], data->field[cat].nlon_ls, data->field[cat].nlat_ls, ntime[cat]);
+        (void) free(read->buf_f);
+        read->buf_f = NULL;
+      }
+      else {
+        istat = data_to_gregorian_cal_d(&(data->field[cat].data[i].field_ls), &dummy, &(data->field[cat].ntime_ls),
+                                        read->buf, time_ls[cat], time_units[cat], data->conf->time_units,
+                                        cal_type[cat], data->field[cat].nlon_ls, data->field[cat].nlat_ls, ntime[cat]);
+        (void) free(read->buf);
+        read->buf = NULL;
+      }
+      if (istat < 0) {
+        /* In case of failure */
+        (void) free(data->field[cat].lon_ls);
+        data->field[cat].lon_ls = NULL;
+        (void) free(data->field[cat].lat_ls);
+        data->field[cat].lat_ls = NULL;
+        (void) free(data->field[cat].data[i].field_ls);
+        data->field[cat].data[i].field_ls = NULL;
+        (void) free(data->field[cat].data[i].field_ls_f);
+        data->field[cat].data[i].field_ls_f = NULL;
+        break;
+      }
+      if (data->field[cat].time_ls == NULL) {
+        data->field[cat].time_ls = (double *) malloc(data->field[cat].ntime_ls * sizeof(double));
+        if (data->field[cat].time_ls == NULL) alloc_error(__FILE__, __LINE__);
+        for (t=0; t<data->field[cat].ntime_ls; t++)
+          data->field[cat].time_ls[t] = dummy[t];
+        istat = compute_time_info(data->field[cat].time_s, data->field[cat].time_ls, data->conf->time_units, data->conf->cal_type,
+                                  data->field[cat].ntime_ls);
+      }
+      (void) free(dummy);
     }
-    if (time_units[cat] != NULL) {
+    istat = 0;
+
+    npts = data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls;
+    /* Move the field to the scratch directory if large arrays are memory-mapped */
+    if (data->field[cat].single_precision == TRUE)
+      istat = alloc_large_move((void **) &(data->field[cat].data[i].field_ls_f), npts * sizeof(float));
+    else
+      istat = alloc_large_move((void **) &(data->field[cat].data[i].field_ls), npts * sizeof(double));
+    if (istat != 0)
+      (void) fprintf(stderr, "%s: Cannot allocate memory for large-scale field %s.\n", __FILE__, data->field[cat].data[i].nomvar_ls);
+
+    /* The field now belongs to the data structure: the memory budget can be used by the next reads */
+    (void) prefetch_release(prefetch, read->item);
+  }
+
+  /* Free memory, including fields read in the background but not processed because of a failure */
+  if (prefetch != NULL)
+    (void) prefetch_free(prefetch);
+  for (r=0; r<nreads; r++) {
+    if (reads[r].buf != NULL)
+      (void) free(reads[r].buf);
+    if (reads[r].buf_f != NULL)
+      (void) free(reads[r].buf_f);
+  }
+  (void) free(reads);
+  for (cat=0; cat<NCAT; cat++) {
+    if (time_ls[cat] != NULL)
+      (void) free(time_ls[cat]);
+    if (time_units[cat] != NULL)
       (void) free(time_units[cat]);
-      time_units[cat] = NULL;
-    }
-    if (cal_type[cat] != NULL) {
+    if (cal_type[cat] != NULL)
       (void) free(cal_type[cat]);
-      cal_type[cat] = NULL;
-    }
+    (void) free_subdomain_index(&(subdomain[cat]));
   }
-
   (void) free(time_units);
   (void) free(cal_type);
 
   /* Diagnostic status */
-  return 0;
+  return istat;
 }
@@ -53,6 +53,8 @@ LICENSE END */
 
 #include <dsclim.h>
 
+static void obs_period_filename(char *infile, char *format, var_struct *obs_var, int var, int year, int month);
+
 /** Read observation data for a given period. */
 int
 read_obs_period(double **buffer, double **lon, double **lat, double *missing_value, data_struct *data, char *varname,
@@ -77,44 +79,59 @@ read_obs_period(double **buffer, double **lon, double **lat, double *missing_val
   
   double *buf = NULL; /* Temporary buffer */
   char *infile = NULL; /* Input filename */
-  int year1 = 0; /* First year of data input file */
-  int year2 = 0; /* End year of data input file */
+  char *nextfile = NULL; /* Input filename of next date */
   double *timeval = NULL; /* Temporary time information buffer */
   char *cal_type = NULL; /* Calendar type (udunits) */
   char *time_units = NULL; /* Time units (udunits) */
-  int ntime_obs; /* Number of times dimension in observation database */
+  int ntime_obs = 0; /* Number of times dimension in observation database */
   int found = FALSE; /* Used to tag if we found a specific date */
   time_vect_struct *time_s = NULL; /* Time structure for observation database */
+  var_struct *obs_var = data->conf->obs_var; /* Observation variables */
 
   info_field_struct *info = NULL; /* Temporary field information structure */
   proj_struct *proj = NULL; /* Temporary field projection structure */
 
-  int tmpi; /* Temporay integer value */
   char *format = NULL; /* Temporay format string */
 
+  int *tindex = NULL; /* Time index in observation file of each date */
+  size_t *tstart = NULL; /* First time index of each run of consecutive timesteps */
+  size_t *tcount = NULL; /* Number of timesteps of each run */
+  int nruns; /* Number of runs of consecutive timesteps in current file */
+  size_t npts = 0; /* Number of points of each 2D field */
+  double fillvalue; /* Missing value of current file */
+
   int t; /* Time loop counter */
+  int t0; /* First date read from current file */
   int tl; /* Time loop counter */
   int var; /* Variable ID */
   int istat; /* Diagnostic status */
-  int i;
-  int j;
+  size_t i; /* Loop counter */
 
   int ntime_file;
 
   char *prev_infile = NULL;
 
   /* Search variable */
-  var = find_str_value(varname, data->conf->obs_var->netcdfname, data->conf->obs_var->nobs_var);
+  var = find_str_value(varname, obs_var->netcdfname, obs_var->nobs_var);
   if (var == -1) return -2;
 
   infile = (char *) malloc(MAXPATH * sizeof(char));
   if (infile == NULL) alloc_error(__FILE__, __LINE__);
+  nextfile = (char *) malloc(MAXPATH * sizeof(char));
+  if (nextfile == NULL) alloc_error(__FILE__, __LINE__);
   prev_infile = (char *) malloc(MAXPATH * sizeof(char));
   if (prev_infile == NULL) alloc_error(__FILE__, __LINE__);
   (void) strcpy(prev_infile, "");
   format = (char *) malloc(MAXPATH * sizeof(char));
   if (format == NULL) alloc_error(__FILE__, __LINE__);
 
+  tindex = (int *) malloc(ntime * sizeof(int));
+  if (tindex == NULL) alloc_error(__FILE__, __LINE__);
+  tstart = (size_t *) malloc(ntime * sizeof(size_t));
+  if (tstart == NULL) alloc_error(__FILE__, __LINE__);
+  tcount = (size_t *) malloc(ntime * sizeof(size_t));
+  if (tcount == NULL) alloc_error(__FILE__, __LINE__);
+
   info = (info_field_struct *) malloc(sizeof(info_field_struct));
   if (info == NULL) alloc_error(__FILE__, __LINE__);
   proj = (proj_struct *) malloc(sizeof(proj_struct));
@@ -123,54 +140,26 @@ read_obs_period(double **buffer, double **lon, double **lat, double *missing_val
   *lat = NULL;
   *lon = NULL;
 
-  if (data->conf->obs_var->proj->name != NULL)
-    (void) free(data->conf->obs_var->proj->name);
-  data->conf->obs_var->proj->name = NULL;
+  if (obs_var->proj->name != NULL)
+    (void) free(obs_var->proj->name);
+  obs_var->proj->name = NULL;
   proj->name = NULL;
-  if (data->conf->obs_var->proj->grid_mapping_name != NULL)
-    (void) free(data->conf->obs_var->proj->grid_mapping_name);
-  data->conf->obs_var->proj->grid_mapping_name = NULL;
+  if (obs_var->proj->grid_mapping_name != NULL)
+    (void) free(obs_var->proj->grid_mapping_name);
+  obs_var->proj->grid_mapping_name = NULL;
   proj->grid_mapping_name = NULL;
 
-  /* Loop over time */
-  for (t=0; t<ntime; t++) {
+  /* Create input filename template */
+  (void) strcpy(format, "%s/%s/");
+  (void) strcat(format, obs_var->template);
+
+  /* Loop over time, reading all dates of the same input file at once */
+  istat = 0;
+  t = 0;
+  while (t < ntime && istat == 0) {
     
     /* Create input filename for reading data */
-    (void) strcpy(format, "%s/%s/");
-    (void) strcat(format, data->conf->obs_var->template);
-    if (data->conf->obs_var->month_begin != 1) {
-      /* Months in observation files *does not* begin in January: must have 2 years in filename */
-      if (month[t] < data->conf->obs_var->month_begin)
-        year1 = year[t] - 1;
-      else
-        year1 = year[t];
-      year2 = year1 + 1;
-      if (data->conf->obs_var->year_digits == 4)
-        (void) sprintf(infile, format, data->conf->obs_var->path, data->conf->obs_var->frequency,
-                       data->conf->obs_var->acronym[var], year1, year2);
-      else {
-        tmpi = year1 / 100;
-        year1 = year1 - (tmpi*100);
-        tmpi = year2 / 100;
-        year2 = year2 - (tmpi*100);
-        (void) sprintf(infile, format, data->conf->obs_var->path, data->conf->obs_var->frequency,
-                       data->conf->obs_var->acronym[var], year1, year2);
-      }
-    }
-    else {
-      /* Months in observation files begins in January: must have 1 year in filename */
-      if (data->conf->obs_var->year_digits == 4) {
-        year1 = year[t];
-        (void) sprintf(infile, format, data->conf->obs_var->path, data->conf->obs_var->frequency,
-                       data->conf->obs_var->acronym[var], year1);
-      }
-      else {
-        tmpi = year1 / 100;
-        year1 = year1 - (tmpi*100);
-        (void) sprintf(infile, format, data->conf->obs_var->path, data->conf->obs_var->frequency,
-                       data->conf->obs_var->acronym[var], year1);
-      }
-    }
+    (void) obs_period_filename(infile, format, obs_var, var, year[t], month[t]);
     
     /* Get time information for this input file if needed */
     if ( strcmp(prev_infile, infile) ) {
@@ -192,110 +181,123 @@ read_obs_period(double **buffer, double **lon, double **lat, double *missing_val
       time_s = (time_vect_struct *) malloc(sizeof(time_vect_struct));
       if (time_s == NULL) alloc_error(__FILE__, __LINE__);
       
-      istat = get_time_info(time_s, &timeval, &time_units, &cal_type, &ntime_obs, infile, data->conf->obs_var->timename, FALSE);
+      istat = get_time_info(time_s, &timeval, &time_units, &cal_type, &ntime_obs, infile, obs_var->timename, FALSE);
       if (istat < 0) {
         (void) free(time_s);
-        (void) free(infile);
-        (void) free(prev_infile);
-        (void) free(format);
-        (void) free(info);
-        (void) free(proj);
-        return -1;
+        time_s = NULL;
+        istat = -1;
+        break;
       }
+      (void) strcpy(prev_infile, infile);
     }
     
-    /* Find date in observation database */
-    found = FALSE;
-    tl = 0;
-    while (tl<ntime_obs && found == FALSE) {
-      if (year[t] == time_s->year[tl] && month[t] == time_s->month[tl] && day[t] == time_s->day[tl])
-        found = TRUE;
+    /* Find all consecutive dates stored in this input file, and their time index in observation database */
+    t0 = t;
+    tl = -1;
+    while (t < ntime) {
+      if (t > t0) {
+        (void) obs_period_filename(nextfile, format, obs_var, var, year[t], month[t]);
+        if ( strcmp(nextfile, infile) )
+          break;
+      }
+      /* Dates are usually following each other: first try next timestep */
+      found = FALSE;
       tl++;
+      if (tl >= 0 && tl < ntime_obs && year[t] == time_s->year[tl] && month[t] == time_s->month[tl] && day[t] == time_s->day[tl])
+        found = TRUE;
+      else {
+        tl = 0;
+        while (tl<ntime_obs && found == FALSE) {
+          if (year[t] == time_s->year[tl] && month[t] == time_s->month[tl] && day[t] == time_s->day[tl])
+            found = TRUE;
+          tl++;
+        }
+        tl--;
+      }
+      if (found == FALSE) {
+        (void) fprintf(stderr, "%s: Fatal error in algorithm: date not found: %d %d %d %d!!\n", __FILE__, t, year[t],month[t],day[t]);
+        istat = -1;
+        break;
+      }
+      tindex[t] = tl;
+      t++;
     }
-    
-    if (found == TRUE) {
-      
-      tl--;
-          
-      /* Read data */
-      istat = read_netcdf_var_3d_2d(&buf, info, proj, infile, data->conf->obs_var->acronym[var],
-                                    data->conf->obs_var->dimxname, data->conf->obs_var->dimyname, data->conf->obs_var->timename,
-                                    tl, nlon, nlat, &ntime_file, FALSE);
+    if (istat != 0)
+      break;
+
+    if ( (*lat) == NULL && (*lon) == NULL ) {
+      /* Read first date to get field information and dimensions */
+      istat = read_netcdf_var_3d_2d(&buf, info, proj, infile, obs_var->acronym[var],
+                                    obs_var->dimxname, obs_var->dimyname, obs_var->timename,
+                                    tindex[t0], nlon, nlat, &ntime_file, FALSE);
+      if (istat < 0)
+        break;
       *missing_value = info->fillvalue;
+      (void) free(buf);
 
-      if (data->conf->obs_var->proj->name == NULL) {
+      if (obs_var->proj->name == NULL) {
         /* Retrieve observation grid parameters if not done already */
-        data->conf->obs_var->proj->name = strdup(proj->name);
-        data->conf->obs_var->proj->grid_mapping_name = strdup(proj->grid_mapping_name);
-        data->conf->obs_var->proj->latin1 = proj->latin1;
-        data->conf->obs_var->proj->latin2 = proj->latin2;
-        data->conf->obs_var->proj->lonc = proj->lonc;
-        data->conf->obs_var->proj->lat0 = proj->lat0;
-        data->conf->obs_var->proj->false_easting = proj->false_easting;
-        data->conf->obs_var->proj->false_northing = proj->false_northing;
+        obs_var->proj->name = strdup(proj->name);
+        obs_var->proj->grid_mapping_name = strdup(proj->grid_mapping_name);
+        obs_var->proj->latin1 = proj->latin1;
+        obs_var->proj->latin2 = proj->latin2;
+        obs_var->proj->lonc = proj->lonc;
+        obs_var->proj->lat0 = proj->lat0;
+        obs_var->proj->false_easting = proj->false_easting;
+        obs_var->proj->false_northing = proj->false_northing;
       }
 
-      if ( (*lat) == NULL && (*lon) == NULL ) {
-        /* Get latitude and longitude coordinates information */
-        istat = read_netcdf_latlon(lon, lat, nlon, nlat, data->conf->obs_var->dimcoords, data->conf->obs_var->proj->coords,
-                                   data->conf->obs_var->proj->name, data->conf->obs_var->lonname,
-                                   data->conf->obs_var->latname, data->conf->obs_var->dimxname,
-                                   data->conf->obs_var->dimyname, infile);
+      /* Get latitude and longitude coordinates information */
+      istat = read_netcdf_latlon(lon, lat, nlon, nlat, obs_var->dimcoords, obs_var->proj->coords,
+                                 obs_var->proj->name, obs_var->lonname,
+                                 obs_var->latname, obs_var->dimxname,
+                                 obs_var->dimyname, infile);
             
-        /* Allocate buffer memory given dimensions */
-        *buffer = (double *) malloc((*nlon)*(*nlat)*ntime * sizeof(double));
-        if ( (*buffer) == NULL) alloc_error(__FILE__, __LINE__);
-      }
+      /* Allocate buffer memory given dimensions: lists of points have no latitude dimension */
+      if ((*nlat) > 0)
+        npts = (size_t) (*nlon) * (size_t) (*nlat);
+      else
+        npts = (size_t) (*nlon);
+      *buffer = (double *) alloc_large(npts*ntime * sizeof(double));
+      if ( (*buffer) == NULL) alloc_error(__FILE__, __LINE__);
 
-      /* Transfer data */
-      for (j=0; j<(*nlat); j++)
-        for (i=0; i<(*nlon); i++)
-          if (buf[i+j*(*nlon)] != (*missing_value))
-            (*buffer)[i+j*(*nlon)+t*(*nlon)*(*nlat)] = (buf[i+j*(*nlon)] * data->conf->obs_var->factor[var]) +
-              data->conf->obs_var->delta[var];
-          else
-            (*buffer)[i+j*(*nlon)+t*(*nlon)*(*nlat)] = (*missing_value);
-                    
       /* Free allocated memory */
       (void) free(proj->name);
       proj->name = NULL;
       (void) free(proj->grid_mapping_name);
+      proj->grid_mapping_name = NULL;
           
       (void) free(info->grid_mapping);
       (void) free(info->units);
       (void) free(info->height);
       (void) free(info->coordinates);
       (void) free(info->long_name);
-
-      (void) free(buf);
     }
-    else {
-      (void) fprintf(stderr, "%s: Fatal error in algorithm: date not found: %d %d %d %d!!\n", __FILE__, t, year[t],month[t],day[t]);
-          
-      /* Fatal error */
-      (void) free(infile);
-      (void) free(format);
-          
-      (void) free(info);
-      (void) free(proj);
-          
-      if (time_s != NULL) {
-        (void) free(time_s->year);
-        (void) free(time_s->month);
-        (void) free(time_s->day);
-        (void) free(time_s->hour);
-        (void) free(time_s->minutes);
-        (void) free(time_s->seconds);
-          
-        (void) free(time_s);
-        (void) free(cal_type);
-        (void) free(time_units);
-        (void) free(timeval);
+
+    /* Group dates into runs of consecutive timesteps: one hyperslab per run, gathered when there are gaps */
+    nruns = 0;
+    for (tl=t0; tl<t; tl++) {
+      if (nruns > 0 && (size_t) tindex[tl] == tstart[nruns-1] + tcount[nruns-1])
+        tcount[nruns-1]++;
+      else {
+        tstart[nruns] = (size_t) tindex[tl];
+        tcount[nruns] = 1;
+        nruns++;
       }
-          
-      return -1;
     }
-    (void) strcpy(prev_infile, infile);
+
+    /* Read data straight into output buffer */
+    istat = read_netcdf_var_3d_range(&((*buffer)[t0*npts]), &fillvalue, infile, obs_var->acronym[var], (subdomain_struct *) NULL,
+                                     tstart, tcount, nruns, *nlon, *nlat);
+    if (istat < 0)
+      break;
+
+    /* Apply factor and delta */
+    for (i=t0*npts; i<t*npts; i++)
+      if ((*buffer)[i] != fillvalue)
+        (*buffer)[i] = ((*buffer)[i] * obs_var->factor[var]) + obs_var->delta[var];
+      else
+        (*buffer)[i] = (*missing_value);
   }
 
   /* Free allocated memory */
@@ -316,10 +318,70 @@ read_obs_period(double **buffer, double **lon, double **lat, double *missing_val
   (void) free(info);
   (void) free(proj);
           
+  (void) free(tindex);
+  (void) free(tstart);
+  (void) free(tcount);
+
   (void) free(infile);
+  (void) free(nextfile);
   (void) free(prev_infile);
   (void) free(format);
   
+  if (istat < 0)
+    /* Fatal error */
+    return -1;
+
   /* Success diagnostic */
   return 0;
 }
+
+
+/** Create observation input filename of a given date. */
+static void
+obs_period_filename(char *infile, char *format, var_struct *obs_var, int var, int year, int month) {
+  /**
+     @param[out]   infile        Input filename
+     @param[in]    format        Filename format
+     @param[in]    obs_var       Observation variables
+     @param[in]    var           Variable ID
+     @param[in]    year          Year
+     @param[in]    month         Month
+  */
+
+  int year1 = 0; /* First year of data input file */
+  int year2 = 0; /* End year of data input file */
+  int tmpi; /* Temporay integer value */
+
+  if (obs_var->month_begin != 1) {
+    /* Months in observation files *does not* begin in January: must have 2 years in filename */
+    if (month < obs_var->month_begin)
+      year1 = year - 1;
+    else
+      year1 = year;
+    year2 = year1 + 1;
+    if (obs_var->year_digits == 4)
+      (void) sprintf(infile, format, obs_var->path, obs_var->frequency,
+                     obs_var->acronym[var], year1, year2);
+    else {
+      tmpi = year1 / 100;
+      year1 = year1 - (tmpi*100);
+      tmpi = year2 / 100;
+      year2 = year2 - (tmpi*100);
+      (void) sprintf(infile, format, obs_var->path, obs_var->frequency,
+                     obs_var->acronym[var], year1, year2);
+    }
+  }
+  else {
+    /* Months in observation files begins in January: must have 1 year in filename */
+    year1 = year;
+    if (obs_var->year_digits == 4)
+      (void) sprintf(infile, format, obs_var->path, obs_var->frequency,
+                     obs_var->acronym[var], year1);
+    else {
+      tmpi = year1 / 100;
+      year1 = year1 - (tmpi*100);
+      (void) sprintf(infile, format, obs_var->path, obs_var->frequency,
+                     obs_var->acronym[var], year1);
+    }
+  }
+}
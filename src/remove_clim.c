@@ -117,9 +117,12 @@ remove_clim(data_struct *data) {
     /* Loop over all large-scale fields */
     for (i=0; i<data->field[cat].n_ls; i++) {
 
-      /* Allocate memory for field with climatology removed */
-      bufnoclim = (double *) malloc(data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls * sizeof(double));
-      if (bufnoclim == NULL) alloc_error(__FILE__, __LINE__);
+      /* Allocate memory for field with climatology removed: fields kept in single precision are processed in place */
+      bufnoclim = NULL;
+      if (data->field[cat].single_precision != TRUE) {
+        bufnoclim = (double *) alloc_large(data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls * sizeof(double));
+        if (bufnoclim == NULL) alloc_error(__FILE__, __LINE__);
+      }
 
       /* Allocate memory for temporary time structure */
       timein_ts = (tstruct *) malloc(data->field[cat].ntime_ls * sizeof(tstruct));
@@ -128,7 +131,7 @@ remove_clim(data_struct *data) {
       istat = get_calendar_ts(timein_ts, data->conf->time_units, data->field[cat].time_ls, data->field[cat].ntime_ls);
       if (istat < 0) {
         (void) free(timein_ts);
-        (void) free(bufnoclim);
+        (void) free_large(bufnoclim);
         (void) free(timeclim);
         return -1;
       }
@@ -137,13 +140,15 @@ remove_clim(data_struct *data) {
       if (data->field[cat].data[i].clim_info->clim_remove == TRUE) {
         /* If climatology field is already provided */
         if (data->field[cat].data[i].clim_info->clim_provided == TRUE) {
-          /* Read climatology from NetCDF file */
+          /* Read climatology from NetCDF file: EOFs may be read concurrently in the background */
+          (void) nc_io_lock();
           istat = read_netcdf_var_3d(&(clim[cat]), &clim_info_field, (proj_struct *) NULL,
                                      data->field[cat].data[i].clim_info->clim_filein_ls,
                                      data->field[cat].data[i].clim_info->clim_nomvar_ls,
                                      data->field[cat].data[i].dimxname, data->field[cat].data[i].dimyname,
                                      data->field[cat].data[i].timename,
                                      &nlon_file, &nlat_file, &ntime_file, TRUE);
+          (void) nc_io_unlock();
           if (data->field[cat].nlon_ls != nlon_file || data->field[cat].nlat_ls != nlat_file || ntime_clim != ntime_file) {
             (void) fprintf(stderr, "%s: Problems in dimensions! nlat=%d nlat_file=%d nlon=%d nlon_file=%d ntime=%d ntime_file=%d\n",
                            __FILE__, data->field[cat].nlat_ls, nlat_file, data->field[cat].nlon_ls, nlon_file, ntime_clim, ntime_file);
@@ -151,10 +156,10 @@ remove_clim(data_struct *data) {
           }
           if (istat != 0) {
             /* In case of error in reading data */
-            (void) free(bufnoclim);
+            (void) free_large(bufnoclim);
             (void) free(timein_ts);
             (void) free(timeclim);
-            if (clim[cat] != NULL) (void) free(clim[cat]);
+            if (clim[cat] != NULL) (void) free_large(clim[cat]);
             return istat;
           }
           /* Get missing value */
@@ -170,7 +175,7 @@ remove_clim(data_struct *data) {
           /* Climatology is not provided: must calculate */
           if (clim[cat] == NULL) {
             /* Allocate memory if not already */
-            clim[cat] = (double *) malloc(data->field[cat].nlon_ls * data->field[cat].nlat_ls * ntime_clim * sizeof(double));
+            clim[cat] = (double *) alloc_large(data->field[cat].nlon_ls * data->field[cat].nlat_ls * ntime_clim * sizeof(double));
             if (clim[cat] == NULL) alloc_error(__FILE__, __LINE__);
           }
           /* Get missing value */
@@ -178,14 +183,23 @@ remove_clim(data_struct *data) {
         }
       
         /* Remove seasonal cycle by calculating filtered climatology and substracting from field values */
-        (void) remove_seasonal_cycle(bufnoclim, clim[cat], data->field[cat].data[i].field_ls, timein_ts,
-                                     data->field[cat].data[i].info->fillvalue,
-                                     data->conf->clim_filter_width, data->conf->clim_filter_type,
-                                     data->field[cat].data[i].clim_info->clim_provided,
-                                     data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
+        /* Fields kept in single precision are widened one latitude row at a time */
+        if (data->field[cat].single_precision == TRUE)
+          (void) remove_seasonal_cycle_f(data->field[cat].data[i].field_ls_f, clim[cat], timein_ts,
+                                         data->field[cat].data[i].info->fillvalue,
+                                         data->conf->clim_filter_width, data->conf->clim_filter_type,
+                                         data->field[cat].data[i].clim_info->clim_provided,
+                                         data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
+        else
+          (void) remove_seasonal_cycle(bufnoclim, clim[cat], data->field[cat].data[i].field_ls, timein_ts,
+                                       data->field[cat].data[i].info->fillvalue,
+                                       data->conf->clim_filter_width, data->conf->clim_filter_type,
+                                       data->field[cat].data[i].clim_info->clim_provided,
+                                       data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
       
         /* If we want to save climatology in NetCDF output file for further use */
         if (data->field[cat].data[i].clim_info->clim_save == TRUE) {
+          (void) nc_io_lock();
           istat = create_netcdf("Computed climatology", "Climatologie calculee", "Computed climatology", "Climatologie calculee",
                                 "climatologie,climatology", "C language", data->info->software,
                                 "Computed climatology", data->info->institution,
@@ -197,10 +211,11 @@ remove_clim(data_struct *data) {
                                 data->field[cat].data[i].clim_info->clim_fileout_ls, TRUE, data->conf->format, data->conf->compression);
           if (istat != 0) {
             /* In case of failure */
-            (void) free(bufnoclim);
+            (void) free_large(bufnoclim);
             (void) free(timein_ts);
             (void) free(timeclim);
-            if (clim[cat] != NULL) (void) free(clim[cat]);
+            if (clim[cat] != NULL) (void) free_large(clim[cat]);
+            (void) nc_io_unlock();
             return istat;
           }
           /* Write dimensions of climatology field in NetCDF output file */
@@ -218,10 +233,11 @@ remove_clim(data_struct *data) {
                                        data->field[cat].data[i].clim_info->clim_fileout_ls, TRUE);
           if (istat != 0) {
             /* In case of failure */
-            (void) free(bufnoclim);
+            (void) free_large(bufnoclim);
             (void) free(timein_ts);
             (void) free(timeclim);
-            if (clim[cat] != NULL) (void) free(clim[cat]);
+            if (clim[cat] != NULL) (void) free_large(clim[cat]);
+            (void) nc_io_unlock();
             return istat;
           }
         
@@ -234,20 +250,23 @@ remove_clim(data_struct *data) {
                                       data->field[cat].nlon_ls, data->field[cat].nlat_ls, ntime_clim, TRUE);
           if (istat != 0) {
             /* In case of failure */
-            (void) free(bufnoclim);
+            (void) free_large(bufnoclim);
             (void) free(timein_ts);
             (void) free(timeclim);
-            if (clim[cat] != NULL) (void) free(clim[cat]);
+            if (clim[cat] != NULL) (void) free_large(clim[cat]);
+            (void) nc_io_unlock();
             return istat;
           }
+          (void) nc_io_unlock();
         }
 
         /* Copy field with climatology removed to proper variable in data structure */
-        for (ii=0; ii<(data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls); ii++)
-          data->field[cat].data[i].field_ls[ii] = bufnoclim[ii];
+        if (data->field[cat].single_precision != TRUE)
+          for (ii=0; ii<(data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls); ii++)
+            data->field[cat].data[i].field_ls[ii] = bufnoclim[ii];
       }
       /* Free memory */
-      (void) free(bufnoclim);
+      (void) free_large(bufnoclim);
       (void) free(timein_ts);
     }
   }
@@ -259,9 +278,12 @@ remove_clim(data_struct *data) {
     /* Loop over all large-scale fields */
     for (i=0; i<data->field[cat].n_ls; i++) {
 
-      /* Allocate memory for field with climatology removed */
-      bufnoclim = (double *) malloc(data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls * sizeof(double));
-      if (bufnoclim == NULL) alloc_error(__FILE__, __LINE__);
+      /* Allocate memory for field with climatology removed: fields kept in single precision are processed in place */
+      bufnoclim = NULL;
+      if (data->field[cat].single_precision != TRUE) {
+        bufnoclim = (double *) alloc_large(data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls * sizeof(double));
+        if (bufnoclim == NULL) alloc_error(__FILE__, __LINE__);
+      }
 
       /* Allocate memory for temporary time structure */
       timein_ts = (tstruct *) malloc(data->field[cat].ntime_ls * sizeof(tstruct));
@@ -270,7 +292,7 @@ remove_clim(data_struct *data) {
       istat = get_calendar_ts(timein_ts, data->conf->time_units, data->field[cat].time_ls, data->field[cat].ntime_ls);
       if (istat < 0) {
         (void) free(timein_ts);
-        (void) free(bufnoclim);
+        (void) free_large(bufnoclim);
         (void) free(timeclim);
         return -1;
       }
@@ -279,13 +301,15 @@ remove_clim(data_struct *data) {
       if (data->field[cat].data[i].clim_info->clim_remove == TRUE) {
         /* If climatology field is already provided */
         if (data->field[cat].data[i].clim_info->clim_provided == TRUE) {
-          /* Read climatology from NetCDF file */
+          /* Read climatology from NetCDF file: EOFs may be read concurrently in the background */
+          (void) nc_io_lock();
           istat = read_netcdf_var_3d(&(clim[cat]), &clim_info_field, (proj_struct *) NULL,
                                      data->field[cat].data[i].clim_info->clim_filein_ls,
                                      data->field[cat].data[i].clim_info->clim_nomvar_ls,
                                      data->field[cat].data[i].dimxname, data->field[cat].data[i].dimyname,
                                      data->field[cat].data[i].timename,
                                      &nlon_file, &nlat_file, &ntime_file, TRUE);
+          (void) nc_io_unlock();
           if (data->field[cat].nlon_ls != nlon_file || data->field[cat].nlat_ls != nlat_file || ntime_clim != ntime_file) {
             (void) fprintf(stderr, "%s: Problems in dimensions! nlat=%d nlat_file=%d nlon=%d nlon_file=%d ntime=%d ntime_file=%d\n",
                            __FILE__, data->field[cat].nlat_ls, nlat_file, data->field[cat].nlon_ls, nlon_file, ntime_clim, ntime_file);
@@ -293,10 +317,10 @@ remove_clim(data_struct *data) {
           }
           if (istat != 0) {
             /* In case of error in reading data */
-            (void) free(bufnoclim);
+            (void) free_large(bufnoclim);
             (void) free(timein_ts);
             (void) free(timeclim);
-            if (clim[cat] != NULL) (void) free(clim[cat]);
+            if (clim[cat] != NULL) (void) free_large(clim[cat]);
             return istat;
           }
           /* Get missing value */
@@ -315,14 +339,23 @@ remove_clim(data_struct *data) {
         }
       
         /* Remove seasonal cycle by substracting control-run climatology from field values (not the clim[cat+1] */
-        (void) remove_seasonal_cycle(bufnoclim, clim[cat+1], data->field[cat].data[i].field_ls, timein_ts,
-                                     data->field[cat].data[i].info->fillvalue,
-                                     data->conf->clim_filter_width, data->conf->clim_filter_type,
-                                     TRUE,
-                                     data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
+        /* Fields kept in single precision are widened one latitude row at a time */
+        if (data->field[cat].single_precision == TRUE)
+          (void) remove_seasonal_cycle_f(data->field[cat].data[i].field_ls_f, clim[cat+1], timein_ts,
+                                         data->field[cat].data[i].info->fillvalue,
+                                         data->conf->clim_filter_width, data->conf->clim_filter_type,
+                                         TRUE,
+                                         data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
+        else
+          (void) remove_seasonal_cycle(bufnoclim, clim[cat+1], data->field[cat].data[i].field_ls, timein_ts,
+                                       data->field[cat].data[i].info->fillvalue,
+                                       data->conf->clim_filter_width, data->conf->clim_filter_type,
+                                       TRUE,
+                                       data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
       
         /* If we want to save climatology in NetCDF output file for further use */
         if (data->field[cat].data[i].clim_info->clim_save == TRUE) {
+          (void) nc_io_lock();
           istat = create_netcdf("Computed climatology", "Climatologie calculee", "Computed climatology", "Climatologie calculee",
                                 "climatologie,climatology", "C language", data->info->software,
                                 "Computed climatology", data->info->institution,
@@ -334,10 +367,11 @@ remove_clim(data_struct *data) {
                                 data->field[cat].data[i].clim_info->clim_fileout_ls, TRUE, data->conf->format, data->conf->compression);
           if (istat != 0) {
             /* In case of failure */
-            (void) free(bufnoclim);
+            (void) free_large(bufnoclim);
             (void) free(timein_ts);
             (void) free(timeclim);
-            if (clim[cat+1] != NULL) (void) free(clim[cat+1]);
+            if (clim[cat+1] != NULL) (void) free_large(clim[cat+1]);
+            (void) nc_io_unlock();
             return istat;
           }
           /* Write dimensions of climatology field in NetCDF output file */
@@ -355,10 +389,11 @@ remove_clim(data_struct *data) {
                                        data->field[cat].data[i].clim_info->clim_fileout_ls, TRUE);
           if (istat != 0) {
             /* In case of failure */
-            (void) free(bufnoclim);
+            (void) free_large(bufnoclim);
             (void) free(timein_ts);
             (void) free(timeclim);
-            if (clim[cat+1] != NULL) (void) free(clim[cat+1]);
+            if (clim[cat+1] != NULL) (void) free_large(clim[cat+1]);
+            (void) nc_io_unlock();
             return istat;
           }
         
@@ -371,20 +406,23 @@ remove_clim(data_struct *data) {
                                       data->field[cat].nlon_ls, data->field[cat].nlat_ls, ntime_clim, TRUE);
           if (istat != 0) {
             /* In case of failure */
-            (void) free(bufnoclim);
+            (void) free_large(bufnoclim);
             (void) free(timein_ts);
             (void) free(timeclim);
-            if (clim[cat+1] != NULL) (void) free(clim[cat+1]);
+            if (clim[cat+1] != NULL) (void) free_large(clim[cat+1]);
+            (void) nc_io_unlock();
             return istat;
           }
+          (void) nc_io_unlock();
         }
 
         /* Copy field with climatology removed to proper variable in data structure */
-        for (ii=0; ii<(data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls); ii++)
-          data->field[cat].data[i].field_ls[ii] = bufnoclim[ii];
+        if (data->field[cat].single_precision != TRUE)
+          for (ii=0; ii<(data->field[cat].nlon_ls * data->field[cat].nlat_ls * data->field[cat].ntime_ls); ii++)
+            data->field[cat].data[i].field_ls[ii] = bufnoclim[ii];
       }
       /* Free memory */
-      (void) free(bufnoclim);
+      (void) free_large(bufnoclim);
       (void) free(timein_ts);
     }
   }
@@ -392,7 +430,7 @@ remove_clim(data_struct *data) {
   /* Free memory */
   (void) free(timeclim);
   for (cat=0; cat<NCAT; cat++)
-    if (clim[cat] != NULL) (void) free(clim[cat]);
+    if (clim[cat] != NULL) (void) free_large(clim[cat]);
   (void) free(clim);
 
   /* Success status */
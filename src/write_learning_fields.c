@@ -162,6 +162,7 @@ write_learning_fields(data_struct *data) {
   istat = utInit("");
 
   /* Open NetCDF file for writing, overwrite and truncate existing file if any */
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_create(data->learning->filename_save_learn, NC_CLOBBER, &ncoutid);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
@@ -693,6 +694,7 @@ write_learning_fields(data_struct *data) {
 
 
   /* Open NetCDF file for writing, overwrite and truncate existing file if any */
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_create(data->learning->filename_save_weight, NC_CLOBBER, &ncoutid);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
@@ -762,6 +764,7 @@ write_learning_fields(data_struct *data) {
 
 
   /* Open NetCDF file for writing, overwrite and truncate existing file if any */
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_create(data->learning->filename_save_clust_learn, NC_CLOBBER, &ncoutid);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
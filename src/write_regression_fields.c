@@ -117,6 +117,7 @@ write_regression_fields(data_struct *data, char *filename, double **timeval, int
   if (tmpstr == NULL) alloc_error(__FILE__, __LINE__);
 
   /* Open NetCDF file for writing, overwrite and truncate existing file if any */
+  (void) instrument_count(INSTR_NC_OPENS, 1);
   istat = nc_create(filename, NC_CLOBBER, &ncoutid);
   if (istat != NC_NOERR) handle_netcdf_error(istat, __FILE__, __LINE__);
 
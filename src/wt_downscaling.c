@@ -62,6 +62,332 @@ LICENSE END */
 
 #include <dsclim.h>
 
+/** Arguments of the downscaling tasks of one field category and one season. */
+typedef struct {
+  data_struct *data; /**< MASTER data structure. */
+  int cat; /**< Field category. */
+  int s; /**< Season. */
+  int **ntime_sub; /**< Number of times for sub-periods. Dimensions number of field categories (NCAT) and number of seasons. */
+  double ***pc_norm; /**< Normalized principal components of the large-scale fields. Dimensions NCAT and number of fields. */
+  double ***time_ls_sub; /**< Time values used for regression diagnostics output. Dimensions NCAT and number of seasons. */
+  short int *mask_sub; /**< Mask covering subdomain. */
+  task_graph_node_struct *classify; /**< Task computing distances to clusters and classifying days (step 7). */
+  task_graph_node_struct *secondary; /**< Task normalizing the secondary large-scale fields (step 8). */
+  task_graph_node_struct *regression; /**< Task applying the regression (step 9). */
+  task_graph_node_struct *analogs; /**< Task finding the analog days (step 10). */
+  task_graph_node_struct *delta; /**< Task computing the secondary large-scale fields difference (step 11). */
+} downscaling_task_struct;
+
+/** Compute distance to clusters and classify days of one season for a large-scale field category (step 7). */
+static int
+downscaling_task_classify(void *arg) {
+  /**
+     @param[in]  arg  Downscaling task structure.
+
+     \return          Status.
+  */
+
+  downscaling_task_struct *task = (downscaling_task_struct *) arg; /* Task arguments */
+  data_struct *data = task->data; /* MASTER data structure */
+  int cat = task->cat; /* Field category */
+  int s = task->s; /* Season */
+  int **ntime_sub = task->ntime_sub; /* Number of times for sub-periods */
+  double *buf_sub = NULL; /* Temporary buffer for sub-period */
+  int i; /* Loop counter */
+  instrument_timer_struct timer; /* Instrumentation timer */
+
+  (void) instrument_begin(&timer, "clustering");
+
+  /* Loop over large-scale fields */
+  for (i=0; i<data->field[cat].n_ls; i++) {
+    /* Select season months in the whole time period and create sub-period large-scale field buffer */
+    (void) extract_subperiod_months(&buf_sub, &(ntime_sub[cat][s]), task->pc_norm[cat][i],
+                                    data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
+                                    data->conf->time_units, data->conf->cal_type, (period_struct *) NULL,
+                                    data->conf->season[s].month,
+                                    1, data->field[cat].time_ls, 1,
+                                    data->field[cat].data[i].eof_info->neof_ls, data->field[cat].ntime_ls,
+                                    data->conf->season[s].nmonths);
+
+    /* Compute distances to clusters using normalization and against the control reference run */
+    data->field[cat].data[i].down->dist[s] = (double *) 
+      malloc(data->conf->season[s].nclusters*ntime_sub[cat][s] * sizeof(double));
+    if (data->field[cat].data[i].down->dist[s] == NULL) alloc_error(__FILE__, __LINE__);
+    (void) dist_clusters_normctrl(data->field[cat].data[i].down->dist[s], buf_sub, data->learning->data[s].weight,
+                                  data->learning->pc_normalized_var, data->field[CTRL_FIELD_LS].data[i].down->var_pc_norm,
+                                  data->field[CTRL_FIELD_LS].data[i].down->mean_dist[s],
+                                  data->field[CTRL_FIELD_LS].data[i].down->var_dist[s],
+                                  data->field[cat].data[i].eof_info->neof_ls, data->conf->season[s].nclusters,
+                                  ntime_sub[cat][s]);
+    /* Classify each day in the current clusters */
+    data->field[cat].data[i].down->days_class_clusters[s] = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+    if (data->field[cat].data[i].down->days_class_clusters[s] == NULL) alloc_error(__FILE__, __LINE__);
+    (void) class_days_pc_clusters(data->field[cat].data[i].down->days_class_clusters[s], buf_sub,
+                                  data->learning->data[s].weight, data->conf->classif_type,
+                                  data->field[cat].data[i].eof_info->neof_ls, data->conf->season[s].nclusters,
+                                  ntime_sub[cat][s]);
+    /* Free temporary buffer */
+    (void) free(buf_sub);
+  }
+
+  (void) instrument_end(&timer);
+
+  return 0;
+}
+
+/** Normalize the secondary large-scale fields of one season by control-run mean and variance (step 8). */
+static int
+downscaling_task_secondary(void *arg) {
+  /**
+     @param[in]  arg  Downscaling task structure.
+
+     \return          Status.
+  */
+
+  downscaling_task_struct *task = (downscaling_task_struct *) arg; /* Task arguments */
+  data_struct *data = task->data; /* MASTER data structure */
+  int cat = task->cat; /* Field category */
+  int s = task->s; /* Season */
+  int **ntime_sub = task->ntime_sub; /* Number of times for sub-periods */
+  double *buf_sub = NULL; /* Temporary buffer for sub-period */
+  int i; /* Loop counter */
+
+  /* Loop over secondary large-scale fields */
+  for (i=0; i<data->field[cat].n_ls; i++) {
+    /* Select season months in the whole time period to create a sub-period buffer */
+    (void) extract_subperiod_months(&buf_sub, &(ntime_sub[cat][s]), data->field[cat].data[i].down->smean,
+                                    data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
+                                    data->conf->time_units, data->conf->cal_type, (period_struct *) NULL,
+                                    data->conf->season[s].month, 3, data->field[cat].time_ls, 1,
+                                    1, data->field[cat].ntime_ls, data->conf->season[s].nmonths);
+    /* Normalize the spatial mean of secondary large-scale fields */
+    data->field[cat].data[i].down->smean_norm[s] = (double *) malloc(data->field[cat].ntime_ls * sizeof(double));
+    if (data->field[cat].data[i].down->smean_norm[s] == NULL) alloc_error(__FILE__, __LINE__);
+    (void) normalize_field(data->field[cat].data[i].down->smean_norm[s], buf_sub,
+                           data->field[CTRL_SEC_FIELD_LS].data[i].down->mean[s], data->field[CTRL_SEC_FIELD_LS].data[i].down->var[s],
+                           1, 1, ntime_sub[cat][s]);
+    /* Free temporary buffer */
+    (void) free(buf_sub);
+
+    /* Select season months in the whole time period to create a 2D sub-period buffer */
+    if (data->field[cat].single_precision == TRUE)
+      (void) extract_subperiod_months_f(&buf_sub, &(ntime_sub[cat][s]), data->field[cat].data[i].field_ls_f,
+                                        data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
+                                        data->conf->time_units, data->conf->cal_type, (period_struct *) NULL,
+                                        data->conf->season[s].month, 3, data->field[cat].time_ls,
+                                        data->field[cat].nlon_ls, data->field[cat].nlat_ls,
+                                        data->field[cat].ntime_ls, data->conf->season[s].nmonths);
+    else
+      (void) extract_subperiod_months(&buf_sub, &(ntime_sub[cat][s]), data->field[cat].data[i].field_ls,
+                                      data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
+                                      data->conf->time_units, data->conf->cal_type, (period_struct *) NULL,
+                                      data->conf->season[s].month, 3, data->field[cat].time_ls,
+                                      data->field[cat].nlon_ls, data->field[cat].nlat_ls,
+                                      data->field[cat].ntime_ls, data->conf->season[s].nmonths);
+    /* Normalize the secondary large-scale fields */
+    data->field[cat].data[i].down->sup_val_norm[s] =
+      (double *) alloc_large(data->field[cat].nlon_ls*data->field[cat].nlat_ls*data->field[cat].ntime_ls * sizeof(double));
+    if (data->field[cat].data[i].down->sup_val_norm[s] == NULL) alloc_error(__FILE__, __LINE__);
+    (void) normalize_field_2d(data->field[cat].data[i].down->sup_val_norm[s], buf_sub,
+                              data->field[CTRL_SEC_FIELD_LS].data[i].down->smean_2d[s],
+                              data->field[CTRL_SEC_FIELD_LS].data[i].down->svar_2d[s],
+                              data->field[cat].nlon_ls, data->field[cat].nlat_ls, ntime_sub[cat][s]);
+    /* Free temporary buffer */
+    (void) free(buf_sub);
+  }
+
+  return 0;
+}
+
+/** Compute the precipitation index of one season using the pre-computed regressions (step 9). */
+static int
+downscaling_task_regression(void *arg) {
+  /**
+     @param[in]  arg  Downscaling task structure.
+
+     \return          Status.
+  */
+
+  downscaling_task_struct *task = (downscaling_task_struct *) arg; /* Task arguments */
+  data_struct *data = task->data; /* MASTER data structure */
+  int cat = task->cat; /* Field category */
+  int s = task->s; /* Season */
+  int **ntime_sub = task->ntime_sub; /* Number of times for sub-periods */
+  int ntime_sub_tmp; /* Number of times for regression diagnostics output */
+  int i; /* Loop counter */
+  instrument_timer_struct timer; /* Instrumentation timer */
+
+  (void) instrument_begin(&timer, "regression");
+
+  /* Apply the regression coefficients to calculate precipitation using the cluster distances */
+  /* and the normalized spatial mean of the corresponding secondary large-scale field. */
+  /* When several large-scale fields are available, the precipitation index of the last one is kept. */
+  data->field[cat].precip_index[s] = (double *) malloc(data->reg->npts*ntime_sub[cat+2][s] * sizeof(double));
+  if (data->field[cat].precip_index[s] == NULL) alloc_error(__FILE__, __LINE__);
+  for (i=0; i<data->field[cat].n_ls; i++)
+    (void) apply_regression(data->field[cat].precip_index[s], data->learning->data[s].precip_reg,
+                            data->learning->data[s].precip_reg_cst,
+                            data->field[cat].data[i].down->dist[s], data->field[cat+2].data[i].down->smean_norm[s],
+                            data->reg->npts, ntime_sub[cat+2][s], data->conf->season[s].nclusters, data->conf->season[s].nreg);
+
+  if (data->reg->reg_save == TRUE)
+    /* Select season months in the whole time period and create sub-period time vector */
+    (void) extract_subperiod_months(&(task->time_ls_sub[cat][s]), &ntime_sub_tmp, data->field[cat].time_ls,
+                                    data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
+                                    data->conf->time_units, data->conf->cal_type, (period_struct *) NULL,
+                                    data->conf->season[s].month,
+                                    1, data->field[cat].time_ls, 1, 1, data->field[cat].ntime_ls,
+                                    data->conf->season[s].nmonths);
+
+  (void) instrument_end(&timer);
+
+  return 0;
+}
+
+/** Find the analog days of one season: resampling (step 10). */
+static int
+downscaling_task_analogs(void *arg) {
+  /**
+     @param[in]  arg  Downscaling task structure.
+
+     \return          Status.
+  */
+
+  downscaling_task_struct *task = (downscaling_task_struct *) arg; /* Task arguments */
+  data_struct *data = task->data; /* MASTER data structure */
+  int cat = task->cat; /* Field category */
+  int s = task->s; /* Season */
+  int **ntime_sub = task->ntime_sub; /* Number of times for sub-periods */
+  int istat; /* Function return diagnostic value */
+  int i; /* Large-scale field index */
+  instrument_timer_struct timer; /* Instrumentation timer */
+
+  (void) instrument_begin(&timer, "analog_search");
+
+  /* Select the first large-scale field which must contain the cluster distances */
+  /* and the first secondary large-scale fields which must contains its spatial mean */
+  i = 0;
+
+  /* Find the analog days in the learning period given the precipitation index, */
+  /* the spatial mean of the secondary large-scale fields and its index, and the cluster classification of the days */
+  data->field[cat].analog_days[s].ntime = ntime_sub[cat][s];
+  data->field[cat].analog_days[s].time = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].time == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].tindex = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].tindex == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].tindex_all = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].tindex_all == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].year = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].year == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].month = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].month == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].day = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].day == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].tindex_s_all = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].tindex_s_all == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].year_s = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].year_s == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].month_s = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].month_s == NULL) alloc_error(__FILE__, __LINE__);
+  data->field[cat].analog_days[s].day_s = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
+  if (data->field[cat].analog_days[s].day_s == NULL) alloc_error(__FILE__, __LINE__);
+  (void) alloc_dayschoice(&(data->field[cat].analog_days[s]), ntime_sub[cat][s], data->conf->season[s].ndayschoices);
+  (void) printf("%s: Searching analog days for season #%d\n", __FILE__, s);
+  istat = find_the_days(data->field[cat].analog_days[s], data->field[cat].precip_index[s], data->learning->data[s].precip_index,
+                        data->field[cat+2].data[i].down->smean_norm[s], data->learning->data[s].sup_index,
+                        data->field[cat+2].data[i].down->sup_val_norm[s], data->learning->data[s].sup_val, task->mask_sub,
+                        data->field[cat].data[i].down->days_class_clusters[s], data->learning->data[s].class_clusters,
+                        data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
+                        data->learning->data[s].time_s->year, data->learning->data[s].time_s->month,
+                        data->learning->data[s].time_s->day, data->conf->time_units,
+                        data->field[cat].ntime_ls, data->learning->data[s].ntime,
+                        data->conf->season[s].month, data->conf->season[s].nmonths,
+                        data->conf->season[s].ndays, data->conf->season[s].ndayschoices, data->reg->npts,
+                        data->conf->season[s].shuffle, data->conf->season[s].secondary_choice,
+                        data->conf->season[s].secondary_main_choice, data->conf->season[s].secondary_cov,
+                        data->conf->use_downscaled_year, data->conf->only_wt,
+                        data->field[cat+2].nlon_ls, data->field[cat+2].nlat_ls,
+                        data->learning->sup_nlon, data->learning->sup_nlat);
+
+  (void) instrument_end(&timer);
+
+  return istat;
+}
+
+/** Compute the secondary large-scale fields difference of one season (step 11). */
+static int
+downscaling_task_delta(void *arg) {
+  /**
+     @param[in]  arg  Downscaling task structure.
+
+     \return          Status.
+  */
+
+  downscaling_task_struct *task = (downscaling_task_struct *) arg; /* Task arguments */
+  data_struct *data = task->data; /* MASTER data structure */
+  int cat = task->cat; /* Field category */
+  int s = task->s; /* Season */
+  int **ntime_sub = task->ntime_sub; /* Number of times for sub-periods */
+  int i; /* Loop counter */
+  int ii; /* Loop counter */
+
+  /* Loop over secondary large-scale fields */
+  for (i=0; i<data->field[cat].n_ls; i++) {
+    data->field[cat].data[i].down->delta[s] = (double *) malloc(ntime_sub[cat][s] * sizeof(double));
+    if (data->field[cat].data[i].down->delta[s] == NULL) alloc_error(__FILE__, __LINE__);
+    /* Rows point into one contiguous block starting at row 0 */
+    data->field[cat].data[i].down->delta_dayschoice[s] =
+      (double **) malloc((ntime_sub[cat][s] > 0 ? ntime_sub[cat][s] : 1) * sizeof(double *));
+    if (data->field[cat].data[i].down->delta_dayschoice[s] == NULL) alloc_error(__FILE__, __LINE__);
+    data->field[cat].data[i].down->delta_dayschoice[s][0] =
+      (double *) calloc((size_t) (ntime_sub[cat][s] > 0 ? ntime_sub[cat][s] : 1) * (size_t) data->conf->season[s].ndayschoices,
+                        sizeof(double));
+    if (data->field[cat].data[i].down->delta_dayschoice[s][0] == NULL) alloc_error(__FILE__, __LINE__);
+    for (ii=1; ii<ntime_sub[cat][s]; ii++)
+      data->field[cat].data[i].down->delta_dayschoice[s][ii] =
+        data->field[cat].data[i].down->delta_dayschoice[s][0] + (size_t) ii * (size_t) data->conf->season[s].ndayschoices;
+    (void) compute_secondary_large_scale_diff(data->field[cat].data[i].down->delta[s],
+                                              data->field[cat].data[i].down->delta_dayschoice[s],
+                                              data->field[cat-2].analog_days[s],
+                                              data->field[cat].data[i].down->smean_norm[s], data->learning->data[s].sup_index,
+                                              data->field[CTRL_SEC_FIELD_LS].data[i].down->var[s],
+                                              data->learning->data[s].sup_index_var, ntime_sub[cat][s]);
+  }
+
+  return 0;
+}
+
+/** Read EOFs and Singular Values of the large-scale fields, in the background while climatologies are removed. */
+static int
+downscaling_read_eof(void *arg, size_t *nbytes) {
+  /**
+     @param[in]  arg     MASTER data structure.
+     @param[out] nbytes  Number of bytes allocated.
+
+     \return             Status.
+  */
+
+  data_struct *data = (data_struct *) arg; /* MASTER data structure */
+  int istat; /* Diagnostic status */
+  int cat; /* Field category loop counter */
+  int i; /* Loop counter */
+
+  /* The NetCDF library is not thread-safe */
+  (void) nc_io_lock();
+  istat = read_large_scale_eof(data);
+  (void) nc_io_unlock();
+
+  *nbytes = 0;
+  if (istat == 0)
+    for (cat=0; cat<2; cat++)
+      for (i=0; i<data->field[cat].n_ls; i++)
+        if (data->field[cat].data[i].eof_info->eof_project == TRUE)
+          *nbytes += (size_t) data->field[cat].nlon_eof_ls * (size_t) data->field[cat].nlat_eof_ls *
+            (size_t) data->field[cat].data[i].eof_info->neof_ls * sizeof(double);
+
+  return istat;
+}
+
 /** Downscaling climate scenarios program using weather typing. */
 int
 wt_downscaling(data_struct *data) {
@@ -80,13 +406,13 @@ wt_downscaling(data_struct *data) {
   double *lat_mask = NULL; /* Latitudes of mask */
   double *var_pc_norm_all = NULL; /* Temporary values of the norm of the principal components */
   int **ntime_sub = NULL; /* Number of times for sub-periods. Dimensions number of field categories (NCAT) and number of seasons */
-  double **time_ls_sub = NULL; /* Time values used for regression diagnostics output */
+  double ***time_ls_sub = NULL; /* Time values used for regression diagnostics output. Dimensions NCAT and number of seasons */
+  double ***pc_norm = NULL; /* Normalized principal components of the large-scale fields. Dimensions NCAT and number of fields */
   int *merged_itimes = NULL; /* Time values in common merged time vector */
   int ntimes_merged; /* Number of times in one particular season */
   int curindex_merged; /* Current index in merged season vector */
   short int *merged_times_flag = NULL; /* Flag variable for days in the year that are processed */
   double *merged_times = NULL; /* Merge times in udunit */
-  int ntime_sub_tmp; /* Number of times for regression diagnostics output */
   int ntime_sub_learn; /* Number of times for learning common sub-period with control run for a specific season */
   int ntime_sub_learn_all; /* Number of times for learning common sub-period with control run for whole period */
   int nlon_mask; /* Longitude dimension for mask subdomain */
@@ -101,29 +427,49 @@ wt_downscaling(data_struct *data) {
   int maxndays; /* Maximum number of analog days choices within all seasons */
 
   char *analog_file = NULL; /* Analog data filename */
+  char *checkpoint_prefix = NULL; /* Prefix of completed output year checkpoints */
   period_struct *period = NULL; /* Period structure for output */
 
   char *filename = NULL; /* Temporary filename for regression optional output */
+
+  prefetch_struct *prefetch = NULL; /* Background read of EOFs */
+  prefetch_item_struct *eof_read = NULL; /* Read of EOFs */
+
+  task_graph_struct *graph = NULL; /* Graph of downscaling tasks */
+  downscaling_task_struct *tasks = NULL; /* Arguments of downscaling tasks for each field category and season */
+  downscaling_task_struct *task = NULL; /* Arguments of current downscaling task */
+
+  instrument_timer_struct timer; /* Instrumentation timer */
   
   if (data->conf->output_only != TRUE) {
   
     /* Allocate memory */
-    ntime_sub = (int **) malloc(NCAT * sizeof(int *));
+    ntime_sub = (int **) arena_alloc(data->arena[PHASE_DOWNSCALING], NCAT * sizeof(int *));
     if (ntime_sub == NULL) alloc_error(__FILE__, __LINE__);
 
     if (data->reg->reg_save == TRUE) {
-      time_ls_sub = (double **) malloc(data->conf->nseasons * sizeof(double *));
+      time_ls_sub = (double ***) arena_alloc(data->arena[PHASE_DOWNSCALING], NCAT * sizeof(double **));
       if (time_ls_sub == NULL) alloc_error(__FILE__, __LINE__);
+      for (cat=0; cat<NCAT; cat++) {
+        time_ls_sub[cat] = (double **) arena_alloc(data->arena[PHASE_DOWNSCALING], data->conf->nseasons * sizeof(double *));
+        if (time_ls_sub[cat] == NULL) alloc_error(__FILE__, __LINE__);
+      }
     }
     
     for (cat=0; cat<NCAT; cat++) {
-      ntime_sub[cat] = (int *) malloc(data->conf->nseasons * sizeof(int));
+      ntime_sub[cat] = (int *) arena_alloc(data->arena[PHASE_DOWNSCALING], data->conf->nseasons * sizeof(int));
       if (ntime_sub[cat] == NULL) alloc_error(__FILE__, __LINE__);
     }
 
     /** Step 1: Read large-scale fields **/
+    (void) instrument_begin(&timer, "read_fields");
     istat = read_large_scale_fields(data);
     if (istat != 0) return istat;
+    (void) instrument_end(&timer);
+
+    /* Read EOFs in the background while climatologies are removed */
+    prefetch = prefetch_create((size_t) data->conf->prefetch_memory * 1024 * 1024);
+    eof_read = prefetch_submit(prefetch, downscaling_read_eof, (void *) data);
     
     /* Prepare optional mask for secondary large-scale fields */
     if (data->secondary_mask->use_mask == TRUE) {
@@ -150,7 +496,7 @@ wt_downscaling(data_struct *data) {
       }
       /* Dimensions are ok and we are using a mask. Get values into short int buffer. */
       if (data->secondary_mask->use_mask == TRUE) {
-        mask_sub = (short int *) malloc(data->field[SEC_FIELD_LS].nlon_ls*data->field[SEC_FIELD_LS].nlat_ls * sizeof(short int));
+        mask_sub = (short int *) arena_alloc(data->arena[PHASE_DOWNSCALING], data->field[SEC_FIELD_LS].nlon_ls*data->field[SEC_FIELD_LS].nlat_ls * sizeof(short int));
         if (mask_sub == NULL) alloc_error(__FILE__, __LINE__);
         for (i=0; i<data->field[SEC_FIELD_LS].nlon_ls*data->field[SEC_FIELD_LS].nlat_ls; i++)
           mask_sub[i] = (short int) mask_subd[i];
@@ -166,13 +512,21 @@ wt_downscaling(data_struct *data) {
       printf("%s: Using a mask for secondary large-scale fields.\n", __FILE__);
 
     /** Step 2: Compute climatologies and remove them from selected large scale fields **/
+    (void) instrument_begin(&timer, "remove_clim");
     istat = remove_clim(data);
-    if (istat != 0) return istat;  
+    (void) instrument_end(&timer);
+    if (istat != 0) {
+      (void) prefetch_free(prefetch);
+      return istat;
+    }
 
     /** Step 3: Project selected large scale fields on EOF **/  
+    (void) instrument_begin(&timer, "eof_projection");
 
-    /* Read EOFs and Singular Values */
-    istat = read_large_scale_eof(data);
+    /* Wait for EOFs and Singular Values */
+    istat = prefetch_wait(prefetch, eof_read);
+    (void) prefetch_release(prefetch, eof_read);
+    (void) prefetch_free(prefetch);
     if (istat != 0) return istat;
   
     /* Project selected large scale fields on EOF */
@@ -187,13 +541,22 @@ wt_downscaling(data_struct *data) {
                                                                     sizeof(double));
           if (data->field[cat].data[i].field_eof_ls == NULL) alloc_error(__FILE__, __LINE__);
           /* Project large-scale field on EOFs */
-          istat = project_field_eof(data->field[cat].data[i].field_eof_ls, data->field[cat].data[i].field_ls,
-                                    data->field[cat].data[i].eof_data->eof_ls, data->field[cat].data[i].eof_data->sing_ls,
-                                    data->field[cat].data[i].eof_info->info->fillvalue, 
-                                    data->field[cat].lon_eof_ls, data->field[cat].lat_eof_ls, 
-                                    data->field[cat].data[i].eof_info->eof_scale,
-                                    data->field[cat].nlon_eof_ls, data->field[cat].nlat_eof_ls, data->field[cat].ntime_ls,
-                                    data->field[cat].data[i].eof_info->neof_ls);
+          if (data->field[cat].single_precision == TRUE)
+            istat = project_field_eof_f(data->field[cat].data[i].field_eof_ls, data->field[cat].data[i].field_ls_f,
+                                        data->field[cat].data[i].eof_data->eof_ls, data->field[cat].data[i].eof_data->sing_ls,
+                                        data->field[cat].data[i].eof_info->info->fillvalue, 
+                                        data->field[cat].lon_eof_ls, data->field[cat].lat_eof_ls, 
+                                        data->field[cat].data[i].eof_info->eof_scale,
+                                        data->field[cat].nlon_eof_ls, data->field[cat].nlat_eof_ls, data->field[cat].ntime_ls,
+                                        data->field[cat].data[i].eof_info->neof_ls);
+          else
+            istat = project_field_eof(data->field[cat].data[i].field_eof_ls, data->field[cat].data[i].field_ls,
+                                      data->field[cat].data[i].eof_data->eof_ls, data->field[cat].data[i].eof_data->sing_ls,
+                                      data->field[cat].data[i].eof_info->info->fillvalue, 
+                                      data->field[cat].lon_eof_ls, data->field[cat].lat_eof_ls, 
+                                      data->field[cat].data[i].eof_info->eof_scale,
+                                      data->field[cat].nlon_eof_ls, data->field[cat].nlat_eof_ls, data->field[cat].ntime_ls,
+                                      data->field[cat].data[i].eof_info->neof_ls);
           if (istat != 0) return istat;
         }
       }
@@ -201,7 +564,10 @@ wt_downscaling(data_struct *data) {
 
     /** CONTROL RUN **/
 
+    (void) instrument_end(&timer);
+
     /** Step 4: Compute distance to clusters for the control run **/
+    (void) instrument_begin(&timer, "clustering");
     /* Process control run only */
     cat = CTRL_FIELD_LS;
     /* Loop over large-scale fields */
@@ -288,6 +654,8 @@ wt_downscaling(data_struct *data) {
       (void) free(buftmp);
     }
 
+    (void) instrument_end(&timer);
+
     /** Step 5: Compute mean and variance of secondary large-scale fields for the control run **/
 
     /* Process only secondary field of control run. */
@@ -299,20 +667,32 @@ wt_downscaling(data_struct *data) {
       data->field[cat].data[i].down->smean = (double *) malloc(data->field[cat].ntime_ls * sizeof(double));
       if (data->field[cat].data[i].down->smean == NULL) alloc_error(__FILE__, __LINE__);
 
-      (void) mean_field_spatial(data->field[cat].data[i].down->smean, data->field[cat].data[i].field_ls, mask_sub,
-                                data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
+      if (data->field[cat].single_precision == TRUE)
+        (void) mean_field_spatial_f(data->field[cat].data[i].down->smean, data->field[cat].data[i].field_ls_f, mask_sub,
+                                    data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
+      else
+        (void) mean_field_spatial(data->field[cat].data[i].down->smean, data->field[cat].data[i].field_ls, mask_sub,
+                                  data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
 
       for (s=0; s<data->conf->nseasons; s++) {
       
         /* Compute seasonal mean and variance of principal components of selected large-scale fields */
       
         /* Select common time period between the learning period and the model period (control run) */
-        istat = sub_period_common(&buf_sub, &ntime_sub_learn, data->field[cat].data[i].field_ls,
-                                  data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
-                                  data->learning->data[s].time_s->year, data->learning->data[s].time_s->month,
-                                  data->learning->data[s].time_s->day, 3,
-                                  data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls,
-                                  data->learning->data[s].ntime);
+        if (data->field[cat].single_precision == TRUE)
+          istat = sub_period_common_f(&buf_sub, &ntime_sub_learn, data->field[cat].data[i].field_ls_f,
+                                      data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
+                                      data->learning->data[s].time_s->year, data->learning->data[s].time_s->month,
+                                      data->learning->data[s].time_s->day, 3,
+                                      data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls,
+                                      data->learning->data[s].ntime);
+        else
+          istat = sub_period_common(&buf_sub, &ntime_sub_learn, data->field[cat].data[i].field_ls,
+                                    data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
+                                    data->learning->data[s].time_s->year, data->learning->data[s].time_s->month,
+                                    data->learning->data[s].time_s->day, 3,
+                                    data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls,
+                                    data->learning->data[s].ntime);
         if (istat != 0) return istat;
       
         /* Compute seasonal mean and variance of spatially-averaged secondary field */
@@ -349,283 +729,136 @@ wt_downscaling(data_struct *data) {
       /* Compute spatial mean of secondary large-scale fields */
       data->field[cat].data[i].down->smean = (double *) malloc(data->field[cat].ntime_ls * sizeof(double));
       if (data->field[cat].data[i].down->smean == NULL) alloc_error(__FILE__, __LINE__);
-      (void) mean_field_spatial(data->field[cat].data[i].down->smean, data->field[cat].data[i].field_ls, mask_sub,
-                                data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
+      if (data->field[cat].single_precision == TRUE)
+        (void) mean_field_spatial_f(data->field[cat].data[i].down->smean, data->field[cat].data[i].field_ls_f, mask_sub,
+                                    data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
+      else
+        (void) mean_field_spatial(data->field[cat].data[i].down->smean, data->field[cat].data[i].field_ls, mask_sub,
+                                  data->field[cat].nlon_ls, data->field[cat].nlat_ls, data->field[cat].ntime_ls);
     }
     
-    /** Step 7: Compute distance to clusters (model run and optionally control run) **/
+    /** Steps 7 to 11: Downscale each field category and season **/
+    /* Each season of the model run and of the control run only depends on the previous steps of the same season */
+    /* and field category: the steps are expressed as a graph of tasks executed concurrently. */
+    (void) instrument_begin(&timer, "downscaling_tasks");
 
     /* Downscale also control run if needed */  
     if (data->conf->period_ctrl->downscale == TRUE)
       beg_cat = CTRL_FIELD_LS;
     else
       beg_cat = FIELD_LS;
-    /* Loop over larg-scale field categories (model run and optionally control run) */
+
+    /* Normalisation of the principal components by the square root of the variance of the control run */
+    pc_norm = (double ***) arena_calloc(data->arena[PHASE_DOWNSCALING], NCAT, sizeof(double **));
+    if (pc_norm == NULL) alloc_error(__FILE__, __LINE__);
     for (cat=beg_cat; cat>=FIELD_LS; cat--) {
-      /* Loop over large-scale fields */
+      pc_norm[cat] = (double **) arena_calloc(data->arena[PHASE_DOWNSCALING], (data->field[cat].n_ls > 0) ? data->field[cat].n_ls : 1,
+                                              sizeof(double *));
+      if (pc_norm[cat] == NULL) alloc_error(__FILE__, __LINE__);
       for (i=0; i<data->field[cat].n_ls; i++) {
-      
-        /* Allocate memory for temporary buffer */
-        buftmp = (double *) malloc(data->field[cat].ntime_ls*data->field[cat].data[i].eof_info->neof_ls * sizeof(double));
-        if (buftmp == NULL) alloc_error(__FILE__, __LINE__); 
-      
-        /* Normalisation of the principal component by the square root of the variance of the control run */
+        pc_norm[cat][i] = (double *) malloc(data->field[cat].ntime_ls*data->field[cat].data[i].eof_info->neof_ls * sizeof(double));
+        if (pc_norm[cat][i] == NULL) alloc_error(__FILE__, __LINE__); 
         var_pc_norm_all = (double *) malloc(data->field[cat].data[i].eof_info->neof_ls * sizeof(double));
         if (var_pc_norm_all == NULL) alloc_error(__FILE__, __LINE__);
-        (void) normalize_pc(var_pc_norm_all, &(data->field[CTRL_FIELD_LS].data[i].first_variance), buftmp,
+        (void) normalize_pc(var_pc_norm_all, &(data->field[CTRL_FIELD_LS].data[i].first_variance), pc_norm[cat][i],
                             data->field[cat].data[i].field_eof_ls, data->field[cat].data[i].eof_info->neof_ls,
                             data->field[cat].ntime_ls);
         (void) free(var_pc_norm_all);
-      
-        /* Loop over seasons */
-        for (s=0; s<data->conf->nseasons; s++) {
-
-          /* Select season months in the whole time period and create sub-period large-scale field buffer */
-          (void) extract_subperiod_months(&buf_sub, &(ntime_sub[cat][s]), buftmp,
-                                          data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
-                                          data->conf->time_units, data->conf->cal_type, period,
-                                          data->conf->season[s].month,
-                                          1, data->field[cat].time_ls, 1,
-                                          data->field[cat].data[i].eof_info->neof_ls, data->field[cat].ntime_ls,
-                                          data->conf->season[s].nmonths);
-
-          /* Compute distances to clusters using normalization and against the control reference run */
-          data->field[cat].data[i].down->dist[s] = (double *) 
-            malloc(data->conf->season[s].nclusters*ntime_sub[cat][s] * sizeof(double));
-          if (data->field[cat].data[i].down->dist[s] == NULL) alloc_error(__FILE__, __LINE__);
-          (void) dist_clusters_normctrl(data->field[cat].data[i].down->dist[s], buf_sub, data->learning->data[s].weight,
-                                        data->learning->pc_normalized_var, data->field[CTRL_FIELD_LS].data[i].down->var_pc_norm,
-                                        data->field[CTRL_FIELD_LS].data[i].down->mean_dist[s],
-                                        data->field[CTRL_FIELD_LS].data[i].down->var_dist[s],
-                                        data->field[cat].data[i].eof_info->neof_ls, data->conf->season[s].nclusters,
-                                        ntime_sub[cat][s]);
-          /* Classify each day in the current clusters */
-          data->field[cat].data[i].down->days_class_clusters[s] = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].data[i].down->days_class_clusters[s] == NULL) alloc_error(__FILE__, __LINE__);
-          (void) class_days_pc_clusters(data->field[cat].data[i].down->days_class_clusters[s], buf_sub,
-                                        data->learning->data[s].weight, data->conf->classif_type,
-                                        data->field[cat].data[i].eof_info->neof_ls, data->conf->season[s].nclusters,
-                                        ntime_sub[cat][s]);
-          /* Free temporary buffer */
-          (void) free(buf_sub);
-        }
-        /* Free temporary buffer */
-        (void) free(buftmp);
       }
     }
-  
-    /** Step 8: Normalize the secondary large-scale fields by control-run mean and variance **/
 
-    /* Downscale also control run if needed */
-    if (data->conf->period_ctrl->downscale == TRUE)
-      beg_cat = CTRL_SEC_FIELD_LS;
-    else
-      beg_cat = SEC_FIELD_LS;
+    /* Arguments of the tasks of each field category and season */
+    tasks = (downscaling_task_struct *) arena_calloc(data->arena[PHASE_DOWNSCALING], NCAT*data->conf->nseasons,
+                                                     sizeof(downscaling_task_struct));
+    if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+    for (cat=0; cat<NCAT; cat++)
+      for (s=0; s<data->conf->nseasons; s++) {
+        task = &(tasks[s+cat*data->conf->nseasons]);
+        task->data = data;
+        task->cat = cat;
+        task->s = s;
+        task->ntime_sub = ntime_sub;
+        task->pc_norm = pc_norm;
+        task->time_ls_sub = time_ls_sub;
+        task->mask_sub = mask_sub;
+        task->classify = NULL;
+        task->secondary = NULL;
+        task->regression = NULL;
+        task->analogs = NULL;
+        task->delta = NULL;
+      }
 
-    /* Loop over secondary field categories (model run and optionally control run) */
-    for (cat=beg_cat; cat>=SEC_FIELD_LS; cat--) {
-      /* Loop over secondary large-scale fields */
-      for (i=0; i<data->field[cat].n_ls; i++)
-        /* Loop over each season */
-        for (s=0; s<data->conf->nseasons; s++) {
-          /* Select season months in the whole time period to create a sub-period buffer */
-          (void) extract_subperiod_months(&buf_sub, &(ntime_sub[cat][s]), data->field[cat].data[i].down->smean,
-                                          data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
-                                          data->conf->time_units, data->conf->cal_type, period,
-                                          data->conf->season[s].month, 3, data->field[cat].time_ls, 1,
-                                          1, data->field[cat].ntime_ls, data->conf->season[s].nmonths);
-          /* Normalize the spatial mean of secondary large-scale fields */
-          data->field[cat].data[i].down->smean_norm[s] = (double *) malloc(data->field[cat].ntime_ls * sizeof(double));
-          if (data->field[cat].data[i].down->smean_norm[s] == NULL) alloc_error(__FILE__, __LINE__);
-          (void) normalize_field(data->field[cat].data[i].down->smean_norm[s], buf_sub,
-                                 data->field[CTRL_SEC_FIELD_LS].data[i].down->mean[s], data->field[CTRL_SEC_FIELD_LS].data[i].down->var[s],
-                                 1, 1, ntime_sub[cat][s]);
-          /* Free temporary buffer */
-          (void) free(buf_sub);
-
-          /* Select season months in the whole time period to create a 2D sub-period buffer */
-          (void) extract_subperiod_months(&buf_sub, &(ntime_sub[cat][s]), data->field[cat].data[i].field_ls,
-                                          data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
-                                          data->conf->time_units, data->conf->cal_type, period,
-                                          data->conf->season[s].month, 3, data->field[cat].time_ls,
-                                          data->field[cat].nlon_ls, data->field[cat].nlat_ls,
-                                          data->field[cat].ntime_ls, data->conf->season[s].nmonths);
-          /* Normalize the secondary large-scale fields */
-          data->field[cat].data[i].down->sup_val_norm[s] =
-            (double *) malloc(data->field[cat].nlon_ls*data->field[cat].nlat_ls*data->field[cat].ntime_ls * sizeof(double));
-          if (data->field[cat].data[i].down->sup_val_norm[s] == NULL) alloc_error(__FILE__, __LINE__);
-          (void) normalize_field_2d(data->field[cat].data[i].down->sup_val_norm[s], buf_sub,
-                                    data->field[CTRL_SEC_FIELD_LS].data[i].down->smean_2d[s],
-                                    data->field[CTRL_SEC_FIELD_LS].data[i].down->svar_2d[s],
-                                    data->field[cat].nlon_ls, data->field[cat].nlat_ls, ntime_sub[cat][s]);
-          /* Free temporary buffer */
-          (void) free(buf_sub);
+    /* Build the graph of tasks, season by season */
+    graph = task_graph_create(data->conf->nthreads);
+    for (s=0; s<data->conf->nseasons; s++) {
+      /* Step 8: Normalize the secondary large-scale fields by control-run mean and variance */
+      for (cat=beg_cat+2; cat>=SEC_FIELD_LS; cat--)
+        if (data->field[cat].n_ls > 0) {
+          task = &(tasks[s+cat*data->conf->nseasons]);
+          task->secondary = task_graph_add(graph, downscaling_task_secondary, (void *) task);
+        }
+      for (cat=beg_cat; cat>=FIELD_LS; cat--)
+        /* Process only if, for this category, at least one large-scale field is available */
+        if (data->field[cat].n_ls > 0) {
+          task = &(tasks[s+cat*data->conf->nseasons]);
+          /* Step 7: Compute distance to clusters */
+          task->classify = task_graph_add(graph, downscaling_task_classify, (void *) task);
+          /* Step 9: Compute the precipitation using the pre-computed regressions */
+          task->regression = task_graph_add(graph, downscaling_task_regression, (void *) task);
+          (void) task_graph_depend(task->regression, task->classify);
+          (void) task_graph_depend(task->regression, tasks[s+(cat+2)*data->conf->nseasons].secondary);
+          /* Step 10: Find the days : resampling */
+          task->analogs = task_graph_add(graph, downscaling_task_analogs, (void *) task);
+          (void) task_graph_depend(task->analogs, task->regression);
+          (void) task_graph_depend(task->analogs, tasks[s+(cat+2)*data->conf->nseasons].secondary);
+        }
+      /* Step 11: Compute the secondary large-scale fields difference */
+      for (cat=beg_cat+2; cat>=SEC_FIELD_LS; cat--)
+        if (data->field[cat].n_ls > 0) {
+          task = &(tasks[s+cat*data->conf->nseasons]);
+          task->delta = task_graph_add(graph, downscaling_task_delta, (void *) task);
+          (void) task_graph_depend(task->delta, task->secondary);
+          (void) task_graph_depend(task->delta, tasks[s+(cat-2)*data->conf->nseasons].analogs);
         }
     }
 
-    /** Step 9: Compute the precipitation using the pre-computed regressions for the model run for each season **/
+    /* Execute all tasks */
+    istat = task_graph_run(graph);
+    (void) task_graph_free(graph);
 
-    /* Select the first large-scale field which must contain the cluster distances */
-    /* and the first secondary large-scale fields which must contains its spatial mean */
-    i = 0;
+    for (cat=beg_cat; cat>=FIELD_LS; cat--)
+      for (i=0; i<data->field[cat].n_ls; i++)
+        (void) free(pc_norm[cat][i]);
 
-    /* Downscale also control run if needed */
-    if (data->conf->period_ctrl->downscale == TRUE)
-      beg_cat = CTRL_FIELD_LS;
-    else
-      beg_cat = FIELD_LS;
+    (void) instrument_end(&timer);
 
-    /* Loop over large-scale field categories (model run and optionally control run) */
-    for (cat=beg_cat; cat>=FIELD_LS; cat--) {
-      /* Process only if, for this category, at least one large-scale field is available */
-      for (i=0; i<data->field[cat].n_ls; i++) {
-        /* Loop over each season */
-        for (s=0; s<data->conf->nseasons; s++) {
-          /* Apply the regression coefficients to calculate precipitation using the cluster distances */
-          /* and the normalized spatial mean of the corresponding secondary large-scale field */
-          data->field[cat].precip_index[s] = (double *) malloc(data->reg->npts*ntime_sub[cat+2][s] * sizeof(double));
-          if (data->field[cat].precip_index[s] == NULL) alloc_error(__FILE__, __LINE__);
-          (void) apply_regression(data->field[cat].precip_index[s], data->learning->data[s].precip_reg,
-                                  data->learning->data[s].precip_reg_cst,
-                                  data->field[cat].data[i].down->dist[s], data->field[cat+2].data[i].down->smean_norm[s],
-                                  data->reg->npts, ntime_sub[cat+2][s], data->conf->season[s].nclusters, data->conf->season[s].nreg);
-          if (data->reg->reg_save == TRUE)
-            /* Select season months in the whole time period and create sub-period time vector */
-            (void) extract_subperiod_months(&(time_ls_sub[s]), &ntime_sub_tmp, data->field[cat].time_ls,
-                                            data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
-                                            data->conf->time_units, data->conf->cal_type, period,
-                                            data->conf->season[s].month,
-                                            1, data->field[cat].time_ls, 1, 1, data->field[cat].ntime_ls,
-                                            data->conf->season[s].nmonths);
-        }
-        if (data->reg->reg_save == TRUE) {
+    if (istat != 0) return istat;
+
+    /* Regression diagnostics output */
+    if (data->reg->reg_save == TRUE) {
+      for (cat=beg_cat; cat>=FIELD_LS; cat--)
+        if (data->field[cat].n_ls > 0) {
           (void) printf("Writing downscaling regression diagnostic fields.\n");
           if (cat == CTRL_FIELD_LS)
             filename = data->reg->filename_save_ctrl_reg;
           else
             filename = data->reg->filename_save_other_reg;
-          (void) write_regression_fields(data, filename, time_ls_sub, ntime_sub[cat+2],
+          i = data->field[cat].n_ls - 1;
+          (void) write_regression_fields(data, filename, time_ls_sub[cat], ntime_sub[cat+2],
                                          data->field[cat].precip_index,
                                          data->field[cat].data[i].down->dist,
                                          data->field[cat+2].data[i].down->smean_norm);
-        }
-      }
-    }
-    if (data->reg->reg_save == TRUE) {
-      for (s=0; s<data->conf->nseasons; s++)
-        (void) free(time_ls_sub[s]);
-      (void) free(time_ls_sub);
-    }
-  
-    /** Step 10: Find the days : resampling **/
-
-    /* Select the first large-scale field which must contain the cluster distances */
-    /* and the first secondary large-scale fields which must contains its spatial mean */
-    i = 0;
-
-    /* Downscale also control run if needed */  
-    if (data->conf->period_ctrl->downscale == TRUE)
-      beg_cat = CTRL_FIELD_LS;
-    else
-      beg_cat = FIELD_LS;
-
-    /* Loop over large-scale field categories (model run and optionally control run) */
-    for (cat=beg_cat; cat>=FIELD_LS; cat--) {
-      /* Process only if, for this category, at least one large-scale field is available */
-      if (data->field[cat].n_ls > 0)
-        /* Loop over each season */
-        for (s=0; s<data->conf->nseasons; s++) {
-          /* Find the analog days in the learning period given the precipitation index, */
-          /* the spatial mean of the secondary large-scale fields and its index, and the cluster classification of the days */
-          data->field[cat].analog_days[s].ntime = ntime_sub[cat][s];
-          data->field[cat].analog_days[s].time = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].time == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].tindex = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].tindex == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].tindex_all = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].tindex_all == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].year = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].year == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].month = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].month == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].day = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].day == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].tindex_s_all = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].tindex_s_all == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].year_s = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].year_s == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].month_s = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].month_s == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].day_s = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].day_s == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].ndayschoice = (int *) malloc(ntime_sub[cat][s] * sizeof(int));
-          if (data->field[cat].analog_days[s].ndayschoice == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].analog_dayschoice = (tstruct **) malloc(ntime_sub[cat][s] * sizeof(tstruct *));
-          if (data->field[cat].analog_days[s].analog_dayschoice == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].metric_norm = (float **) malloc(ntime_sub[cat][s] * sizeof(float *));
-          if (data->field[cat].analog_days[s].metric_norm == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].analog_days[s].tindex_dayschoice = (int **) malloc(ntime_sub[cat][s] * sizeof(int *));
-          if (data->field[cat].analog_days[s].tindex_dayschoice == NULL) alloc_error(__FILE__, __LINE__);
-          for (ii=0; ii<ntime_sub[cat][s]; ii++) {
-            data->field[cat].analog_days[s].ndayschoice[ii] = data->conf->season[s].ndayschoices;
-            data->field[cat].analog_days[s].analog_dayschoice[ii] = (tstruct *) NULL;
-            data->field[cat].analog_days[s].metric_norm[ii] = (float *) NULL;            
-            data->field[cat].analog_days[s].tindex_dayschoice[ii] = (int *) NULL;
-          }
-          (void) printf("%s: Searching analog days for season #%d\n", __FILE__, s);
-          istat = find_the_days(data->field[cat].analog_days[s], data->field[cat].precip_index[s], data->learning->data[s].precip_index,
-                                data->field[cat+2].data[i].down->smean_norm[s], data->learning->data[s].sup_index,
-                                data->field[cat+2].data[i].down->sup_val_norm[s], data->learning->data[s].sup_val, mask_sub,
-                                data->field[cat].data[i].down->days_class_clusters[s], data->learning->data[s].class_clusters,
-                                data->field[cat].time_s->year, data->field[cat].time_s->month, data->field[cat].time_s->day,
-                                data->learning->data[s].time_s->year, data->learning->data[s].time_s->month,
-                                data->learning->data[s].time_s->day, data->conf->time_units,
-                                data->field[cat].ntime_ls, data->learning->data[s].ntime,
-                                data->conf->season[s].month, data->conf->season[s].nmonths,
-                                data->conf->season[s].ndays, data->conf->season[s].ndayschoices, data->reg->npts,
-                                data->conf->season[s].shuffle, data->conf->season[s].secondary_choice,
-                                data->conf->season[s].secondary_main_choice, data->conf->season[s].secondary_cov,
-                                data->conf->use_downscaled_year, data->conf->only_wt,
-                                data->field[cat+2].nlon_ls, data->field[cat+2].nlat_ls,
-                                data->learning->sup_nlon, data->learning->sup_nlat);
-          if (istat != 0) return istat;
-        }
-    }
-
-    /** Step 11: Compute the secondary large-scale fields difference if wanted */
-    
-    /* Downscale also control run if needed */
-    if (data->conf->period_ctrl->downscale == TRUE)
-      beg_cat = CTRL_SEC_FIELD_LS;
-    else
-      beg_cat = SEC_FIELD_LS;
-    
-    /* Loop over secondary field categories (model run and optionally control run) */
-    for (cat=beg_cat; cat>=SEC_FIELD_LS; cat--) {
-      /* Process only if, for this category, at least one secondary large-scale field is available */
-      for (i=0; i<data->field[cat].n_ls; i++)
-        /* Loop over each season */
-        for (s=0; s<data->conf->nseasons; s++) {
-          data->field[cat].data[i].down->delta[s] = (double *) malloc(ntime_sub[cat][s] * sizeof(double));
-          if (data->field[cat].data[i].down->delta[s] == NULL) alloc_error(__FILE__, __LINE__);
-          data->field[cat].data[i].down->delta_dayschoice[s] = (double **) malloc(ntime_sub[cat][s] * sizeof(double *));
-          if (data->field[cat].data[i].down->delta_dayschoice[s] == NULL) alloc_error(__FILE__, __LINE__);
-          for (ii=0; ii<ntime_sub[cat][s]; ii++) {
-            data->field[cat].data[i].down->delta_dayschoice[s][ii] = (double *) calloc(data->conf->season[s].ndayschoices, sizeof(double));
-            if (data->field[cat].data[i].down->delta_dayschoice[s][ii] == NULL) alloc_error(__FILE__, __LINE__);
-          }
-          (void) compute_secondary_large_scale_diff(data->field[cat].data[i].down->delta[s],
-                                                    data->field[cat].data[i].down->delta_dayschoice[s],
-                                                    data->field[cat-2].analog_days[s],
-                                                    data->field[cat].data[i].down->smean_norm[s], data->learning->data[s].sup_index,
-                                                    data->field[CTRL_SEC_FIELD_LS].data[i].down->var[s],
-                                                    data->learning->data[s].sup_index_var, ntime_sub[cat][s]);
+          for (s=0; s<data->conf->nseasons; s++)
+            (void) free(time_ls_sub[cat][s]);
         }
     }
     
   }
   
+  (void) arena_phase_end(data->arena[PHASE_DOWNSCALING]);
+
   /** Step 12: Reconstruct data using chosen resampled days and write output */
+  (void) instrument_begin(&timer, "output");
   
   /* Downscale also control run if needed */  
   if (data->conf->period_ctrl->downscale == TRUE)
@@ -645,7 +878,7 @@ wt_downscaling(data_struct *data) {
         /** Determine the number of elements given the seasons **/
         /* Take into account the fact that it may be possible that the seasons does not span the whole year */
         ntimes_merged = 0;
-        merged_times_flag = (short int *) malloc(data->field[cat].ntime_ls * sizeof(short int));
+        merged_times_flag = (short int *) arena_alloc(data->arena[PHASE_OUTPUT], data->field[cat].ntime_ls * sizeof(short int));
         if (merged_times_flag == NULL) alloc_error(__FILE__, __LINE__);
         for (ii=0; ii<data->field[cat].ntime_ls; ii++) merged_times_flag[ii] = 0;
         /* Flag all times within the processed seasons, and count number of timestep */
@@ -663,7 +896,7 @@ wt_downscaling(data_struct *data) {
             ntimes_merged++;
           }
         /* Save time index given flag */
-        merged_itimes = (int *) malloc(data->field[cat].ntime_ls * sizeof(int));
+        merged_itimes = (int *) arena_alloc(data->arena[PHASE_OUTPUT], data->field[cat].ntime_ls * sizeof(int));
         if (merged_itimes == NULL) alloc_error(__FILE__, __LINE__);
         merged_times = (double *) malloc(ntimes_merged * sizeof(double));
         if (merged_times == NULL) alloc_error(__FILE__, __LINE__);
@@ -676,7 +909,6 @@ wt_downscaling(data_struct *data) {
           else
             merged_itimes[ii] = -1;
         }
-        (void) free(merged_times_flag);
 
         data->field[cat].analog_days_year.time = (int *) malloc(ntimes_merged * sizeof(int));
         if (data->field[cat].analog_days_year.time == NULL) alloc_error(__FILE__, __LINE__);
@@ -698,23 +930,8 @@ wt_downscaling(data_struct *data) {
         if (data->field[cat].analog_days_year.month_s == NULL) alloc_error(__FILE__, __LINE__);
         data->field[cat].analog_days_year.day_s = (int *) malloc(ntimes_merged * sizeof(int));
         if (data->field[cat].analog_days_year.day_s == NULL) alloc_error(__FILE__, __LINE__);
-        data->field[cat].analog_days_year.analog_dayschoice = (tstruct **) malloc(ntimes_merged * sizeof(tstruct *));
-        if (data->field[cat].analog_days_year.analog_dayschoice == NULL) alloc_error(__FILE__, __LINE__);
-        data->field[cat].analog_days_year.metric_norm = (float **) malloc(ntimes_merged * sizeof(float *));
-        if (data->field[cat].analog_days_year.metric_norm == NULL) alloc_error(__FILE__, __LINE__);
-        data->field[cat].analog_days_year.tindex_dayschoice = (int **) malloc(ntimes_merged * sizeof(int *));
-        if (data->field[cat].analog_days_year.tindex_dayschoice == NULL) alloc_error(__FILE__, __LINE__);
-        for (ii=0; ii<ntimes_merged; ii++) {
-          data->field[cat].analog_days_year.analog_dayschoice[ii] = (tstruct *) NULL;
-          data->field[cat].analog_days_year.metric_norm[ii] = (float *) NULL;
-          data->field[cat].analog_days_year.tindex_dayschoice[ii] = (int *) NULL;
-        }
-        data->field[cat].analog_days_year.ndayschoice = (int *) malloc(ntimes_merged * sizeof(int));
-        if (data->field[cat].analog_days_year.ndayschoice == NULL) alloc_error(__FILE__, __LINE__);
         data->field[cat+2].data[i].down->delta_all = (double *) malloc(ntimes_merged * sizeof(double));
         if (data->field[cat+2].data[i].down->delta_all == NULL) alloc_error(__FILE__, __LINE__);
-        data->field[cat+2].data[i].down->delta_dayschoice_all = (double **) malloc(ntimes_merged * sizeof(double *));
-        if (data->field[cat+2].data[i].down->delta_dayschoice_all == NULL) alloc_error(__FILE__, __LINE__);
         data->field[cat].data[i].down->dist_all = (double *) malloc(ntimes_merged * sizeof(double));
         if (data->field[cat].data[i].down->dist_all == NULL) alloc_error(__FILE__, __LINE__);
         data->field[cat].data[i].down->days_class_clusters_all = (int *) malloc(ntimes_merged * sizeof(int));
@@ -725,11 +942,17 @@ wt_downscaling(data_struct *data) {
         for (s=0; s<data->conf->nseasons; s++)
           if (maxndays < data->conf->season[s].ndayschoices)
             maxndays = data->conf->season[s].ndayschoices;
-        /* Allocate memory for special 2D delta t vector. Initialize to zero because dimensions can vary for each season. */
-        for (ii=0; ii<ntimes_merged; ii++) {
-          data->field[cat+2].data[i].down->delta_dayschoice_all[ii] = (double *) calloc(maxndays, sizeof(double));
-          if (data->field[cat+2].data[i].down->delta_dayschoice_all[ii] == NULL) alloc_error(__FILE__, __LINE__);
-        }
+        /* Allocate memory for analog day choices and special 2D delta t vector, as contiguous blocks. */
+        /* Initialize to zero because dimensions can vary for each season. */
+        (void) alloc_dayschoice(&(data->field[cat].analog_days_year), ntimes_merged, maxndays);
+        data->field[cat+2].data[i].down->delta_dayschoice_all = (double **) malloc((ntimes_merged > 0 ? ntimes_merged : 1) * sizeof(double *));
+        if (data->field[cat+2].data[i].down->delta_dayschoice_all == NULL) alloc_error(__FILE__, __LINE__);
+        data->field[cat+2].data[i].down->delta_dayschoice_all[0] =
+          (double *) calloc((size_t) (ntimes_merged > 0 ? ntimes_merged : 1) * (size_t) maxndays, sizeof(double));
+        if (data->field[cat+2].data[i].down->delta_dayschoice_all[0] == NULL) alloc_error(__FILE__, __LINE__);
+        for (ii=1; ii<ntimes_merged; ii++)
+          data->field[cat+2].data[i].down->delta_dayschoice_all[ii] =
+            data->field[cat+2].data[i].down->delta_dayschoice_all[0] + (size_t) ii * (size_t) maxndays;
 
         /* Loop over each season */
         data->field[cat].analog_days_year.ntime = 0;
@@ -756,7 +979,6 @@ wt_downscaling(data_struct *data) {
                                         ntimes_merged, ntime_sub[cat][s]);
           if (istat != 0) {
             (void) free(merged_times);
-            (void) free(merged_itimes);
             return istat;
           }
           data->field[cat].analog_days_year.ntime += ntime_sub[cat][s];
@@ -773,6 +995,12 @@ wt_downscaling(data_struct *data) {
                                   data->field[cat].data[i].down->dist_all, data->field[cat].data[i].down->days_class_clusters_all,
                                   merged_times, analog_file, data);
         }
+
+        /** Checkpoint analog_days information, so that a resumed run only has to output data **/
+        (void) checkpoint_analog_save(data, cat, data->field[cat].analog_days_year, data->field[cat+2].data[i].down->delta_all,
+                                      data->field[cat+2].data[i].down->delta_dayschoice_all,
+                                      data->field[cat].data[i].down->dist_all, data->field[cat].data[i].down->days_class_clusters_all,
+                                      merged_times);
       }
       else {
         if (cat == FIELD_LS)
@@ -793,33 +1021,28 @@ wt_downscaling(data_struct *data) {
         else {
           period = data->conf->period_ctrl;
         }
+        checkpoint_prefix = checkpoint_output_prefix(data, cat);
         istat = output_downscaled_analog(data->field[cat].analog_days_year, data->field[cat+2].data[i].down->delta_all,
                                          data->conf->output_month_begin, data->conf->output_path, data->conf->config,
                                          data->conf->time_units, data->conf->cal_type, data->conf->deltat,
                                          data->conf->format, data->conf->compression, data->conf->compression_level,
-                                         data->conf->debug,
+                                         data->conf->debug, data->conf->nthreads, data->conf->output_pipeline,
+                                         checkpoint_prefix, data->checkpoint->resume,
                                          data->info, data->conf->obs_var, period, merged_times, ntimes_merged);
+        if (checkpoint_prefix != NULL)
+          (void) free(checkpoint_prefix);
         if (istat != 0) {
           (void) free(merged_times);
-          (void) free(merged_itimes);
           return istat;
         }
       }
       (void) free(merged_times);
-      (void) free(merged_itimes);
     }
   }
           
-  /* Free memory for specific downscaling buffers */
-  if (data->conf->output_only != TRUE) {
-    for (cat=0; cat<NCAT; cat++)
-      (void) free(ntime_sub[cat]);
-    (void) free(ntime_sub);
-    
-    /* Free mask memory if needed */
-    if (mask_sub != NULL)
-      (void) free(mask_sub);
-  }
+  (void) instrument_end(&timer);
+
+  /* Specific downscaling buffers are released with the downscaling and output phase arenas */
 
   /* Success return */
   return 0;
@@ -66,28 +66,47 @@ LICENSE END */
 
 #include <dsclim.h>
 
-/** Compute or read learning data needed for downscaling climate scenarios using weather typing. */
-int
-wt_learning(data_struct *data) {
+/** Arguments of the learning task of one season. */
+typedef struct {
+  data_struct *data; /**< MASTER data structure. */
+  int s; /**< Season. */
+  double *buf_learn_obs; /**< Observation principal components over the whole learning period. */
+  double *buf_learn_rea; /**< Reanalysis principal components over the whole learning period. */
+  double *buf_learn_pc; /**< Normalized reanalysis principal components over the whole learning period. */
+  double *tas_rea_mean; /**< Spatial mean of the secondary large-scale field over the whole learning period. */
+  double *tas_rea; /**< Secondary large-scale field over the whole learning period. */
+  double *mean_precip; /**< Precipitation averaged around each regression point over the whole learning period. */
+  int ntime_learn_all; /**< Number of times of the whole learning period. */
+  int *ntime_sub; /**< Number of times of each season. */
+  int niter; /**< Number of iterations of the best classification. */
+} learning_task_struct;
+
+/** Compute learning data of one season: clusters, classification and regression. */
+static int
+learning_task_season(void *arg) {
   /**
-     @param[in]  data  MASTER data structure.
-     
-     \return           Status.
+     @param[in]  arg  Learning task structure.
+
+     \return          Status.
   */
 
+  learning_task_struct *task = (learning_task_struct *) arg; /* Task arguments */
+  data_struct *data = task->data; /* MASTER data structure */
+  int s = task->s; /* Season */
+  double *buf_learn_obs = task->buf_learn_obs;
+  double *buf_learn_rea = task->buf_learn_rea;
+  double *buf_learn_pc = task->buf_learn_pc;
+  double *tas_rea_mean = task->tas_rea_mean;
+  double *tas_rea = task->tas_rea;
+  double *mean_precip = task->mean_precip;
+  int ntime_learn_all = task->ntime_learn_all;
+  int *ntime_sub = task->ntime_sub;
+
   double *buf_learn = NULL;
   double *buf_weight = NULL;
-  double *buf_learn_obs = NULL;
-  double *buf_learn_rea = NULL;
   double *buf_learn_obs_sub = NULL;
   double *buf_learn_rea_sub = NULL;
-  double *buf_learn_pc = NULL;
   double *buf_learn_pc_sub = NULL;
-
-  double *precip_liquid_obs = NULL;
-  double *precip_solid_obs = NULL;
-  double *precip_obs = NULL;
-  double *mean_precip = NULL;
   double *mean_precip_sub = NULL;
 
   double *precip_reg = NULL;
@@ -102,21 +121,401 @@ wt_learning(data_struct *data) {
   double obs_first_sing;
   double rea_sing;
   double obs_sing;
-  double *rea_var = NULL;
   double rea_first_sing;
 
-  double *tas_rea = NULL;
   double *tas_rea_sub = NULL;
-  double *tas_rea_mean = NULL;
   double *tas_rea_mean_sub = NULL;
 
-  double missing_value;
-  double missing_value_precip;
-
   double *mean_dist = NULL;
   double *var_dist = NULL;
   double *dist = NULL;
-  double dist_pt;
+
+  double *sup_mean = NULL;
+  double *sup_var = NULL;
+
+  double meanvif = 0.0;
+
+  int eof;
+  int clust;
+  int nt;
+  int ntt;
+  int t;
+  int pt;
+  int term;
+
+  /* udunits variables */
+  ut_system *unitSystem = NULL; /* Unit System (udunits) */
+  ut_unit *dataunits = NULL; /* Data units (udunits) */
+
+  int istat; /** Return status. */
+  int istat_cal = 0; /** Return status of date conversions. */
+
+  instrument_timer_struct timer; /* Instrumentation timer */
+
+  /* Process separately each season */
+
+  /* Select season months in the whole time period and create sub-period fields */
+  if (data->learning->obs_neof != 0) {
+    (void) extract_subperiod_months(&buf_learn_obs_sub, &(ntime_sub[s]), buf_learn_obs,
+                                    data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
+                                    (char *) NULL, (char *) NULL, (period_struct *) NULL, data->conf->season[s].month,
+                                    1, (double *) NULL, 1, data->learning->obs_neof, ntime_learn_all,
+                                    data->conf->season[s].nmonths);
+  }
+  (void) extract_subperiod_months(&buf_learn_rea_sub, &(ntime_sub[s]), buf_learn_rea,
+                                  data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
+                                  (char *) NULL, (char *) NULL, (period_struct *) NULL, data->conf->season[s].month,
+                                  1, (double *) NULL, 1, data->learning->rea_neof, ntime_learn_all,
+                                  data->conf->season[s].nmonths);
+  (void) extract_subperiod_months(&buf_learn_pc_sub, &(ntime_sub[s]), buf_learn_pc,
+                                  data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
+                                  (char *) NULL, (char *) NULL, (period_struct *) NULL, data->conf->season[s].month,
+                                  1, (double *) NULL, 1, data->learning->rea_neof, ntime_learn_all,
+                                  data->conf->season[s].nmonths);
+  (void) extract_subperiod_months(&tas_rea_mean_sub, &(ntime_sub[s]), tas_rea_mean,
+                                  data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
+                                  (char *) NULL, (char *) NULL, (period_struct *) NULL, data->conf->season[s].month,
+                                  1, (double *) NULL, 1, 1, ntime_learn_all,
+                                  data->conf->season[s].nmonths);
+  (void) extract_subperiod_months(&tas_rea_sub, &(ntime_sub[s]), tas_rea,
+                                  data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
+                                  (char *) NULL, (char *) NULL, (period_struct *) NULL, data->conf->season[s].month,
+                                  1, (double *) NULL, data->learning->sup_nlon, data->learning->sup_nlat, ntime_learn_all,
+                                  data->conf->season[s].nmonths);
+  (void) extract_subperiod_months(&mean_precip_sub, &(ntime_sub[s]), mean_precip,
+                                  data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
+                                  (char *) NULL, (char *) NULL, (period_struct *) NULL, data->conf->season[s].month,
+                                  1, (double *) NULL, 1, data->reg->npts, ntime_learn_all,
+                                  data->conf->season[s].nmonths);
+
+  /** Normalize secondary large-scale fields for re-analysis learning data **/
+  data->learning->data[s].sup_index = (double *) malloc(ntime_sub[s] * sizeof(double));
+  if (data->learning->data[s].sup_index == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].sup_val = (double *) malloc(data->learning->sup_nlon*data->learning->sup_nlat*ntime_sub[s] * sizeof(double));
+  if (data->learning->data[s].sup_val == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Compute mean and variance over time */
+  data->learning->data[s].sup_index_mean = gsl_stats_mean(tas_rea_mean_sub, 1, ntime_sub[s]);
+  data->learning->data[s].sup_index_var = gsl_stats_variance(tas_rea_mean_sub, 1, ntime_sub[s]);
+
+  /* Normalize using mean and variance */
+  (void) normalize_field(data->learning->data[s].sup_index, tas_rea_mean_sub, data->learning->data[s].sup_index_mean,
+                         data->learning->data[s].sup_index_var, 1, 1, ntime_sub[s]);
+
+  /* Compute mean and variance over time for each point */
+  sup_mean = (double *) malloc(data->learning->sup_nlon*data->learning->sup_nlat*ntime_sub[s] * sizeof(double));
+  if (sup_mean == NULL) alloc_error(__FILE__, __LINE__);
+  sup_var = (double *) malloc(data->learning->sup_nlon*data->learning->sup_nlat*ntime_sub[s] * sizeof(double));
+  if (sup_var == NULL) alloc_error(__FILE__, __LINE__);
+  (void) time_mean_variance_field_2d(sup_mean, sup_var, tas_rea_sub, data->learning->sup_nlon, data->learning->sup_nlat, ntime_sub[s]);
+
+  /* Normalize whole secondary 2D field using mean and variance at each point */
+  (void) normalize_field_2d(data->learning->data[s].sup_val, tas_rea_sub, sup_mean,
+                            sup_var, data->learning->sup_nlon, data->learning->sup_nlat, ntime_sub[s]);
+  
+  (void) free(sup_mean);
+  sup_mean = NULL;
+  (void) free(sup_var);
+  sup_var = NULL;
+
+  /** Construct time vectors **/
+  data->learning->data[s].ntime = ntime_sub[s];
+  data->learning->data[s].time = (double *) malloc(ntime_sub[s] * sizeof(double));
+  if (data->learning->data[s].time == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].time_s->year = (int *) malloc(ntime_sub[s] * sizeof(int));
+  if (data->learning->data[s].time_s->year == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].time_s->month = (int *) malloc(ntime_sub[s] * sizeof(int));
+  if (data->learning->data[s].time_s->month == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].time_s->day = (int *) malloc(ntime_sub[s] * sizeof(int));
+  if (data->learning->data[s].time_s->day == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].time_s->hour = (int *) malloc(ntime_sub[s] * sizeof(int));
+  if (data->learning->data[s].time_s->hour == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].time_s->minutes = (int *) malloc(ntime_sub[s] * sizeof(int));
+  if (data->learning->data[s].time_s->minutes == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].time_s->seconds = (double *) malloc(ntime_sub[s] * sizeof(double));
+  if (data->learning->data[s].time_s->seconds == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Retrieve time index spanning selected months and assign time structure values */
+  t = 0;
+
+  /* Initialize udunits */
+  (void) udunits_lock();
+  ut_set_error_message_handler(ut_ignore);
+  unitSystem = ut_read_xml(NULL);
+  ut_set_error_message_handler(ut_write_to_stderr);
+  dataunits = ut_parse(unitSystem, data->conf->time_units, UT_ASCII);
+
+  for (nt=0; nt<ntime_learn_all; nt++)
+    for (ntt=0; ntt<data->conf->season[s].nmonths; ntt++)
+      if (data->learning->time_s->month[nt] == data->conf->season[s].month[ntt]) {
+        data->learning->data[s].time_s->year[t] = data->learning->time_s->year[nt];
+        data->learning->data[s].time_s->month[t] = data->learning->time_s->month[nt];
+        data->learning->data[s].time_s->day[t] = data->learning->time_s->day[nt];
+        data->learning->data[s].time_s->hour[t] = data->learning->time_s->hour[nt];
+        data->learning->data[s].time_s->minutes[t] = data->learning->time_s->minutes[nt];
+        data->learning->data[s].time_s->seconds[t] = data->learning->time_s->seconds[nt];
+        istat = utInvCalendar2(data->learning->data[s].time_s->year[t], data->learning->data[s].time_s->month[t],
+                               data->learning->data[s].time_s->day[t], data->learning->data[s].time_s->hour[t],
+                               data->learning->data[s].time_s->minutes[t], data->learning->data[s].time_s->seconds[t],
+                               dataunits, &(data->learning->data[s].time[t]));
+        if (istat != 0)
+          istat_cal = istat;
+        t++;
+      }
+
+  (void) ut_free(dataunits);
+  (void) ut_free_system(unitSystem);  
+  (void) udunits_unlock();
+  if (istat_cal != 0) {
+    (void) fprintf(stderr, "%s: Fatal error: cannot compute learning dates of season %d.\n", __FILE__, s);
+    return istat_cal;
+  }
+  
+  /** Merge observation and reanalysis principal components for clustering algorithm and normalize using first Singular Value **/
+
+  buf_learn = (double *) malloc(ntime_sub[s] * (data->learning->rea_neof + data->learning->obs_neof) * sizeof(double));
+  if (buf_learn == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Normalisation by the first Singular Value */
+  rea_first_sing = data->learning->rea->sing[0];
+  for (eof=0; eof<data->learning->rea_neof; eof++) {
+    rea_sing = data->learning->rea->sing[eof];        
+    for (nt=0; nt<ntime_sub[s]; nt++) {
+      buf_learn_rea_sub[nt+eof*ntime_sub[s]] = buf_learn_rea_sub[nt+eof*ntime_sub[s]] * rea_sing / rea_first_sing;
+      buf_learn[nt+eof*ntime_sub[s]] = buf_learn_rea_sub[nt+eof*ntime_sub[s]];
+    }
+  }      
+  if (data->learning->obs_neof != 0) {
+    obs_first_sing = data->learning->obs->sing[0];
+    for (eof=0; eof<data->learning->obs_neof; eof++) {
+      obs_sing = data->learning->obs->sing[eof];        
+      for (nt=0; nt<ntime_sub[s]; nt++) {
+        buf_learn_obs_sub[nt+eof*ntime_sub[s]] = buf_learn_obs_sub[nt+eof*ntime_sub[s]] * obs_sing / obs_first_sing;
+        buf_learn[nt+(eof+data->learning->rea_neof)*ntime_sub[s]] = buf_learn_obs_sub[nt+eof*ntime_sub[s]];
+      }
+    }
+  }
+
+  /* Compute best clusters */
+  (void) instrument_begin(&timer, "clustering");
+  buf_weight = (double *) malloc(data->conf->season[s].nclusters * (data->learning->rea_neof + data->learning->obs_neof) *
+                                  sizeof(double));
+  if (buf_weight == NULL) alloc_error(__FILE__, __LINE__);
+  task->niter = best_clusters(buf_weight, buf_learn, data->conf->classif_type, data->conf->npartitions,
+                              data->conf->nclassifications, data->learning->rea_neof + data->learning->obs_neof,
+                              data->conf->season[s].nclusters, ntime_sub[s]);
+
+  /* Keep only first data->learning->rea_neof EOFs */
+  data->learning->data[s].weight = (double *) 
+    malloc(data->conf->season[s].nclusters*data->learning->rea_neof * sizeof(double));
+  if (data->learning->data[s].weight == NULL) alloc_error(__FILE__, __LINE__);
+  for (clust=0; clust<data->conf->season[s].nclusters; clust++)
+    for (eof=0; eof<data->learning->rea_neof; eof++)
+      data->learning->data[s].weight[eof+clust*data->learning->rea_neof] =
+        buf_weight[eof+clust*(data->learning->rea_neof+data->learning->obs_neof)];
+  
+  /* Classify each day in the current clusters */
+  data->learning->data[s].class_clusters = (int *) malloc(ntime_sub[s] * sizeof(int));
+  if (data->learning->data[s].class_clusters == NULL) alloc_error(__FILE__, __LINE__);
+  (void) class_days_pc_clusters(data->learning->data[s].class_clusters, buf_learn,
+                                data->learning->data[s].weight, data->conf->classif_type,
+                                data->learning->rea_neof, data->conf->season[s].nclusters,
+                                ntime_sub[s]);
+
+  /* Set mean and variance of distances to clusters to 1.0 because we first need to compute distances and */
+  /* we don't have a control run in learning mode */
+  mean_dist = (double *) malloc(data->conf->season[s].nclusters * sizeof(double));
+  if (mean_dist == NULL) alloc_error(__FILE__, __LINE__);
+  var_dist = (double *) malloc(data->conf->season[s].nclusters * sizeof(double));
+  if (var_dist == NULL) alloc_error(__FILE__, __LINE__);
+  for (clust=0; clust<data->conf->season[s].nclusters; clust++) {
+    mean_dist[clust] = 1.0;
+    var_dist[clust] = 1.0;
+  }
+
+  /* Compute distances to clusters using normalization */
+  dist = (double *) malloc(data->conf->season[s].nclusters*ntime_sub[s] * sizeof(double));
+  if (dist == NULL) alloc_error(__FILE__, __LINE__);
+  (void) dist_clusters_normctrl(dist, buf_learn_pc_sub, data->learning->data[s].weight,
+                                data->learning->pc_normalized_var, data->learning->pc_normalized_var, mean_dist, var_dist,
+                                data->learning->rea_neof, data->conf->season[s].nclusters, ntime_sub[s]);
+  /* Normalize */
+  for (clust=0; clust<data->conf->season[s].nclusters; clust++) {
+    /* Calculate mean over time */
+    mean_dist[clust] = gsl_stats_mean(&(dist[clust*ntime_sub[s]]), 1, ntime_sub[s]);
+    /* Calculate variance over time */
+    var_dist[clust] = gsl_stats_variance(&(dist[clust*ntime_sub[s]]), 1, ntime_sub[s]);
+    /* Normalize */
+    for (nt=0; nt<ntime_sub[s]; nt++)
+      dist[nt+clust*ntime_sub[s]] = ( dist[nt+clust*ntime_sub[s]] - mean_dist[clust] ) / sqrt(var_dist[clust]);
+  }
+
+  /* Classify each day in the current clusters */
+  /* data->learning->data[s].class_clusters */
+  /*      data->learning->data[s].class_clusters = (int *) malloc(ntime_sub[s] * sizeof(int));
+  if (data->learning->data[s].class_clusters == NULL) alloc_error(__FILE__, __LINE__);
+  (void) class_days_pc_clusters(data->learning->data[s].class_clusters, buf_learn,
+  data->learning->data[s].weight, data->conf->classif_type,
+  data->learning->rea_neof, data->conf->season[s].nclusters, ntime_sub[s]);*/
+
+  (void) instrument_end(&timer);
+
+  /* Allocate memory for regression */
+  (void) instrument_begin(&timer, "regression");
+  precip_reg = (double *) malloc(data->conf->season[s].nreg * sizeof(double));
+  if (precip_reg == NULL) alloc_error(__FILE__, __LINE__);
+  precip_index = (double *) malloc(ntime_sub[s] * sizeof(double));
+  if (precip_index == NULL) alloc_error(__FILE__, __LINE__);
+  precip_err = (double *) malloc(ntime_sub[s] * sizeof(double));
+  if (precip_err == NULL) alloc_error(__FILE__, __LINE__);
+  dist_reg = (double *) malloc(data->conf->season[s].nreg*ntime_sub[s] * sizeof(double));
+  if (dist_reg == NULL) alloc_error(__FILE__, __LINE__);
+  vif = (double *) malloc(data->conf->season[s].nreg * sizeof(double));
+  if (vif == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Create variable to hold values of x vector for regression */
+  /* Begin with distances to clusters */
+  for (clust=0; clust<data->conf->season[s].nclusters; clust++)
+    for (t=0; t<ntime_sub[s]; t++)
+      dist_reg[t+clust*ntime_sub[s]] = dist[t+clust*ntime_sub[s]];
+
+  /* For special seasons using secondary field in the regression, append values to x vector for regression */
+  if (data->conf->season[s].nreg == (data->conf->season[s].nclusters+1)) {
+    clust = data->conf->season[s].nclusters;
+    for (t=0; t<ntime_sub[s]; t++)
+      dist_reg[t+clust*ntime_sub[s]] = data->learning->data[s].sup_index[t];
+  }
+
+  data->learning->data[s].precip_reg_cst = (double *) malloc(data->reg->npts * sizeof(double));
+  if (data->learning->data[s].precip_reg_cst == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].precip_reg = (double *) malloc(data->reg->npts*data->conf->season[s].nreg * sizeof(double));
+  if (data->learning->data[s].precip_reg == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].precip_reg_dist = (double *)
+    malloc(data->conf->season[s].nclusters*ntime_sub[s] * sizeof(double));
+  if (data->learning->data[s].precip_reg_dist == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].precip_index = (double *) malloc(data->reg->npts*ntime_sub[s] * sizeof(double));
+  if (data->learning->data[s].precip_index == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].precip_index_obs = (double *) malloc(data->reg->npts*ntime_sub[s] * sizeof(double));
+  if (data->learning->data[s].precip_index_obs == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].precip_reg_err = (double *) malloc(data->reg->npts*ntime_sub[s] * sizeof(double));
+  if (data->learning->data[s].precip_reg_err == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].precip_reg_rsq = (double *) malloc(data->reg->npts * sizeof(double));
+  if (data->learning->data[s].precip_reg_rsq == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].precip_reg_vif = (double *) malloc(data->conf->season[s].nreg * sizeof(double));
+  if (data->learning->data[s].precip_reg_vif == NULL) alloc_error(__FILE__, __LINE__);
+  data->learning->data[s].precip_reg_autocor = (double *) malloc(data->reg->npts * sizeof(double));
+  if (data->learning->data[s].precip_reg_autocor == NULL) alloc_error(__FILE__, __LINE__);
+
+  /* Save distances */
+  for (t=0; t<ntime_sub[s]; t++)
+    for (clust=0; clust<data->conf->season[s].nclusters; clust++)
+      data->learning->data[s].precip_reg_dist[clust+t*data->conf->season[s].nclusters] = dist[t+clust*ntime_sub[s]];
+
+  for (pt=0; pt<data->reg->npts; pt++) {
+    /* Compute regression and save regression constant */
+    istat = regress(precip_reg, dist_reg, &(mean_precip_sub[pt*ntime_sub[s]]), &(data->learning->data[s].precip_reg_cst[pt]),
+                    precip_index, precip_err, &chisq, &rsq, vif, &autocor, data->conf->season[s].nreg, ntime_sub[s]);
+    if (istat != 0) {
+      (void) fprintf(stderr, "%s: Fatal error: regression failed at point %d of season %d.\n", __FILE__, pt, s);
+      return istat;
+    }
+    /* Save R^2 */
+    data->learning->data[s].precip_reg_rsq[pt] = rsq;
+    /* Save residuals */
+    for (t=0; t<ntime_sub[s]; t++)
+      data->learning->data[s].precip_reg_err[pt+t*data->reg->npts] = precip_err[t];
+    /* Save autocorrelation of residuals */
+    data->learning->data[s].precip_reg_autocor[pt] = autocor;
+    /* Save Variance Inflation Factor VIF, and compute mean VIF */
+    if (pt == 0) {
+      meanvif = 0.0;
+      for (term=0; term<data->conf->season[s].nreg; term++) {
+        data->learning->data[s].precip_reg_vif[term] = vif[term];
+        meanvif += vif[term];
+      }
+      meanvif = meanvif / (double) data->conf->season[s].nreg;
+    }
+
+    //        (void) fprintf(stdout, "%s: pt=%d R^2=%lf CHI^2=%lf ACOR=%lf\n", __FILE__, pt, rsq, chisq, autocor);
+
+    /* Save regression coefficients */
+    for (clust=0; clust<data->conf->season[s].nreg; clust++)
+      data->learning->data[s].precip_reg[pt+clust*data->reg->npts] = precip_reg[clust];
+
+    /* Save precipitation index */
+    for (t=0; t<ntime_sub[s]; t++)
+      data->learning->data[s].precip_index[pt+t*data->reg->npts] = precip_index[t];
+
+    /* Save observed precipitation index */
+    for (t=0; t<ntime_sub[s]; t++)
+      data->learning->data[s].precip_index_obs[pt+t*data->reg->npts] = mean_precip_sub[t+pt*ntime_sub[s]];
+  }
+
+  (void) instrument_end(&timer);
+  (void) fprintf(stdout, "%s: MeanVIF=%lf\n", __FILE__, meanvif);
+
+  (void) free(precip_reg);
+  (void) free(precip_index);
+  (void) free(precip_err);
+  (void) free(dist_reg);
+  (void) free(vif);
+
+  (void) free(buf_learn_rea_sub);
+  buf_learn_rea_sub = NULL;
+  if (data->learning->obs_neof != 0) {
+    (void) free(buf_learn_obs_sub);
+    buf_learn_obs_sub = NULL;
+  }
+  (void) free(buf_learn_pc_sub);
+  buf_learn_pc_sub = NULL;
+  (void) free(tas_rea_mean_sub);
+  tas_rea_mean_sub = NULL;
+  (void) free(tas_rea_sub);
+  tas_rea_sub = NULL;
+  (void) free(mean_precip_sub);
+  mean_precip_sub = NULL;
+
+  (void) free(buf_weight);
+  (void) free(buf_learn);
+  (void) free(mean_dist);
+  (void) free(var_dist);
+  (void) free(dist);
+
+  return 0;
+}
+
+/** Compute or read learning data needed for downscaling climate scenarios using weather typing. */
+int
+wt_learning(data_struct *data) {
+  /**
+     @param[in]  data  MASTER data structure.
+     
+     \return           Status.
+  */
+
+  double *buf_learn_obs = NULL;
+  double *buf_learn_rea = NULL;
+  double *buf_learn_pc = NULL;
+
+  double *precip_liquid_obs = NULL;
+  double *precip_solid_obs = NULL;
+  double *precip_obs = NULL;
+  double *mean_precip = NULL;
+
+  double *rea_var = NULL;
+
+  double *tas_rea = NULL;
+  double *tas_rea_mean = NULL;
+
+  double missing_value;
+  double missing_value_precip;
+
+  double *precip_t = NULL;
+  double sum_precip;
+  int nobs_pt;
+  int *nb_start = NULL;
+  int *nb_index = NULL;
+  int nb;
 
   double *mask_subd = NULL;
   short int *mask_sub = NULL;
@@ -128,36 +527,38 @@ wt_learning(data_struct *data) {
   int ntime_learn_all;
   int *ntime_sub = NULL;
 
-  double *sup_mean = NULL;
-  double *sup_var = NULL;
-
-  double meanvif = 0.0;
-
   int eof;
-  int clust;
   int nt;
-  int ntt;
   int t;
   int s;
   int i;
   int j;
   int pt;
-  int term;
   int *npt = NULL;
-  short int allpt;
-
-  /* udunits variables */
-  ut_system *unitSystem = NULL; /* Unit System (udunits) */
-  ut_unit *dataunits = NULL; /* Data units (udunits) */
 
   int niter = 2;
 
   int istat; /** Return status. */
   int istat_solid; /** Return status solid precipitation. */
 
+  task_graph_struct *graph = NULL; /* Graph of season tasks */
+  learning_task_struct *tasks = NULL; /* Arguments of season tasks */
+
+  instrument_timer_struct timer; /* Instrumentation timer */
+
+  /* When resuming a run, use its learning data checkpoint, if any */
+  if (data->learning->learning_provided == FALSE)
+    (void) checkpoint_learning_lookup(data);
+
+  /* Use cached learning data computed from the same inputs, if any */
+  if (data->learning->learning_provided == FALSE && data->learning->cache_dir != NULL)
+    (void) learning_cache_lookup(data);
+
   if (data->learning->learning_provided == TRUE) {
     /** Read learning data **/
+    (void) instrument_begin(&timer, "read_fields");
     istat = read_learning_fields(data);
+    (void) instrument_end(&timer);
     if (istat != 0) return istat;
   }
   else  {
@@ -165,12 +566,14 @@ wt_learning(data_struct *data) {
     /** Assume EOFs are already pre-computed **/
 
     /* Read re-analysis pre-computed EOF and Singular Values */
+    (void) instrument_begin(&timer, "read_fields");
     istat = read_learning_rea_eof(data);
     if (istat != 0) return istat;
 
     /* Read observations pre-computed EOF and Singular Values */
     istat = read_learning_obs_eof(data);
     if (istat != 0) return istat;
+    (void) instrument_end(&timer);
 
     /* Select common time period between the re-analysis and the observation data periods */
     if (data->learning->obs_neof != 0) {
@@ -186,14 +589,14 @@ wt_learning(data_struct *data) {
                               1, data->learning->rea_neof, 1, data->learning->rea->ntime, data->learning->obs->ntime);
     if (istat != 0) return istat;
 
-    rea_var = (double *) malloc(data->learning->rea_neof * sizeof(double));
+    rea_var = (double *) arena_alloc(data->arena[PHASE_LEARNING], data->learning->rea_neof * sizeof(double));
     if (rea_var == NULL) alloc_error(__FILE__, __LINE__);
 
     /* Compute normalisation factor of EOF of large-scale field for the whole period */
 
     data->learning->pc_normalized_var = (double *) malloc(data->learning->rea_neof * sizeof(double));
     if (data->learning->pc_normalized_var == NULL) alloc_error(__FILE__, __LINE__);
-    buf_learn_pc = (double *) malloc(data->learning->rea_neof * ntime_learn_all * sizeof(double));
+    buf_learn_pc = (double *) arena_alloc(data->arena[PHASE_LEARNING], data->learning->rea_neof * ntime_learn_all * sizeof(double));
     if (buf_learn_pc == NULL) alloc_error(__FILE__, __LINE__);
 
     for (eof=0; eof<data->learning->rea_neof; eof++) {
@@ -221,10 +624,11 @@ wt_learning(data_struct *data) {
       }
     }
                                                     
-    ntime_sub = (int *) malloc(data->conf->nseasons * sizeof(int));
+    ntime_sub = (int *) arena_alloc(data->arena[PHASE_LEARNING], data->conf->nseasons * sizeof(int));
     if (ntime_sub == NULL) alloc_error(__FILE__, __LINE__);
 
     /* Read observed precipitation (liquid and solid) */
+    (void) instrument_begin(&timer, "read_fields");
     istat_solid = read_obs_period(&precip_solid_obs, &(data->learning->lon), &(data->learning->lat), &missing_value_precip,
                                   data, "prsn", data->learning->obs->time_s->year, data->learning->obs->time_s->month,
                                   data->learning->obs->time_s->day, &(data->learning->nlon), &(data->learning->nlat),
@@ -238,10 +642,11 @@ wt_learning(data_struct *data) {
                             data->learning->obs->time_s->year, data->learning->obs->time_s->month, data->learning->obs->time_s->day,
                             &(data->learning->nlon), &(data->learning->nlat), data->learning->obs->ntime);
     if (istat == -1) return -1;
+    (void) instrument_end(&timer);
 
     /* Calculate total precipitation */
     printf("%d %d %d\n",data->learning->nlon, data->learning->nlat, data->learning->obs->ntime);
-    precip_obs = (double *) malloc(data->learning->nlon*data->learning->nlat*data->learning->obs->ntime * sizeof(double));
+    precip_obs = (double *) alloc_large(data->learning->nlon*data->learning->nlat*data->learning->obs->ntime * sizeof(double));
     if (precip_obs == NULL) alloc_error(__FILE__, __LINE__);
 
     if (istat_solid == -2) {
@@ -254,7 +659,7 @@ wt_learning(data_struct *data) {
                 precip_liquid_obs[i+j*data->learning->nlon+t*data->learning->nlon*data->learning->nlat] * 86400;
             else
               precip_obs[i+j*data->learning->nlon+t*data->learning->nlon*data->learning->nlat] = missing_value_precip;
-      (void) free(precip_liquid_obs);
+      (void) free_large(precip_liquid_obs);
     }
     else {
       (void) printf("%s: Calculating total precipitation from solid and liquid.\n", __FILE__);
@@ -267,8 +672,8 @@ wt_learning(data_struct *data) {
                  precip_solid_obs[i+j*data->learning->nlon+t*data->learning->nlon*data->learning->nlat]) * 86400.0;
             else
               precip_obs[i+j*data->learning->nlon+t*data->learning->nlon*data->learning->nlat] = missing_value_precip;
-      (void) free(precip_liquid_obs);
-      (void) free(precip_solid_obs);
+      (void) free_large(precip_liquid_obs);
+      (void) free_large(precip_solid_obs);
     }
 
     /* Apply mask for learning data */
@@ -301,45 +706,47 @@ wt_learning(data_struct *data) {
 
     /* Perform spatial mean of observed precipitation around regression points, normalize precip */
     (void) printf("%s: Perform spatial mean of observed precipitation around regression points.\n", __FILE__);
-    mean_precip = (double *) malloc(data->reg->npts * data->learning->obs->ntime * sizeof(double));
+    /* Observation grid points in the vicinity of each regression point, found once with a latitude-sorted index */
+    (void) neighbour_points(&nb_start, &nb_index, data->reg->lon, data->reg->lat, data->learning->lon, data->learning->lat,
+                            data->reg->dist, data->reg->npts, data->learning->nlon*data->learning->nlat);
+    mean_precip = (double *) arena_alloc(data->arena[PHASE_LEARNING], data->reg->npts * data->learning->obs->ntime * sizeof(double));
     if (mean_precip == NULL) alloc_error(__FILE__, __LINE__);
-    npt = (int *) malloc(data->learning->obs->ntime * sizeof(int));
+    /* First time without any observation in the vicinity of each regression point, -1 if none */
+    npt = (int *) arena_alloc(data->arena[PHASE_LEARNING], data->reg->npts * sizeof(int));
     if (npt == NULL) alloc_error(__FILE__, __LINE__);
-    for (pt=0; pt<data->reg->npts; pt++) {
-      for (t=0; t<data->learning->obs->ntime; t++) {
-        mean_precip[t+pt*data->learning->obs->ntime] = 0.0;
-        npt[t] = 0;
+    for (pt=0; pt<data->reg->npts; pt++)
+      npt[pt] = -1;
+    /* Single pass over time: each daily field is contiguous and shared by all regression points */
+    for (t=0; t<data->learning->obs->ntime; t++) {
+      precip_t = &(precip_obs[(size_t) t*data->learning->nlon*data->learning->nlat]);
+      for (pt=0; pt<data->reg->npts; pt++) {
+        sum_precip = 0.0;
+        nobs_pt = 0;
+        for (nb=nb_start[pt]; nb<nb_start[pt+1]; nb++)
+          if (precip_t[nb_index[nb]] != missing_value_precip) {
+            sum_precip += precip_t[nb_index[nb]];
+            nobs_pt++;
+          }
+        if (nobs_pt > 0)
+          mean_precip[t+pt*data->learning->obs->ntime] = sqrt(sum_precip / (double) nobs_pt);
+        else if (npt[pt] == -1)
+          npt[pt] = t;
       }
-      for (j=0; j<data->learning->nlat; j++)
-        for (i=0; i<data->learning->nlon; i++) {
-          dist_pt = distance_point(data->reg->lon[pt], data->reg->lat[pt],
-                                   data->learning->lon[i+j*data->learning->nlon], data->learning->lat[i+j*data->learning->nlon]);
-          if (dist_pt <= data->reg->dist)
-            for (t=0; t<data->learning->obs->ntime; t++)
-              if (precip_obs[i+j*data->learning->nlon+t*data->learning->nlon*data->learning->nlat] != missing_value_precip) {
-                mean_precip[t+pt*data->learning->obs->ntime] +=
-                  precip_obs[i+j*data->learning->nlon+t*data->learning->nlon*data->learning->nlat];
-                npt[t]++;
-              }
-        }
-      allpt = FALSE;
-      for (t=0; t<data->learning->obs->ntime; t++)
-        if (npt[t] == 0) allpt = TRUE;
-      if (allpt == TRUE) {
+    }
+    for (pt=0; pt<data->reg->npts; pt++)
+      if (npt[pt] != -1) {
         (void) fprintf(stderr, "%s: WARNING: There are no point of observation in the vicinity of the regression point #%d at a minimum distance of at least %f meters! Verify your regression points, or the configuration of your coordinate variable names in your configuration file, or that you don't have all missing values in your observations in the vicinity of the regression point. Time=%d. lon=%lf lat=%lf. WARNING: Will desactivate this regression point.\n",
-                       __FILE__, pt, data->reg->dist, t, data->reg->lon[pt], data->reg->lat[pt]);
+                       __FILE__, pt, data->reg->dist, npt[pt], data->reg->lon[pt], data->reg->lat[pt]);
         for (t=0; t<data->learning->obs->ntime; t++)
           mean_precip[t+pt*data->learning->obs->ntime] = missing_value_precip;
       }
-      else
-        for (t=0; t<data->learning->obs->ntime; t++)
-          mean_precip[t+pt*data->learning->obs->ntime] = sqrt(mean_precip[t+pt*data->learning->obs->ntime] / (double) npt[t]);
-    }
-    (void) free(npt);
-    (void) free(precip_obs);
+    (void) free(nb_start);
+    (void) free(nb_index);
+    (void) free_large(precip_obs);
 
     /* Select common time period between the re-analysis and the observation data periods for */
     /* secondary large-scale field and extract subdomain */
+    (void) instrument_begin(&timer, "read_fields");
     istat = read_field_subdomain_period(&tas_rea, &(data->learning->sup_lon), &(data->learning->sup_lat),
                                         &missing_value, data->learning->nomvar_rea_sup,
                                         data->learning->obs->time_s->year, data->learning->obs->time_s->month,
@@ -351,9 +758,10 @@ wt_learning(data_struct *data) {
                                         data->learning->rea_dimxname, data->learning->rea_dimyname,
                                         data->learning->rea_timename, data->learning->filename_rea_sup,
                                         &(data->learning->sup_nlon), &(data->learning->sup_nlat), data->learning->obs->ntime);
+    (void) instrument_end(&timer);
 
     /* Perform spatial mean of secondary large-scale fields */
-    tas_rea_mean = (double *) malloc(data->learning->obs->ntime * sizeof(double));
+    tas_rea_mean = (double *) arena_alloc(data->arena[PHASE_LEARNING], data->learning->obs->ntime * sizeof(double));
     if (tas_rea_mean == NULL) alloc_error(__FILE__, __LINE__);
     /* Prepare mask */
     if (data->secondary_mask->use_mask == TRUE) {
@@ -391,333 +799,47 @@ wt_learning(data_struct *data) {
     /* Loop over each season */
     (void) printf("Extract data for each season separately and process each season.\n");
 
+    /* Process each season separately: seasons are independent tasks */
+    tasks = (learning_task_struct *) arena_alloc(data->arena[PHASE_LEARNING], data->conf->nseasons * sizeof(learning_task_struct));
+    if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+    graph = task_graph_create(data->conf->nthreads);
     for (s=0; s<data->conf->nseasons; s++) {
-      /* Process separately each season */
-
-      /* Select season months in the whole time period and create sub-period fields */
-      if (data->learning->obs_neof != 0) {
-        (void) extract_subperiod_months(&buf_learn_obs_sub, &(ntime_sub[s]), buf_learn_obs,
-                                        data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
-                                        data->conf->season[s].month,
-                                        1, 1, data->learning->obs_neof, ntime_learn_all,
-                                        data->conf->season[s].nmonths);
-      }
-      (void) extract_subperiod_months(&buf_learn_rea_sub, &(ntime_sub[s]), buf_learn_rea,
-                                      data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
-                                      data->conf->season[s].month,
-                                      1, 1, data->learning->rea_neof, ntime_learn_all,
-                                      data->conf->season[s].nmonths);
-      (void) extract_subperiod_months(&buf_learn_pc_sub, &(ntime_sub[s]), buf_learn_pc,
-                                      data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
-                                      data->conf->season[s].month,
-                                      1, 1, data->learning->rea_neof, ntime_learn_all,
-                                      data->conf->season[s].nmonths);
-      (void) extract_subperiod_months(&tas_rea_mean_sub, &(ntime_sub[s]), tas_rea_mean,
-                                      data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
-                                      data->conf->season[s].month,
-                                      1, 1, 1, ntime_learn_all,
-                                      data->conf->season[s].nmonths);
-      (void) extract_subperiod_months(&tas_rea_sub, &(ntime_sub[s]), tas_rea,
-                                      data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
-                                      data->conf->season[s].month,
-                                      1, data->learning->sup_nlon, data->learning->sup_nlat, ntime_learn_all,
-                                      data->conf->season[s].nmonths);
-      (void) extract_subperiod_months(&mean_precip_sub, &(ntime_sub[s]), mean_precip,
-                                      data->learning->time_s->year, data->learning->time_s->month, data->learning->time_s->day,
-                                      data->conf->season[s].month,
-                                      1, 1, data->reg->npts, ntime_learn_all,
-                                      data->conf->season[s].nmonths);
-
-      /** Normalize secondary large-scale fields for re-analysis learning data **/
-      data->learning->data[s].sup_index = (double *) malloc(ntime_sub[s] * sizeof(double));
-      if (data->learning->data[s].sup_index == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].sup_val = (double *) malloc(data->learning->sup_nlon*data->learning->sup_nlat*ntime_sub[s] * sizeof(double));
-      if (data->learning->data[s].sup_val == NULL) alloc_error(__FILE__, __LINE__);
-
-      /* Compute mean and variance over time */
-      data->learning->data[s].sup_index_mean = gsl_stats_mean(tas_rea_mean_sub, 1, ntime_sub[s]);
-      data->learning->data[s].sup_index_var = gsl_stats_variance(tas_rea_mean_sub, 1, ntime_sub[s]);
-
-      /* Normalize using mean and variance */
-      (void) normalize_field(data->learning->data[s].sup_index, tas_rea_mean_sub, data->learning->data[s].sup_index_mean,
-                             data->learning->data[s].sup_index_var, 1, 1, ntime_sub[s]);
-
-      /* Compute mean and variance over time for each point */
-      sup_mean = (double *) malloc(data->learning->sup_nlon*data->learning->sup_nlat*ntime_sub[s] * sizeof(double));
-      if (sup_mean == NULL) alloc_error(__FILE__, __LINE__);
-      sup_var = (double *) malloc(data->learning->sup_nlon*data->learning->sup_nlat*ntime_sub[s] * sizeof(double));
-      if (sup_var == NULL) alloc_error(__FILE__, __LINE__);
-      (void) time_mean_variance_field_2d(sup_mean, sup_var, tas_rea_sub, data->learning->sup_nlon, data->learning->sup_nlat, ntime_sub[s]);
-
-      /* Normalize whole secondary 2D field using mean and variance at each point */
-      (void) normalize_field_2d(data->learning->data[s].sup_val, tas_rea_sub, sup_mean,
-                                sup_var, data->learning->sup_nlon, data->learning->sup_nlat, ntime_sub[s]);
-      
-      (void) free(sup_mean);
-      sup_mean = NULL;
-      (void) free(sup_var);
-      sup_var = NULL;
-
-      /** Construct time vectors **/
-      data->learning->data[s].ntime = ntime_sub[s];
-      data->learning->data[s].time = (double *) malloc(ntime_sub[s] * sizeof(double));
-      if (data->learning->data[s].time == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].time_s->year = (int *) malloc(ntime_sub[s] * sizeof(int));
-      if (data->learning->data[s].time_s->year == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].time_s->month = (int *) malloc(ntime_sub[s] * sizeof(int));
-      if (data->learning->data[s].time_s->month == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].time_s->day = (int *) malloc(ntime_sub[s] * sizeof(int));
-      if (data->learning->data[s].time_s->day == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].time_s->hour = (int *) malloc(ntime_sub[s] * sizeof(int));
-      if (data->learning->data[s].time_s->hour == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].time_s->minutes = (int *) malloc(ntime_sub[s] * sizeof(int));
-      if (data->learning->data[s].time_s->minutes == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].time_s->seconds = (double *) malloc(ntime_sub[s] * sizeof(double));
-      if (data->learning->data[s].time_s->seconds == NULL) alloc_error(__FILE__, __LINE__);
-
-      /* Retrieve time index spanning selected months and assign time structure values */
-      t = 0;
-
-      /* Initialize udunits */
-      ut_set_error_message_handler(ut_ignore);
-      unitSystem = ut_read_xml(NULL);
-      ut_set_error_message_handler(ut_write_to_stderr);
-      dataunits = ut_parse(unitSystem, data->conf->time_units, UT_ASCII);
-
-      for (nt=0; nt<ntime_learn_all; nt++)
-        for (ntt=0; ntt<data->conf->season[s].nmonths; ntt++)
-          if (data->learning->time_s->month[nt] == data->conf->season[s].month[ntt]) {
-            data->learning->data[s].time_s->year[t] = data->learning->time_s->year[nt];
-            data->learning->data[s].time_s->month[t] = data->learning->time_s->month[nt];
-            data->learning->data[s].time_s->day[t] = data->learning->time_s->day[nt];
-            data->learning->data[s].time_s->hour[t] = data->learning->time_s->hour[nt];
-            data->learning->data[s].time_s->minutes[t] = data->learning->time_s->minutes[nt];
-            data->learning->data[s].time_s->seconds[t] = data->learning->time_s->seconds[nt];
-            istat = utInvCalendar2(data->learning->data[s].time_s->year[t], data->learning->data[s].time_s->month[t],
-                                   data->learning->data[s].time_s->day[t], data->learning->data[s].time_s->hour[t],
-                                   data->learning->data[s].time_s->minutes[t], data->learning->data[s].time_s->seconds[t],
-                                   dataunits, &(data->learning->data[s].time[t]));
-            t++;
-          }
-
-      (void) ut_free(dataunits);
-      (void) ut_free_system(unitSystem);  
-      
-      /** Merge observation and reanalysis principal components for clustering algorithm and normalize using first Singular Value **/
-
-      buf_learn = (double *) realloc(buf_learn, ntime_sub[s] * (data->learning->rea_neof + data->learning->obs_neof) * sizeof(double));
-      if (buf_learn == NULL) alloc_error(__FILE__, __LINE__);
-
-      /* Normalisation by the first Singular Value */
-      rea_first_sing = data->learning->rea->sing[0];
-      for (eof=0; eof<data->learning->rea_neof; eof++) {
-        rea_sing = data->learning->rea->sing[eof];        
-        for (nt=0; nt<ntime_sub[s]; nt++) {
-          buf_learn_rea_sub[nt+eof*ntime_sub[s]] = buf_learn_rea_sub[nt+eof*ntime_sub[s]] * rea_sing / rea_first_sing;
-          buf_learn[nt+eof*ntime_sub[s]] = buf_learn_rea_sub[nt+eof*ntime_sub[s]];
-        }
-      }      
-      if (data->learning->obs_neof != 0) {
-        obs_first_sing = data->learning->obs->sing[0];
-        for (eof=0; eof<data->learning->obs_neof; eof++) {
-          obs_sing = data->learning->obs->sing[eof];        
-          for (nt=0; nt<ntime_sub[s]; nt++) {
-            buf_learn_obs_sub[nt+eof*ntime_sub[s]] = buf_learn_obs_sub[nt+eof*ntime_sub[s]] * obs_sing / obs_first_sing;
-            buf_learn[nt+(eof+data->learning->rea_neof)*ntime_sub[s]] = buf_learn_obs_sub[nt+eof*ntime_sub[s]];
-          }
-        }
-      }
-
-      /* Compute best clusters */
-      buf_weight = (double *) realloc(buf_weight, data->conf->season[s].nclusters * (data->learning->rea_neof + data->learning->obs_neof) *
-                                      sizeof(double));
-      if (buf_weight == NULL) alloc_error(__FILE__, __LINE__);
-      niter = best_clusters(buf_weight, buf_learn, data->conf->classif_type, data->conf->npartitions,
-                            data->conf->nclassifications, data->learning->rea_neof + data->learning->obs_neof,
-                            data->conf->season[s].nclusters, ntime_sub[s]);
-
-      /* Keep only first data->learning->rea_neof EOFs */
-      data->learning->data[s].weight = (double *) 
-        malloc(data->conf->season[s].nclusters*data->learning->rea_neof * sizeof(double));
-      if (data->learning->data[s].weight == NULL) alloc_error(__FILE__, __LINE__);
-      for (clust=0; clust<data->conf->season[s].nclusters; clust++)
-        for (eof=0; eof<data->learning->rea_neof; eof++)
-          data->learning->data[s].weight[eof+clust*data->learning->rea_neof] =
-            buf_weight[eof+clust*(data->learning->rea_neof+data->learning->obs_neof)];
-      
-      /* Classify each day in the current clusters */
-      data->learning->data[s].class_clusters = (int *) malloc(ntime_sub[s] * sizeof(int));
-      if (data->learning->data[s].class_clusters == NULL) alloc_error(__FILE__, __LINE__);
-      (void) class_days_pc_clusters(data->learning->data[s].class_clusters, buf_learn,
-                                    data->learning->data[s].weight, data->conf->classif_type,
-                                    data->learning->rea_neof, data->conf->season[s].nclusters,
-                                    ntime_sub[s]);
-
-      /* Set mean and variance of distances to clusters to 1.0 because we first need to compute distances and */
-      /* we don't have a control run in learning mode */
-      mean_dist = (double *) realloc(mean_dist, data->conf->season[s].nclusters * sizeof(double));
-      if (mean_dist == NULL) alloc_error(__FILE__, __LINE__);
-      var_dist = (double *) realloc(var_dist, data->conf->season[s].nclusters * sizeof(double));
-      if (var_dist == NULL) alloc_error(__FILE__, __LINE__);
-      for (clust=0; clust<data->conf->season[s].nclusters; clust++) {
-        mean_dist[clust] = 1.0;
-        var_dist[clust] = 1.0;
-      }
-
-      /* Compute distances to clusters using normalization */
-      dist = (double *) realloc(dist, data->conf->season[s].nclusters*ntime_sub[s] * sizeof(double));
-      if (dist == NULL) alloc_error(__FILE__, __LINE__);
-      (void) dist_clusters_normctrl(dist, buf_learn_pc_sub, data->learning->data[s].weight,
-                                    data->learning->pc_normalized_var, data->learning->pc_normalized_var, mean_dist, var_dist,
-                                    data->learning->rea_neof, data->conf->season[s].nclusters, ntime_sub[s]);
-      /* Normalize */
-      for (clust=0; clust<data->conf->season[s].nclusters; clust++) {
-        /* Calculate mean over time */
-        mean_dist[clust] = gsl_stats_mean(&(dist[clust*ntime_sub[s]]), 1, ntime_sub[s]);
-        /* Calculate variance over time */
-        var_dist[clust] = gsl_stats_variance(&(dist[clust*ntime_sub[s]]), 1, ntime_sub[s]);
-        /* Normalize */
-        for (nt=0; nt<ntime_sub[s]; nt++)
-          dist[nt+clust*ntime_sub[s]] = ( dist[nt+clust*ntime_sub[s]] - mean_dist[clust] ) / sqrt(var_dist[clust]);
-      }
-
-      /* Classify each day in the current clusters */
-      /* data->learning->data[s].class_clusters */
-      /*      data->learning->data[s].class_clusters = (int *) malloc(ntime_sub[s] * sizeof(int));
-      if (data->learning->data[s].class_clusters == NULL) alloc_error(__FILE__, __LINE__);
-      (void) class_days_pc_clusters(data->learning->data[s].class_clusters, buf_learn,
-      data->learning->data[s].weight, data->conf->classif_type,
-      data->learning->rea_neof, data->conf->season[s].nclusters, ntime_sub[s]);*/
-
-      /* Allocate memory for regression */
-      precip_reg = (double *) malloc(data->conf->season[s].nreg * sizeof(double));
-      if (precip_reg == NULL) alloc_error(__FILE__, __LINE__);
-      precip_index = (double *) malloc(ntime_sub[s] * sizeof(double));
-      if (precip_index == NULL) alloc_error(__FILE__, __LINE__);
-      precip_err = (double *) malloc(ntime_sub[s] * sizeof(double));
-      if (precip_err == NULL) alloc_error(__FILE__, __LINE__);
-      dist_reg = (double *) malloc(data->conf->season[s].nreg*ntime_sub[s] * sizeof(double));
-      if (dist_reg == NULL) alloc_error(__FILE__, __LINE__);
-      vif = (double *) malloc(data->conf->season[s].nreg * sizeof(double));
-      if (vif == NULL) alloc_error(__FILE__, __LINE__);
-
-      /* Create variable to hold values of x vector for regression */
-      /* Begin with distances to clusters */
-      for (clust=0; clust<data->conf->season[s].nclusters; clust++)
-        for (t=0; t<ntime_sub[s]; t++)
-          dist_reg[t+clust*ntime_sub[s]] = dist[t+clust*ntime_sub[s]];
-
-      /* For special seasons using secondary field in the regression, append values to x vector for regression */
-      if (data->conf->season[s].nreg == (data->conf->season[s].nclusters+1)) {
-        clust = data->conf->season[s].nclusters;
-        for (t=0; t<ntime_sub[s]; t++)
-          dist_reg[t+clust*ntime_sub[s]] = data->learning->data[s].sup_index[t];
-      }
-
-      data->learning->data[s].precip_reg_cst = (double *) malloc(data->reg->npts * sizeof(double));
-      if (data->learning->data[s].precip_reg_cst == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].precip_reg = (double *) malloc(data->reg->npts*data->conf->season[s].nreg * sizeof(double));
-      if (data->learning->data[s].precip_reg == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].precip_reg_dist = (double *)
-        malloc(data->conf->season[s].nclusters*ntime_sub[s] * sizeof(double));
-      if (data->learning->data[s].precip_reg_dist == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].precip_index = (double *) malloc(data->reg->npts*ntime_sub[s] * sizeof(double));
-      if (data->learning->data[s].precip_index == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].precip_index_obs = (double *) malloc(data->reg->npts*ntime_sub[s] * sizeof(double));
-      if (data->learning->data[s].precip_index_obs == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].precip_reg_err = (double *) malloc(data->reg->npts*ntime_sub[s] * sizeof(double));
-      if (data->learning->data[s].precip_reg_err == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].precip_reg_rsq = (double *) malloc(data->reg->npts * sizeof(double));
-      if (data->learning->data[s].precip_reg_rsq == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].precip_reg_vif = (double *) malloc(data->conf->season[s].nreg * sizeof(double));
-      if (data->learning->data[s].precip_reg_vif == NULL) alloc_error(__FILE__, __LINE__);
-      data->learning->data[s].precip_reg_autocor = (double *) malloc(data->reg->npts * sizeof(double));
-      if (data->learning->data[s].precip_reg_autocor == NULL) alloc_error(__FILE__, __LINE__);
-
-      /* Save distances */
-      for (t=0; t<ntime_sub[s]; t++)
-        for (clust=0; clust<data->conf->season[s].nclusters; clust++)
-          data->learning->data[s].precip_reg_dist[clust+t*data->conf->season[s].nclusters] = dist[t+clust*ntime_sub[s]];
-
-      for (pt=0; pt<data->reg->npts; pt++) {
-        /* Compute regression and save regression constant */
-        istat = regress(precip_reg, dist_reg, &(mean_precip_sub[pt*ntime_sub[s]]), &(data->learning->data[s].precip_reg_cst[pt]),
-                        precip_index, precip_err, &chisq, &rsq, vif, &autocor, data->conf->season[s].nreg, ntime_sub[s]);
-        /* Save R^2 */
-        data->learning->data[s].precip_reg_rsq[pt] = rsq;
-        /* Save residuals */
-        for (t=0; t<ntime_sub[s]; t++)
-          data->learning->data[s].precip_reg_err[pt+t*data->reg->npts] = precip_err[t];
-        /* Save autocorrelation of residuals */
-        data->learning->data[s].precip_reg_autocor[pt] = autocor;
-        /* Save Variance Inflation Factor VIF, and compute mean VIF */
-        if (pt == 0) {
-          meanvif = 0.0;
-          for (term=0; term<data->conf->season[s].nreg; term++) {
-            data->learning->data[s].precip_reg_vif[term] = vif[term];
-            meanvif += vif[term];
-          }
-          meanvif = meanvif / (double) data->conf->season[s].nreg;
-        }
-
-        //        (void) fprintf(stdout, "%s: pt=%d R^2=%lf CHI^2=%lf ACOR=%lf\n", __FILE__, pt, rsq, chisq, autocor);
-
-        /* Save regression coefficients */
-        for (clust=0; clust<data->conf->season[s].nreg; clust++)
-          data->learning->data[s].precip_reg[pt+clust*data->reg->npts] = precip_reg[clust];
-
-        /* Save precipitation index */
-        for (t=0; t<ntime_sub[s]; t++)
-          data->learning->data[s].precip_index[pt+t*data->reg->npts] = precip_index[t];
-
-        /* Save observed precipitation index */
-        for (t=0; t<ntime_sub[s]; t++)
-          data->learning->data[s].precip_index_obs[pt+t*data->reg->npts] = mean_precip_sub[t+pt*ntime_sub[s]];
-      }
-
-      (void) fprintf(stdout, "%s: MeanVIF=%lf\n", __FILE__, meanvif);
-
-      (void) free(precip_reg);
-      (void) free(precip_index);
-      (void) free(precip_err);
-      (void) free(dist_reg);
-      (void) free(vif);
-
-      (void) free(buf_learn_rea_sub);
-      buf_learn_rea_sub = NULL;
-      if (data->learning->obs_neof != 0) {
-        (void) free(buf_learn_obs_sub);
-        buf_learn_obs_sub = NULL;
-      }
-      (void) free(buf_learn_pc_sub);
-      buf_learn_pc_sub = NULL;
-      (void) free(tas_rea_mean_sub);
-      tas_rea_mean_sub = NULL;
-      (void) free(tas_rea_sub);
-      tas_rea_sub = NULL;
-      (void) free(mean_precip_sub);
-      mean_precip_sub = NULL;
+      tasks[s].data = data;
+      tasks[s].s = s;
+      tasks[s].buf_learn_obs = buf_learn_obs;
+      tasks[s].buf_learn_rea = buf_learn_rea;
+      tasks[s].buf_learn_pc = buf_learn_pc;
+      tasks[s].tas_rea_mean = tas_rea_mean;
+      tasks[s].tas_rea = tas_rea;
+      tasks[s].mean_precip = mean_precip;
+      tasks[s].ntime_learn_all = ntime_learn_all;
+      tasks[s].ntime_sub = ntime_sub;
+      tasks[s].niter = 2;
+      (void) task_graph_add(graph, learning_task_season, (void *) &(tasks[s]));
     }
+    istat = task_graph_run(graph);
+    (void) task_graph_free(graph);
+    if (istat != 0) return istat;
+    /* Keep diagnostic of the last season */
+    if (data->conf->nseasons > 0)
+      niter = tasks[data->conf->nseasons-1].niter;
 
     (void) free(tas_rea);
-    (void) free(tas_rea_mean);
-    (void) free(mean_precip);
-    (void) free(buf_weight);
-    (void) free(buf_learn);
     (void) free(buf_learn_rea);
     if (data->learning->obs_neof != 0) (void) free(buf_learn_obs);
-    (void) free(buf_learn_pc);
-    (void) free(ntime_sub);
-    (void) free(rea_var);
-    (void) free(mean_dist);
-    (void) free(var_dist);
-    (void) free(dist);
+    /* Other scratch buffers are released with the learning phase arena */
 
     /* If wanted, write learning data to files for later use */
     if (data->learning->learning_save == TRUE) {
       (void) printf("Writing learning fields.\n");
       istat = write_learning_fields(data);
     }
+    /* Store learning data in the learning cache for later runs */
+    if (data->learning->cache_dir != NULL && niter != 1)
+      (void) learning_cache_store(data);
+    /* Checkpoint learning data of this run */
+    if (niter != 1)
+      (void) checkpoint_learning_save(data);
     if (niter == 1) {
       (void) fprintf(stderr, "%s: ERROR: In one classification, only 1 iteration was needed! Probably an error in your EOF data or configuration. Must abort...\n",
                      __FILE__);
@@ -0,0 +1,290 @@
+/* ***************************************************** */
+/* bench_date_index Time common-period selection.        */
+/* bench_date_index.c                                    */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file bench_date_index.c
+    \brief Micro-benchmark of common-period and season selection on long daily time vectors.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** GNU extensions */
+#define _GNU_SOURCE
+
+/* C standard includes */
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_TIME_H
+#include <time.h>
+#endif
+#ifdef HAVE_LIBGEN_H
+#include <libgen.h>
+#endif
+
+#include <utils.h>
+
+/** C prototypes. */
+void show_usage(char *pgm);
+void make_daily_noleap(int *year, int *month, int *day, int year_begin, int nyears);
+int nested_common_dates(int **index, int *year, int *month, int *day, int *year_learn, int *month_learn, int *day_learn,
+                        int ntime, int ntime_learn);
+double elapsed(clock_t begin);
+
+/** Main program. */
+int main(int argc, char **argv)
+{
+  /**
+     @param[in]  argc  Number of command-line arguments.
+     @param[in]  argv  Vector of command-line argument strings.
+
+     \return           Status.
+   */
+
+  int nyears = 150; /* Number of years of the model time vector */
+  int nyears_learn = 150; /* Number of years of the learning time vector */
+  int ndim = 10; /* Number of values per timestep */
+  int smonths[3] = { 6, 7, 8 }; /* Season months */
+
+  int *year = NULL;
+  int *month = NULL;
+  int *day = NULL;
+  int *year_learn = NULL;
+  int *month_learn = NULL;
+  int *day_learn = NULL;
+  int *index = NULL;
+  int *index_old = NULL;
+  double *bufin = NULL;
+  double *buf_sub = NULL;
+  int ntime;
+  int ntime_learn;
+  int nmatch;
+  int nmatch_old;
+  clock_t begin;
+  int i;
+  int t;
+
+  /* Print BEGIN banner */
+  (void) banner(basename(argv[0]), "1.0", "BEGIN");
+
+  /* Get command-line arguments and set appropriate variables */
+  for (i=1; i<argc; i++) {
+    if ( !strcmp(argv[i], "-h") ) {
+      (void) show_usage(basename(argv[0]));
+      (void) banner(basename(argv[0]), "OK", "END");
+      return 0;
+    }
+    else if ( !strcmp(argv[i], "-years") && i+1 < argc )
+      nyears = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-years_learn") && i+1 < argc )
+      nyears_learn = atoi(argv[++i]);
+    else {
+      (void) fprintf(stderr, "%s:: Wrong arg %s.\n\n", basename(argv[0]), argv[i]);
+      (void) show_usage(basename(argv[0]));
+      (void) banner(basename(argv[0]), "ABORT", "END");
+      (void) abort();
+    }
+  }
+
+  /* Daily time vectors: model run from 1950, learning period overlapping it from 1960 */
+  ntime = nyears * 365;
+  ntime_learn = nyears_learn * 365;
+  year = (int *) malloc(ntime * sizeof(int));
+  month = (int *) malloc(ntime * sizeof(int));
+  day = (int *) malloc(ntime * sizeof(int));
+  year_learn = (int *) malloc(ntime_learn * sizeof(int));
+  month_learn = (int *) malloc(ntime_learn * sizeof(int));
+  day_learn = (int *) malloc(ntime_learn * sizeof(int));
+  index = (int *) malloc(ntime * sizeof(int));
+  bufin = (double *) malloc((size_t) ntime * ndim * sizeof(double));
+  buf_sub = (double *) malloc((size_t) ntime * ndim * sizeof(double));
+  if (year == NULL || month == NULL || day == NULL || year_learn == NULL || month_learn == NULL || day_learn == NULL ||
+      index == NULL || bufin == NULL || buf_sub == NULL) alloc_error(__FILE__, __LINE__);
+  (void) make_daily_noleap(year, month, day, 1950, nyears);
+  (void) make_daily_noleap(year_learn, month_learn, day_learn, 1960, nyears_learn);
+  for (t=0; t<ntime*ndim; t++)
+    bufin[t] = (double) t;
+
+  (void) printf("Model time vector: %d days. Learning time vector: %d days.\n", ntime, ntime_learn);
+
+  /* Common period: nested loop with realloc per match */
+  begin = clock();
+  nmatch_old = nested_common_dates(&index_old, year, month, day, year_learn, month_learn, day_learn, ntime, ntime_learn);
+  (void) printf("Common dates, nested loop:  %d matches in %.4f s\n", nmatch_old, elapsed(begin));
+
+  /* Common period: merge-join on packed dates */
+  begin = clock();
+  nmatch = match_common_dates(index, year, month, day, year_learn, month_learn, day_learn, ntime, ntime_learn);
+  (void) printf("Common dates, merge-join:   %d matches in %.4f s\n", nmatch, elapsed(begin));
+
+  if (nmatch != nmatch_old || (nmatch > 0 && memcmp(index, index_old, nmatch * sizeof(int)) != 0)) {
+    (void) fprintf(stderr, "%s: Common dates differ between the two methods!\n", __FILE__);
+    (void) banner(basename(argv[0]), "ABORT", "END");
+    return 1;
+  }
+
+  /* Gather common period, time dimension last */
+  begin = clock();
+  (void) gather_time_index(buf_sub, bufin, index, 3, ndim, 1, ntime, nmatch);
+  (void) printf("Gather %d timesteps:        %.4f s\n", nmatch, elapsed(begin));
+
+  /* Season selection */
+  begin = clock();
+  nmatch = select_months_index(index, month, smonths, (double *) NULL, 0.0, 0.0, ntime, 3);
+  (void) gather_time_index(buf_sub, bufin, index, 3, ndim, 1, ntime, nmatch);
+  (void) printf("Season selection %d days:  %.4f s\n", nmatch, elapsed(begin));
+
+  (void) free(year);
+  (void) free(month);
+  (void) free(day);
+  (void) free(year_learn);
+  (void) free(month_learn);
+  (void) free(day_learn);
+  (void) free(index);
+  (void) free(index_old);
+  (void) free(bufin);
+  (void) free(buf_sub);
+
+  /* Print END banner */
+  (void) banner(basename(argv[0]), "OK", "END");
+
+  return 0;
+}
+
+
+/** Local Subroutines **/
+
+/** Show usage for program command-line arguments. */
+void show_usage(char *pgm) {
+  /**
+     @param[in]  pgm  Program name.
+  */
+
+  (void) fprintf(stderr, "%s: usage:\n", pgm);
+  (void) fprintf(stderr, "-years N: number of years of model time vector (default 150)\n");
+  (void) fprintf(stderr, "-years_learn N: number of years of learning time vector (default 150)\n");
+  (void) fprintf(stderr, "-h: help\n");
+
+}
+
+/** Build daily year, month and day vectors for a 365-day calendar. */
+void make_daily_noleap(int *year, int *month, int *day, int year_begin, int nyears) {
+  /**
+     @param[out]  year        Year vector
+     @param[out]  month       Month vector
+     @param[out]  day         Day vector
+     @param[in]   year_begin  First year
+     @param[in]   nyears      Number of years
+  */
+
+  int ndays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  int y;
+  int m;
+  int d;
+  int t = 0;
+
+  for (y=0; y<nyears; y++)
+    for (m=0; m<12; m++)
+      for (d=1; d<=ndays[m]; d++) {
+        year[t] = year_begin + y;
+        month[t] = m + 1;
+        day[t] = d;
+        t++;
+      }
+}
+
+/** Reference nested-loop common date search, growing the index vector by one element per match. */
+int nested_common_dates(int **index, int *year, int *month, int *day, int *year_learn, int *month_learn, int *day_learn,
+                        int ntime, int ntime_learn) {
+  /**
+     @param[out]  index        Time indexes of common dates
+     @param[in]   year         Year vector for the first time vector
+     @param[in]   month        Month vector for the first time vector
+     @param[in]   day          Day vector for the first time vector
+     @param[in]   year_learn   Year vector for the second time vector
+     @param[in]   month_learn  Month vector for the second time vector
+     @param[in]   day_learn    Day vector for the second time vector
+     @param[in]   ntime        Time dimension of the first time vector
+     @param[in]   ntime_learn  Time dimension of the second time vector
+
+     \return                  Number of common dates.
+  */
+
+  int nmatch = 0;
+  int t;
+  int tt;
+
+  for (t=0; t<ntime; t++)
+    for (tt=0; tt<ntime_learn; tt++)
+      if (year[t] == year_learn[tt] && month[t] == month_learn[tt] && day[t] == day_learn[tt]) {
+        (*index) = (int *) realloc((*index), (nmatch+1) * sizeof(int));
+        if ((*index) == NULL) alloc_error(__FILE__, __LINE__);
+        (*index)[nmatch++] = t;
+      }
+
+  return nmatch;
+}
+
+/** Elapsed processor time in seconds. */
+double elapsed(clock_t begin) {
+  /**
+     @param[in]  begin  Start processor time.
+
+     \return            Elapsed time in seconds.
+  */
+
+  return (double) (clock() - begin) / (double) CLOCKS_PER_SEC;
+}
@@ -0,0 +1,633 @@
+/* ***************************************************** */
+/* bench_kernels Hot kernels benchmarks.                 */
+/* bench_kernels.c                                       */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file bench_kernels.c
+    \brief Benchmark of the downscaling hot kernels on synthetic data, with throughput and scaling across thread counts.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** GNU extensions */
+#define _GNU_SOURCE
+
+/* C standard includes */
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_MATH_H
+#include <math.h>
+#endif
+#ifdef HAVE_LIBGEN_H
+#include <libgen.h>
+#endif
+
+/* GSL includes */
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+
+/* NetCDF include */
+#include <netcdf.h>
+
+#include <dsclim.h>
+
+/** Maximum number of thread counts. */
+#define MAXNTHREADS 32
+
+/** Benchmark input data shared read-only by all kernel instances. */
+typedef struct {
+  char *kernel; /**< Kernel name. */
+  char *outdir; /**< Directory for output writing benchmark. */
+  int nlon; /**< Longitude dimension. */
+  int nlat; /**< Latitude dimension. */
+  int ntime; /**< Time dimension of fields and learning period. */
+  int ntime_down; /**< Time dimension of downscaled period. */
+  int neof; /**< Number of EOFs. */
+  int nclust; /**< Number of clusters. */
+  int nclassif; /**< Number of classifications for k-means. */
+  int npts; /**< Number of regression points. */
+  double *field; /**< 3D field (nlon x nlat x ntime). */
+  double *lon; /**< 2D longitudes. */
+  double *lat; /**< 2D latitudes. */
+  double *eof; /**< EOFs (nlon x nlat x neof). */
+  double *sing; /**< Singular values. */
+  double *pc; /**< Principal components (ntime x neof). */
+  double *dist; /**< Cluster distances (ntime x nclust). */
+  double *precip; /**< Precipitation at regression points (npts x ntime). */
+  double *precip_down; /**< Precipitation index of downscaled period (npts x ntime_down). */
+  double *sup_index; /**< Secondary field index of learning period. */
+  double *sup_index_down; /**< Secondary field index of downscaled period. */
+  int *clusters; /**< Cluster of each day of learning period. */
+  int *clusters_down; /**< Cluster of each day of downscaled period. */
+  int *year; /**< Years of learning period. */
+  int *month; /**< Months of learning period. */
+  int *day; /**< Days of learning period. */
+  int *year_down; /**< Years of downscaled period. */
+  int *month_down; /**< Months of downscaled period. */
+  int *day_down; /**< Days of downscaled period. */
+  tstruct *buftime; /**< Time structure of learning period. */
+} bench_data_struct;
+
+/** One kernel instance executed by a thread. */
+typedef struct {
+  bench_data_struct *data; /**< Shared input data. */
+  int instance; /**< Instance number. */
+  int istat; /**< Status of the kernel. */
+} bench_task_struct;
+
+/** C prototypes. */
+void show_usage(char *pgm);
+void make_daily_noleap(int *year, int *month, int *day, int year_begin, int nyears);
+double kernel_work(bench_data_struct *data, char **units);
+void run_kernel(void *arg);
+
+/** Main program. */
+int main(int argc, char **argv)
+{
+  /**
+     @param[in]  argc  Number of command-line arguments.
+     @param[in]  argv  Vector of command-line argument strings.
+
+     \return           Status.
+   */
+
+  char *kernels[7] = { "analog", "kmeans", "regression", "climatology", "filter", "eof", "output" }; /* Kernel names */
+  int nkernels = 7; /* Number of kernels */
+  char *kernel = NULL; /* Kernel selected on command-line, all when NULL */
+  char *csvfile = NULL; /* CSV results file */
+  char outdir[500]; /* Output directory for output writing benchmark */
+  char threads_list[500]; /* Comma-separated list of thread counts */
+  int nthreads[MAXNTHREADS]; /* Thread counts */
+  int nnthreads = 0; /* Number of thread counts */
+  int nyears = 30; /* Number of years of learning period */
+  int nyears_down = 10; /* Number of years of downscaled period */
+  int reps = 1; /* Number of repetitions */
+
+  bench_data_struct data; /* Benchmark input data */
+  bench_task_struct *tasks = NULL; /* Kernel instances */
+  thread_pool_struct *pool = NULL; /* Thread pool */
+  FILE *csvptr = NULL; /* CSV file pointer */
+  gsl_rng *rng = NULL; /* Random number generator */
+  char *units = NULL; /* Work units of kernel */
+  char *tok = NULL; /* Token of thread counts list */
+  double work; /* Work per kernel instance */
+  double begin; /* Start wall-clock time */
+  double seconds; /* Wall-clock time per repetition */
+  double throughput; /* Throughput */
+  double throughput_1; /* Throughput with the first thread count, reference for speedup */
+  int npts; /* Number of grid points */
+  int istat = 0; /* Diagnostic status */
+  int i; /* Loop counter */
+  int k; /* Kernel loop counter */
+  int n; /* Thread count loop counter */
+  int r; /* Repetition loop counter */
+  int t; /* Time loop counter */
+  int e; /* EOF loop counter */
+  int pts; /* Points loop counter */
+
+  /* Print BEGIN banner */
+  (void) banner(basename(argv[0]), "1.0", "BEGIN");
+
+  (void) strcpy(outdir, ".");
+  (void) strcpy(threads_list, "1,2,4");
+  data.nlon = 40;
+  data.nlat = 30;
+  data.neof = 10;
+  data.nclust = 9;
+  data.nclassif = 100;
+  data.npts = 50;
+
+  /* Get command-line arguments and set appropriate variables */
+  for (i=1; i<argc; i++) {
+    if ( !strcmp(argv[i], "-h") ) {
+      (void) show_usage(basename(argv[0]));
+      (void) banner(basename(argv[0]), "OK", "END");
+      return 0;
+    }
+    else if ( !strcmp(argv[i], "-nlon") && i+1 < argc )
+      data.nlon = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-nlat") && i+1 < argc )
+      data.nlat = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-years") && i+1 < argc )
+      nyears = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-years_down") && i+1 < argc )
+      nyears_down = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-neof") && i+1 < argc )
+      data.neof = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-nclust") && i+1 < argc )
+      data.nclust = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-nclassif") && i+1 < argc )
+      data.nclassif = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-npts") && i+1 < argc )
+      data.npts = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-threads") && i+1 < argc )
+      (void) strncpy(threads_list, argv[++i], 499);
+    else if ( !strcmp(argv[i], "-kernel") && i+1 < argc )
+      kernel = argv[++i];
+    else if ( !strcmp(argv[i], "-reps") && i+1 < argc )
+      reps = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-out") && i+1 < argc )
+      (void) strncpy(outdir, argv[++i], 499);
+    else if ( !strcmp(argv[i], "-csv") && i+1 < argc )
+      csvfile = argv[++i];
+    else {
+      (void) fprintf(stderr, "%s:: Wrong arg %s.\n\n", basename(argv[0]), argv[i]);
+      (void) show_usage(basename(argv[0]));
+      (void) banner(basename(argv[0]), "ABORT", "END");
+      (void) abort();
+    }
+  }
+  threads_list[499] = '\0';
+  outdir[499] = '\0';
+  data.outdir = outdir;
+  if (reps < 1) reps = 1;
+
+  for (tok = strtok(threads_list, ","); tok != NULL && nnthreads < MAXNTHREADS; tok = strtok(NULL, ","))
+    if (atoi(tok) > 0)
+      nthreads[nnthreads++] = (atoi(tok) < MAXNTHREADS) ? atoi(tok) : MAXNTHREADS;
+  if (nnthreads == 0)
+    nthreads[nnthreads++] = 1;
+
+  /* Synthetic inputs: noleap daily time vectors, learning period from 1961, downscaled period from 2071 */
+  npts = data.nlon * data.nlat;
+  data.ntime = nyears * 365;
+  data.ntime_down = nyears_down * 365;
+  data.year = (int *) malloc(data.ntime * sizeof(int));
+  data.month = (int *) malloc(data.ntime * sizeof(int));
+  data.day = (int *) malloc(data.ntime * sizeof(int));
+  data.year_down = (int *) malloc(data.ntime_down * sizeof(int));
+  data.month_down = (int *) malloc(data.ntime_down * sizeof(int));
+  data.day_down = (int *) malloc(data.ntime_down * sizeof(int));
+  data.buftime = (tstruct *) malloc(data.ntime * sizeof(tstruct));
+  data.field = (double *) malloc((size_t) npts * data.ntime * sizeof(double));
+  data.lon = (double *) malloc(npts * sizeof(double));
+  data.lat = (double *) malloc(npts * sizeof(double));
+  data.eof = (double *) malloc((size_t) npts * data.neof * sizeof(double));
+  data.sing = (double *) malloc(data.neof * sizeof(double));
+  data.pc = (double *) malloc((size_t) data.ntime * data.neof * sizeof(double));
+  data.dist = (double *) malloc((size_t) data.ntime * data.nclust * sizeof(double));
+  data.precip = (double *) malloc((size_t) data.npts * data.ntime * sizeof(double));
+  data.precip_down = (double *) malloc((size_t) data.npts * data.ntime_down * sizeof(double));
+  data.sup_index = (double *) malloc(data.ntime * sizeof(double));
+  data.sup_index_down = (double *) malloc(data.ntime_down * sizeof(double));
+  data.clusters = (int *) malloc(data.ntime * sizeof(int));
+  data.clusters_down = (int *) malloc(data.ntime_down * sizeof(int));
+  if (data.year == NULL || data.month == NULL || data.day == NULL || data.year_down == NULL || data.month_down == NULL ||
+      data.day_down == NULL || data.buftime == NULL || data.field == NULL || data.lon == NULL || data.lat == NULL ||
+      data.eof == NULL || data.sing == NULL || data.pc == NULL || data.dist == NULL || data.precip == NULL ||
+      data.precip_down == NULL || data.sup_index == NULL || data.sup_index_down == NULL || data.clusters == NULL ||
+      data.clusters_down == NULL) alloc_error(__FILE__, __LINE__);
+
+  (void) make_daily_noleap(data.year, data.month, data.day, 1961, nyears);
+  (void) make_daily_noleap(data.year_down, data.month_down, data.day_down, 2071, nyears_down);
+  for (t=0; t<data.ntime; t++) {
+    data.buftime[t].year = data.year[t];
+    data.buftime[t].month = data.month[t];
+    data.buftime[t].day = data.day[t];
+    data.buftime[t].hour = 0;
+    data.buftime[t].min = 0;
+    data.buftime[t].sec = 0.0;
+  }
+
+  /* Fixed seed so that runs are comparable between versions */
+  rng = gsl_rng_alloc(gsl_rng_mt19937);
+  (void) gsl_rng_set(rng, 1);
+  for (i=0; i<npts; i++) {
+    data.lon[i] = -10.0 + 0.5 * (double) (i % data.nlon);
+    data.lat[i] = 35.0 + 0.5 * (double) (i / data.nlon);
+  }
+  for (t=0; t<data.ntime; t++)
+    for (i=0; i<npts; i++)
+      data.field[i+(size_t) t*npts] = 285.0 - 8.0 * cos(2.0 * M_PI * (double) (t % 365) / 365.0) + gsl_ran_gaussian(rng, 3.0);
+  for (e=0; e<data.neof; e++) {
+    for (i=0; i<npts; i++)
+      data.eof[i+(size_t) e*npts] = gsl_ran_gaussian(rng, 1.0) / sqrt((double) npts);
+    data.sing[e] = 1000.0 / (double) (e+1);
+  }
+  for (i=0; i<data.ntime*data.neof; i++)
+    data.pc[i] = gsl_ran_gaussian(rng, 1.0);
+  for (i=0; i<data.ntime*data.nclust; i++)
+    data.dist[i] = gsl_ran_gaussian(rng, 1.0);
+  for (t=0; t<data.ntime; t++) {
+    data.sup_index[t] = gsl_ran_gaussian(rng, 1.0);
+    data.clusters[t] = (int) gsl_rng_uniform_int(rng, (unsigned long int) data.nclust);
+    for (pts=0; pts<data.npts; pts++)
+      data.precip[pts+t*data.npts] = gsl_ran_gaussian(rng, 1.0);
+  }
+  for (t=0; t<data.ntime_down; t++) {
+    data.sup_index_down[t] = gsl_ran_gaussian(rng, 1.0);
+    data.clusters_down[t] = (int) gsl_rng_uniform_int(rng, (unsigned long int) data.nclust);
+    for (pts=0; pts<data.npts; pts++)
+      data.precip_down[pts+t*data.npts] = gsl_ran_gaussian(rng, 1.0);
+  }
+  (void) gsl_rng_free(rng);
+
+  (void) printf("Grid %dx%d, %d learning days, %d downscaled days, %d EOFs, %d clusters, %d regression points, %d repetitions.\n",
+                data.nlon, data.nlat, data.ntime, data.ntime_down, data.neof, data.nclust, data.npts, reps);
+
+  if (csvfile != NULL) {
+    csvptr = fopen(csvfile, "a");
+    if (csvptr == NULL) {
+      (void) fprintf(stderr, "%s: Cannot open CSV file %s.\n", __FILE__, csvfile);
+      (void) banner(basename(argv[0]), "ABORT", "END");
+      return 1;
+    }
+  }
+
+  tasks = (bench_task_struct *) malloc(MAXNTHREADS * sizeof(bench_task_struct));
+  if (tasks == NULL) alloc_error(__FILE__, __LINE__);
+
+  (void) printf("\n%-12s %8s %12s %14s %-10s %8s\n", "kernel", "threads", "seconds", "throughput", "units", "speedup");
+
+  /* Each thread count runs that many independent kernel instances concurrently: */
+  /* the throughput measures how the kernel scales when seasons or categories are processed in parallel */
+  for (k=0; k<nkernels && istat == 0; k++) {
+    if (kernel != NULL && strcmp(kernel, kernels[k]))
+      continue;
+    data.kernel = kernels[k];
+    work = kernel_work(&data, &units);
+    throughput_1 = 0.0;
+    for (n=0; n<nnthreads && istat == 0; n++) {
+      /* The analog search initializes udunits, whose parser is not reentrant */
+      if ( !strcmp(kernels[k], "analog") && nthreads[n] > 1 ) {
+        (void) printf("%-12s %8d %12s\n", kernels[k], nthreads[n], "skipped");
+        continue;
+      }
+      pool = thread_pool_create(nthreads[n]);
+      begin = instrument_clock();
+      for (r=0; r<reps; r++) {
+        for (i=0; i<nthreads[n]; i++) {
+          tasks[i].data = &data;
+          tasks[i].instance = i;
+          tasks[i].istat = 0;
+          (void) thread_pool_submit(pool, run_kernel, &(tasks[i]));
+        }
+        (void) thread_pool_wait(pool);
+        for (i=0; i<nthreads[n]; i++)
+          if (tasks[i].istat != 0) istat = tasks[i].istat;
+      }
+      seconds = (instrument_clock() - begin) / (double) reps;
+      (void) thread_pool_free(pool);
+      throughput = (seconds > 0.0) ? work * (double) nthreads[n] / seconds : 0.0;
+      if (throughput_1 == 0.0)
+        throughput_1 = throughput / (double) nthreads[n];
+      (void) printf("%-12s %8d %12.4f %14.2f %-10s %8.2f\n", kernels[k], nthreads[n], seconds, throughput, units,
+                    (throughput_1 > 0.0) ? throughput / throughput_1 : 0.0);
+      if (csvptr != NULL)
+        (void) fprintf(csvptr, "%s,%s,%d,%d,%d,%d,%.6f,%.4f,%s\n", PACKAGE_VERSION, kernels[k], nthreads[n], data.nlon, data.nlat,
+                       data.ntime, seconds, throughput, units);
+    }
+  }
+
+  if (csvptr != NULL)
+    (void) fclose(csvptr);
+
+  (void) free(tasks);
+  (void) free(data.year);
+  (void) free(data.month);
+  (void) free(data.day);
+  (void) free(data.year_down);
+  (void) free(data.month_down);
+  (void) free(data.day_down);
+  (void) free(data.buftime);
+  (void) free(data.field);
+  (void) free(data.lon);
+  (void) free(data.lat);
+  (void) free(data.eof);
+  (void) free(data.sing);
+  (void) free(data.pc);
+  (void) free(data.dist);
+  (void) free(data.precip);
+  (void) free(data.precip_down);
+  (void) free(data.sup_index);
+  (void) free(data.sup_index_down);
+  (void) free(data.clusters);
+  (void) free(data.clusters_down);
+
+  if (istat != 0) {
+    (void) banner(basename(argv[0]), "ABORT", "END");
+    return 1;
+  }
+
+  /* Print END banner */
+  (void) banner(basename(argv[0]), "OK", "END");
+
+  return 0;
+}
+
+
+/** Local Subroutines **/
+
+/** Show usage for program command-line arguments. */
+void show_usage(char *pgm) {
+  /**
+     @param[in]  pgm  Program name.
+  */
+
+  (void) fprintf(stderr, "%s: usage:\n", pgm);
+  (void) fprintf(stderr, "-nlon N -nlat N: grid dimensions (default 40x30)\n");
+  (void) fprintf(stderr, "-years N: number of years of learning period and fields (default 30)\n");
+  (void) fprintf(stderr, "-years_down N: number of years of downscaled period for analog search (default 10)\n");
+  (void) fprintf(stderr, "-neof N: number of EOFs (default 10)\n");
+  (void) fprintf(stderr, "-nclust N: number of clusters (default 9)\n");
+  (void) fprintf(stderr, "-nclassif N: number of k-means classifications (default 100)\n");
+  (void) fprintf(stderr, "-npts N: number of regression points (default 50)\n");
+  (void) fprintf(stderr, "-threads list: comma-separated thread counts (default 1,2,4)\n");
+  (void) fprintf(stderr, "-kernel name: analog, kmeans, regression, climatology, filter, eof or output (default all)\n");
+  (void) fprintf(stderr, "-reps N: number of repetitions (default 1)\n");
+  (void) fprintf(stderr, "-out dir: directory for output writing benchmark files (default .)\n");
+  (void) fprintf(stderr, "-csv file: append results to a CSV file (version,kernel,threads,nlon,nlat,ntime,seconds,throughput,units)\n");
+  (void) fprintf(stderr, "-h: help\n");
+
+}
+
+/** Build daily year, month and day vectors for a 365-day calendar. */
+void make_daily_noleap(int *year, int *month, int *day, int year_begin, int nyears) {
+  /**
+     @param[out]  year        Year vector
+     @param[out]  month       Month vector
+     @param[out]  day         Day vector
+     @param[in]   year_begin  First year
+     @param[in]   nyears      Number of years
+  */
+
+  int ndays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  int y;
+  int m;
+  int d;
+  int t = 0;
+
+  for (y=0; y<nyears; y++)
+    for (m=0; m<12; m++)
+      for (d=1; d<=ndays[m]; d++) {
+        year[t] = year_begin + y;
+        month[t] = m + 1;
+        day[t] = d;
+        t++;
+      }
+}
+
+/** Work done by one kernel instance, in the kernel throughput units. */
+double kernel_work(bench_data_struct *data, char **units) {
+  /**
+     @param[in]   data   Benchmark input data
+     @param[out]  units  Throughput units
+
+     \return             Work per kernel instance.
+  */
+
+  if ( !strcmp(data->kernel, "analog") ) {
+    (*units) = "days/s";
+    return (double) data->ntime_down;
+  }
+  else if ( !strcmp(data->kernel, "kmeans") ) {
+    (*units) = "days/s";
+    return (double) data->ntime;
+  }
+  else if ( !strcmp(data->kernel, "regression") ) {
+    (*units) = "points/s";
+    return (double) data->npts;
+  }
+
+  /* Field kernels: size of the 3D field */
+  (*units) = "MB/s";
+  return (double) data->nlon * (double) data->nlat * (double) data->ntime * sizeof(double) / (1024.0 * 1024.0);
+}
+
+/** Run one instance of a kernel, with its own output buffers. */
+void run_kernel(void *arg) {
+  /**
+     @param[in,out]  arg  Kernel instance (bench_task_struct).
+  */
+
+  bench_task_struct *task = (bench_task_struct *) arg; /* Kernel instance */
+  bench_data_struct *data = task->data; /* Shared input data */
+  size_t nfield = (size_t) data->nlon * data->nlat * data->ntime; /* Field size */
+  int months[3] = { 6, 7, 8 }; /* Season months for analog search */
+  analog_day_struct analog_days; /* Analog days */
+  double *bufout = NULL; /* Output buffer */
+  double *clim = NULL; /* Climatology buffer */
+  double *coef = NULL; /* Regression coefficients of all points */
+  double *coef_pt = NULL; /* Regression coefficients of one point */
+  double *cst = NULL; /* Regression constants */
+  double *yreg = NULL; /* Regressed values */
+  double *yerr = NULL; /* Regression residuals */
+  double *vif = NULL; /* Variance inflation factors */
+  double cte; /* Regression constant */
+  double chisq; /* Chi-square */
+  double rsq; /* R squared */
+  double autocor; /* Autocorrelation */
+  char filename[1000]; /* Output filename */
+  int ncoutid; /* NetCDF output file handle ID */
+  int varoutid; /* NetCDF variable ID */
+  int dimids[3]; /* NetCDF dimension IDs */
+  int istat = 0; /* Diagnostic status */
+  int pts; /* Points loop counter */
+  int clust; /* Cluster loop counter */
+  int t; /* Time loop counter */
+
+  if ( !strcmp(data->kernel, "analog") ) {
+    analog_days.ntime = data->ntime_down;
+    analog_days.time = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.tindex = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.tindex_all = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.year = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.month = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.day = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.tindex_s_all = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.year_s = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.month_s = (int *) malloc(data->ntime_down * sizeof(int));
+    analog_days.day_s = (int *) malloc(data->ntime_down * sizeof(int));
+    if (analog_days.time == NULL || analog_days.tindex == NULL || analog_days.tindex_all == NULL || analog_days.year == NULL ||
+        analog_days.month == NULL || analog_days.day == NULL || analog_days.tindex_s_all == NULL || analog_days.year_s == NULL ||
+        analog_days.month_s == NULL || analog_days.day_s == NULL) alloc_error(__FILE__, __LINE__);
+    (void) alloc_dayschoice(&analog_days, data->ntime_down, 16);
+    istat = find_the_days(analog_days, data->precip_down, data->precip, data->sup_index_down, data->sup_index,
+                          (double *) NULL, (double *) NULL, (short int *) NULL, data->clusters_down, data->clusters,
+                          data->year_down, data->month_down, data->day_down, data->year, data->month, data->day,
+                          "days since 1900-01-01 00:00:00", data->ntime_down, data->ntime, months, 3, 10, 16, data->npts,
+                          FALSE, TRUE, FALSE, FALSE, FALSE, TRUE, data->nlon, data->nlat, data->nlon, data->nlat);
+    (void) free_dayschoice(&analog_days);
+    (void) free(analog_days.time);
+    (void) free(analog_days.tindex);
+    (void) free(analog_days.tindex_all);
+    (void) free(analog_days.year);
+    (void) free(analog_days.month);
+    (void) free(analog_days.day);
+    (void) free(analog_days.tindex_s_all);
+    (void) free(analog_days.year_s);
+    (void) free(analog_days.month_s);
+    (void) free(analog_days.day_s);
+  }
+  else if ( !strcmp(data->kernel, "kmeans") ) {
+    bufout = (double *) malloc(data->neof * data->nclust * sizeof(double));
+    if (bufout == NULL) alloc_error(__FILE__, __LINE__);
+    (void) best_clusters(bufout, data->pc, "euclidian", 30, data->nclassif, data->neof, data->nclust, data->ntime);
+  }
+  else if ( !strcmp(data->kernel, "regression") ) {
+    /* Regression of precipitation at each point against cluster distances, then reconstruction */
+    coef = (double *) malloc(data->nclust * data->npts * sizeof(double));
+    cst = (double *) malloc(data->npts * sizeof(double));
+    yreg = (double *) malloc(data->ntime * sizeof(double));
+    yerr = (double *) malloc(data->ntime * sizeof(double));
+    vif = (double *) malloc(data->nclust * sizeof(double));
+    coef_pt = (double *) malloc(data->nclust * sizeof(double));
+    bufout = (double *) malloc((size_t) data->npts * data->ntime * sizeof(double));
+    clim = (double *) malloc(data->ntime * sizeof(double));
+    if (coef == NULL || cst == NULL || yreg == NULL || yerr == NULL || vif == NULL || coef_pt == NULL || bufout == NULL || clim == NULL)
+      alloc_error(__FILE__, __LINE__);
+    for (pts=0; pts<data->npts && istat == 0; pts++) {
+      for (t=0; t<data->ntime; t++)
+        clim[t] = data->precip[pts+t*data->npts];
+      istat = regress(coef_pt, data->dist, clim, &cte, yreg, yerr, &chisq, &rsq, vif, &autocor, data->nclust, data->ntime);
+      for (clust=0; clust<data->nclust; clust++)
+        coef[pts+clust*data->npts] = coef_pt[clust];
+      cst[pts] = cte;
+    }
+    if (istat == 0)
+      (void) apply_regression(bufout, coef, cst, data->dist, (double *) NULL, data->npts, data->ntime, data->nclust, data->nclust);
+    (void) free(coef);
+    (void) free(cst);
+    (void) free(yreg);
+    (void) free(yerr);
+    (void) free(vif);
+    (void) free(coef_pt);
+  }
+  else if ( !strcmp(data->kernel, "climatology") ) {
+    bufout = (double *) malloc(nfield * sizeof(double));
+    clim = (double *) malloc((size_t) data->nlon * data->nlat * 366 * sizeof(double));
+    if (bufout == NULL || clim == NULL) alloc_error(__FILE__, __LINE__);
+    (void) remove_seasonal_cycle(bufout, clim, data->field, data->buftime, -9999.0, 60, "hanning", FALSE,
+                                 data->nlon, data->nlat, data->ntime);
+  }
+  else if ( !strcmp(data->kernel, "filter") ) {
+    bufout = (double *) malloc(nfield * sizeof(double));
+    if (bufout == NULL) alloc_error(__FILE__, __LINE__);
+    (void) filter(bufout, data->field, "hanning", 60, data->nlon, data->nlat, data->ntime);
+  }
+  else if ( !strcmp(data->kernel, "eof") ) {
+    bufout = (double *) malloc((size_t) data->ntime * data->neof * sizeof(double));
+    if (bufout == NULL) alloc_error(__FILE__, __LINE__);
+    istat = project_field_eof(bufout, data->field, data->eof, data->sing, -9999.0, data->lon, data->lat, 1.0,
+                              data->nlon, data->nlat, data->ntime, data->neof);
+  }
+  else if ( !strcmp(data->kernel, "output") ) {
+    /* Compressed NetCDF-4 write. The NetCDF library is not thread-safe: instances are serialized by the NetCDF lock */
+    (void) nc_io_lock();
+    (void) snprintf(filename, 1000, "%s/bench_output_%d.nc", data->outdir, task->instance);
+    istat = nc_create(filename, NC_CLOBBER | NC_NETCDF4, &ncoutid);
+    if (istat == NC_NOERR) {
+      istat = nc_def_dim(ncoutid, "time", (size_t) data->ntime, &(dimids[0]));
+      if (istat == NC_NOERR) istat = nc_def_dim(ncoutid, "lat", (size_t) data->nlat, &(dimids[1]));
+      if (istat == NC_NOERR) istat = nc_def_dim(ncoutid, "lon", (size_t) data->nlon, &(dimids[2]));
+      if (istat == NC_NOERR) istat = nc_def_var(ncoutid, "tas", NC_DOUBLE, 3, dimids, &varoutid);
+      if (istat == NC_NOERR) istat = nc_def_var_deflate(ncoutid, varoutid, 1, 1, 1);
+      if (istat == NC_NOERR) istat = nc_enddef(ncoutid);
+      if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, varoutid, data->field);
+      if (istat != NC_NOERR) (void) handle_netcdf_error(istat, __FILE__, __LINE__);
+      (void) nc_close(ncoutid);
+    }
+    else
+      (void) handle_netcdf_error(istat, __FILE__, __LINE__);
+    (void) remove(filename);
+    (void) nc_io_unlock();
+  }
+
+  (void) free(bufout);
+  (void) free(clim);
+
+  task->istat = istat;
+}
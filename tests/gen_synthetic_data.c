@@ -0,0 +1,666 @@
+/* ***************************************************** */
+/* gen_synthetic_data Synthetic NetCDF input data.       */
+/* gen_synthetic_data.c                                  */
+/* ***************************************************** */
+/* Author: Christian Page, CERFACS, Toulouse, France.    */
+/* ***************************************************** */
+/*! \file gen_synthetic_data.c
+    \brief Generate reproducible synthetic NetCDF inputs (large-scale fields, EOFs, observations, regression points) for benchmarks.
+*/
+
+/* LICENSE BEGIN
+
+Copyright Cerfacs (Christian Page) (2015)
+
+christian.page@cerfacs.fr
+
+This software is a computer program whose purpose is to downscale climate
+scenarios using a statistical methodology based on weather regimes.
+
+This software is governed by the CeCILL license under French law and
+abiding by the rules of distribution of free software. You can use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty and the software's author, the holder of the
+economic rights, and the successive licensors have only limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading, using, modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean that it is complicated to manipulate, and that also
+therefore means that it is reserved for developers and experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and, more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+
+LICENSE END */
+
+
+
+
+
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/** GNU extensions */
+#define _GNU_SOURCE
+
+/* C standard includes */
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_MATH_H
+#include <math.h>
+#endif
+#ifdef HAVE_LIBGEN_H
+#include <libgen.h>
+#endif
+
+/* GSL includes */
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+
+/* NetCDF include */
+#include <netcdf.h>
+
+#include <utils.h>
+#include <io.h>
+
+/** Maximum number of observation variables. */
+#define MAXOBSVARS 9
+
+/** C prototypes. */
+void show_usage(char *pgm);
+int days_in_year(int year, char *calendar);
+void make_grid(double *lon, double *lat, double lon0, double lat0, double res, int nlon, int nlat);
+int write_synthetic_field(char *filename, char *varname, char *units, double *lon, double *lat, double *timein,
+                          char *time_units, char *calendar, double mean, double amplitude, double noise, int daylen,
+                          gsl_rng *rng, int nlon, int nlat, int ntime, int coords2d);
+int write_synthetic_eof(char *filename, char *varname, double *lon, double *lat, gsl_rng *rng, int nlon, int nlat, int neof);
+int write_regression_points(char *filename, double *lon, double *lat, gsl_rng *rng, int nlon, int nlat, int npts);
+
+/** Main program. */
+int main(int argc, char **argv)
+{
+  /**
+     @param[in]  argc  Number of command-line arguments.
+     @param[in]  argv  Vector of command-line argument strings.
+
+     \return           Status.
+   */
+
+  /* Observation variables acronyms, units, mean value, seasonal amplitude and noise */
+  char *obs_acronym[MAXOBSVARS] = { "tas", "tasmax", "tasmin", "prr", "prsn", "huss", "rsds", "rlds", "uvas" };
+  char *obs_units[MAXOBSVARS] = { "K", "K", "K", "kg m-2 s-1", "kg m-2 s-1", "kg kg-1", "W m-2", "W m-2", "m s-1" };
+  double obs_mean[MAXOBSVARS] = { 285.0, 290.0, 280.0, 2.0e-5, 2.0e-6, 6.0e-3, 150.0, 300.0, 3.0 };
+  double obs_ampl[MAXOBSVARS] = { 8.0, 9.0, 7.0, 1.0e-5, 2.0e-6, 3.0e-3, 100.0, 40.0, 1.0 };
+  double obs_noise[MAXOBSVARS] = { 3.0, 3.0, 3.0, 1.0e-5, 1.0e-6, 1.0e-3, 40.0, 20.0, 1.0 };
+
+  int nlon = 40; /* Large-scale grid longitude dimension */
+  int nlat = 30; /* Large-scale grid latitude dimension */
+  int obs_nlon = 80; /* Observation grid x dimension */
+  int obs_nlat = 60; /* Observation grid y dimension */
+  int nyears = 30; /* Number of years */
+  int year_begin = 1961; /* First year */
+  int nvars = 3; /* Number of observation variables */
+  int npts = 50; /* Number of regression points */
+  int neof = 10; /* Number of EOFs */
+  unsigned long int seed = 1; /* Random number generator seed */
+  char calendar[500]; /* Calendar of time coordinate */
+  char outdir[500]; /* Output directory */
+  char filename[1000]; /* Output filename */
+  char time_units[500]; /* Time units */
+
+  double *lon = NULL; /* Large-scale longitudes */
+  double *lat = NULL; /* Large-scale latitudes */
+  double *obs_lon = NULL; /* Observation longitudes */
+  double *obs_lat = NULL; /* Observation latitudes */
+  double *timein = NULL; /* Time coordinate */
+  int ntime; /* Time dimension */
+  int daylen; /* Number of days in the seasonal cycle */
+  int istat; /* Diagnostic status */
+  int i; /* Loop counter */
+  int t; /* Time loop counter */
+  int y; /* Year loop counter */
+
+  gsl_rng *rng = NULL; /* Random number generator */
+
+  /* Print BEGIN banner */
+  (void) banner(basename(argv[0]), "1.0", "BEGIN");
+
+  (void) strcpy(calendar, "gregorian");
+  (void) strcpy(outdir, ".");
+
+  /* Get command-line arguments and set appropriate variables */
+  for (i=1; i<argc; i++) {
+    if ( !strcmp(argv[i], "-h") ) {
+      (void) show_usage(basename(argv[0]));
+      (void) banner(basename(argv[0]), "OK", "END");
+      return 0;
+    }
+    else if ( !strcmp(argv[i], "-nlon") && i+1 < argc )
+      nlon = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-nlat") && i+1 < argc )
+      nlat = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-obs_nlon") && i+1 < argc )
+      obs_nlon = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-obs_nlat") && i+1 < argc )
+      obs_nlat = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-years") && i+1 < argc )
+      nyears = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-year_begin") && i+1 < argc )
+      year_begin = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-calendar") && i+1 < argc )
+      (void) strncpy(calendar, argv[++i], 499);
+    else if ( !strcmp(argv[i], "-nvars") && i+1 < argc )
+      nvars = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-npts") && i+1 < argc )
+      npts = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-neof") && i+1 < argc )
+      neof = atoi(argv[++i]);
+    else if ( !strcmp(argv[i], "-seed") && i+1 < argc )
+      seed = (unsigned long int) atol(argv[++i]);
+    else if ( !strcmp(argv[i], "-out") && i+1 < argc )
+      (void) strncpy(outdir, argv[++i], 499);
+    else {
+      (void) fprintf(stderr, "%s:: Wrong arg %s.\n\n", basename(argv[0]), argv[i]);
+      (void) show_usage(basename(argv[0]));
+      (void) banner(basename(argv[0]), "ABORT", "END");
+      (void) abort();
+    }
+  }
+  calendar[499] = '\0';
+  outdir[499] = '\0';
+
+  if (days_in_year(year_begin, calendar) < 0) {
+    (void) fprintf(stderr, "%s: Unsupported calendar %s.\n", __FILE__, calendar);
+    (void) banner(basename(argv[0]), "ABORT", "END");
+    return 1;
+  }
+  if (nvars < 0 || nvars > MAXOBSVARS) {
+    (void) fprintf(stderr, "%s: Number of observation variables must be between 0 and %d.\n", __FILE__, MAXOBSVARS);
+    (void) banner(basename(argv[0]), "ABORT", "END");
+    return 1;
+  }
+  if (npts > nlon * nlat) npts = nlon * nlat;
+  if (neof > nlon * nlat) neof = nlon * nlat;
+
+  /* Daily time coordinate in the requested calendar */
+  ntime = 0;
+  for (y=year_begin; y<year_begin+nyears; y++)
+    ntime += days_in_year(y, calendar);
+  timein = (double *) malloc(ntime * sizeof(double));
+  if (timein == NULL) alloc_error(__FILE__, __LINE__);
+  for (t=0; t<ntime; t++)
+    timein[t] = (double) t;
+  (void) snprintf(time_units, 500, "days since %d-01-01 00:00:00", year_begin);
+  daylen = days_in_year(year_begin, calendar);
+
+  /* Regular large-scale grid, observation grid on a finer resolution over the same area */
+  lon = (double *) malloc(nlon * nlat * sizeof(double));
+  if (lon == NULL) alloc_error(__FILE__, __LINE__);
+  lat = (double *) malloc(nlon * nlat * sizeof(double));
+  if (lat == NULL) alloc_error(__FILE__, __LINE__);
+  obs_lon = (double *) malloc(obs_nlon * obs_nlat * sizeof(double));
+  if (obs_lon == NULL) alloc_error(__FILE__, __LINE__);
+  obs_lat = (double *) malloc(obs_nlon * obs_nlat * sizeof(double));
+  if (obs_lat == NULL) alloc_error(__FILE__, __LINE__);
+  (void) make_grid(lon, lat, -10.0, 35.0, 0.5, nlon, nlat);
+  (void) make_grid(obs_lon, obs_lat, -10.0, 35.0, 0.5 * (double) nlon / (double) obs_nlon, obs_nlon, obs_nlat);
+
+  rng = gsl_rng_alloc(gsl_rng_mt19937);
+  (void) gsl_rng_set(rng, seed);
+
+  (void) printf("Grid %dx%d, observations %dx%d, %d years from %d (%s calendar, %d days), %d observation variables, %d regression points.\n",
+                nlon, nlat, obs_nlon, obs_nlat, nyears, year_begin, calendar, ntime, nvars, npts);
+
+  /* Large-scale field and secondary large-scale field */
+  (void) snprintf(filename, 1000, "%s/psl_%d-%d.nc", outdir, year_begin, year_begin+nyears-1);
+  istat = write_synthetic_field(filename, "psl", "Pa", lon, lat, timein, time_units, calendar, 101325.0, 800.0, 600.0, daylen,
+                                rng, nlon, nlat, ntime, FALSE);
+  if (istat == 0) {
+    (void) snprintf(filename, 1000, "%s/tas_ls_%d-%d.nc", outdir, year_begin, year_begin+nyears-1);
+    istat = write_synthetic_field(filename, "tas", "K", lon, lat, timein, time_units, calendar, 285.0, 8.0, 3.0, daylen,
+                                  rng, nlon, nlat, ntime, FALSE);
+  }
+
+  /* EOFs and singular values of large-scale field */
+  if (istat == 0) {
+    (void) snprintf(filename, 1000, "%s/psl_eof.nc", outdir);
+    istat = write_synthetic_eof(filename, "psl", lon, lat, rng, nlon, nlat, neof);
+  }
+
+  /* Regression points */
+  if (istat == 0) {
+    (void) snprintf(filename, 1000, "%s/reg_points.nc", outdir);
+    istat = write_regression_points(filename, obs_lon, obs_lat, rng, obs_nlon, obs_nlat, npts);
+  }
+
+  /* Observation variables, following the acronym_YYYYYYYY.nc template */
+  for (i=0; i<nvars && istat == 0; i++) {
+    (void) snprintf(filename, 1000, "%s/%s_%d%d.nc", outdir, obs_acronym[i], year_begin, year_begin+nyears-1);
+    istat = write_synthetic_field(filename, obs_acronym[i], obs_units[i], obs_lon, obs_lat, timein, time_units, calendar,
+                                  obs_mean[i], obs_ampl[i], obs_noise[i], daylen, rng, obs_nlon, obs_nlat, ntime, TRUE);
+  }
+
+  (void) gsl_rng_free(rng);
+  (void) free(timein);
+  (void) free(lon);
+  (void) free(lat);
+  (void) free(obs_lon);
+  (void) free(obs_lat);
+
+  if (istat != 0) {
+    (void) banner(basename(argv[0]), "ABORT", "END");
+    return 1;
+  }
+
+  /* Print END banner */
+  (void) banner(basename(argv[0]), "OK", "END");
+
+  return 0;
+}
+
+
+/** Local Subroutines **/
+
+/** Show usage for program command-line arguments. */
+void show_usage(char *pgm) {
+  /**
+     @param[in]  pgm  Program name.
+  */
+
+  (void) fprintf(stderr, "%s: usage:\n", pgm);
+  (void) fprintf(stderr, "-nlon N -nlat N: large-scale grid dimensions (default 40x30)\n");
+  (void) fprintf(stderr, "-obs_nlon N -obs_nlat N: observation grid dimensions (default 80x60)\n");
+  (void) fprintf(stderr, "-years N: number of years (default 30)\n");
+  (void) fprintf(stderr, "-year_begin N: first year (default 1961)\n");
+  (void) fprintf(stderr, "-calendar name: gregorian, standard, noleap, 365_day, all_leap, 366_day or 360_day (default gregorian)\n");
+  (void) fprintf(stderr, "-nvars N: number of observation variables, at most %d (default 3)\n", MAXOBSVARS);
+  (void) fprintf(stderr, "-npts N: number of regression points (default 50)\n");
+  (void) fprintf(stderr, "-neof N: number of EOFs (default 10)\n");
+  (void) fprintf(stderr, "-seed N: random number generator seed (default 1)\n");
+  (void) fprintf(stderr, "-out dir: output directory (default .)\n");
+  (void) fprintf(stderr, "-h: help\n");
+
+}
+
+/** Number of days in a year for a given calendar, -1 if the calendar is not supported. */
+int days_in_year(int year, char *calendar) {
+  /**
+     @param[in]  year      Year
+     @param[in]  calendar  Calendar name
+
+     \return               Number of days.
+  */
+
+  if ( !strcmp(calendar, "gregorian") || !strcmp(calendar, "standard") || !strcmp(calendar, "proleptic_gregorian") ) {
+    if ( (year % 4 == 0 && year % 100 != 0) || year % 400 == 0 )
+      return 366;
+    else
+      return 365;
+  }
+  else if ( !strcmp(calendar, "noleap") || !strcmp(calendar, "365_day") )
+    return 365;
+  else if ( !strcmp(calendar, "all_leap") || !strcmp(calendar, "366_day") )
+    return 366;
+  else if ( !strcmp(calendar, "360_day") )
+    return 360;
+  else
+    return -1;
+}
+
+/** Build a regular 2D longitude-latitude grid. */
+void make_grid(double *lon, double *lat, double lon0, double lat0, double res, int nlon, int nlat) {
+  /**
+     @param[out]  lon   Longitudes
+     @param[out]  lat   Latitudes
+     @param[in]   lon0  First longitude
+     @param[in]   lat0  First latitude
+     @param[in]   res   Resolution in degrees
+     @param[in]   nlon  Longitude dimension
+     @param[in]   nlat  Latitude dimension
+  */
+
+  int i;
+  int j;
+
+  for (j=0; j<nlat; j++)
+    for (i=0; i<nlon; i++) {
+      lon[i+j*nlon] = lon0 + res * (double) i;
+      lat[i+j*nlon] = lat0 + res * (double) j;
+    }
+}
+
+/** Write a synthetic 3D daily field: seasonal cycle, large-scale spatial waves and gaussian noise. */
+int write_synthetic_field(char *filename, char *varname, char *units, double *lon, double *lat, double *timein,
+                          char *time_units, char *calendar, double mean, double amplitude, double noise, int daylen,
+                          gsl_rng *rng, int nlon, int nlat, int ntime, int coords2d) {
+  /**
+     @param[in]  filename    Output filename
+     @param[in]  varname     Variable name
+     @param[in]  units       Variable units
+     @param[in]  lon         Longitudes
+     @param[in]  lat         Latitudes
+     @param[in]  timein      Time coordinate
+     @param[in]  time_units  Time units
+     @param[in]  calendar    Calendar
+     @param[in]  mean        Mean value
+     @param[in]  amplitude   Seasonal cycle amplitude
+     @param[in]  noise       Standard deviation of the gaussian noise
+     @param[in]  daylen      Number of days of the seasonal cycle
+     @param[in]  rng         Random number generator
+     @param[in]  nlon        Longitude (or x) dimension
+     @param[in]  nlat        Latitude (or y) dimension
+     @param[in]  ntime       Time dimension
+     @param[in]  coords2d    TRUE for an x/y grid with 2D lon/lat variables, FALSE for 1D lon/lat dimensions
+
+     \return                 Status.
+  */
+
+  int ncoutid; /* NetCDF output file handle ID */
+  int londimoutid; /* Longitude (or x) dimension ID */
+  int latdimoutid; /* Latitude (or y) dimension ID */
+  int timedimoutid; /* Time dimension ID */
+  int lonoutid; /* Longitude variable ID */
+  int latoutid; /* Latitude variable ID */
+  int timeoutid; /* Time variable ID */
+  int varoutid; /* Field variable ID */
+  int vardimids[3]; /* Dimension IDs of field variable */
+  size_t start[3]; /* Start element when writing */
+  size_t count[3]; /* Count of elements to write */
+  size_t chunksize[3]; /* Chunk sizes */
+  double fillvalue = 1.0e20; /* Missing value */
+  double *buf = NULL; /* One timestep of the field */
+  double *buf1d = NULL; /* 1D coordinate buffer */
+  double season; /* Seasonal cycle factor */
+  int istat; /* Diagnostic status */
+  int i; /* Loop counter */
+  int j; /* Loop counter */
+  int t; /* Time loop counter */
+
+  (void) printf("Writing %s\n", filename);
+
+  istat = nc_create(filename, NC_CLOBBER | NC_NETCDF4, &ncoutid);
+  if (istat != NC_NOERR) { (void) handle_netcdf_error(istat, __FILE__, __LINE__); return -1; }
+
+  if (coords2d == TRUE) {
+    istat = nc_def_dim(ncoutid, "x", (size_t) nlon, &londimoutid);
+    if (istat == NC_NOERR) istat = nc_def_dim(ncoutid, "y", (size_t) nlat, &latdimoutid);
+  }
+  else {
+    istat = nc_def_dim(ncoutid, "lon", (size_t) nlon, &londimoutid);
+    if (istat == NC_NOERR) istat = nc_def_dim(ncoutid, "lat", (size_t) nlat, &latdimoutid);
+  }
+  if (istat == NC_NOERR) istat = nc_def_dim(ncoutid, "time", NC_UNLIMITED, &timedimoutid);
+
+  /* Coordinate variables */
+  if (istat == NC_NOERR) {
+    if (coords2d == TRUE) {
+      vardimids[0] = latdimoutid;
+      vardimids[1] = londimoutid;
+      istat = nc_def_var(ncoutid, "lon", NC_DOUBLE, 2, vardimids, &lonoutid);
+      if (istat == NC_NOERR) istat = nc_def_var(ncoutid, "lat", NC_DOUBLE, 2, vardimids, &latoutid);
+    }
+    else {
+      istat = nc_def_var(ncoutid, "lon", NC_DOUBLE, 1, &londimoutid, &lonoutid);
+      if (istat == NC_NOERR) istat = nc_def_var(ncoutid, "lat", NC_DOUBLE, 1, &latdimoutid, &latoutid);
+    }
+  }
+  if (istat == NC_NOERR) istat = nc_put_att_text(ncoutid, lonoutid, "units", strlen("degrees_east"), "degrees_east");
+  if (istat == NC_NOERR) istat = nc_put_att_text(ncoutid, latoutid, "units", strlen("degrees_north"), "degrees_north");
+  if (istat == NC_NOERR) istat = nc_def_var(ncoutid, "time", NC_DOUBLE, 1, &timedimoutid, &timeoutid);
+  if (istat == NC_NOERR) istat = nc_put_att_text(ncoutid, timeoutid, "units", strlen(time_units), time_units);
+  if (istat == NC_NOERR) istat = nc_put_att_text(ncoutid, timeoutid, "calendar", strlen(calendar), calendar);
+
+  /* Field variable, chunked by timestep and compressed like dsclim outputs */
+  vardimids[0] = timedimoutid;
+  vardimids[1] = latdimoutid;
+  vardimids[2] = londimoutid;
+  chunksize[0] = 1;
+  chunksize[1] = (size_t) nlat;
+  chunksize[2] = (size_t) nlon;
+  if (istat == NC_NOERR) istat = nc_def_var(ncoutid, varname, NC_DOUBLE, 3, vardimids, &varoutid);
+  if (istat == NC_NOERR) istat = nc_def_var_chunking(ncoutid, varoutid, NC_CHUNKED, chunksize);
+  if (istat == NC_NOERR) istat = nc_def_var_deflate(ncoutid, varoutid, 1, 1, 1);
+  if (istat == NC_NOERR) istat = nc_put_att_text(ncoutid, varoutid, "units", strlen(units), units);
+  if (istat == NC_NOERR) istat = nc_put_att_double(ncoutid, varoutid, "_FillValue", NC_DOUBLE, 1, &fillvalue);
+  if (istat == NC_NOERR) istat = nc_put_att_double(ncoutid, varoutid, "missing_value", NC_DOUBLE, 1, &fillvalue);
+  if (istat == NC_NOERR) istat = nc_put_att_text(ncoutid, NC_GLOBAL, "title", strlen("dsclim synthetic benchmark data"),
+                                                 "dsclim synthetic benchmark data");
+  if (istat == NC_NOERR) istat = nc_enddef(ncoutid);
+
+  /* Coordinates */
+  if (istat == NC_NOERR) {
+    if (coords2d == TRUE) {
+      istat = nc_put_var_double(ncoutid, lonoutid, lon);
+      if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, latoutid, lat);
+    }
+    else {
+      buf1d = (double *) malloc((nlon > nlat ? nlon : nlat) * sizeof(double));
+      if (buf1d == NULL) alloc_error(__FILE__, __LINE__);
+      for (i=0; i<nlon; i++)
+        buf1d[i] = lon[i];
+      istat = nc_put_var_double(ncoutid, lonoutid, buf1d);
+      for (j=0; j<nlat; j++)
+        buf1d[j] = lat[j*nlon];
+      if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, latoutid, buf1d);
+      (void) free(buf1d);
+    }
+  }
+  start[0] = 0;
+  count[0] = (size_t) ntime;
+  if (istat == NC_NOERR) istat = nc_put_vara_double(ncoutid, timeoutid, start, count, timein);
+
+  /* Field, one timestep at a time to keep memory bounded for large grids */
+  buf = (double *) malloc(nlon * nlat * sizeof(double));
+  if (buf == NULL) alloc_error(__FILE__, __LINE__);
+  start[1] = 0;
+  start[2] = 0;
+  count[0] = 1;
+  count[1] = (size_t) nlat;
+  count[2] = (size_t) nlon;
+  for (t=0; t<ntime && istat == NC_NOERR; t++) {
+    season = -cos(2.0 * M_PI * (double) (t % daylen) / (double) daylen);
+    for (j=0; j<nlat; j++)
+      for (i=0; i<nlon; i++)
+        buf[i+j*nlon] = mean + amplitude * season
+          + 0.5 * amplitude * sin(2.0 * M_PI * ((double) i / (double) nlon + (double) t / 7.0))
+          * cos(M_PI * (double) j / (double) nlat)
+          + gsl_ran_gaussian(rng, noise);
+    start[0] = (size_t) t;
+    istat = nc_put_vara_double(ncoutid, varoutid, start, count, buf);
+  }
+  (void) free(buf);
+
+  if (istat != NC_NOERR) {
+    (void) handle_netcdf_error(istat, __FILE__, __LINE__);
+    (void) nc_close(ncoutid);
+    return -1;
+  }
+
+  istat = nc_close(ncoutid);
+  if (istat != NC_NOERR) { (void) handle_netcdf_error(istat, __FILE__, __LINE__); return -1; }
+
+  return 0;
+}
+
+/** Write synthetic orthonormal EOFs and decreasing singular values. */
+int write_synthetic_eof(char *filename, char *varname, double *lon, double *lat, gsl_rng *rng, int nlon, int nlat, int neof) {
+  /**
+     @param[in]  filename  Output filename
+     @param[in]  varname   Field variable name: EOF variable is named varname_eof and singular values varname_sing
+     @param[in]  lon       Longitudes
+     @param[in]  lat       Latitudes
+     @param[in]  rng       Random number generator
+     @param[in]  nlon      Longitude dimension
+     @param[in]  nlat      Latitude dimension
+     @param[in]  neof      Number of EOFs
+
+     \return               Status.
+  */
+
+  int ncoutid; /* NetCDF output file handle ID */
+  int dimids[3]; /* Dimension IDs: eof, lat, lon */
+  int lonoutid; /* Longitude variable ID */
+  int latoutid; /* Latitude variable ID */
+  int eofoutid; /* EOF variable ID */
+  int singoutid; /* Singular value variable ID */
+  char name[500]; /* Variable name */
+  double *eof = NULL; /* EOFs */
+  double *sing = NULL; /* Singular values */
+  double *buf1d = NULL; /* 1D coordinate buffer */
+  double dot; /* Scalar product */
+  double norm; /* Norm */
+  int npts = nlon * nlat; /* Number of grid points */
+  int istat; /* Diagnostic status */
+  int e; /* EOF loop counter */
+  int ee; /* EOF loop counter */
+  int i; /* Loop counter */
+
+  (void) printf("Writing %s\n", filename);
+
+  /* Random vectors orthonormalized with Gram-Schmidt */
+  eof = (double *) malloc((size_t) neof * npts * sizeof(double));
+  if (eof == NULL) alloc_error(__FILE__, __LINE__);
+  sing = (double *) malloc(neof * sizeof(double));
+  if (sing == NULL) alloc_error(__FILE__, __LINE__);
+  for (e=0; e<neof; e++) {
+    for (i=0; i<npts; i++)
+      eof[i+e*npts] = gsl_ran_gaussian(rng, 1.0);
+    for (ee=0; ee<e; ee++) {
+      dot = 0.0;
+      for (i=0; i<npts; i++)
+        dot += eof[i+e*npts] * eof[i+ee*npts];
+      for (i=0; i<npts; i++)
+        eof[i+e*npts] -= dot * eof[i+ee*npts];
+    }
+    norm = 0.0;
+    for (i=0; i<npts; i++)
+      norm += eof[i+e*npts] * eof[i+e*npts];
+    norm = sqrt(norm);
+    for (i=0; i<npts; i++)
+      eof[i+e*npts] /= norm;
+    sing[e] = 1000.0 / (double) (e+1);
+  }
+
+  istat = nc_create(filename, NC_CLOBBER | NC_NETCDF4, &ncoutid);
+  if (istat != NC_NOERR) { (void) handle_netcdf_error(istat, __FILE__, __LINE__); return -1; }
+  istat = nc_def_dim(ncoutid, "eof", (size_t) neof, &(dimids[0]));
+  if (istat == NC_NOERR) istat = nc_def_dim(ncoutid, "lat", (size_t) nlat, &(dimids[1]));
+  if (istat == NC_NOERR) istat = nc_def_dim(ncoutid, "lon", (size_t) nlon, &(dimids[2]));
+  if (istat == NC_NOERR) istat = nc_def_var(ncoutid, "lon", NC_DOUBLE, 1, &(dimids[2]), &lonoutid);
+  if (istat == NC_NOERR) istat = nc_def_var(ncoutid, "lat", NC_DOUBLE, 1, &(dimids[1]), &latoutid);
+  (void) snprintf(name, 500, "%s_eof", varname);
+  if (istat == NC_NOERR) istat = nc_def_var(ncoutid, name, NC_DOUBLE, 3, dimids, &eofoutid);
+  (void) snprintf(name, 500, "%s_sing", varname);
+  if (istat == NC_NOERR) istat = nc_def_var(ncoutid, name, NC_DOUBLE, 1, &(dimids[0]), &singoutid);
+  if (istat == NC_NOERR) istat = nc_enddef(ncoutid);
+
+  buf1d = (double *) malloc((nlon > nlat ? nlon : nlat) * sizeof(double));
+  if (buf1d == NULL) alloc_error(__FILE__, __LINE__);
+  for (i=0; i<nlon; i++)
+    buf1d[i] = lon[i];
+  if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, lonoutid, buf1d);
+  for (i=0; i<nlat; i++)
+    buf1d[i] = lat[i*nlon];
+  if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, latoutid, buf1d);
+  (void) free(buf1d);
+  if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, eofoutid, eof);
+  if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, singoutid, sing);
+
+  (void) free(eof);
+  (void) free(sing);
+
+  if (istat != NC_NOERR) {
+    (void) handle_netcdf_error(istat, __FILE__, __LINE__);
+    (void) nc_close(ncoutid);
+    return -1;
+  }
+
+  istat = nc_close(ncoutid);
+  if (istat != NC_NOERR) { (void) handle_netcdf_error(istat, __FILE__, __LINE__); return -1; }
+
+  return 0;
+}
+
+/** Write regression points randomly chosen over a grid. */
+int write_regression_points(char *filename, double *lon, double *lat, gsl_rng *rng, int nlon, int nlat, int npts) {
+  /**
+     @param[in]  filename  Output filename
+     @param[in]  lon       Longitudes of the grid
+     @param[in]  lat       Latitudes of the grid
+     @param[in]  rng       Random number generator
+     @param[in]  nlon      Longitude dimension of the grid
+     @param[in]  nlat      Latitude dimension of the grid
+     @param[in]  npts      Number of regression points
+
+     \return               Status.
+  */
+
+  int ncoutid; /* NetCDF output file handle ID */
+  int ptsdimoutid; /* Points dimension ID */
+  int lonoutid; /* Longitude variable ID */
+  int latoutid; /* Latitude variable ID */
+  double *reg_lon = NULL; /* Regression points longitudes */
+  double *reg_lat = NULL; /* Regression points latitudes */
+  unsigned long int ind; /* Grid point index */
+  int istat; /* Diagnostic status */
+  int pts; /* Points loop counter */
+
+  (void) printf("Writing %s\n", filename);
+
+  reg_lon = (double *) malloc(npts * sizeof(double));
+  if (reg_lon == NULL) alloc_error(__FILE__, __LINE__);
+  reg_lat = (double *) malloc(npts * sizeof(double));
+  if (reg_lat == NULL) alloc_error(__FILE__, __LINE__);
+  for (pts=0; pts<npts; pts++) {
+    ind = gsl_rng_uniform_int(rng, (unsigned long int) (nlon * nlat));
+    reg_lon[pts] = lon[ind];
+    reg_lat[pts] = lat[ind];
+  }
+
+  istat = nc_create(filename, NC_CLOBBER | NC_NETCDF4, &ncoutid);
+  if (istat != NC_NOERR) { (void) handle_netcdf_error(istat, __FILE__, __LINE__); return -1; }
+  istat = nc_def_dim(ncoutid, "pts", (size_t) npts, &ptsdimoutid);
+  if (istat == NC_NOERR) istat = nc_def_var(ncoutid, "lon", NC_DOUBLE, 1, &ptsdimoutid, &lonoutid);
+  if (istat == NC_NOERR) istat = nc_def_var(ncoutid, "lat", NC_DOUBLE, 1, &ptsdimoutid, &latoutid);
+  if (istat == NC_NOERR) istat = nc_put_att_text(ncoutid, lonoutid, "units", strlen("degrees_east"), "degrees_east");
+  if (istat == NC_NOERR) istat = nc_put_att_text(ncoutid, latoutid, "units", strlen("degrees_north"), "degrees_north");
+  if (istat == NC_NOERR) istat = nc_enddef(ncoutid);
+  if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, lonoutid, reg_lon);
+  if (istat == NC_NOERR) istat = nc_put_var_double(ncoutid, latoutid, reg_lat);
+
+  (void) free(reg_lon);
+  (void) free(reg_lat);
+
+  if (istat != NC_NOERR) {
+    (void) handle_netcdf_error(istat, __FILE__, __LINE__);
+    (void) nc_close(ncoutid);
+    return -1;
+  }
+
+  istat = nc_close(ncoutid);
+  if (istat != NC_NOERR) { (void) handle_netcdf_error(istat, __FILE__, __LINE__); return -1; }
+
+  return 0;
+}